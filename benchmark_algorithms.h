@@ -10,6 +10,7 @@
 
 #include <iterator>
 #include <algorithm>
+#include <cmath>
 
 namespace benchmark {
     
@@ -445,6 +446,63 @@ void heapsort( RandomAccessIterator begin, RandomAccessIterator end )
 
 /******************************************************************************/
 
+// Error free transformation, a + b == sum + error exactly, for any magnitudes (Knuth)
+// Only works when the compiler follows IEEE rules, not with fast math options.
+template <typename T>
+inline void two_sum( T a, T b, T &sum, T &error ) {
+    sum = a + b;
+    T bb = sum - a;
+    error = (a - (sum - bb)) + (b - bb);
+}
+
+/******************************************************************************/
+
+// About 106 bits of precision, used as the exact reference for float and double sums and inner products
+struct double_double {
+    double hi, lo;
+
+    double_double() : hi(0), lo(0) {}
+
+    void add( double value ) {
+        double s, e;
+        two_sum( hi, value, s, e );
+        e += lo;
+        hi = s + e;
+        lo = e - (hi - s);
+    }
+
+    // a*b == p + e exactly
+    void add_product( double a, double b ) {
+        double p = a * b;
+        add( p );
+        add( std::fma( a, b, -p ) );
+    }
+
+    // relative error of a result against this reference
+    double relative_error( long double result ) const {
+        long double diff = (result - (long double)hi) - (long double)lo;
+        long double reference = (long double)hi + (long double)lo;
+        if (reference == 0)
+            return double( std::fabs( diff ) );
+        return double( std::fabs( diff / reference ) );
+    }
+};
+
+/******************************************************************************/
+
+// random values from 0.01 up to a million, evenly spread over the decades, with random signs
+template <typename T>
+void fill_mixed_magnitudes( T *first, const size_t count ) {
+    for (size_t j = 0; j < count; ++j) {
+        double mantissa = 1.0 + 9.0 * double( uint64_t(crand64()) & 0xFFFFF ) / double(0x100000);
+        int exponent = int( uint64_t(crand64()) % 8 ) - 2;
+        double sign = (crand64() & 1) ? -1.0 : 1.0;
+        first[j] = T( sign * mantissa * std::pow( 10.0, exponent ) );
+    }
+}
+
+/******************************************************************************/
+
 }    // end namespace benchmark
 
 using namespace benchmark;
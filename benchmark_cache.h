@@ -0,0 +1,108 @@
+/*
+    Copyright 2026 CppPerformanceBenchmarks contributors
+    Distributed under the MIT License (see accompanying file LICENSE_1_0_0.txt
+    or a copy at http://stlab.adobe.com/licenses.html )
+
+    Shared source file for cache size detection, used by blocked and tiled benchmarks
+
+    Sizes come from the OS where it reports them (sysfs on Linux, sysctl on MacOS),
+    otherwise we fall back to conservative guesses that fit most current CPUs.
+*/
+
+/******************************************************************************/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__APPLE__)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#endif
+
+namespace benchmark {
+
+/******************************************************************************/
+
+struct cache_sizes {
+    size_t L1;      // data cache, per core
+    size_t L2;
+    size_t L3;      // 0 if there is no L3
+};
+
+/******************************************************************************/
+
+#if defined(__linux__)
+// read one line from a sysfs file, returns false if it doesn't exist
+inline bool read_cache_file( int index, const char *name, char *buffer, size_t length ) {
+    char filename[ 256 ];
+    snprintf( filename, sizeof(filename), "/sys/devices/system/cpu/cpu0/cache/index%d/%s", index, name );
+    FILE *info = fopen( filename, "r" );
+    if (info == NULL)
+        return false;
+    bool found = (fgets( buffer, (int)length, info ) != NULL);
+    fclose( info );
+    return found;
+}
+#endif
+
+/******************************************************************************/
+
+inline cache_sizes read_cache_sizes() {
+    cache_sizes result = { 32*1024, 256*1024, 0 };
+
+#if defined(__linux__)
+    // iterate over cache levels, sizes look like "48K"
+    for (int index = 0; index < 10; ++index) {
+        char level[ 64 ], type[ 64 ], size[ 64 ];
+        if (!read_cache_file( index, "level", level, sizeof(level) )
+            || !read_cache_file( index, "type", type, sizeof(type) )
+            || !read_cache_file( index, "size", size, sizeof(size) ))
+            break;
+        if (type[0] == 'I')     // skip instruction caches
+            continue;
+        char *suffix = NULL;
+        size_t bytes = (size_t) strtoul( size, &suffix, 10 );
+        if (suffix && (*suffix == 'K' || *suffix == 'k'))
+            bytes *= 1024;
+        else if (suffix && *suffix == 'M')
+            bytes *= 1024*1024;
+        if (bytes == 0)
+            continue;
+        switch (atoi(level)) {
+            case 1: result.L1 = bytes; break;
+            case 2: result.L2 = bytes; break;
+            case 3: result.L3 = bytes; break;
+            default: break;
+        }
+    }
+#elif defined(__APPLE__)
+    int64_t bytes = 0;
+    size_t len = sizeof(bytes);
+    if (sysctlbyname( "hw.l1dcachesize", &bytes, &len, NULL, 0 ) == 0 && bytes > 0)
+        result.L1 = (size_t) bytes;
+    len = sizeof(bytes);
+    if (sysctlbyname( "hw.l2cachesize", &bytes, &len, NULL, 0 ) == 0 && bytes > 0)
+        result.L2 = (size_t) bytes;
+    bytes = 0;
+    len = sizeof(bytes);
+    if (sysctlbyname( "hw.l3cachesize", &bytes, &len, NULL, 0 ) == 0 && bytes > 0)
+        result.L3 = (size_t) bytes;
+#endif
+
+    return result;
+}
+
+/******************************************************************************/
+
+// the sizes don't change while we run, so only read them once
+inline cache_sizes detect_cache_sizes() {
+    static const cache_sizes result = read_cache_sizes();
+    return result;
+}
+
+/******************************************************************************/
+
+}    // end namespace benchmark
+
+/******************************************************************************/
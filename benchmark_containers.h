@@ -8,9 +8,126 @@
 #define benchmark_containers_h
 
 
+#include <cstddef>
+#include <iterator>
+#include <vector>
+#include <deque>
+#include <list>
+#include <forward_list>
 #include "container_singlelinklist.h"
 #include "container_doublelinklist.h"
 #include "container_hashmap.h"
 
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Lets algorithms written with indices (first[j]) run on forward iterators, such as linked lists.
+    All copies of an indexer share one cursor that only moves forward, so reads must be in increasing order
+        (as they are in the unrolled loops of the sequence benchmarks).
+    Reading an earlier index restarts from the beginning: correct, but slow.
+*/
+template<typename Iter>
+struct forward_cursor {
+    typedef typename std::iterator_traits<Iter>::reference   reference;
+
+    forward_cursor( Iter x ) : start(x), current(x), position(0) {}
+
+    reference at( size_t index ) {
+        if (index < position) {
+            current = start;
+            position = 0;
+        }
+        while (position < index) {
+            ++current;
+            ++position;
+        }
+        return *current;
+    }
+
+    Iter    start;
+    Iter    current;
+    size_t  position;
+};
+
+/******************************************************************************/
+
+template<typename Iter>
+struct forward_indexer {
+    typedef ptrdiff_t                                           difference_type;
+    typedef std::forward_iterator_tag                           iterator_category;
+    typedef typename std::iterator_traits<Iter>::value_type     value_type;
+    typedef typename std::iterator_traits<Iter>::pointer        pointer;
+    typedef typename std::iterator_traits<Iter>::reference      reference;
+
+    forward_indexer( forward_cursor<Iter> &x, size_t i = 0 ) : cursor(&x), index(i) {}
+
+    reference operator*() const { return cursor->at( index ); }
+
+    reference operator[]( size_t k ) const { return cursor->at( index + k ); }
+
+    forward_indexer& operator++() {
+        ++index;
+        return *this;
+    }
+
+    forward_indexer operator++(int) {
+        forward_indexer tmp = *this;
+        ++index;
+        return tmp;
+    }
+
+    // only the index moves, the cursor catches up on the next read
+    forward_indexer operator+( size_t k ) const {
+        return forward_indexer( *cursor, index + k );
+    }
+
+    bool operator==(const forward_indexer<Iter>& other) const {
+        return index == other.index;
+    }
+
+    bool operator!=(const forward_indexer<Iter>& other) const {
+        return index != other.index;
+    }
+
+    forward_cursor<Iter>    *cursor;
+    size_t                  index;
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    The same values copied into every sequence container the benchmarks compare:
+    the standard containers, and our own linked lists with and without a node pool.
+*/
+template<typename T>
+struct sequence_containers {
+
+    sequence_containers( const T *first, const T *last ) :
+                            dataVector( first, last ),
+                            dataDeque( first, last ),
+                            dataList( first, last ),
+                            dataForwardList( first, last ) {
+        for ( ; first != last; ++first) {
+            dataSingleList.push_back( *first );
+            dataPooledSingleList.push_back( *first );
+            dataDoubleList.push_back( *first );
+            dataPooledDoubleList.push_back( *first );
+        }
+    }
+
+    std::vector<T>              dataVector;
+    std::deque<T>               dataDeque;
+    std::list<T>                dataList;
+    std::forward_list<T>        dataForwardList;
+    SingleLinkList<T>           dataSingleList;
+    PooledSingleLinkList<T>     dataPooledSingleList;
+    DoubleLinkList<T>           dataDoubleList;
+    PooledDoubleLinkList<T>     dataPooledDoubleList;
+};
+
+/******************************************************************************/
+/******************************************************************************/
 
 #endif /* benchmark_containers_h */
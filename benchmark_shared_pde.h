@@ -243,5 +243,37 @@ T laplace_initial_conditions2( T *dest, int rows, int cols ) {
     return laplace_initial_condition_set( dest, rows, cols, values );
 }
 
+/******************************************************************************/
+
+// 3D grid of planes*rows*cols, with fixed values on the 6 faces and 0 inside
+// front, back, top, left, bottom, right
+template <typename T>
+T laplace_initial_condition_set3D( T *dest, int planes, int rows, int cols, const T values[6] ) {
+    const size_t planeStep = size_t(rows) * cols;
+
+    T average = (values[0] + values[1] + values[2] + values[3] + values[4] + values[5]) / 6;
+    std::fill( dest, dest+planes*planeStep, T(0) );    // initial condition = black, shows worst case
+    
+    for (int z = 1; z < (planes-1); ++z) {
+        T *plane = dest + z*planeStep;
+        fill_step( plane, rows, cols, values[3] );  // left
+        fill_step( plane+cols-1, rows, cols, values[5] );   // right
+        fill_step( plane+(rows-1)*cols, cols, 1, values[4] );   // bottom
+        fill_step( plane, cols, 1, values[2] ); // top
+    }
+    std::fill( dest, dest+planeStep, values[0] );    // front
+    std::fill( dest+(planes-1)*planeStep, dest+planes*planeStep, values[1] );    // back
+    
+    return average;
+}
+
+/******************************************************************************/
+
+template <typename T>
+T laplace_initial_conditions3D( T *dest, int planes, int rows, int cols ) {
+    T values[6] = { 50, 150, 20, 80, 200, 100 }; // front, back, top, left, bottom, right
+    return laplace_initial_condition_set3D( dest, planes, rows, cols, values );
+}
+
 /******************************************************************************/
 /******************************************************************************/
@@ -0,0 +1,128 @@
+/*
+    Copyright 2026 CppPerformanceBenchmarks contributors
+    Distributed under the MIT License (see accompanying file LICENSE_1_0_0.txt
+    or a copy at http://stlab.adobe.com/licenses.html )
+
+    Shared source file for threaded tests, used by several benchmarks
+
+    The threads are started once and reused, so timed loops measure the work
+    and synchronization, not thread creation.
+    Threaded tests should use the wall clock timer from benchmark_timer.h.
+*/
+
+/******************************************************************************/
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+namespace benchmark {
+
+/******************************************************************************/
+
+inline int hardware_threads() {
+    unsigned count = std::thread::hardware_concurrency();
+    return (count > 0) ? int(count) : 1;
+}
+
+/******************************************************************************/
+
+class thread_pool {
+public:
+    explicit thread_pool( int count = hardware_threads() ) :
+        active(0), remaining(0), generation(0), quitting(false) {
+        if (count < 1)
+            count = 1;
+        for (int i = 0; i < count; ++i)
+            workers.emplace_back( [this,i] { worker_loop(i); } );
+    }
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            quitting = true;
+            generation++;
+        }
+        wake.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    int size() const { return int(workers.size()); }
+
+    // Run task(index) for index in [0,count), one index per thread, and wait for all of them.
+    // count must not exceed size(), so all the tasks are running at the same time
+    //    (needed by tests where threads wait on each other).
+    void run( int count, std::function<void(int)> task ) {
+        if (count > size())
+            count = size();
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+            job = task;
+            active = count;
+            remaining = count;
+            generation++;
+        }
+        wake.notify_all();
+        std::unique_lock<std::mutex> lock( mutex );
+        done.wait( lock, [this] { return remaining == 0; } );
+        job = nullptr;
+    }
+
+    // Run task(index) for index in [0,count), handing out indices as threads become free,
+    //    and wait for all of them.
+    void parallel_for( int count, std::function<void(int)> task ) {
+        std::atomic<int> next( 0 );
+        run( std::min( count, size() ), [&]( int ) {
+            int index;
+            while ((index = next.fetch_add(1)) < count)
+                task( index );
+        } );
+    }
+
+private:
+    void worker_loop( int index ) {
+        unsigned seen = 0;
+        for (;;) {
+            std::function<void(int)> task;
+            {
+                std::unique_lock<std::mutex> lock( mutex );
+                wake.wait( lock, [&] { return generation != seen; } );
+                seen = generation;
+                if (quitting)
+                    return;
+                if (index >= active)
+                    continue;
+                task = job;
+            }
+
+            task( index );
+
+            {
+                std::lock_guard<std::mutex> lock( mutex );
+                remaining--;
+            }
+            done.notify_all();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::function<void(int)> job;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    int active;
+    int remaining;
+    unsigned generation;
+    bool quitting;
+};
+
+/******************************************************************************/
+
+}    // end namespace benchmark
+
+/******************************************************************************/
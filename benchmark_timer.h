@@ -27,3 +27,22 @@ double timer() {
 }
 
 /******************************************************************************/
+
+#ifdef __cplusplus
+#include <chrono>
+
+/*  wall clock timer functions
+    clock() only counts CPU time used by this process, so it misses time spent
+    waiting on devices, and counts every thread's time when running threaded tests.
+*/
+std::chrono::steady_clock::time_point start_wall_time;
+
+void start_wall_timer() { start_wall_time = std::chrono::steady_clock::now(); }
+
+double wall_timer() {
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_wall_time;
+  return elapsed.count();
+}
+#endif
+
+/******************************************************************************/
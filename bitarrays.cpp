@@ -21,6 +21,11 @@ Assumptions:
     4) Recognition of byte/word setting loops and converting to memset calls will help some operations.
  
     5) std::bitset operations should be well optimized.
+    
+    6) Counting the bits in large bitmaps should use hardware population count or be vectorized,
+        and combine the logic ops and the count into one pass over the data.
+    
+    7) Rank and select queries on a bitmap can be answered in constant time with a small index.
 
 
 NOTE: This sort of bitarray pattern occurs in std::vector<bool>, std::bitset,
@@ -28,8 +33,9 @@ NOTE: This sort of bitarray pattern occurs in std::vector<bool>, std::bitset,
         simulation systems, and other odd places.
 
 
-TODO - use pseudo-random values for bit counting tests.
-TODO - unify the tests for different word sizes
+NOTE: Bitmap indexes in databases and search engines evaluate filters by combining
+        large bitmaps, then counting or ranking the result.
+        The bulk bitmap tests use pseudo-random and sparse data, and one set of templates for all word sizes.
 
 */
 
@@ -41,8 +47,13 @@ TODO - unify the tests for different word sizes
 #include <time.h>
 #include <stdlib.h>
 #include <math.h>
+#include <algorithm>
+#include <deque>
+#include <string>
+#include <vector>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
+#include "benchmark_algorithms.h"
 #include <bitset>
 
 /******************************************************************************/
@@ -67,6 +78,9 @@ int init_value = 39;    // 0x00100111 = 4 bits
 
 typedef std::bitset<BITSIZE-6> testBitset;
 
+
+std::deque<std::string> gLabels;
+
 /******************************************************************************/
 
 #include "benchmark_shared_tests.h"
@@ -1864,6 +1878,510 @@ void test_countbitsStdLoop(testBitset &first, const char *label) {
 /******************************************************************************/
 /******************************************************************************/
 
+/*
+    Bulk bitmap kernels
+    These work on whole words of any unsigned type, so one set of templates covers uint8_t through uint64_t.
+*/
+
+// parallel bit count that works for any unsigned word size
+template<typename T>
+inline size_t popcount_swar( T value ) {
+    const T m1 = T( T(~T(0)) / 3 );             // 0x55...
+    const T m2 = T( T(~T(0)) / 15 * 3 );        // 0x33...
+    const T m4 = T( T(~T(0)) / 255 * 15 );      // 0x0F...
+    const T h01 = T( T(~T(0)) / 255 );          // 0x01...
+    value = T( value - ((value >> 1) & m1) );
+    value = T( (value & m2) + ((value >> 2) & m2) );
+    value = T( (value + (value >> 4)) & m4 );
+    return size_t( T(value * h01) >> ((sizeof(T) - 1) * 8) );
+}
+
+/******************************************************************************/
+
+// std::bitset::count becomes a single popcnt instruction when the target has one, otherwise a table or SWAR count
+template<typename T>
+inline size_t popcount_bitset( T value ) {
+    return std::bitset<64>( (unsigned long long) value ).count();
+}
+
+/******************************************************************************/
+
+// the bits below the lowest set bit, counted
+inline size_t count_trailing_zeros( uint64_t value ) {
+    return popcount_bitset( uint64_t( (value & (~value + 1)) - 1 ) );
+}
+
+/******************************************************************************/
+
+template<typename T>
+size_t count_words_swar( const T *table, const size_t words ) {
+    size_t result = 0;
+    for (size_t j = 0; j < words; ++j)
+        result += popcount_swar( table[j] );
+    return result;
+}
+
+/******************************************************************************/
+
+template<typename T>
+size_t count_words_bitset( const T *table, const size_t words ) {
+    size_t result = 0;
+    for (size_t j = 0; j < words; ++j)
+        result += popcount_bitset( table[j] );
+    return result;
+}
+
+/******************************************************************************/
+
+// full adder on each bit position: low gets the sum bits, high gets the carry bits
+template<typename T>
+inline void carry_save_add( T &high, T &low, const T a, const T b, const T c ) {
+    const T u = T( a ^ b );
+    high = T( (a & b) | (u & c) );
+    low = T( u ^ c );
+}
+
+// Harley-Seal: a tree of carry save adders reduces 16 words to one word of 16s,
+// so we only need one population count per 16 words
+template<typename T>
+size_t count_words_harley_seal( const T *table, const size_t words ) {
+    T ones = 0, twos = 0, fours = 0, eights = 0, sixteens;
+    T twosA, twosB, foursA, foursB, eightsA, eightsB;
+    size_t total = 0;
+    size_t j;
+
+    for (j = 0; j < (words & ~size_t(15)); j += 16) {
+        const T *v = table + j;
+        carry_save_add( twosA, ones, ones, v[0], v[1] );
+        carry_save_add( twosB, ones, ones, v[2], v[3] );
+        carry_save_add( foursA, twos, twos, twosA, twosB );
+        carry_save_add( twosA, ones, ones, v[4], v[5] );
+        carry_save_add( twosB, ones, ones, v[6], v[7] );
+        carry_save_add( foursB, twos, twos, twosA, twosB );
+        carry_save_add( eightsA, fours, fours, foursA, foursB );
+        carry_save_add( twosA, ones, ones, v[8], v[9] );
+        carry_save_add( twosB, ones, ones, v[10], v[11] );
+        carry_save_add( foursA, twos, twos, twosA, twosB );
+        carry_save_add( twosA, ones, ones, v[12], v[13] );
+        carry_save_add( twosB, ones, ones, v[14], v[15] );
+        carry_save_add( foursB, twos, twos, twosA, twosB );
+        carry_save_add( eightsB, fours, fours, foursA, foursB );
+        carry_save_add( sixteens, eights, eights, eightsA, eightsB );
+        total += popcount_bitset( sixteens );
+    }
+
+    total = 16 * total + 8 * popcount_bitset( eights ) + 4 * popcount_bitset( fours )
+            + 2 * popcount_bitset( twos ) + popcount_bitset( ones );
+
+    for ( ; j < words; ++j)
+        total += popcount_bitset( table[j] );
+
+    return total;
+}
+
+/******************************************************************************/
+
+template<typename T>
+void bitmap_and( T *dest, const T *a, const T *b, const size_t words ) {
+    for (size_t j = 0; j < words; ++j)
+        dest[j] = T( a[j] & b[j] );
+}
+
+/******************************************************************************/
+
+template<typename T>
+void bitmap_andnot( T *dest, const T *a, const T *b, const size_t words ) {
+    for (size_t j = 0; j < words; ++j)
+        dest[j] = T( a[j] & ~b[j] );
+}
+
+/******************************************************************************/
+
+// filter "a and b and not c", one pass for each operation, then count the result
+template<typename T>
+size_t filter_separate( T *dest, const T *a, const T *b, const T *c, const size_t words ) {
+    bitmap_and( dest, a, b, words );
+    bitmap_andnot( dest, dest, c, words );
+    return count_words_bitset( dest, words );
+}
+
+/******************************************************************************/
+
+// same filter, counting each word as it is stored
+template<typename T>
+size_t filter_fused( T *dest, const T *a, const T *b, const T *c, const size_t words ) {
+    size_t result = 0;
+    for (size_t j = 0; j < words; ++j) {
+        T value = T( a[j] & b[j] & ~c[j] );
+        dest[j] = value;
+        result += popcount_bitset( value );
+    }
+    return result;
+}
+
+/******************************************************************************/
+
+// same filter, counting with the portable parallel bit count so the whole loop can be vectorized
+template<typename T>
+size_t filter_fused_swar( T *dest, const T *a, const T *b, const T *c, const size_t words ) {
+    size_t result = 0;
+    for (size_t j = 0; j < words; ++j) {
+        T value = T( a[j] & b[j] & ~c[j] );
+        dest[j] = value;
+        result += popcount_swar( value );
+    }
+    return result;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Rank and select index over a bitmap of 64 bit words
+        rank(pos) = number of set bits before pos
+        select(k) = position of the k-th set bit, counting from zero
+
+    Counts are kept for each 512 bit block as a pair of words (Vigna's rank9):
+    the absolute count before the block, then seven 9 bit counts relative to the start of the block.
+    So rank is two table reads and one population count.
+
+    Select uses a sampled position for every 512th set bit to bound the search over blocks,
+    the relative counts to find the word, then finds the bit inside the word.
+*/
+
+// position of the r-th set bit inside a word
+inline size_t select_in_word( uint64_t value, size_t r ) {
+    // skip whole bytes, then clear the lowest set bits
+    size_t shift = 0;
+    for (;;) {
+        size_t byte_count = popcount_bitset( uint8_t(value) );
+        if (r < byte_count)
+            break;
+        r -= byte_count;
+        value >>= 8;
+        shift += 8;
+    }
+    while (r--)
+        value &= value - 1;
+    return shift + count_trailing_zeros( value );
+}
+
+/******************************************************************************/
+
+struct rank_select_index {
+
+    static const size_t kBlockWords = 8;
+    static const size_t kSampleRate = 512;
+
+    void build( const uint64_t *table, const size_t wordCount ) {
+        bits = table;
+        words = wordCount;
+        blocks = (words + kBlockWords - 1) / kBlockWords;
+        counts.assign( 2*blocks + 2, 0 );
+        samples.clear();
+
+        size_t total = 0;
+        size_t nextSample = 0;
+        for (size_t block = 0; block < blocks; ++block) {
+            uint64_t relative = 0;
+            size_t inBlock = 0;
+            for (size_t w = 0; w < kBlockWords; ++w) {
+                if (w > 0)
+                    relative |= uint64_t(inBlock) << (9*(w-1));
+                size_t index = block*kBlockWords + w;
+                if (index < words)
+                    inBlock += popcount_bitset( bits[index] );
+            }
+            counts[2*block] = total;
+            counts[2*block+1] = relative;
+            total += inBlock;
+            while (nextSample < total) {
+                samples.push_back( block );
+                nextSample += kSampleRate;
+            }
+        }
+
+        // sentinels: the end of the bitmap
+        counts[2*blocks] = total;
+        samples.push_back( blocks );
+        ones = total;
+    }
+
+    size_t rank( const size_t pos ) const {
+        const size_t word = pos / 64;
+        const size_t block = word / kBlockWords;
+        // (word - 1) wraps around for the first word in a block, and the shift picks up the unused top bit
+        const uint64_t t = uint64_t(word % kBlockWords) - 1;
+        const size_t relative = size_t( (counts[2*block+1] >> ((t + ((t >> 60) & 8)) * 9)) & 0x1FF );
+        const uint64_t mask = (uint64_t(1) << (pos % 64)) - 1;
+        return size_t( counts[2*block] ) + relative + popcount_bitset( bits[word] & mask );
+    }
+
+    // only uses the absolute counts, then counts the words before pos inside the block
+    size_t rank_scan( const size_t pos ) const {
+        const size_t word = pos / 64;
+        size_t result = size_t( counts[2*(word / kBlockWords)] );
+        for (size_t w = word & ~(kBlockWords - 1); w < word; ++w)
+            result += popcount_bitset( bits[w] );
+        const uint64_t mask = (uint64_t(1) << (pos % 64)) - 1;
+        return result + popcount_bitset( bits[word] & mask );
+    }
+
+    size_t select( const size_t k ) const {
+        const size_t sample = k / kSampleRate;
+        return select_in_blocks( k, samples[sample], samples[sample+1] );
+    }
+
+    // binary search over all the blocks, without the samples
+    size_t select_search( const size_t k ) const {
+        return select_in_blocks( k, 0, blocks - 1 );
+    }
+
+    // the answer is in the last block in [low, high] that starts with no more than k set bits
+    size_t select_in_blocks( const size_t k, size_t low, size_t high ) const {
+        while (low < high) {
+            size_t middle = (low + high + 1) / 2;
+            if (counts[2*middle] <= k)
+                low = middle;
+            else
+                high = middle - 1;
+        }
+
+        size_t remaining = k - size_t( counts[2*low] );
+        const uint64_t relative = counts[2*low+1];
+        size_t word = 0;
+        size_t before = 0;
+        for (size_t w = 1; w < kBlockWords; ++w) {
+            size_t start = size_t( (relative >> (9*(w-1))) & 0x1FF );
+            if (start > remaining)
+                break;
+            word = w;
+            before = start;
+        }
+
+        const size_t index = low*kBlockWords + word;
+        return 64*index + select_in_word( bits[index], remaining - before );
+    }
+
+    const uint64_t          *bits = NULL;
+    size_t                  words = 0;
+    size_t                  blocks = 0;
+    size_t                  ones = 0;
+    std::vector<uint64_t>   counts;
+    std::vector<size_t>     samples;
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
+template<typename T>
+void fill_bitmap_random( T *table, const size_t words ) {
+    for (size_t j = 0; j < words; ++j)
+        table[j] = T( crand64() );
+}
+
+/******************************************************************************/
+
+// about one bit in 64 set, at random positions
+template<typename T>
+void fill_bitmap_sparse( T *table, const size_t words ) {
+    const size_t wordBits = 8*sizeof(T);
+    const size_t bits = words * wordBits;
+    std::fill( table, table + words, T(0) );
+    for (size_t k = 0; k < bits / 64; ++k) {
+        size_t pos = size_t( uint64_t(crand64()) % bits );
+        table[ pos / wordBits ] |= T( T(1) << (pos % wordBits) );
+    }
+}
+
+/******************************************************************************/
+
+template <typename T, typename Counter>
+void test_bulk_count( const T *table, const size_t words, const size_t expected, const int count_iterations,
+                    Counter counter, const std::string &label ) {
+    int i;
+    size_t result = 0;
+
+    // the data doesn't change, so keep the compiler from moving the calculation out of the loop
+    const T * volatile source = table;
+
+    start_timer();
+
+    for(i = 0; i < count_iterations; ++i) {
+        result += counter( source, words );
+    }
+
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+
+    if (result != expected * count_iterations)
+        printf("test %s failed, got %zu bits instead of %zu\n", label.c_str(), result / count_iterations, expected);
+}
+
+/******************************************************************************/
+
+template <typename T, typename Filter>
+void test_bulk_filter( T *dest, const T *a, const T *b, const T *c, const size_t words, const size_t expected,
+                    const int filter_iterations, Filter filter, const std::string &label ) {
+    int i;
+    size_t result = 0;
+
+    // the data doesn't change, so keep the compiler from moving the calculation out of the loop
+    const T * volatile source = a;
+
+    std::fill( dest, dest + words, T(0) );
+
+    start_timer();
+
+    for(i = 0; i < filter_iterations; ++i) {
+        result += filter( dest, source, b, c, words );
+    }
+
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+
+    if (result != expected * filter_iterations)
+        printf("test %s failed, got %zu bits instead of %zu\n", label.c_str(), result / filter_iterations, expected);
+    else if (CountBitsShift( dest, 0, words*8*sizeof(T) ) != expected)
+        printf("test %s failed, stored bitmap does not match the count\n", label.c_str() );
+}
+
+/******************************************************************************/
+
+// sizes in bits, well past BITSIZE: inside L2 cache, then past most L3 caches
+const size_t bulk_bitmap_bits[] = { size_t(1) << 20, size_t(1) << 26 };
+
+template <typename T>
+void TestBulkBitmaps( const char *typeName ) {
+    std::string name( typeName );
+
+    for (size_t bits : bulk_bitmap_bits) {
+        const size_t words = bits / (8*sizeof(T));
+        const int bulk_iterations = int( std::max( size_t(1), (size_t(iterations) * BITSIZE) / bits ) );
+
+        std::vector<T> a( words ), b( words ), c( words ), dest( words );
+
+        for (int sparse = 0; sparse < 2; ++sparse) {
+            scrand( init_value + 50 + sparse );
+            if (sparse)
+                fill_bitmap_sparse( a.data(), words );
+            else
+                fill_bitmap_random( a.data(), words );
+            fill_bitmap_random( b.data(), words );
+            fill_bitmap_random( c.data(), words );
+
+            // expected values come from the bit at a time counter
+            const size_t expected = CountBitsShift( a.data(), 0, bits );
+            for (size_t j = 0; j < words; ++j)
+                dest[j] = T( a[j] & b[j] & ~c[j] );
+            const size_t filterExpected = CountBitsShift( dest.data(), 0, bits );
+
+            std::string prefix = name + " bitmap ";
+            test_bulk_count( a.data(), words, expected, bulk_iterations, count_words_swar<T>, prefix + "count swar" );
+            test_bulk_count( a.data(), words, expected, bulk_iterations, count_words_bitset<T>, prefix + "count std::bitset" );
+            test_bulk_count( a.data(), words, expected, bulk_iterations, count_words_harley_seal<T>, prefix + "count Harley-Seal" );
+
+            test_bulk_filter( dest.data(), a.data(), b.data(), c.data(), words, filterExpected, bulk_iterations, filter_separate<T>, prefix + "filter separate passes" );
+            test_bulk_filter( dest.data(), a.data(), b.data(), c.data(), words, filterExpected, bulk_iterations, filter_fused<T>, prefix + "filter fused" );
+            test_bulk_filter( dest.data(), a.data(), b.data(), c.data(), words, filterExpected, bulk_iterations, filter_fused_swar<T>, prefix + "filter fused swar" );
+
+            std::string title = name + " bulk bitmaps, " + std::to_string( bits >> 20 ) + "M bits, " + (sparse ? "sparse" : "random");
+            summarize( title.c_str(), bits, bulk_iterations, kDontShowGMeans, kDontShowPenalty );
+        }
+    }
+}
+
+/******************************************************************************/
+
+template <typename Query>
+void test_bitmap_queries( const size_t *queries, const size_t count, const size_t expected, const int query_iterations,
+                        Query query, const char *label ) {
+    int i;
+    size_t result = 0;
+
+    // the queries don't change, so keep the compiler from moving the calculation out of the loop
+    const size_t * volatile source = queries;
+
+    start_timer();
+
+    for(i = 0; i < query_iterations; ++i) {
+        const size_t *list = source;
+        for (size_t j = 0; j < count; ++j)
+            result += query( list[j] );
+    }
+
+    record_result( timer(), label );
+
+    if (result != expected * query_iterations)
+        printf("test %s failed, got %zu instead of %zu\n", label, result / query_iterations, expected);
+}
+
+/******************************************************************************/
+
+void TestRankSelect() {
+    const size_t kQueries = 1 << 16;
+    const int query_iterations = std::max( 1, iterations / 4000 );
+
+    for (size_t bits : bulk_bitmap_bits) {
+        const size_t words = bits / 64;
+        std::vector<uint64_t> table( words );
+
+        for (int sparse = 0; sparse < 2; ++sparse) {
+            scrand( init_value + 60 + sparse );
+            if (sparse)
+                fill_bitmap_sparse( table.data(), words );
+            else
+                fill_bitmap_random( table.data(), words );
+
+            rank_select_index index;
+            index.build( table.data(), words );
+
+            // reference: a count before every word
+            std::vector<size_t> prefix( words + 1, 0 );
+            for (size_t j = 0; j < words; ++j)
+                prefix[j+1] = prefix[j] + size_t( CountBitsShift( &table[j], 0, 64 ) );
+            if (prefix[words] != index.ones)
+                printf("test rank/select index build failed, got %zu bits instead of %zu\n", index.ones, prefix[words]);
+
+            std::vector<size_t> positions( kQueries ), ranks( kQueries );
+            size_t rankExpected = 0, selectExpected = 0;
+            for (size_t q = 0; q < kQueries; ++q) {
+                size_t pos = size_t( uint64_t(crand64()) % bits );
+                positions[q] = pos;
+                rankExpected += prefix[pos / 64] + CountBitsShift( &table[pos / 64], 0, pos % 64 );
+
+                size_t k = size_t( uint64_t(crand64()) % index.ones );
+                ranks[q] = k;
+                size_t word = size_t( std::upper_bound( prefix.begin(), prefix.end(), k ) - prefix.begin() ) - 1;
+                size_t remaining = k - prefix[word];
+                size_t bit = 0;
+                for ( ; bit < 64; ++bit)
+                    if ((table[word] >> bit) & 1) {
+                        if (remaining == 0)
+                            break;
+                        --remaining;
+                    }
+                selectExpected += 64*word + bit;
+            }
+
+            test_bitmap_queries( positions.data(), kQueries, rankExpected, query_iterations,
+                                [&index]( size_t pos ) { return index.rank( pos ); }, "rank with block and word counts" );
+            test_bitmap_queries( positions.data(), kQueries, rankExpected, query_iterations,
+                                [&index]( size_t pos ) { return index.rank_scan( pos ); }, "rank with block counts and scan" );
+            test_bitmap_queries( ranks.data(), kQueries, selectExpected, query_iterations,
+                                [&index]( size_t k ) { return index.select( k ); }, "select with samples" );
+            test_bitmap_queries( ranks.data(), kQueries, selectExpected, query_iterations,
+                                [&index]( size_t k ) { return index.select_search( k ); }, "select with binary search" );
+
+            std::string title = "rank/select index, " + std::to_string( bits >> 20 ) + "M bits, " + (sparse ? "sparse" : "random");
+            summarize( title.c_str(), kQueries, query_iterations, kDontShowGMeans, kDontShowPenalty );
+        }
+    }
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 
 int main(int argc, char** argv) {
     
@@ -2170,6 +2688,15 @@ int main(int argc, char** argv) {
 
     summarize("std bitset", BITSIZE, iterations, kDontShowGMeans, kDontShowPenalty );
 
+
+// bulk bitmaps
+    TestBulkBitmaps<uint8_t>( "uint8_t" );
+    TestBulkBitmaps<uint16_t>( "uint16_t" );
+    TestBulkBitmaps<uint32_t>( "uint32_t" );
+    TestBulkBitmaps<uint64_t>( "uint64_t" );
+
+    TestRankSelect();
+
             
     return 0;
 }
@@ -11,6 +11,7 @@
 #include <stdexcept>
 #include <utility>
 #include <deque>
+#include <memory>
 
 /******************************************************************************/
 
@@ -23,6 +24,7 @@ struct DoubleLinkedNodeBase {
 
 struct PooledLinkNodeInfo {
     PooledLinkNodeInfo() : pool_index(-1) {}
+    bool in_use() const { return pool_index != size_t(-1); }
     size_t pool_index;
 };
 
@@ -248,13 +250,17 @@ struct DoubleLinkListBaseAllocator {
 /******************************************************************************/
 
 // less obvious, higher performance: allocate nodes in blocks, track unused nodes
+// the blocks are fixed size arrays, so algorithms that don't care about list order can walk them with plain pointers
 template<typename T>
 struct DoubleLinkListPoolAllocator {
 
-    typedef DoubleLinkedNodeBase<T>          node_base_type;
-    typedef DoubleLinkedPooledNode<T>        node_pooled_type;
-    typedef std::deque< node_pooled_type >   linked_pool_type;
-    typedef std::deque< size_t >             free_node_list_type;
+    typedef DoubleLinkedNodeBase<T>                 node_base_type;
+    typedef DoubleLinkedPooledNode<T>               node_pooled_type;
+    typedef std::unique_ptr< node_pooled_type[] >   node_block_type;
+    typedef std::deque< node_block_type >           linked_pool_type;
+    typedef std::deque< size_t >                    free_node_list_type;
+
+    DoubleLinkListPoolAllocator() : pool_size(0) {}
 
     node_base_type *allocate_node() {
         if (empty_slots.size() == 0)
@@ -263,35 +269,58 @@ struct DoubleLinkListPoolAllocator {
         size_t index = empty_slots.back();
         empty_slots.pop_back();
         
-        node_pool[index].pool_index = index;
-        node_base_type *node = static_cast<node_base_type *>( &(node_pool[index]) ); // cast up to base type
+        node_pooled_type &item = node_at(index);
+        item.pool_index = index;
+        node_base_type *node = static_cast<node_base_type *>( &item ); // cast up to base type
         return node;
     }
     
     void release_node(const node_base_type *node) {
         const node_pooled_type *old = static_cast<const node_pooled_type *>(node);    // cast down to our pooled type
         empty_slots.push_back(old->pool_index);
-        node_pool[old->pool_index].pool_index = size_t(-1);
+        node_at(old->pool_index).pool_index = size_t(-1);
     }
     
     void grow_node_pool() {
-        const size_t delta = std::max( size_t(20), size_t(4096)/sizeof(node_pooled_type) );
-        size_t old_size = node_pool.size();
-        size_t new_size = old_size + delta;
-        node_pool.resize( new_size );
+        size_t old_size = pool_size;
+        size_t new_size = old_size + block_size();
+        node_pool.push_back( node_block_type( new node_pooled_type[ block_size() ] ) );
+        pool_size = new_size;
         
         // push in reverse so we'll use contiguous (lowest) values first
         for (size_t index = new_size; index > old_size; --index)
             empty_slots.push_back(index-1);
     }
     
-    const linked_pool_type &get_node_pool() const {
-        return node_pool;
+    static size_t block_size() {
+        return std::max( size_t(20), size_t(4096)/sizeof(node_pooled_type) );
+    }
+    
+    size_t size() const {
+        return pool_size;
+    }
+    
+    node_pooled_type &node_at(size_t index) {
+        return node_pool[ index / block_size() ][ index % block_size() ];
+    }
+    
+    const node_pooled_type &node_at(size_t index) const {
+        return node_pool[ index / block_size() ][ index % block_size() ];
+    }
+    
+    // func(first,last) is called once for each block of nodes, including the unused ones
+    template<typename Func>
+    void for_each_block(Func func) const {
+        for (const node_block_type &block : node_pool) {
+            const node_pooled_type *first = block.get();
+            func( first, first + block_size() );
+        }
     }
 
 private:
     free_node_list_type     empty_slots;
     linked_pool_type        node_pool;
+    size_t                  pool_size;
 };
 
 /******************************************************************************/
@@ -310,9 +339,9 @@ struct DoubleLinkListBase {
     typedef DoubleLinkedNodeBase<T>             node_type;
     typedef node_type *                         node_ptr;
     
-    DoubleLinkListBase() : start(NULL), finish(NULL), currentSize(0) {}
+    DoubleLinkListBase() : currentSize(0), start(NULL), finish(NULL) {}
     
-    DoubleLinkListBase( const DoubleLinkListBase &other ) : start(NULL), finish(NULL), currentSize(0)
+    DoubleLinkListBase( const DoubleLinkListBase &other ) : currentSize(0), start(NULL), finish(NULL)
     {
         // REVISIT - could optimize by preallocating size of other in pooled case
         iterator current = other.begin();
@@ -489,6 +518,20 @@ struct DoubleLinkListBase {
         --currentSize;
     }
     
+    // relink the nodes in reverse order, the values do not move
+    void reverse() {
+        node_ptr current = start;
+        
+        while (current != NULL) {
+            node_ptr next_item = current->next;
+            current->next = current->previous;
+            current->previous = next_item;
+            current = next_item;
+        }
+        
+        std::swap( start, finish );
+    }
+    
     void erase(iterator &first_item, iterator &end_item) {
         
         node_ptr next_item = NULL;
@@ -595,54 +638,47 @@ struct ConstDoubleLinkPoolIterator {
     typedef const T                              value_type;
     typedef const T*                             pointer;
     typedef const T&                             reference;
-    typedef DoubleLinkedNodeBase<T>              node_base_type;
-    typedef DoubleLinkedPooledNode<T>            node_pooled_type;
-    typedef std::deque< node_pooled_type >       linked_pool_type;
-    typedef typename linked_pool_type::const_iterator   pool_iter;
+    typedef DoubleLinkListPoolAllocator<T>       pool_type;
 
-    const linked_pool_type &node_pool;
-    pool_iter              current_iter;
+    const pool_type *node_pool;
+    size_t          current_index;
     
-    ConstDoubleLinkPoolIterator() {}
-    ConstDoubleLinkPoolIterator(const linked_pool_type &pool, pool_iter iter) :
-                            node_pool(pool), current_iter(iter) {}
+    ConstDoubleLinkPoolIterator() : node_pool(NULL), current_index(0) {}
+    ConstDoubleLinkPoolIterator(const pool_type &pool, size_t index) :
+                            node_pool(&pool), current_index(index) {}
     
-    reference operator*() const { return current_iter->value; }
+    reference operator*() const { return node_pool->node_at(current_index).value; }
     
-    reference operator->() const { return current_iter->value; }
+    reference operator->() const { return node_pool->node_at(current_index).value; }
     
     ConstDoubleLinkPoolIterator& operator++() {
-        ++current_iter;
-        while (current_iter != node_pool.end() && current_iter->pool_index == size_t(-1))        // skip unused entries
-            ++current_iter;
+        ++current_index;
+        while (current_index != node_pool->size() && node_pool->node_at(current_index).pool_index == size_t(-1))        // skip unused entries
+            ++current_index;
         return *this;
     }
     
     ConstDoubleLinkPoolIterator& operator--() {
-        --current_iter;
-        while (current_iter != node_pool.begin() && current_iter->pool_index == size_t(-1))        // skip unused entries
-            --current_iter;
+        --current_index;
+        while (current_index != 0 && node_pool->node_at(current_index).pool_index == size_t(-1))        // skip unused entries
+            --current_index;
         return *this;
     }
     
     ConstDoubleLinkPoolIterator operator++(int) {
         ConstDoubleLinkPoolIterator tmp = *this;
-        ++current_iter;
-        while (current_iter != node_pool.end() && current_iter->pool_index == size_t(-1))        // skip unused entries
-            ++current_iter;
+        ++*this;
         return tmp;
     }
     
     ConstDoubleLinkPoolIterator operator--(int) {
         ConstDoubleLinkPoolIterator tmp = *this;
-        --current_iter;
-        while (current_iter != node_pool.begin() && current_iter->pool_index == size_t(-1))        // skip unused entries
-            --current_iter;
+        --*this;
         return tmp;
     }
     
     bool operator==(const ConstDoubleLinkPoolIterator<T>& y) const {
-        return current_iter == y.current_iter;
+        return current_index == y.current_index;
     }
 
     bool operator!=(const ConstDoubleLinkPoolIterator<T>& other) const {
@@ -668,11 +704,18 @@ struct PooledDoubleLinkList : public DoubleLinkListBase<T, DoubleLinkListPoolAll
     // Always const, because changing the data in the pool could be dangerous  (though I can see some situations where it might be useful)
     // No reverse, because this is unordered data
     pool_iter cubegin() {
-        return pool_iter(_parent::allocator_data.get_node_pool(), _parent::allocator_data.get_node_pool().begin());
+        return pool_iter(_parent::allocator_data, 0);
     }
     
     pool_iter cuend() {
-        return pool_iter(_parent::allocator_data.get_node_pool(), _parent::allocator_data.get_node_pool().end());
+        return pool_iter(_parent::allocator_data, _parent::allocator_data.size());
+    }
+    
+    // unordered blocks of nodes, for algorithms that don't care about list order
+    // func(first,last) gets pointers to pooled nodes, and unused nodes are not in_use()
+    template<typename Func>
+    void for_each_block(Func func) const {
+        _parent::allocator_data.for_each_block( func );
     }
 
 };
@@ -8,6 +8,7 @@
 #ifndef container_hashmap_h
 #define container_hashmap_h
 
+#include <cmath>
 #include <stdexcept>
 #include <utility>
 #include <deque>
@@ -16,21 +16,24 @@ Assumptions:
         "Best" performance depends a lot on instruction latencies and register availability.
 
     2) Compilers will recognize inefficient loop orders and reorder loops for better cache usage.
+
+    3) Compilers will generate code for kernels with a runtime size that is nearly as fast
+        as the code for kernels with a compile time size.
  
 
 
 
 
-TODO -
-    repeat edge values
-    2D with negative weights
-    3D convolution
-    3D as separable filters
+NOTE - the convolution engine tests cover arbitrary weights, edge modes, 3D and separable 3D,
+        tent filters, and negative weights in 2D.
 
-    1D and separable with arbitrary weights passed in   -- separate file? convolution_arbitrary.cpp
-    1D, 2D, 3D tent filters  -- separate file? convolution_tent.cpp
-        iterated tent filters
-    Difference of gaussians  -- separate file?
+NOTE - FFT convolution is compared to direct convolution for large kernels,
+        and the crossover radius depends on the machine, so it is measured and reported.
+
+TODO -
+    iterated tent filters
+    Difference of gaussians (only a small difference of tents is tested)
+    mixed radix FFT sizes, so FFT blocks don't have to be a power of 2
 
 */
 
@@ -43,6 +46,11 @@ TODO -
 #include <deque>
 #include <string>
 #include <memory>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <complex>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_typenames.h"
@@ -2202,6 +2210,1395 @@ void convolution2D_sep_opt4(const T *source, T *dest, int rows, int cols, int ro
     record_result( timer(), gLabels.back().c_str() );
 }
 
+/******************************************************************************/
+
+/*
+    General convolution engine
+    arbitrary weights and radius passed in at runtime
+    common radii get specialized code, where the kernel size is a compile time constant
+    1D, 2D and 3D, full kernels or separable passes
+    edges are handled instead of ignored
+    
+    Separable filters apply the same 1D kernel along each axis, rounding between passes.
+    Full kernels are (2*radius+1)^2 or (2*radius+1)^3 weights, stored [z][y][x].
+*/
+
+enum edgeMode { kEdgeZero, kEdgeRepeat, kEdgeMirror };
+
+static const char *edge_mode_name( edgeMode mode ) {
+    switch (mode) {
+        case kEdgeZero: return "zero";
+        case kEdgeRepeat: return "repeat";
+        default: return "mirror";
+    }
+}
+
+/******************************************************************************/
+
+// map an index outside [0,count) back inside, or return -1 if it reads zero
+inline int edge_index( int i, int count, edgeMode mode ) {
+    if (i >= 0 && i < count)
+        return i;
+    
+    switch (mode) {
+        case kEdgeZero:
+            return -1;
+        case kEdgeRepeat:
+            return (i < 0) ? 0 : (count-1);
+        case kEdgeMirror:
+        default:
+            // reflect around the edge value, then clamp if the kernel is wider than the data
+            if (i < 0)
+                i = -i;
+            if (i >= count)
+                i = 2*(count-1) - i;
+            return std::min( std::max( i, 0 ), count-1 );
+    }
+}
+
+/******************************************************************************/
+
+template <typename TS>
+struct conv_kernel {
+    int radius;
+    TS divisor;
+    std::vector<TS> weights;
+};
+
+/******************************************************************************/
+
+// 1D tent (triangle) filter, weights 1 2 .. radius+1 .. 2 1
+template <typename TS>
+conv_kernel<TS> make_tent_kernel( int radius ) {
+    conv_kernel<TS> result;
+    result.radius = radius;
+    result.divisor = TS( (radius+1)*(radius+1) );
+    for (int k = -radius; k <= radius; ++k)
+        result.weights.push_back( TS( radius + 1 - std::abs(k) ) );
+    return result;
+}
+
+/******************************************************************************/
+
+// full 2D or 3D kernel from the outer product of a 1D kernel with itself
+template <typename TS>
+conv_kernel<TS> make_outer_kernel( const conv_kernel<TS> &line, int dims ) {
+    const int taps = 2*line.radius+1;
+    const int zTaps = (dims == 3) ? taps : 1;
+    conv_kernel<TS> result;
+    result.radius = line.radius;
+    result.divisor = (dims == 3) ? TS(line.divisor*line.divisor*line.divisor) : TS(line.divisor*line.divisor);
+    for (int z = 0; z < zTaps; ++z)
+        for (int y = 0; y < taps; ++y)
+            for (int x = 0; x < taps; ++x)
+                result.weights.push_back( TS( ((dims == 3) ? line.weights[z] : TS(1)) * line.weights[y] * line.weights[x] ) );
+    return result;
+}
+
+/******************************************************************************/
+
+// 2D difference of tents, a cheap stand-in for a difference of gaussians
+// narrow*scale - wide, so it has negative weights
+template <typename TS>
+conv_kernel<TS> make_difference_kernel( const conv_kernel<TS> &narrow, int scale, const conv_kernel<TS> &wide ) {
+    const int taps = 2*wide.radius+1;
+    const int narrowTaps = 2*narrow.radius+1;
+    const int offset = wide.radius - narrow.radius;
+    int divisor = 0;
+    conv_kernel<TS> result = wide;
+    for (int y = 0; y < taps; ++y)
+        for (int x = 0; x < taps; ++x) {
+            int value = -int(wide.weights[y*taps+x]);
+            if (y >= offset && y < offset+narrowTaps && x >= offset && x < offset+narrowTaps)
+                value += scale * int(narrow.weights[(y-offset)*narrowTaps + (x-offset)]);
+            result.weights[y*taps+x] = TS(value);
+            divisor += value;
+        }
+    result.divisor = TS(divisor);
+    return result;
+}
+
+/******************************************************************************/
+
+// Turning the sum into a result: integer types round to nearest, like the hard coded versions.
+// A runtime divisor would cost a divide per value, so we pick the cheapest exact form.
+// These are passed by value, so the compiler knows that stores to dest can't change them.
+template <typename T, typename TS>
+struct divide_result {
+    TS divisor, half;
+    T operator()( TS sum ) const { return T( (sum+half) / divisor ); }
+};
+
+// power of 2 divisor, adjusting negative values so we still round toward zero like divide_result
+template <typename T, typename TS>
+struct shift_result {
+    int shift;
+    TS half, mask;
+    T operator()( TS sum ) const {
+        TS value = sum + half;
+        if (std::numeric_limits<TS>::is_signed)
+            value += (value < TS(0)) ? mask : TS(0);
+        return T( value >> shift );
+    }
+};
+
+// floating point multiplies by the reciprocal
+template <typename T, typename TS>
+struct scale_result {
+    TS scale;
+    T operator()( TS sum ) const { return T( sum * scale ); }
+};
+
+template <typename T, typename TS, typename Func>
+inline void with_normalize( TS divisor, Func func, std::true_type /* floating point */ ) {
+    scale_result<T,TS> norm = { TS(1) / divisor };
+    func( norm );
+}
+
+template <typename T, typename TS, typename Func>
+inline void with_normalize( TS divisor, Func func, std::false_type /* integer */ ) {
+    const TS half = TS(divisor / TS(2));
+    int shift = 0;
+    while (shift < int(8*sizeof(TS)-2) && (TS(1) << shift) < divisor)
+        ++shift;
+    if (divisor > TS(0) && (TS(1) << shift) == divisor) {
+        shift_result<T,TS> norm = { shift, half, TS(divisor - TS(1)) };
+        func( norm );
+    } else {
+        divide_result<T,TS> norm = { divisor, half };
+        func( norm );
+    }
+}
+
+template <typename T, typename TS, typename Func>
+inline void with_normalize( TS divisor, Func func ) {
+    with_normalize<T,TS>( divisor, func, std::is_floating_point<TS>() );
+}
+
+/******************************************************************************/
+
+// call func with the radius as a compile time constant, for the radii we specialize
+// returns false for other radii, so the caller can use the runtime sized version
+template <typename Func>
+inline bool with_fixed_radius( int radius, Func func ) {
+    switch (radius) {
+        case 1: func( std::integral_constant<int,1>() ); return true;
+        case 2: func( std::integral_constant<int,2>() ); return true;
+        case 3: func( std::integral_constant<int,3>() ); return true;
+        case 4: func( std::integral_constant<int,4>() ); return true;
+        case 5: func( std::integral_constant<int,5>() ); return true;
+        case 7: func( std::integral_constant<int,7>() ); return true;
+        default: return false;
+    }
+}
+
+/******************************************************************************/
+
+// one output value, reading through edge_index
+template <typename T, typename TS, typename Normalize>
+inline T convolve_edge_value( const T *source, int x, int count, const TS *weights, int radius,
+                            Normalize norm, edgeMode mode ) {
+    TS sum = 0;
+    for (int k = -radius; k <= radius; ++k) {
+        int i = edge_index( x+k, count, mode );
+        if (i >= 0)
+            sum += weights[k+radius] * TS(source[i]);
+    }
+    return norm( sum );
+}
+
+/******************************************************************************/
+
+// copy a line into pad[0, count+2*radius), filling the edges
+template <typename T>
+inline void pad_line( const T *source, T *pad, int count, int radius, edgeMode mode ) {
+    for (int k = -radius; k < 0; ++k) {
+        int i = edge_index( k, count, mode );
+        pad[k+radius] = (i < 0) ? T(0) : source[i];
+    }
+    for (int k = 0; k < count; ++k)
+        pad[k+radius] = source[k];
+    for (int k = count; k < count+radius; ++k) {
+        int i = edge_index( k, count, mode );
+        pad[k+radius] = (i < 0) ? T(0) : source[i];
+    }
+}
+
+/******************************************************************************/
+
+// contiguous line, fixed radius: the tap loop unrolls and sums stay in registers
+template <typename T, typename TS, int RADIUS, typename Normalize>
+void convolve_line_fixed( const T *source, T *dest, int count, const TS *weights,
+                        Normalize norm, edgeMode mode ) {
+    const int taps = 2*RADIUS+1;
+    TS w[ taps ];
+    for (int k = 0; k < taps; ++k)
+        w[k] = weights[k];
+
+    int x = 0;
+    for ( ; x < RADIUS && x < count; ++x)
+        dest[x] = convolve_edge_value( source, x, count, weights, RADIUS, norm, mode );
+
+    for ( ; x < (count-RADIUS); ++x) {
+        TS sum = 0;
+        for (int k = 0; k < taps; ++k)
+            sum += w[k] * TS(source[x-RADIUS+k]);
+        dest[x] = norm( sum );
+    }
+
+    for ( ; x < count; ++x)
+        dest[x] = convolve_edge_value( source, x, count, weights, RADIUS, norm, mode );
+}
+
+/******************************************************************************/
+
+// contiguous line, runtime radius: taps outside, accumulating a strip of values
+template <typename T, typename TS, typename Normalize>
+void convolve_line_generic( const T *source, T *dest, int count, const TS *weights, int radius,
+                            Normalize norm, edgeMode mode, TS *acc, int strip ) {
+    const int taps = 2*radius+1;
+    int x = 0;
+    for ( ; x < radius && x < count; ++x)
+        dest[x] = convolve_edge_value( source, x, count, weights, radius, norm, mode );
+
+    while (x < (count-radius)) {
+        const int length = std::min( strip, count-radius-x );
+        const T *base = source + x - radius;
+        
+        for (int i = 0; i < length; ++i)
+            acc[i] = TS(0);
+        for (int k = 0; k < taps; ++k) {
+            const TS w = weights[k];
+            for (int i = 0; i < length; ++i)
+                acc[i] += w * TS(base[k+i]);
+        }
+        for (int i = 0; i < length; ++i)
+            dest[x+i] = norm( acc[i] );
+        
+        x += length;
+    }
+
+    for ( ; x < count; ++x)
+        dest[x] = convolve_edge_value( source, x, count, weights, radius, norm, mode );
+}
+
+/******************************************************************************/
+
+// across lines (columns of an image, or planes of a volume), fixed radius
+// each output line reads 2*RADIUS+1 input lines in one pass
+// lines outside the data get a zero weight, so the inner loop has no edge tests
+template <typename T, typename TS, int RADIUS, typename Normalize>
+void convolve_across_fixed( const T *source, T *dest, int lineCount, int lineLength, ptrdiff_t lineStep,
+                            const TS *weights, Normalize norm, edgeMode mode ) {
+    const int taps = 2*RADIUS+1;
+    
+    for (int y = 0; y < lineCount; ++y) {
+        const T *lines[ taps ];
+        TS w[ taps ];
+        for (int k = 0; k < taps; ++k) {
+            int j = edge_index( y+k-RADIUS, lineCount, mode );
+            lines[k] = source + ((j < 0) ? y : j) * lineStep;
+            w[k] = (j < 0) ? TS(0) : weights[k];
+        }
+        
+        T *out = dest + y*lineStep;
+        for (int x = 0; x < lineLength; ++x) {
+            TS sum = 0;
+            for (int k = 0; k < taps; ++k)
+                sum += w[k] * TS(lines[k][x]);
+            out[x] = norm( sum );
+        }
+    }
+}
+
+/******************************************************************************/
+
+// across lines, runtime radius, accumulating a strip of values one input line at a time
+template <typename T, typename TS, typename Normalize>
+void convolve_across_generic( const T *source, T *dest, int lineCount, int lineLength, ptrdiff_t lineStep,
+                            const TS *weights, int radius, Normalize norm, edgeMode mode,
+                            TS *acc, int strip ) {
+    for (int y = 0; y < lineCount; ++y) {
+        T *out = dest + y*lineStep;
+        
+        for (int x = 0; x < lineLength; x += strip) {
+            const int length = std::min( strip, lineLength-x );
+            
+            for (int i = 0; i < length; ++i)
+                acc[i] = TS(0);
+            for (int k = -radius; k <= radius; ++k) {
+                int j = edge_index( y+k, lineCount, mode );
+                if (j < 0)
+                    continue;
+                const TS w = weights[k+radius];
+                const T *line = source + j*lineStep + x;
+                for (int i = 0; i < length; ++i)
+                    acc[i] += w * TS(line[i]);
+            }
+            for (int i = 0; i < length; ++i)
+                out[x+i] = norm( acc[i] );
+        }
+    }
+}
+
+/******************************************************************************/
+
+// full 2D or 3D kernel
+// each source line is padded once per use, then the x taps run without edge tests
+// RADIUS == 0 means use the runtime radius
+template <typename T, typename TS, int RADIUS, typename Normalize>
+void convolve_full( const T *source, T *dest, int planes, int rows, int cols,
+                    ptrdiff_t rowStep, ptrdiff_t planeStep, bool volume,
+                    const TS *weights, int radius, Normalize norm, edgeMode mode,
+                    TS *acc, T *pad ) {
+    const int r = (RADIUS > 0) ? RADIUS : radius;
+    const int taps = 2*r+1;
+    const int rz = volume ? r : 0;
+
+    for (int z = 0; z < planes; ++z)
+        for (int y = 0; y < rows; ++y) {
+        
+            for (int x = 0; x < cols; ++x)
+                acc[x] = TS(0);
+            
+            for (int kz = -rz; kz <= rz; ++kz) {
+                int iz = edge_index( z+kz, planes, mode );
+                if (iz < 0)
+                    continue;
+                for (int ky = -r; ky <= r; ++ky) {
+                    int iy = edge_index( y+ky, rows, mode );
+                    if (iy < 0)
+                        continue;
+                    
+                    pad_line( source + iz*planeStep + iy*rowStep, pad, cols, r, mode );
+                    const TS *w = weights + ((kz+rz)*taps + (ky+r))*taps;
+                    
+                    for (int x = 0; x < cols; ++x) {
+                        TS sum = 0;
+                        for (int k = 0; k < taps; ++k)
+                            sum += w[k] * TS(pad[x+k]);
+                        acc[x] += sum;
+                    }
+                }
+            }
+            
+            T *out = dest + z*planeStep + y*rowStep;
+            for (int x = 0; x < cols; ++x)
+                out[x] = norm( acc[x] );
+        }
+}
+
+/******************************************************************************/
+
+template <typename T, typename TS>
+class convolution_engine {
+public:
+    // useFixed = false forces the runtime radius code, for comparison
+    convolution_engine( const conv_kernel<TS> &k, edgeMode m, bool useFixed = true ) :
+        kernel(k), mode(m), specialize(useFixed) {}
+    
+    // values near the edges that don't match the interior for constant input
+    int check_edge() const { return (mode == kEdgeZero) ? kernel.radius : 0; }
+
+    void filter1D( const T *source, T *dest, int count ) {
+        line_pass( source, dest, count );
+    }
+
+    void filter2D_separable( const T *source, T *dest, int rows, int cols, ptrdiff_t rowStep ) {
+        temp.resize( rows*rowStep );
+        for (int y = 0; y < rows; ++y)
+            line_pass( source + y*rowStep, &temp[0] + y*rowStep, cols );
+        across_pass( &temp[0], dest, rows, cols, rowStep );
+    }
+
+    void filter3D_separable( const T *source, T *dest, int planes, int rows, int cols,
+                            ptrdiff_t rowStep, ptrdiff_t planeStep ) {
+        temp.resize( planes*planeStep );
+        for (int z = 0; z < planes; ++z)
+            for (int y = 0; y < rows; ++y)
+                line_pass( source + z*planeStep + y*rowStep, dest + z*planeStep + y*rowStep, cols );
+        for (int z = 0; z < planes; ++z)
+            across_pass( dest + z*planeStep, &temp[0] + z*planeStep, rows, cols, rowStep );
+        // one row at a time, so we never touch the padding between rows
+        for (int y = 0; y < rows; ++y)
+            across_pass( &temp[0] + y*rowStep, dest + y*rowStep, planes, cols, planeStep );
+    }
+
+    void filter2D( const T *source, T *dest, int rows, int cols, ptrdiff_t rowStep ) {
+        full_pass( source, dest, 1, rows, cols, rowStep, 0, false );
+    }
+
+    void filter3D( const T *source, T *dest, int planes, int rows, int cols,
+                    ptrdiff_t rowStep, ptrdiff_t planeStep ) {
+        full_pass( source, dest, planes, rows, cols, rowStep, planeStep, true );
+    }
+
+private:
+    // small enough that the accumulators stay in L1 cache
+    static const int kStrip = 512;
+
+    void line_pass( const T *source, T *dest, int count ) {
+        const TS *w = &kernel.weights[0];
+        acc.resize( kStrip );
+        with_normalize<T,TS>( kernel.divisor, [&]( const auto &norm ) {
+            if (specialize && with_fixed_radius( kernel.radius, [&]( auto R ) {
+                    convolve_line_fixed<T,TS,decltype(R)::value>( source, dest, count, w, norm, mode );
+                } ))
+                return;
+            convolve_line_generic( source, dest, count, w, kernel.radius, norm, mode, &acc[0], kStrip );
+        } );
+    }
+
+    void across_pass( const T *source, T *dest, int lineCount, int lineLength, ptrdiff_t lineStep ) {
+        const TS *w = &kernel.weights[0];
+        acc.resize( kStrip );
+        with_normalize<T,TS>( kernel.divisor, [&]( const auto &norm ) {
+            if (specialize && with_fixed_radius( kernel.radius, [&]( auto R ) {
+                    convolve_across_fixed<T,TS,decltype(R)::value>( source, dest, lineCount, lineLength, lineStep,
+                                                                    w, norm, mode );
+                } ))
+                return;
+            convolve_across_generic( source, dest, lineCount, lineLength, lineStep,
+                                    w, kernel.radius, norm, mode, &acc[0], kStrip );
+        } );
+    }
+
+    void full_pass( const T *source, T *dest, int planes, int rows, int cols,
+                    ptrdiff_t rowStep, ptrdiff_t planeStep, bool volume ) {
+        const TS *w = &kernel.weights[0];
+        acc.resize( std::max( cols, int(kStrip) ) );
+        pad.resize( cols + 2*kernel.radius );
+        with_normalize<T,TS>( kernel.divisor, [&]( const auto &norm ) {
+            if (specialize && with_fixed_radius( kernel.radius, [&]( auto R ) {
+                    convolve_full<T,TS,decltype(R)::value>( source, dest, planes, rows, cols, rowStep, planeStep, volume,
+                                                            w, kernel.radius, norm, mode, &acc[0], &pad[0] );
+                } ))
+                return;
+            convolve_full<T,TS,0>( source, dest, planes, rows, cols, rowStep, planeStep, volume,
+                                    w, kernel.radius, norm, mode, &acc[0], &pad[0] );
+        } );
+    }
+
+    conv_kernel<TS> kernel;
+    edgeMode mode;
+    bool specialize;
+    std::vector<TS> acc;
+    std::vector<T> pad;
+    std::vector<T> temp;
+};
+
+/******************************************************************************/
+
+// straightforward version to check the engine against
+// zero radius on an axis means no filtering along that axis
+template <typename T, typename TS>
+void reference_filter( const T *source, T *dest, int planes, int rows, int cols,
+                        ptrdiff_t rowStep, ptrdiff_t planeStep,
+                        const TS *weights, int rz, int ry, int rx, TS divisor, edgeMode mode ) {
+    const bool isFloat = (T(2.9) > T(2.0));
+    const TS half = isFloat ? TS(0) : TS(divisor / TS(2));
+    
+    for (int z = 0; z < planes; ++z)
+        for (int y = 0; y < rows; ++y)
+            for (int x = 0; x < cols; ++x) {
+                TS sum = 0;
+                for (int kz = -rz; kz <= rz; ++kz)
+                    for (int ky = -ry; ky <= ry; ++ky)
+                        for (int kx = -rx; kx <= rx; ++kx) {
+                            int iz = edge_index( z+kz, planes, mode );
+                            int iy = edge_index( y+ky, rows, mode );
+                            int ix = edge_index( x+kx, cols, mode );
+                            if (iz < 0 || iy < 0 || ix < 0)
+                                continue;
+                            TS w = weights[ ((kz+rz)*(2*ry+1) + (ky+ry))*(2*rx+1) + (kx+rx) ];
+                            sum += w * TS(source[ iz*planeStep + iy*rowStep + ix ]);
+                        }
+                dest[ z*planeStep + y*rowStep + x ] = T( (sum+half) / divisor );
+            }
+}
+
+/******************************************************************************/
+
+template <typename T>
+bool volume_equal( const std::vector<T> &result, const std::vector<T> &expected, int planes, int rows, int cols,
+                    ptrdiff_t rowStep, ptrdiff_t planeStep ) {
+    for (int z = 0; z < planes; ++z)
+        for (int y = 0; y < rows; ++y)
+            for (int x = 0; x < cols; ++x) {
+                T a = result[ z*planeStep + y*rowStep + x ];
+                T b = expected[ z*planeStep + y*rowStep + x ];
+                if (!tolerance_equal<T>( a, b ))
+                    return false;
+            }
+    return true;
+}
+
+/******************************************************************************/
+
+// check every path of the engine against the reference, on small odd sizes with varying data
+template <typename T, typename TS>
+void verify_convolution_engine( const std::string &name ) {
+    const int planes = 7, rows = 9, cols = 11;
+    const ptrdiff_t rowStep = 13, planeStep = rows*rowStep + 5;
+    const int radii[] = { 1, 2, 3, 5, 7, 9 };
+    const edgeMode modes[] = { kEdgeZero, kEdgeRepeat, kEdgeMirror };
+    const size_t total = planes*planeStep;
+    
+    std::vector<T> source( total ), result( total ), expected( total ), temp1( total ), temp2( total );
+    for (size_t i = 0; i < total; ++i)
+        source[i] = T( (i*7 + 3) % 16 );
+    
+    std::vector< conv_kernel<TS> > kernels;
+    for (int r : radii)
+        kernels.push_back( make_tent_kernel<TS>( r ) );
+    if (std::numeric_limits<TS>::is_signed) {
+        conv_kernel<TS> negative = { 2, TS(7), { TS(-1), TS(2), TS(5), TS(2), TS(-1) } };
+        kernels.push_back( negative );
+    }
+
+    for (edgeMode mode : modes)
+    for (int fixed = 0; fixed < 2; ++fixed) {
+        const char *modeName = edge_mode_name( mode );
+        
+        for (const auto &kernel : kernels) {
+            convolution_engine<T,TS> engine( kernel, mode, fixed != 0 );
+            const TS *w = &kernel.weights[0];
+            const int r = kernel.radius;
+            
+            // 1D, including lines shorter than the kernel
+            for (int count : { 5, 41 }) {
+                std::fill( result.begin(), result.end(), T(0) );
+                std::fill( expected.begin(), expected.end(), T(0) );
+                engine.filter1D( &source[0], &result[0], count );
+                reference_filter( &source[0], &expected[0], 1, 1, count, 0, 0, w, 0, 0, r, kernel.divisor, mode );
+                if (!volume_equal( result, expected, 1, 1, count, 0, 0 ))
+                    printf("test %s convolution engine 1D radius %d %s edges failed verification\n", name.c_str(), r, modeName );
+            }
+            
+            // 2D separable
+            std::fill( result.begin(), result.end(), T(0) );
+            std::fill( expected.begin(), expected.end(), T(0) );
+            engine.filter2D_separable( &source[0], &result[0], rows, cols, rowStep );
+            reference_filter( &source[0], &temp1[0], 1, rows, cols, rowStep, 0, w, 0, 0, r, kernel.divisor, mode );
+            reference_filter( &temp1[0], &expected[0], 1, rows, cols, rowStep, 0, w, 0, r, 0, kernel.divisor, mode );
+            if (!volume_equal( result, expected, 1, rows, cols, rowStep, 0 ))
+                printf("test %s convolution engine 2D separable radius %d %s edges failed verification\n", name.c_str(), r, modeName );
+            
+            // 3D separable
+            std::fill( result.begin(), result.end(), T(0) );
+            std::fill( expected.begin(), expected.end(), T(0) );
+            engine.filter3D_separable( &source[0], &result[0], planes, rows, cols, rowStep, planeStep );
+            reference_filter( &source[0], &temp1[0], planes, rows, cols, rowStep, planeStep, w, 0, 0, r, kernel.divisor, mode );
+            reference_filter( &temp1[0], &temp2[0], planes, rows, cols, rowStep, planeStep, w, 0, r, 0, kernel.divisor, mode );
+            reference_filter( &temp2[0], &expected[0], planes, rows, cols, rowStep, planeStep, w, r, 0, 0, kernel.divisor, mode );
+            if (!volume_equal( result, expected, planes, rows, cols, rowStep, planeStep ))
+                printf("test %s convolution engine 3D separable radius %d %s edges failed verification\n", name.c_str(), r, modeName );
+            
+            // full kernels, kept small so integer sums can't overflow
+            if (r <= 3) {
+                conv_kernel<TS> full2D = make_outer_kernel( kernel, 2 );
+                convolution_engine<T,TS> engine2D( full2D, mode, fixed != 0 );
+                std::fill( result.begin(), result.end(), T(0) );
+                std::fill( expected.begin(), expected.end(), T(0) );
+                engine2D.filter2D( &source[0], &result[0], rows, cols, rowStep );
+                reference_filter( &source[0], &expected[0], 1, rows, cols, rowStep, 0, &full2D.weights[0], 0, r, r, full2D.divisor, mode );
+                if (!volume_equal( result, expected, 1, rows, cols, rowStep, 0 ))
+                    printf("test %s convolution engine 2D radius %d %s edges failed verification\n", name.c_str(), r, modeName );
+            }
+            
+            if (r <= 2) {
+                conv_kernel<TS> full3D = make_outer_kernel( kernel, 3 );
+                convolution_engine<T,TS> engine3D( full3D, mode, fixed != 0 );
+                std::fill( result.begin(), result.end(), T(0) );
+                std::fill( expected.begin(), expected.end(), T(0) );
+                engine3D.filter3D( &source[0], &result[0], planes, rows, cols, rowStep, planeStep );
+                reference_filter( &source[0], &expected[0], planes, rows, cols, rowStep, planeStep, &full3D.weights[0], r, r, r, full3D.divisor, mode );
+                if (!volume_equal( result, expected, planes, rows, cols, rowStep, planeStep ))
+                    printf("test %s convolution engine 3D radius %d %s edges failed verification\n", name.c_str(), r, modeName );
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+
+// volume used by the 3D tests, same number of values as the 2D tests
+const int VOLUME_PLANES = 200;
+const int VOLUME_ROWS = 150;
+const int VOLUME_COLS = 150;
+
+template <typename T>
+inline void check_add_3D(const int edge, const T* out,
+                        const int planes, const int rows, const int cols,
+                        const ptrdiff_t rowStep, const ptrdiff_t planeStep,
+                        const std::string &label) {
+    T sum = 0;
+    for (int z = edge; z < (planes-edge); ++z)
+        for (int y = edge; y < (rows-edge); ++y)
+            for (int x = edge; x < (cols-edge); ++x)
+                sum += out[(z*planeStep)+(y*rowStep)+x];
+    
+    T temp = (T)((planes-2*edge)*(rows-2*edge)*(cols-2*edge)) * (T)init_value;
+    if (!tolerance_equal<T>(sum,temp))
+        printf("test %s failed\n", label.c_str() );
+}
+
+/******************************************************************************/
+
+template <typename T, typename TS>
+void test_engine1D( const T *source, T *dest, int cols, convolution_engine<T,TS> &engine, const std::string &label ) {
+    start_timer();
+
+    for (int i = 0; i < iterations; ++i)
+        engine.filter1D( source, dest, cols );
+    
+    check_add_1D( engine.check_edge(), dest, cols, label );
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template <typename T, typename TS>
+void test_engine2D( const T *source, T *dest, int rows, int cols, int rowStep, bool separable,
+                    convolution_engine<T,TS> &engine, const std::string &label ) {
+    start_timer();
+
+    for (int i = 0; i < iterations; ++i) {
+        if (separable)
+            engine.filter2D_separable( source, dest, rows, cols, rowStep );
+        else
+            engine.filter2D( source, dest, rows, cols, rowStep );
+    }
+    
+    check_add_2D( engine.check_edge(), dest, rows, cols, rowStep, label );
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template <typename T, typename TS>
+void test_engine3D( const T *source, T *dest, bool separable,
+                    convolution_engine<T,TS> &engine, const std::string &label ) {
+    const int planes = VOLUME_PLANES, rows = VOLUME_ROWS, cols = VOLUME_COLS;
+    const ptrdiff_t rowStep = cols, planeStep = rows*cols;
+    
+    start_timer();
+
+    for (int i = 0; i < iterations; ++i) {
+        if (separable)
+            engine.filter3D_separable( source, dest, planes, rows, cols, rowStep, planeStep );
+        else
+            engine.filter3D( source, dest, planes, rows, cols, rowStep, planeStep );
+    }
+    
+    check_add_3D( engine.check_edge(), dest, planes, rows, cols, rowStep, planeStep, label );
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+// arbitrary kernels, across kernel sizes, compared to the hard coded versions above
+template <typename T, typename TS>
+void TestConvolutionEngine( const T *source, T *dest, const std::string &myTypeName )
+{
+    const int base_iterations = iterations;
+    const bool signedSums = std::numeric_limits<TS>::is_signed;
+    
+    verify_convolution_engine<T,TS>( myTypeName );
+    
+    const conv_kernel<TS> k13831 = { 2, TS(16), { TS(1), TS(3), TS(8), TS(3), TS(1) } };
+    const conv_kernel<TS> k15851 = { 1, TS(32), { TS(1), TS(5), TS(1), TS(5), TS(8), TS(5), TS(1), TS(5), TS(1) } };
+    const int lineRadii[] = { 1, 3, 4, 7, 12 };
+    char buffer[ 200 ];
+
+
+    iterations = base_iterations / 2;
+
+    convolution1D<T,TS>( source, dest, SIZE, myTypeName + " convolution engine 1D hard coded 1 3 8 3 1");
+    for (edgeMode mode : { kEdgeRepeat, kEdgeZero, kEdgeMirror }) {
+        convolution_engine<T,TS> engine( k13831, mode );
+        snprintf( buffer, sizeof(buffer), "%s convolution engine 1D 1 3 8 3 1 %s edges", myTypeName.c_str(), edge_mode_name(mode) );
+        test_engine1D( source, dest, SIZE, engine, buffer );
+    }
+    {
+        convolution_engine<T,TS> engine( k13831, kEdgeRepeat, false );
+        test_engine1D( source, dest, SIZE, engine, myTypeName + " convolution engine 1D 1 3 8 3 1 runtime radius" );
+    }
+    for (int r : lineRadii) {
+        convolution_engine<T,TS> engine( make_tent_kernel<TS>(r), kEdgeRepeat );
+        snprintf( buffer, sizeof(buffer), "%s convolution engine 1D tent radius %d", myTypeName.c_str(), r );
+        test_engine1D( source, dest, SIZE, engine, buffer );
+    }
+    
+    std::string temp1( myTypeName + " convolution engine 1D" );
+    summarize( temp1.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
+    iterations = base_iterations / 4;
+
+    convolution2D_sep<T,TS>( source, dest, HEIGHT, WIDTH, WIDTH, myTypeName + " convolution engine 2D separable hard coded 1 3 8 3 1");
+    for (edgeMode mode : { kEdgeRepeat, kEdgeZero, kEdgeMirror }) {
+        convolution_engine<T,TS> engine( k13831, mode );
+        snprintf( buffer, sizeof(buffer), "%s convolution engine 2D separable 1 3 8 3 1 %s edges", myTypeName.c_str(), edge_mode_name(mode) );
+        test_engine2D( source, dest, HEIGHT, WIDTH, WIDTH, true, engine, buffer );
+    }
+    {
+        convolution_engine<T,TS> engine( k13831, kEdgeRepeat, false );
+        test_engine2D( source, dest, HEIGHT, WIDTH, WIDTH, true, engine, myTypeName + " convolution engine 2D separable 1 3 8 3 1 runtime radius" );
+    }
+    for (int r : lineRadii) {
+        convolution_engine<T,TS> engine( make_tent_kernel<TS>(r), kEdgeRepeat );
+        snprintf( buffer, sizeof(buffer), "%s convolution engine 2D separable tent radius %d", myTypeName.c_str(), r );
+        test_engine2D( source, dest, HEIGHT, WIDTH, WIDTH, true, engine, buffer );
+    }
+    
+    std::string temp2( myTypeName + " convolution engine 2D separable" );
+    summarize( temp2.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
+    iterations = base_iterations / 4;
+
+    convolution2D<T,TS>( source, dest, HEIGHT, WIDTH, WIDTH, myTypeName + " convolution engine 2D hard coded 3x3");
+    {
+        convolution_engine<T,TS> engine( k15851, kEdgeRepeat );
+        test_engine2D( source, dest, HEIGHT, WIDTH, WIDTH, false, engine, myTypeName + " convolution engine 2D 3x3" );
+    }
+    {
+        convolution_engine<T,TS> engine( k15851, kEdgeRepeat, false );
+        test_engine2D( source, dest, HEIGHT, WIDTH, WIDTH, false, engine, myTypeName + " convolution engine 2D 3x3 runtime radius" );
+    }
+    for (int r : { 2, 3 }) {
+        convolution_engine<T,TS> engine( make_outer_kernel( make_tent_kernel<TS>(r), 2 ), kEdgeMirror );
+        snprintf( buffer, sizeof(buffer), "%s convolution engine 2D tent %dx%d", myTypeName.c_str(), 2*r+1, 2*r+1 );
+        test_engine2D( source, dest, HEIGHT, WIDTH, WIDTH, false, engine, buffer );
+    }
+    if (signedSums) {
+        const conv_kernel<TS> sharpen = { 1, TS(4), { TS(-1), TS(-1), TS(-1), TS(-1), TS(12), TS(-1), TS(-1), TS(-1), TS(-1) } };
+        convolution_engine<T,TS> engine( sharpen, kEdgeRepeat );
+        test_engine2D( source, dest, HEIGHT, WIDTH, WIDTH, false, engine, myTypeName + " convolution engine 2D 3x3 sharpen" );
+        
+        conv_kernel<TS> difference = make_difference_kernel( make_outer_kernel( make_tent_kernel<TS>(1), 2 ), 6,
+                                                             make_outer_kernel( make_tent_kernel<TS>(2), 2 ) );
+        convolution_engine<T,TS> engine2( difference, kEdgeRepeat );
+        test_engine2D( source, dest, HEIGHT, WIDTH, WIDTH, false, engine2, myTypeName + " convolution engine 2D 5x5 difference of tents" );
+    }
+    
+    std::string temp3( myTypeName + " convolution engine 2D" );
+    summarize( temp3.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
+    iterations = base_iterations / 8;
+
+    for (int r : { 1, 2, 4 }) {
+        convolution_engine<T,TS> engine( make_tent_kernel<TS>(r), kEdgeRepeat );
+        snprintf( buffer, sizeof(buffer), "%s convolution engine 3D separable tent radius %d", myTypeName.c_str(), r );
+        test_engine3D( source, dest, true, engine, buffer );
+    }
+    {
+        convolution_engine<T,TS> engine( make_tent_kernel<TS>(2), kEdgeRepeat, false );
+        test_engine3D( source, dest, true, engine, myTypeName + " convolution engine 3D separable tent radius 2 runtime radius" );
+    }
+    for (edgeMode mode : { kEdgeRepeat, kEdgeZero }) {
+        convolution_engine<T,TS> engine( make_outer_kernel( make_tent_kernel<TS>(1), 3 ), mode );
+        snprintf( buffer, sizeof(buffer), "%s convolution engine 3D tent 3x3x3 %s edges", myTypeName.c_str(), edge_mode_name(mode) );
+        test_engine3D( source, dest, false, engine, buffer );
+    }
+    {
+        convolution_engine<T,TS> engine( make_outer_kernel( make_tent_kernel<TS>(1), 3 ), kEdgeRepeat, false );
+        test_engine3D( source, dest, false, engine, myTypeName + " convolution engine 3D tent 3x3x3 runtime radius" );
+    }
+    
+    std::string temp4( myTypeName + " convolution engine 3D" );
+    summarize( temp4.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+
+/*
+    FFT convolution
+    Direct convolution costs O(r) per value in 1D and O(r^2) per value in 2D,
+    the FFT costs O(log N) per value for N point blocks, almost independent of the radius.
+    
+    Overlap-save: each block of input, with a radius wide apron read through the edge mode,
+    is transformed, multiplied by the kernel spectrum, and transformed back.
+    Only the part that didn't wrap around is kept.
+    
+    The FFTs are power of 2 sizes, radix 2 on complex values, with real data packed
+    two values per complex value.
+*/
+
+// integer and double data use a double precision FFT, so integer results round the same as direct
+template <typename T> struct fft_real { typedef double type; };
+template <> struct fft_real<float> { typedef float type; };
+
+/******************************************************************************/
+
+// written out, because std::complex multiply has to check for infinities and NaNs
+template <typename R>
+inline std::complex<R> complex_multiply( const std::complex<R> &a, const std::complex<R> &b ) {
+    return std::complex<R>( a.real()*b.real() - a.imag()*b.imag(),
+                            a.real()*b.imag() + a.imag()*b.real() );
+}
+
+/******************************************************************************/
+
+// complex FFT of a power of 2 size, unscaled in both directions
+template <typename R>
+class complex_fft {
+public:
+    typedef std::complex<R> value_type;
+
+    explicit complex_fft( int count = 1 ) : n(count), bitReverse(count), forwardTwiddle(count/2), inverseTwiddle(count/2) {
+        int bits = 0;
+        while ((1 << bits) < n)
+            ++bits;
+        
+        for (int i = 0; i < n; ++i) {
+            int reversed = 0;
+            for (int b = 0; b < bits; ++b)
+                if (i & (1 << b))
+                    reversed |= 1 << (bits-1-b);
+            bitReverse[i] = reversed;
+        }
+        
+        const double pi = 3.14159265358979323846;
+        for (int k = 0; k < n/2; ++k) {
+            forwardTwiddle[k] = value_type( R(cos(-2.0*pi*k/n)), R(sin(-2.0*pi*k/n)) );
+            inverseTwiddle[k] = std::conj( forwardTwiddle[k] );
+        }
+    }
+
+    int size() const { return n; }
+
+    void forward( value_type *data ) const { transform( data, &forwardTwiddle[0] ); }
+    void inverse( value_type *data ) const { transform( data, &inverseTwiddle[0] ); }
+
+private:
+    void transform( value_type *data, const value_type *twiddle ) const {
+        for (int i = 0; i < n; ++i)
+            if (i < bitReverse[i])
+                std::swap( data[i], data[ bitReverse[i] ] );
+        
+        for (int length = 2; length <= n; length *= 2) {
+            const int half = length / 2;
+            const int step = n / length;
+            for (int start = 0; start < n; start += length)
+                for (int k = 0; k < half; ++k) {
+                    value_type a = data[start+k];
+                    value_type b = complex_multiply( data[start+k+half], twiddle[k*step] );
+                    data[start+k] = a + b;
+                    data[start+k+half] = a - b;
+                }
+        }
+    }
+
+    int n;
+    std::vector<int> bitReverse;
+    std::vector<value_type> forwardTwiddle;
+    std::vector<value_type> inverseTwiddle;
+};
+
+/******************************************************************************/
+
+// real FFT of n values, using a complex FFT of n/2 values
+// The spectrum is n/2+1 complex values, and inverse returns n/2 times the original values.
+template <typename R>
+class real_fft {
+public:
+    typedef std::complex<R> value_type;
+
+    explicit real_fft( int count = 2 ) : n(count), half(count/2), fft(count/2), packed(count/2), rotate(count/2+1) {
+        const double pi = 3.14159265358979323846;
+        for (int k = 0; k <= half; ++k)
+            rotate[k] = value_type( R(cos(-2.0*pi*k/n)), R(sin(-2.0*pi*k/n)) );
+    }
+
+    int size() const { return n; }
+    int spectrum_size() const { return half+1; }
+
+    void forward( const R *input, value_type *spectrum ) {
+        for (int k = 0; k < half; ++k)
+            packed[k] = value_type( input[2*k], input[2*k+1] );
+        
+        fft.forward( &packed[0] );
+        
+        // split into the spectra of the even and odd values, then combine them
+        for (int k = 0; k <= half; ++k) {
+            value_type z = packed[ (k == half) ? 0 : k ];
+            value_type zc = std::conj( packed[ (k == 0) ? 0 : (half-k) ] );
+            value_type even = (z + zc) * R(0.5);
+            value_type odd = complex_multiply( rotate[k], z - zc );
+            // even - i/2 * odd
+            spectrum[k] = even + value_type( R(0.5)*odd.imag(), R(-0.5)*odd.real() );
+        }
+    }
+
+    void inverse( const value_type *spectrum, R *output ) {
+        for (int k = 0; k < half; ++k) {
+            value_type x = spectrum[k];
+            value_type xc = std::conj( spectrum[half-k] );
+            value_type even = (x + xc) * R(0.5);
+            value_type odd = complex_multiply( x - xc, std::conj( rotate[k] ) ) * R(0.5);
+            // even + i * odd
+            packed[k] = even + value_type( -odd.imag(), odd.real() );
+        }
+        
+        fft.inverse( &packed[0] );
+        
+        for (int k = 0; k < half; ++k) {
+            output[2*k] = packed[k].real();
+            output[2*k+1] = packed[k].imag();
+        }
+    }
+
+private:
+    int n;
+    int half;
+    complex_fft<R> fft;
+    std::vector<value_type> packed;
+    std::vector<value_type> rotate;
+};
+
+/******************************************************************************/
+
+// overlap-save FFT convolution, with the same kernels and edge modes as convolution_engine
+// 1D uses a line kernel, 2D uses a full (2*radius+1)^2 kernel
+template <typename T, typename TS>
+class fft_convolution {
+public:
+    typedef typename fft_real<T>::type R;
+    typedef std::complex<R> value_type;
+
+    fft_convolution( const conv_kernel<TS> &kernel, edgeMode m, int dims ) :
+        radius(kernel.radius), n( choose_size( kernel.radius, dims ) ), valid( n - 2*kernel.radius ),
+        mode(m), rowFFT(n), columnFFT( (dims == 2) ? n : 1 ), spectrumWidth(n/2+1) {
+        const int taps = 2*radius+1;
+        const int rows = (dims == 2) ? n : 1;
+        
+        // reverse the kernel so the product is a correlation, like the direct code
+        // then fold the divisor and the scaling of the inverse transforms into the kernel spectrum
+        const R scale = R(1) / (R(kernel.divisor) * R(n/2) * R( (dims == 2) ? n : 1 ));
+        block.assign( rows*n, R(0) );
+        for (int y = 0; y < ((dims == 2) ? taps : 1); ++y)
+            for (int x = 0; x < taps; ++x) {
+                const int source = (dims == 2) ? ((taps-1-y)*taps + (taps-1-x)) : (taps-1-x);
+                block[y*n + x] = R( kernel.weights[source] ) * scale;
+            }
+        
+        kernelSpectrum.resize( rows*spectrumWidth );
+        column.resize( n );
+        if (dims == 2)
+            forward2D( &block[0], &kernelSpectrum[0] );
+        else
+            rowFFT.forward( &block[0], &kernelSpectrum[0] );
+        spectrum.resize( kernelSpectrum.size() );
+    }
+
+    int block_size() const { return n; }
+
+    void filter1D( const T *source, T *dest, int count ) {
+        for (int x0 = 0; x0 < count; x0 += valid) {
+            const int start = x0 - radius;
+            if (start >= 0 && (start + n) <= count) {
+                for (int j = 0; j < n; ++j)
+                    block[j] = R( source[start+j] );
+            } else {
+                for (int j = 0; j < n; ++j) {
+                    int i = edge_index( start+j, count, mode );
+                    block[j] = (i < 0) ? R(0) : R( source[i] );
+                }
+            }
+            
+            rowFFT.forward( &block[0], &spectrum[0] );
+            for (int k = 0; k < spectrumWidth; ++k)
+                spectrum[k] = complex_multiply( spectrum[k], kernelSpectrum[k] );
+            rowFFT.inverse( &spectrum[0], &block[0] );
+            
+            const int length = std::min( valid, count - x0 );
+            for (int i = 0; i < length; ++i)
+                dest[x0+i] = to_result( block[i + 2*radius] );
+        }
+    }
+
+    void filter2D( const T *source, T *dest, int rows, int cols, ptrdiff_t rowStep ) {
+        for (int y0 = 0; y0 < rows; y0 += valid)
+            for (int x0 = 0; x0 < cols; x0 += valid) {
+                load_tile( source, rows, cols, rowStep, y0 - radius, x0 - radius );
+                
+                forward2D( &block[0], &spectrum[0] );
+                for (size_t k = 0; k < spectrum.size(); ++k)
+                    spectrum[k] = complex_multiply( spectrum[k], kernelSpectrum[k] );
+                inverse2D( &spectrum[0], &block[0] );
+                
+                const int height = std::min( valid, rows - y0 );
+                const int width = std::min( valid, cols - x0 );
+                for (int i = 0; i < height; ++i) {
+                    const R *result = &block[ (i + 2*radius)*n + 2*radius ];
+                    T *out = dest + (y0+i)*rowStep + x0;
+                    for (int j = 0; j < width; ++j)
+                        out[j] = to_result( result[j] );
+                }
+            }
+    }
+
+    // pick the power of 2 block with the fewest operations per output value
+    static int choose_size( int radius, int dims ) {
+        int smallest = 16;
+        while (smallest < 2*(2*radius+1))
+            smallest *= 2;
+        
+        int best = smallest;
+        double bestCost = 1.0e30;
+        // large 2D blocks fall out of cache long before the operation count says they should
+        const int largest = (dims == 2) ? 2*smallest : 8*smallest;
+        for (int size = smallest; size <= largest; size *= 2) {
+            const double outputs = double(size - 2*radius);
+            const double points = (dims == 2) ? double(size)*size : double(size);
+            const double cost = points * log2(double(size)) / ((dims == 2) ? outputs*outputs : outputs);
+            if (cost < bestCost) {
+                bestCost = cost;
+                best = size;
+            }
+        }
+        return best;
+    }
+
+private:
+    T to_result( R value ) const {
+        const bool isFloat = (T(2.9) > T(2.0));
+        return isFloat ? T(value) : T( std::floor( value + R(0.5) ) );
+    }
+
+    // n x n values starting at (top, left), read through the edge mode when outside the image
+    void load_tile( const T *source, int rows, int cols, ptrdiff_t rowStep, int top, int left ) {
+        const bool inside = (left >= 0 && (left + n) <= cols);
+        for (int ty = 0; ty < n; ++ty) {
+            R *line = &block[ty*n];
+            int iy = edge_index( top+ty, rows, mode );
+            if (iy < 0) {
+                std::fill( line, line+n, R(0) );
+                continue;
+            }
+            const T *input = source + iy*rowStep;
+            if (inside) {
+                for (int tx = 0; tx < n; ++tx)
+                    line[tx] = R( input[left+tx] );
+            } else {
+                for (int tx = 0; tx < n; ++tx) {
+                    int ix = edge_index( left+tx, cols, mode );
+                    line[tx] = (ix < 0) ? R(0) : R( input[ix] );
+                }
+            }
+        }
+    }
+
+    // real FFT of the rows, then complex FFT of the columns
+    void forward2D( const R *input, value_type *output ) {
+        for (int y = 0; y < n; ++y)
+            rowFFT.forward( input + y*n, output + y*spectrumWidth );
+        for (int k = 0; k < spectrumWidth; ++k) {
+            for (int y = 0; y < n; ++y)
+                column[y] = output[y*spectrumWidth + k];
+            columnFFT.forward( &column[0] );
+            for (int y = 0; y < n; ++y)
+                output[y*spectrumWidth + k] = column[y];
+        }
+    }
+
+    void inverse2D( value_type *input, R *output ) {
+        for (int k = 0; k < spectrumWidth; ++k) {
+            for (int y = 0; y < n; ++y)
+                column[y] = input[y*spectrumWidth + k];
+            columnFFT.inverse( &column[0] );
+            for (int y = 0; y < n; ++y)
+                input[y*spectrumWidth + k] = column[y];
+        }
+        for (int y = 0; y < n; ++y)
+            rowFFT.inverse( input + y*spectrumWidth, output + y*n );
+    }
+
+    int radius;
+    int n;          // FFT size
+    int valid;      // outputs per block
+    edgeMode mode;
+    real_fft<R> rowFFT;
+    complex_fft<R> columnFFT;
+    int spectrumWidth;
+    std::vector<value_type> kernelSpectrum;
+    std::vector<value_type> spectrum;
+    std::vector<value_type> column;
+    std::vector<R> block;
+};
+
+/******************************************************************************/
+
+// line kernel for 1D, full kernel for 2D
+template <typename TS>
+conv_kernel<TS> make_blur_kernel( int radius, int dims ) {
+    conv_kernel<TS> line = make_tent_kernel<TS>( radius );
+    return (dims == 2) ? make_outer_kernel( line, 2 ) : line;
+}
+
+/******************************************************************************/
+
+// Chooses direct or FFT convolution from timings on this machine.
+// The crossover is the smallest radius where the FFT won, and larger radii use the FFT.
+template <typename T, typename TS>
+class convolution_planner {
+public:
+    convolution_planner() : crossover1D( tune(1) ), crossover2D( tune(2) ) {}
+
+    int crossover( int dims ) const { return (dims == 2) ? crossover2D : crossover1D; }
+
+    bool use_fft( int radius, int dims ) const { return radius >= crossover( dims ); }
+
+    // largest radius tried, crossover() is larger than this if the FFT never won
+    static int max_radius( int dims ) { return (dims == 2) ? 48 : 512; }
+
+private:
+    template <typename Func>
+    static double seconds_per_call( Func func ) {
+        int count = 0;
+        double elapsed;
+        start_timer();
+        do {
+            func();
+            ++count;
+        } while ((elapsed = timer()) < 0.02);
+        return elapsed / count;
+    }
+
+    static int tune( int dims ) {
+        const int rows = (dims == 2) ? 256 : 1;
+        const int cols = (dims == 2) ? 256 : 65536;
+        const int runs = 3;
+        std::vector<T> source( rows*cols, T(init_value) ), dest( rows*cols );
+        
+        for (int radius = 1; radius <= max_radius( dims ); radius += std::max( 1, radius/2 )) {
+            conv_kernel<TS> kernel = make_blur_kernel<TS>( radius, dims );
+            convolution_engine<T,TS> direct( kernel, kEdgeRepeat );
+            fft_convolution<T,TS> fft( kernel, kEdgeRepeat, dims );
+            
+            double directTime = 1.0e30, fftTime = 1.0e30;
+            for (int run = 0; run < runs; ++run) {
+                directTime = std::min( directTime, seconds_per_call( [&] {
+                    if (dims == 2)
+                        direct.filter2D( &source[0], &dest[0], rows, cols, cols );
+                    else
+                        direct.filter1D( &source[0], &dest[0], cols );
+                } ) );
+                fftTime = std::min( fftTime, seconds_per_call( [&] {
+                    if (dims == 2)
+                        fft.filter2D( &source[0], &dest[0], rows, cols, cols );
+                    else
+                        fft.filter1D( &source[0], &dest[0], cols );
+                } ) );
+            }
+            
+            if (fftTime < directTime)
+                return radius;
+        }
+        
+        return max_radius( dims ) + 1;
+    }
+
+    int crossover1D;
+    int crossover2D;
+};
+
+/******************************************************************************/
+
+template <typename T>
+inline bool fft_result_close( T a, T b ) {
+    const bool isFloat = (T(2.9) > T(2.0));
+    if (isFloat)
+        return tolerance_equal<T>( a, b );
+    // values that land near a rounding boundary may round either way
+    return std::abs( double(a) - double(b) ) <= 1.0;
+}
+
+/******************************************************************************/
+
+// compare the FFT against the direct engine on small odd sizes with varying data
+template <typename T, typename TS>
+void verify_fft_convolution( const std::string &name ) {
+    const int count = 301;
+    const int rows = 37, cols = 53, rowStep = 60;
+    const edgeMode modes[] = { kEdgeZero, kEdgeRepeat, kEdgeMirror };
+    
+    std::vector<T> source( rows*rowStep ), expected( rows*rowStep ), result( rows*rowStep );
+    for (size_t i = 0; i < source.size(); ++i)
+        source[i] = T( (i*7 + 3) % 16 );
+    
+    for (edgeMode mode : modes) {
+        for (int radius : { 1, 5, 17, 40 }) {
+            conv_kernel<TS> kernel = make_blur_kernel<TS>( radius, 1 );
+            convolution_engine<T,TS> direct( kernel, mode );
+            fft_convolution<T,TS> fft( kernel, mode, 1 );
+            direct.filter1D( &source[0], &expected[0], count );
+            fft.filter1D( &source[0], &result[0], count );
+            for (int x = 0; x < count; ++x)
+                if (!fft_result_close( result[x], expected[x] )) {
+                    printf("test %s FFT convolution 1D radius %d %s edges failed verification\n", name.c_str(), radius, edge_mode_name(mode) );
+                    break;
+                }
+        }
+        
+        for (int radius : { 1, 3, 9 }) {
+            conv_kernel<TS> kernel = make_blur_kernel<TS>( radius, 2 );
+            convolution_engine<T,TS> direct( kernel, mode );
+            fft_convolution<T,TS> fft( kernel, mode, 2 );
+            direct.filter2D( &source[0], &expected[0], rows, cols, rowStep );
+            fft.filter2D( &source[0], &result[0], rows, cols, rowStep );
+            bool good = true;
+            for (int y = 0; y < rows && good; ++y)
+                for (int x = 0; x < cols && good; ++x)
+                    good = fft_result_close( result[y*rowStep+x], expected[y*rowStep+x] );
+            if (!good)
+                printf("test %s FFT convolution 2D radius %d %s edges failed verification\n", name.c_str(), radius, edge_mode_name(mode) );
+        }
+    }
+}
+
+/******************************************************************************/
+
+template <typename T>
+inline void check_constant_2D( const T* out, const int rows, const int cols,
+                            const int rowStep, const std::string &label ) {
+    T sum = 0;
+    for (int y = 0; y < rows; ++y)
+        for (int x = 0; x < cols; ++x)
+            sum += out[(y*rowStep)+x];
+    
+    T temp = (T)(rows*cols) * (T)init_value;
+    if (!tolerance_equal<T>(sum,temp))
+        printf("test %s failed\n", label.c_str() );
+}
+
+/******************************************************************************/
+
+// region of the image used for the 2D tests, large kernels are too slow to run directly on the whole image
+const int FFT_ROWS = 750;
+const int FFT_COLS = 750;
+
+// Large blur kernels, direct against FFT.
+// The planner's choice for each radius is marked in the labels.
+template <typename T, typename TS>
+void TestFFTConvolution() {
+    const int base_iterations = iterations;
+    std::string myTypeName( getTypeName<T>() );
+    const int radii1D[] = { 4, 16, 64, 128 };
+    const int radii2D[] = { 2, 4, 8, 16 };
+    const int fftOnly2D = 32;
+    char buffer[ 200 ];
+    
+    verify_fft_convolution<T,TS>( myTypeName );
+    
+    convolution_planner<T,TS> planner;
+    for (int dims = 1; dims <= 2; ++dims) {
+        if (planner.crossover(dims) > convolution_planner<T,TS>::max_radius(dims))
+            printf("\n%s FFT convolution %dD crossover radius: none up to %d\n", myTypeName.c_str(), dims, convolution_planner<T,TS>::max_radius(dims) );
+        else
+            printf("\n%s FFT convolution %dD crossover radius: %d\n", myTypeName.c_str(), dims, planner.crossover(dims) );
+    }
+
+    std::unique_ptr<T[]> source_unique( new T[ SIZE ] );
+    std::unique_ptr<T[]> dest_unique( new T[ SIZE ] );
+    T *source = source_unique.get();
+    T *dest = dest_unique.get();
+    ::fill( source, source+SIZE, T(init_value) );
+    ::fill( dest, dest+SIZE, T(init_value+6) );
+
+
+    iterations = std::max( 1, base_iterations / 20 );
+
+    for (int radius : radii1D) {
+        conv_kernel<TS> kernel = make_blur_kernel<TS>( radius, 1 );
+        const bool planned = planner.use_fft( radius, 1 );
+        
+        convolution_engine<T,TS> direct( kernel, kEdgeRepeat );
+        snprintf( buffer, sizeof(buffer), "%s FFT convolution 1D radius %d direct%s", myTypeName.c_str(), radius, planned ? "" : " (planned)" );
+        test_engine1D( source, dest, SIZE, direct, buffer );
+        
+        fft_convolution<T,TS> fft( kernel, kEdgeRepeat, 1 );
+        snprintf( buffer, sizeof(buffer), "%s FFT convolution 1D radius %d fft %d%s", myTypeName.c_str(), radius, fft.block_size(), planned ? " (planned)" : "" );
+        std::string label( buffer );
+        start_timer();
+        for (int i = 0; i < iterations; ++i)
+            fft.filter1D( source, dest, SIZE );
+        check_add_1D( 0, dest, SIZE, label );
+        gLabels.push_back( label );
+        record_result( timer(), gLabels.back().c_str() );
+    }
+    
+    std::string temp1( myTypeName + " FFT convolution 1D" );
+    summarize( temp1.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
+    iterations = std::max( 1, base_iterations / 20 );
+
+    for (int radius : radii2D) {
+        conv_kernel<TS> kernel = make_blur_kernel<TS>( radius, 2 );
+        const bool planned = planner.use_fft( radius, 2 );
+        
+        convolution_engine<T,TS> direct( kernel, kEdgeRepeat );
+        snprintf( buffer, sizeof(buffer), "%s FFT convolution 2D radius %d direct%s", myTypeName.c_str(), radius, planned ? "" : " (planned)" );
+        std::string directLabel( buffer );
+        start_timer();
+        for (int i = 0; i < iterations; ++i)
+            direct.filter2D( source, dest, FFT_ROWS, FFT_COLS, WIDTH );
+        check_constant_2D( dest, FFT_ROWS, FFT_COLS, WIDTH, directLabel );
+        gLabels.push_back( directLabel );
+        record_result( timer(), gLabels.back().c_str() );
+    }
+    
+    for (int radius : radii2D) {
+        conv_kernel<TS> kernel = make_blur_kernel<TS>( radius, 2 );
+        const bool planned = planner.use_fft( radius, 2 );
+        
+        fft_convolution<T,TS> fft( kernel, kEdgeRepeat, 2 );
+        snprintf( buffer, sizeof(buffer), "%s FFT convolution 2D radius %d fft %d%s", myTypeName.c_str(), radius, fft.block_size(), planned ? " (planned)" : "" );
+        std::string label( buffer );
+        start_timer();
+        for (int i = 0; i < iterations; ++i)
+            fft.filter2D( source, dest, FFT_ROWS, FFT_COLS, WIDTH );
+        check_constant_2D( dest, FFT_ROWS, FFT_COLS, WIDTH, label );
+        gLabels.push_back( label );
+        record_result( timer(), gLabels.back().c_str() );
+    }
+    
+    {
+        // too slow to run directly
+        fft_convolution<T,TS> fft( make_blur_kernel<TS>( fftOnly2D, 2 ), kEdgeRepeat, 2 );
+        snprintf( buffer, sizeof(buffer), "%s FFT convolution 2D radius %d fft %d", myTypeName.c_str(), fftOnly2D, fft.block_size() );
+        std::string label( buffer );
+        start_timer();
+        for (int i = 0; i < iterations; ++i)
+            fft.filter2D( source, dest, FFT_ROWS, FFT_COLS, WIDTH );
+        check_constant_2D( dest, FFT_ROWS, FFT_COLS, WIDTH, label );
+        gLabels.push_back( label );
+        record_result( timer(), gLabels.back().c_str() );
+    }
+    
+    std::string temp2( myTypeName + " FFT convolution 2D" );
+    summarize( temp2.c_str(), FFT_ROWS*FFT_COLS, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
+    iterations = base_iterations;
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -2289,6 +3686,9 @@ void TestOneType()
     
     iterations = base_iterations;
 
+    ::fill( data_flatDst, data_flatDst+SIZE, T(init_value+5) );
+    TestConvolutionEngine<T,TS>( data_flat, data_flatDst, myTypeName );
+
 }
 
 /******************************************************************************/
@@ -2323,6 +3723,11 @@ int main(int argc, char** argv) {
     TestOneType<float,float>();
     TestOneType<double,double>();
 
+    // 8 bit images need wider sums for large kernels
+    TestFFTConvolution<uint8_t, uint32_t>();
+    TestFFTConvolution<float, float>();
+    TestFFTConvolution<double, double>();
+
 #if WORKS_BUT_SLOW
     TestOneType<long double,long double>();
 #endif
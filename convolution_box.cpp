@@ -13,11 +13,23 @@ Assumptions:
     1) Most likely, there will be no single best implementation for all types.
         "Best" performance will depend a lot on cache organization, instruction latencies, vectorization, and register availability.
 
+    2) Fusing the horizontal and vertical passes over cache sized tiles will be faster
+        than separate passes over the whole image, and the tiles will scale across threads.
 
+    3) Recursive gaussians and integral image box filters will cost the same for any radius,
+        and will be competitive with repeated box passes.
 
 
 
-TODO - find best buffer sizes for vertical iteration, see if it varies with data size
+
+
+NOTE - the tiled pipeline tunes its tile size at runtime, and prints the size it found.
+
+NOTE - integral images with 32 bit unsigned sums overflow on large images,
+        but box sums are differences of table values, so they are still exact modulo 2^32.
+
+TODO - find best buffer sizes for vertical iteration in the unfused versions,
+        see if it varies with data size
         need to test in and out of cache
 
 TODO -
@@ -38,9 +50,14 @@ TODO -
 #include <iostream>
 #include <algorithm>
 #include <utility>
+#include <vector>
+#include <atomic>
+#include <limits>
+#include <type_traits>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_typenames.h"
+#include "benchmark_threads.h"
 
 /******************************************************************************/
 
@@ -2771,6 +2788,899 @@ void TestOneType()
 /******************************************************************************/
 /******************************************************************************/
 
+/*
+    Tiled pipeline for 2D box filters
+
+    The separate passes above each read and write the whole image, so large images
+    go through memory twice. Here each tile runs the horizontal pass into a ring buffer
+    of rows, and the vertical pass keeps running sums over the ring, so the intermediate
+    rows stay in cache. Tiles are independent, so they are handed out to a thread pool.
+
+    The results match box_horiz followed by box_vert, including edge replication and rounding.
+    Tiles overlap by edge-1 rows of horizontal work, so taller tiles do less redundant work
+    but need more cache for the same width.
+*/
+
+// horizontal box filter for columns [x0,x1) of one row, with edge replication
+template<typename T, typename TS>
+void box_row_segment(const T *srcRow, T *out, int cols, int x0, int x1, int edge, TS half ) {
+    const int halfEdge = edge / 2;
+    const int remainEdge = edge - halfEdge;
+    
+    // only the windows near the ends of the row need clamping
+    const int safeStart = std::min( std::max( x0, halfEdge ), x1 );
+    const int safeEnd = std::max( std::min( x1, (cols-1) - remainEdge ), safeStart );
+    
+    TS sum = half;
+    for (int k = x0-halfEdge; k < x0+remainEdge; ++k)
+        sum += srcRow[ std::min( std::max( k, 0 ), cols-1 ) ];
+    
+    int x = x0;
+    for (; x < safeStart; ++x) {
+        TS result = sum / edge;
+        out[x-x0] = T(result);
+        sum += srcRow[ std::min( x+remainEdge, cols-1 ) ];
+        sum -= srcRow[ std::max( x-halfEdge, 0 ) ];
+    }
+    
+    for (; x < safeEnd; ++x) {
+        TS result = sum / edge;
+        out[x-x0] = T(result);
+        sum += srcRow[x+remainEdge];
+        sum -= srcRow[x-halfEdge];
+    }
+    
+    for (; x < x1; ++x) {
+        TS result = sum / edge;
+        out[x-x0] = T(result);
+        sum += srcRow[ std::min( x+remainEdge, cols-1 ) ];
+        sum -= srcRow[ std::max( x-halfEdge, 0 ) ];
+    }
+}
+
+/******************************************************************************/
+
+// per thread buffers, reused from tile to tile
+template<typename T, typename TS>
+struct box_tile_workspace {
+    std::vector<T> ring;        // edge rows of horizontally filtered values
+    std::vector<TS> sums;       // running vertical sums for each column of the tile
+};
+
+/******************************************************************************/
+
+// 2D box filter for one tile, columns [x0,x1) and rows [y0,y1)
+// row v of the window lives in ring slot (v mod edge), so the row entering the window
+//   replaces the row leaving it
+template<typename T, typename TS>
+void box_2D_tile(const T *src, T *dest, int rows, int cols, int rowStep, int edge,
+                 int x0, int x1, int y0, int y1, box_tile_workspace<T,TS> &work ) {
+    const bool isFloat = (T(2.9) > T(2.0));
+    const TS half = isFloat ? TS(0) : TS(edge/2);
+    const int halfEdge = edge / 2;
+    const int remainEdge = edge - halfEdge;
+    const int width = x1 - x0;
+    
+    work.ring.resize( edge * width );
+    work.sums.resize( width );
+    T *ring = &work.ring[0];
+    TS *sums = &work.sums[0];
+    
+    for (int i = 0; i < width; ++i)
+        sums[i] = half;
+    
+    // fill the window for the first row of the tile
+    for (int v = y0-halfEdge; v < y0+remainEdge; ++v) {
+        T *line = ring + (((v % edge) + edge) % edge) * width;
+        const int srcRow = std::min( std::max( v, 0 ), rows-1 );
+        box_row_segment<T,TS>( src + srcRow*rowStep, line, cols, x0, x1, edge, half );
+        for (int i = 0; i < width; ++i)
+            sums[i] += line[i];
+    }
+    
+    for (int y = y0; y < y1; ++y) {
+        T *destRow = dest + y*rowStep + x0;
+        for (int i = 0; i < width; ++i) {
+            TS result = sums[i] / edge;
+            destRow[i] = T(result);
+        }
+        
+        if ((y+1) == y1)
+            break;
+        
+        // slide the window down one row
+        const int v = y + remainEdge;
+        T *line = ring + (v % edge) * width;
+        const int srcRow = std::min( v, rows-1 );
+        for (int i = 0; i < width; ++i)
+            sums[i] -= line[i];
+        box_row_segment<T,TS>( src + srcRow*rowStep, line, cols, x0, x1, edge, half );
+        for (int i = 0; i < width; ++i)
+            sums[i] += line[i];
+    }
+}
+
+/******************************************************************************/
+
+// src and dest must be different images
+template<typename T, typename TS>
+class box_blur_pipeline {
+public:
+    explicit box_blur_pipeline( int maxThreads ) : workspaces( std::max( maxThreads, 1 ) ) {}
+
+    void operator()( benchmark::thread_pool &pool, int threads,
+                    const T *src, T *dest, int rows, int cols, int rowStep, int edge,
+                    int tileWidth, int tileHeight ) {
+        threads = std::min( threads, int(workspaces.size()) );
+        tileWidth = std::min( tileWidth, cols );
+        tileHeight = std::min( tileHeight, rows );
+        const int tilesX = (cols + tileWidth - 1) / tileWidth;
+        const int tilesY = (rows + tileHeight - 1) / tileHeight;
+        const int count = tilesX * tilesY;
+        std::atomic<int> next( 0 );
+        
+        auto work = [&]( int thread ) {
+            int tile;
+            while ((tile = next.fetch_add(1)) < count) {
+                const int x0 = (tile % tilesX) * tileWidth;
+                const int y0 = (tile / tilesX) * tileHeight;
+                box_2D_tile<T,TS>( src, dest, rows, cols, rowStep, edge,
+                                x0, std::min( x0+tileWidth, cols ), y0, std::min( y0+tileHeight, rows ),
+                                workspaces[thread] );
+            }
+        };
+        
+        if (threads <= 1)
+            work( 0 );
+        else
+            pool.run( threads, work );
+    }
+
+private:
+    std::vector< box_tile_workspace<T,TS> > workspaces;
+};
+
+/******************************************************************************/
+
+struct box_tile_size {
+    int width;
+    int height;
+};
+
+// Try tile widths with a fixed height, then heights with the best width, using all the threads.
+// The best tile depends on the cache sizes, the image width and the edge length.
+template<typename T, typename TS>
+box_tile_size tune_box_tiles( benchmark::thread_pool &pool, box_blur_pipeline<T,TS> &pipeline,
+                            const T *src, T *dest, int rows, int cols, int rowStep, int edge ) {
+    const int widths[] = { 128, 256, 512, 1024, 2048, cols };
+    const int heights[] = { 32, 64, 128, 256, 512, rows };
+    box_tile_size best = { 512, 128 };
+    double bestTime = 1.0e30;
+    
+    auto tryTile = [&]( int width, int height ) {
+        if (width > cols || height > rows)
+            return;
+        start_wall_timer();
+        pipeline( pool, pool.size(), src, dest, rows, cols, rowStep, edge, width, height );
+        double elapsed = wall_timer();
+        if (elapsed < bestTime) {
+            bestTime = elapsed;
+            best.width = width;
+            best.height = height;
+        }
+    };
+    
+    for (int width : widths)
+        tryTile( width, best.height );
+    const int bestWidth = best.width;
+    for (int height : heights)
+        tryTile( bestWidth, height );
+    
+    return best;
+}
+
+/******************************************************************************/
+
+// odd sizes and small tiles, against the separate horizontal and vertical passes
+template<typename T, typename TS>
+void verify_box_pipeline( const std::string &myTypeName ) {
+    const int rows = 97, cols = 131, rowStep = 140;
+    const size_t total = rows * rowStep;
+    benchmark::thread_pool pool( 4 );
+    box_blur_pipeline<T,TS> pipeline( pool.size() );
+    
+    std::vector<T> src( total ), temp( total ), expected( total ), result( total );
+    for (size_t i = 0; i < total; ++i)
+        src[i] = T( (i * 7 + 3) % 61 );
+    
+    const box_tile_size tiles[] = { { 16, 8 }, { 37, 29 }, { 64, 97 }, { cols, 5 } };
+    
+    for (int edge : { 1, 2, 7, 21 }) {
+        box_horiz<T,TS>( &src[0], &temp[0], rows, cols, rowStep, edge );
+        box_vert<T,TS>( &temp[0], &expected[0], rows, cols, rowStep, edge );
+        
+        for (const auto &tile : tiles) {
+            std::fill( result.begin(), result.end(), T(0) );
+            pipeline( pool, pool.size(), &src[0], &result[0], rows, cols, rowStep, edge, tile.width, tile.height );
+            
+            bool good = true;
+            for (int y = 0; y < rows && good; ++y)
+                for (int x = 0; x < cols && good; ++x)
+                    good = tolerance_equal<T>( result[y*rowStep+x], expected[y*rowStep+x] );
+            if (!good)
+                printf("test %s box pipeline edge %d tile %dx%d failed verification\n",
+                    myTypeName.c_str(), edge, tile.width, tile.height );
+        }
+    }
+}
+
+/******************************************************************************/
+
+// check_add one row at a time, because a float sum of a whole 8K image runs out of precision
+template <typename T>
+inline void check_add_rows(const T* out, const int rows, const int cols, const int rowStep, const std::string &label) {
+    T expected = T( cols * T(init_value) );
+    
+    for (int y = 0; y < rows; ++y) {
+        T sum = 0;
+        for (int x = 0; x < cols; ++x)
+            sum += out[y*rowStep+x];
+        
+        if (!tolerance_equal<T>(sum,expected)) {
+            std::cout << "test " << label << " failed at row " << y << ", got " << sum << " expected " << expected << "\n";
+            return;
+        }
+    }
+}
+
+/******************************************************************************/
+
+// an 8K video frame, much larger than the caches
+const int LARGE_WIDTH = 7680;
+const int LARGE_HEIGHT = 4320;
+
+const int LARGE_SIZE = LARGE_HEIGHT*LARGE_WIDTH;
+
+// "M/s" in these summaries is megapixels per second
+template< typename T, typename TS >
+void TestTiledPipeline( benchmark::thread_pool &pool )
+{
+    const int base_iterations = iterations;
+    const int edge = edge_length;
+    const int rows = LARGE_HEIGHT, cols = LARGE_WIDTH, rowStep = LARGE_WIDTH;
+
+    std::string myTypeName( getTypeName<T>() );
+    
+    verify_box_pipeline<T,TS>( myTypeName );
+    
+    gLabels.clear();
+    
+    std::vector<T> src( LARGE_SIZE, T(init_value) );
+    std::vector<T> dest( LARGE_SIZE );
+    std::vector<T> dest2( LARGE_SIZE );
+    
+    box_blur_pipeline<T,TS> pipeline( pool.size() );
+    box_tile_size tile = tune_box_tiles<T,TS>( pool, pipeline, &src[0], &dest[0], rows, cols, rowStep, edge );
+    printf("\n%s box pipeline tile %d x %d\n", myTypeName.c_str(), tile.width, tile.height );
+    
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < pool.size(); threads *= 2)
+        threadCounts.push_back( threads );
+    threadCounts.push_back( pool.size() );
+    
+    char buffer[ 200 ];
+    
+    
+    iterations = std::max( 1, base_iterations / 4 );
+    
+    std::string name( myTypeName + " convolution_box tiled pipeline 2D " + std::to_string(cols) + "x" + std::to_string(rows) );
+    
+    {
+        // the best separate passes, for comparison
+        std::string label( myTypeName + " box 2D separate passes, 1 thread" );
+        start_wall_timer();
+        for (int i = 0; i < iterations; ++i) {
+            box_horiz_opt4<T,TS>( &src[0], &dest2[0], rows, cols, rowStep, edge );
+            box_vert_opt7<T,TS>( &dest2[0], &dest[0], rows, cols, rowStep, edge );
+        }
+        gLabels.push_back( label );
+        record_result( wall_timer(), gLabels.back().c_str() );
+        check_add_rows( &dest[0], rows, cols, rowStep, label );
+    }
+    
+    double oneThread = 0.0;
+    for (int threads : threadCounts) {
+        start_wall_timer();
+        for (int i = 0; i < iterations; ++i)
+            pipeline( pool, threads, &src[0], &dest[0], rows, cols, rowStep, edge, tile.width, tile.height );
+        double elapsed = wall_timer();
+        
+        if (threads == 1)
+            oneThread = elapsed;
+        double efficiency = (elapsed > 0.0) ? 100.0 * oneThread / (elapsed * threads) : 0.0;
+        
+        snprintf( buffer, sizeof(buffer), "%s box 2D tiled pipeline, %d threads, %.0f%% efficiency",
+                myTypeName.c_str(), threads, efficiency );
+        gLabels.push_back( buffer );
+        record_result( elapsed, gLabels.back().c_str() );
+        check_add_rows( &dest[0], rows, cols, rowStep, gLabels.back() );
+    }
+    
+    summarize( name.c_str(), LARGE_SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    
+    // repeated box filters approximate a gaussian
+    iterations = std::max( 1, base_iterations / (4*repeats) );
+    
+    std::string nameRepeated( myTypeName + " convolution_box_repeated tiled pipeline 2D " + std::to_string(cols) + "x" + std::to_string(rows) );
+    
+    for (int threads : threadCounts) {
+        std::copy( src.begin(), src.end(), dest.begin() );
+        
+        start_wall_timer();
+        for (int i = 0; i < iterations; ++i) {
+            for (int k = 0; k < repeats/2; ++k) {
+                pipeline( pool, threads, &dest[0], &dest2[0], rows, cols, rowStep, edge, tile.width, tile.height );
+                pipeline( pool, threads, &dest2[0], &dest[0], rows, cols, rowStep, edge, tile.width, tile.height );
+            }
+            if ((repeats & 1) != 0) {
+                pipeline( pool, threads, &dest[0], &dest2[0], rows, cols, rowStep, edge, tile.width, tile.height );
+                std::swap( dest, dest2 );
+            }
+        }
+        double elapsed = wall_timer();
+        
+        snprintf( buffer, sizeof(buffer), "%s box 2D tiled pipeline repeated, %d threads", myTypeName.c_str(), threads );
+        gLabels.push_back( buffer );
+        record_result( elapsed, gLabels.back().c_str() );
+        check_add_rows( &dest[0], rows, cols, rowStep, gLabels.back() );
+    }
+    
+    summarize( nameRepeated.c_str(), LARGE_SIZE, iterations*repeats, kDontShowGMeans, kDontShowPenalty );
+
+
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Gaussian blurs with a cost per pixel that doesn't depend on the radius
+
+    Repeated box filters: 3 passes of width w have variance 3*(w*w-1)/12.
+    Recursive (IIR) filters run a causal pass and an anticausal pass along each axis,
+        with a few multiplies per pixel for any sigma.
+    Integral images (summed area tables) give any box sum from 4 table values.
+
+    Horizontal recursive passes are serial along each row.
+    Vertical passes run across whole rows, so they vectorize.
+    The recursive filters work in float (double for double data),
+        and round and clamp integer results.
+*/
+
+template <typename T> struct gaussian_real { typedef float type; };
+template <> struct gaussian_real<double> { typedef double type; };
+
+/******************************************************************************/
+
+template <typename T, typename R>
+inline T to_pixel( R value ) {
+    if (!std::numeric_limits<T>::is_integer)
+        return T(value);
+    const R low = R( std::numeric_limits<T>::lowest() );
+    const R high = R( std::numeric_limits<T>::max() );
+    value = std::floor( value + R(0.5) );
+    return T( std::min( std::max( value, low ), high ) );
+}
+
+/******************************************************************************/
+
+// odd box width, so that 3 box passes have about the same variance as the gaussian
+inline int box_width_for_sigma( double sigma ) {
+    int width = int( std::floor( std::sqrt( 4.0*sigma*sigma + 1.0 ) ) );
+    return width | 1;
+}
+
+/******************************************************************************/
+
+// Deriche smoothing filter, 2nd order causal and anticausal parts added together
+// alpha = 1.695 / sigma gives the closest fit to the gaussian
+template <typename R>
+struct deriche_coefficients {
+    R a1, a2, a3, a4;       // input weights
+    R b1, b2;               // feedback weights
+    R causalGain;           // steady state response to a constant, used to start at the edges
+    R anticausalGain;
+
+    explicit deriche_coefficients( double sigma ) {
+        const double alpha = 1.695 / sigma;
+        const double e1 = std::exp( -alpha );
+        const double e2 = std::exp( -2.0 * alpha );
+        const double k = (1.0 - e1) * (1.0 - e1) / (1.0 + 2.0 * alpha * e1 - e2);
+        a1 = R( k );
+        a2 = R( k * e1 * (alpha - 1.0) );
+        a3 = R( k * e1 * (alpha + 1.0) );
+        a4 = R( -k * e2 );
+        b1 = R( 2.0 * e1 );
+        b2 = R( -e2 );
+        causalGain = R( (k + k * e1 * (alpha - 1.0)) / (1.0 - 2.0*e1 + e2) );
+        anticausalGain = R( (k * e1 * (alpha + 1.0) - k * e2) / (1.0 - 2.0*e1 + e2) );
+    }
+};
+
+/******************************************************************************/
+
+// Young and van Vliet, 3rd order, the same filter run forward and then backward
+// w[n] = B x[n] + c1 w[n-1] + c2 w[n-2] + c3 w[n-3]
+// B + c1 + c2 + c3 = 1, so a constant passes through unchanged and the forward pass
+//   can start from the replicated edge by clamping the indices.
+// The backward pass starts from the Triggs and Sdika boundary values, which give the
+//   same result as an infinitely replicated edge.
+template <typename R>
+struct young_coefficients {
+    R B, c1, c2, c3;
+    R edge[9];      // backward start values from the last 3 forward values, B already applied
+
+    explicit young_coefficients( double sigma ) {
+        double q;
+        if (sigma >= 2.5)
+            q = 0.98711 * sigma - 0.96330;
+        else
+            q = 3.97156 - 4.14554 * std::sqrt( 1.0 - 0.26891 * sigma );
+        const double q2 = q * q;
+        const double q3 = q2 * q;
+        const double b0 = 1.57825 + 2.44413*q + 1.4281*q2 + 0.422205*q3;
+        const double a1 = (2.44413*q + 2.85619*q2 + 1.26661*q3) / b0;
+        const double a2 = -(1.4281*q2 + 1.26661*q3) / b0;
+        const double a3 = (0.422205*q3) / b0;
+        const double gain = 1.0 - (a1 + a2 + a3);
+        c1 = R( a1 );
+        c2 = R( a2 );
+        c3 = R( a3 );
+        B = R( gain );
+        
+        const double M[9] = {
+            -a3*a1 + 1.0 - a3*a3 - a2,
+            (a3 + a1)*(a2 + a3*a1),
+            a3*(a1 + a3*a2),
+            a1 + a3*a2,
+            -(a2 - 1.0)*(a2 + a3*a1),
+            -(a3*a1 + a3*a3 + a2 - 1.0)*a3,
+            a3*a1 + a2 + a1*a1 - a2*a2,
+            a1*a2 + a3*a2*a2 - a1*a3*a3 - a3*a3*a3 - a3*a2 + a3,
+            a3*(a1 + a3*a2) };
+        const double scale = gain / ((1.0 + a1 - a2 + a3) * (1.0 - a1 - a2 - a3) * (1.0 + a2 + (a1 - a3)*a3));
+        for (int i = 0; i < 9; ++i)
+            edge[i] = R( M[i] * scale );
+    }
+};
+
+/******************************************************************************/
+
+template <typename T>
+class recursive_gaussian {
+public:
+    typedef typename gaussian_real<T>::type R;
+
+    explicit recursive_gaussian( double sigma ) : deriche(sigma), young(sigma) {}
+
+    void deriche2D( const T *src, T *dest, int rows, int cols, int rowStep ) {
+        const deriche_coefficients<R> &k = deriche;
+        work.resize( rows*cols );
+        causal.resize( rows*cols );
+        line.resize( cols );
+        prev1.resize( cols );
+        prev2.resize( cols );
+        
+        // horizontal, serial along each row
+        for (int y = 0; y < rows; ++y) {
+            const T *srcRow = src + y*rowStep;
+            R *out = &work[y*cols];
+            
+            R xp = R(srcRow[0]);
+            R yp1 = k.causalGain * xp, yp2 = yp1;
+            for (int x = 0; x < cols; ++x) {
+                R xc = R(srcRow[x]);
+                R yc = k.a1*xc + k.a2*xp + k.b1*yp1 + k.b2*yp2;
+                xp = xc;
+                yp2 = yp1;
+                yp1 = yc;
+                line[x] = yc;
+            }
+            
+            R xn1 = R(srcRow[cols-1]), xn2 = xn1;
+            R yn1 = k.anticausalGain * xn1, yn2 = yn1;
+            for (int x = cols-1; x >= 0; --x) {
+                R yc = k.a3*xn1 + k.a4*xn2 + k.b1*yn1 + k.b2*yn2;
+                xn2 = xn1;
+                xn1 = R(srcRow[x]);
+                yn2 = yn1;
+                yn1 = yc;
+                out[x] = line[x] + yc;
+            }
+        }
+        
+        // vertical causal, one row at a time so the columns vectorize
+        R *p1 = &prev1[0], *p2 = &prev2[0];
+        for (int x = 0; x < cols; ++x)
+            p1[x] = p2[x] = k.causalGain * work[x];
+        for (int y = 0; y < rows; ++y) {
+            const R *xc = &work[y*cols];
+            const R *xp = &work[ std::max( y-1, 0 )*cols ];
+            R *out = &causal[y*cols];
+            for (int x = 0; x < cols; ++x)
+                out[x] = k.a1*xc[x] + k.a2*xp[x] + k.b1*p1[x] + k.b2*p2[x];
+            std::swap( p1, p2 );
+            std::copy( out, out+cols, p1 );
+        }
+        
+        // vertical anticausal, added to the causal part on the way out
+        for (int x = 0; x < cols; ++x)
+            p1[x] = p2[x] = k.anticausalGain * work[(rows-1)*cols + x];
+        for (int y = rows-1; y >= 0; --y) {
+            const R *xn1 = &work[ std::min( y+1, rows-1 )*cols ];
+            const R *xn2 = &work[ std::min( y+2, rows-1 )*cols ];
+            const R *c = &causal[y*cols];
+            R *l = &line[0];
+            T *destRow = dest + y*rowStep;
+            for (int x = 0; x < cols; ++x) {
+                l[x] = k.a3*xn1[x] + k.a4*xn2[x] + k.b1*p1[x] + k.b2*p2[x];
+                destRow[x] = to_pixel<T>( c[x] + l[x] );
+            }
+            std::swap( p1, p2 );
+            std::copy( l, l+cols, p1 );
+        }
+    }
+
+    void young2D( const T *src, T *dest, int rows, int cols, int rowStep ) {
+        const young_coefficients<R> &k = young;
+        work.resize( rows*cols );
+        line.resize( cols );
+        prev1.resize( cols );
+        prev2.resize( cols );
+        
+        // horizontal, serial along each row, in place
+        for (int y = 0; y < rows; ++y) {
+            const T *srcRow = src + y*rowStep;
+            R *w = &work[y*cols];
+            
+            R w1 = R(srcRow[0]), w2 = w1, w3 = w1;
+            for (int x = 0; x < cols; ++x) {
+                R wc = k.B*R(srcRow[x]) + k.c1*w1 + k.c2*w2 + k.c3*w3;
+                w3 = w2;
+                w2 = w1;
+                w1 = wc;
+                w[x] = wc;
+            }
+            
+            const R last = R(srcRow[cols-1]);
+            const R d0 = w[cols-1] - last;
+            const R d1 = w[ std::max( cols-2, 0 ) ] - last;
+            const R d2 = w[ std::max( cols-3, 0 ) ] - last;
+            w1 = last + k.edge[0]*d0 + k.edge[1]*d1 + k.edge[2]*d2;
+            w2 = last + k.edge[3]*d0 + k.edge[4]*d1 + k.edge[5]*d2;
+            w3 = last + k.edge[6]*d0 + k.edge[7]*d1 + k.edge[8]*d2;
+            w[cols-1] = w1;
+            for (int x = cols-2; x >= 0; --x) {
+                R wc = k.B*w[x] + k.c1*w1 + k.c2*w2 + k.c3*w3;
+                w3 = w2;
+                w2 = w1;
+                w1 = wc;
+                w[x] = wc;
+            }
+        }
+        
+        // keep the last row's input for the backward boundary values
+        R *last = &line[0];
+        std::copy( &work[(rows-1)*cols], &work[(rows-1)*cols] + cols, last );
+        
+        // vertical forward, in place, whole rows at a time
+        for (int y = 1; y < rows; ++y) {
+            R *w = &work[y*cols];
+            const R *w1 = &work[ (y-1)*cols ];
+            const R *w2 = &work[ std::max( y-2, 0 )*cols ];
+            const R *w3 = &work[ std::max( y-3, 0 )*cols ];
+            for (int x = 0; x < cols; ++x)
+                w[x] = k.B*w[x] + k.c1*w1[x] + k.c2*w2[x] + k.c3*w3[x];
+        }
+        
+        // boundary values for the last row and the 2 rows after it
+        {
+            R *w0 = &work[(rows-1)*cols];
+            const R *w1 = &work[ std::max( rows-2, 0 )*cols ];
+            const R *w2 = &work[ std::max( rows-3, 0 )*cols ];
+            R *after1 = &prev1[0], *after2 = &prev2[0];
+            T *destRow = dest + (rows-1)*rowStep;
+            for (int x = 0; x < cols; ++x) {
+                const R d0 = w0[x] - last[x];
+                const R d1 = w1[x] - last[x];
+                const R d2 = w2[x] - last[x];
+                after1[x] = last[x] + k.edge[3]*d0 + k.edge[4]*d1 + k.edge[5]*d2;
+                after2[x] = last[x] + k.edge[6]*d0 + k.edge[7]*d1 + k.edge[8]*d2;
+                w0[x] = last[x] + k.edge[0]*d0 + k.edge[1]*d1 + k.edge[2]*d2;
+                destRow[x] = to_pixel<T>( w0[x] );
+            }
+        }
+        
+        // vertical backward, in place, converting on the way out
+        for (int y = rows-2; y >= 0; --y) {
+            R *w = &work[y*cols];
+            const R *w1 = &work[ (y+1)*cols ];
+            const R *w2 = (y+2 < rows) ? &work[ (y+2)*cols ] : &prev1[0];
+            const R *w3 = (y+3 < rows) ? &work[ (y+3)*cols ] : ((y+3 == rows) ? &prev1[0] : &prev2[0]);
+            T *destRow = dest + y*rowStep;
+            for (int x = 0; x < cols; ++x) {
+                w[x] = k.B*w[x] + k.c1*w1[x] + k.c2*w2[x] + k.c3*w3[x];
+                destRow[x] = to_pixel<T>( w[x] );
+            }
+        }
+    }
+
+private:
+    deriche_coefficients<R> deriche;
+    young_coefficients<R> young;
+    std::vector<R> work;
+    std::vector<R> causal;
+    std::vector<R> line;
+    std::vector<R> prev1;
+    std::vector<R> prev2;
+};
+
+/******************************************************************************/
+
+// Box filter from a summed area table, with edge replication, rounding once.
+// The table covers the image extended by the replicated edges, so boxes never need clamping.
+// Only edge+1 rows of the table are needed at a time, kept in a ring.
+// With unsigned wrapping sums (TI = uint32_t for 8 and 16 bit data) the table overflows,
+//   but each box sum is still exact, because the box sum itself fits in TI.
+template<typename T, typename TI>
+void integral_box_2D(const T *src, T *dest, int rows, int cols, int rowStep, int edge, std::vector<TI> &ring ) {
+    const bool isFloat = (T(2.9) > T(2.0));
+    const TI area = TI(edge) * TI(edge);
+    const TI half = isFloat ? TI(0) : TI(area / 2);
+    const int halfEdge = edge / 2;
+    const int width = cols + edge;          // table columns, including the zero column
+    const int slots = edge + 1;
+    
+    ring.resize( slots * width );
+    
+    // table row i is the sum over extended rows [0,i), row 0 is all zeros
+    TI *zero = &ring[0];
+    for (int j = 0; j < width; ++j)
+        zero[j] = TI(0);
+    
+    for (int i = 1; i < rows + edge; ++i) {
+        const T *srcRow = src + std::min( std::max( i-1-halfEdge, 0 ), rows-1 ) * rowStep;
+        const TI *above = &ring[ ((i-1) % slots) * width ];
+        TI *current = &ring[ (i % slots) * width ];
+        
+        TI rowSum = TI(0);
+        current[0] = TI(0);
+        for (int j = 1; j < width; ++j) {
+            rowSum += TI( srcRow[ std::min( std::max( j-1-halfEdge, 0 ), cols-1 ) ] );
+            current[j] = above[j] + rowSum;
+        }
+        
+        // output row y needs table rows y and y+edge
+        const int y = i - edge;
+        if (y < 0)
+            continue;
+        
+        const TI *top = &ring[ (y % slots) * width ];
+        T *destRow = dest + y*rowStep;
+        for (int x = 0; x < cols; ++x) {
+            TI sum = current[x+edge] - top[x+edge] - current[x] + top[x];
+            destRow[x] = T( (sum + half) / area );
+        }
+    }
+}
+
+/******************************************************************************/
+
+// separable gaussian computed directly in double, truncated at 4 sigma, with replicated edges
+template <typename T>
+void reference_gaussian( const std::vector<T> &src, std::vector<double> &dest, int rows, int cols, double sigma ) {
+    const int radius = int( std::ceil( 4.0 * sigma ) );
+    std::vector<double> weights( 2*radius+1 );
+    double total = 0.0;
+    for (int k = -radius; k <= radius; ++k)
+        total += (weights[k+radius] = std::exp( -0.5 * k * k / (sigma * sigma) ));
+    for (auto &w : weights)
+        w /= total;
+    
+    std::vector<double> temp( rows*cols );
+    for (int y = 0; y < rows; ++y)
+        for (int x = 0; x < cols; ++x) {
+            double sum = 0.0;
+            for (int k = -radius; k <= radius; ++k)
+                sum += weights[k+radius] * double( src[ y*cols + std::min( std::max( x+k, 0 ), cols-1 ) ] );
+            temp[y*cols+x] = sum;
+        }
+    
+    dest.resize( rows*cols );
+    for (int y = 0; y < rows; ++y)
+        for (int x = 0; x < cols; ++x) {
+            double sum = 0.0;
+            for (int k = -radius; k <= radius; ++k)
+                sum += weights[k+radius] * temp[ std::min( std::max( y+k, 0 ), rows-1 )*cols + x ];
+            dest[y*cols+x] = sum;
+        }
+}
+
+/******************************************************************************/
+
+// Only compares pixels at least border away from the edges:
+//   repeated box passes replicate the blurred result, not the source, so their edges differ.
+template <typename T>
+double max_gaussian_error( const std::vector<T> &result, const std::vector<double> &expected, int rows, int cols, int border ) {
+    double worst = 0.0;
+    for (int y = border; y < rows - border; ++y)
+        for (int x = border; x < cols - border; ++x)
+            worst = std::max( worst, std::abs( double(result[y*cols+x]) - expected[y*cols+x] ) );
+    return worst;
+}
+
+/******************************************************************************/
+
+// the gaussian approximations used in the timed tests
+enum gaussianMethod { kGaussBox3, kGaussIntegral3Wrapping, kGaussIntegral3Wide, kGaussDeriche, kGaussYoung };
+
+template <typename T, typename TS>
+class gaussian_blur {
+public:
+    typedef typename std::conditional< std::numeric_limits<T>::is_integer, uint32_t, double >::type wrapping_sum;
+    typedef typename std::conditional< std::numeric_limits<T>::is_integer, uint64_t, double >::type wide_sum;
+
+    gaussian_blur( double sigma ) : recursive(sigma), boxWidth( box_width_for_sigma(sigma) ), pipeline(1), pool(1) {}
+
+    int box_width() const { return boxWidth; }
+
+    // src and dest must be different, temp is used by the multiple pass methods
+    void operator()( gaussianMethod method, const T *src, T *dest, T *temp, int rows, int cols, int rowStep ) {
+        switch (method) {
+            case kGaussBox3:
+                pipeline( pool, 1, src, dest, rows, cols, rowStep, boxWidth, 512, 128 );
+                pipeline( pool, 1, dest, temp, rows, cols, rowStep, boxWidth, 512, 128 );
+                pipeline( pool, 1, temp, dest, rows, cols, rowStep, boxWidth, 512, 128 );
+                break;
+            case kGaussIntegral3Wrapping:
+                integral_box_2D<T,wrapping_sum>( src, dest, rows, cols, rowStep, boxWidth, wrappingRing );
+                integral_box_2D<T,wrapping_sum>( dest, temp, rows, cols, rowStep, boxWidth, wrappingRing );
+                integral_box_2D<T,wrapping_sum>( temp, dest, rows, cols, rowStep, boxWidth, wrappingRing );
+                break;
+            case kGaussIntegral3Wide:
+                integral_box_2D<T,wide_sum>( src, dest, rows, cols, rowStep, boxWidth, wideRing );
+                integral_box_2D<T,wide_sum>( dest, temp, rows, cols, rowStep, boxWidth, wideRing );
+                integral_box_2D<T,wide_sum>( temp, dest, rows, cols, rowStep, boxWidth, wideRing );
+                break;
+            case kGaussDeriche:
+                recursive.deriche2D( src, dest, rows, cols, rowStep );
+                break;
+            case kGaussYoung:
+                recursive.young2D( src, dest, rows, cols, rowStep );
+                break;
+        }
+    }
+
+private:
+    recursive_gaussian<T> recursive;
+    int boxWidth;
+    box_blur_pipeline<T,TS> pipeline;
+    benchmark::thread_pool pool;
+    std::vector<wrapping_sum> wrappingRing;
+    std::vector<wide_sum> wideRing;
+};
+
+/******************************************************************************/
+
+// Compare the constant time gaussian approximations for several sigmas on the 4K frame.
+// Labels include the largest error against a true gaussian, on a small image of random 0..255 values,
+//   away from the edges. The edges are checked with the constant source.
+template< typename T, typename TS >
+void TestGaussianBlur()
+{
+    const int base_iterations = iterations;
+    const double sigmas[] = { 2.0, 5.0, 10.0, 20.0 };
+    const int testRows = 251, testCols = 307;
+    const bool isInteger = std::numeric_limits<T>::is_integer;
+
+    std::string myTypeName( getTypeName<T>() );
+    
+    std::vector<T> src( SIZE, T(init_value) );
+    std::vector<T> dest( SIZE );
+    std::vector<T> temp( SIZE );
+    
+    std::vector<T> testSrc( testRows*testCols ), testDest( testRows*testCols ), testTemp( testRows*testCols );
+    uint32_t seed = 12345;
+    for (auto &value : testSrc) {
+        seed = seed * 1664525 + 1013904223;
+        value = T( (seed >> 8) % 256 );
+    }
+    std::vector<double> expected;
+    std::vector<T> boxResult;
+
+    struct method_info { gaussianMethod method; const char *name; bool integerOnly; };
+    const method_info methods[] = {
+        { kGaussBox3, "3 box passes", false },
+        { kGaussIntegral3Wrapping, "3 integral image box passes, 32 bit wrapping sums", true },
+        { kGaussIntegral3Wide, isInteger ? "3 integral image box passes, 64 bit sums" : "3 integral image box passes, double sums", false },
+        { kGaussDeriche, "Deriche recursive", false },
+        { kGaussYoung, "Young van Vliet recursive", false },
+    };
+
+    // a full scale frame overflows the 32 bit table many times over, but the box sums stay exact
+    if (isInteger) {
+        std::vector<T> full( SIZE, std::numeric_limits<T>::max() );
+        std::vector<uint32_t> ring;
+        integral_box_2D( &full[0], &dest[0], HEIGHT, WIDTH, WIDTH, 21, ring );
+        for (int i = 0; i < SIZE; ++i)
+            if (dest[i] != full[i]) {
+                printf("test %s integral image box with wrapping sums failed\n", myTypeName.c_str() );
+                break;
+            }
+    }
+
+    iterations = std::max( 1, base_iterations / 5 );
+
+    for (double sigma : sigmas) {
+        gaussian_blur<T,TS> blur( sigma );
+        reference_gaussian( testSrc, expected, testRows, testCols, sigma );
+        
+        gLabels.clear();
+        char buffer[ 200 ];
+        
+        for (const auto &info : methods) {
+            if (info.integerOnly && !isInteger)
+                continue;
+            
+            blur( info.method, &testSrc[0], &testDest[0], &testTemp[0], testRows, testCols, testCols );
+            double error = max_gaussian_error( testDest, expected, testRows, testCols, int( 3.0 * sigma ) );
+            bool isBox = (info.method == kGaussBox3 || info.method == kGaussIntegral3Wrapping || info.method == kGaussIntegral3Wide);
+            
+            if (info.method == kGaussBox3)
+                boxResult = testDest;
+            
+            // integral images round once per pass instead of twice, everything else must match the sliding box
+            if (isBox && info.method != kGaussBox3) {
+                double limit = isInteger ? 2.0 : 0.01;
+                for (size_t j = 0; j < testDest.size(); ++j)
+                    if (std::abs( double(testDest[j]) - double(boxResult[j]) ) > limit) {
+                        printf("test %s %s sigma %g failed verification against the sliding box\n", myTypeName.c_str(), info.name, sigma );
+                        break;
+                    }
+            }
+            
+            // the recursive filters should stay within a few percent of 255
+            if (!isBox && error > 8.0)
+                printf("test %s %s sigma %g failed verification, max error %g\n", myTypeName.c_str(), info.name, sigma, error );
+            
+            if (isBox)
+                snprintf( buffer, sizeof(buffer), "%s %s, width %d, max error %.2f", myTypeName.c_str(), info.name, blur.box_width(), error );
+            else
+                snprintf( buffer, sizeof(buffer), "%s %s, max error %.2f", myTypeName.c_str(), info.name, error );
+            std::string label( buffer );
+            
+            start_timer();
+            for (int i = 0; i < iterations; ++i)
+                blur( info.method, &src[0], &dest[0], &temp[0], HEIGHT, WIDTH, WIDTH );
+            double elapsed = timer();
+            
+            gLabels.push_back( label );
+            record_result( elapsed, gLabels.back().c_str() );
+            check_add_rows( &dest[0], HEIGHT, WIDTH, WIDTH, label );
+        }
+        
+        snprintf( buffer, sizeof(buffer), "%s convolution_box gaussian sigma %g", myTypeName.c_str(), sigma );
+        summarize( buffer, SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    }
+
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 int main(int argc, char** argv) {
     
     // output command for documentation:
@@ -2804,6 +3714,17 @@ int main(int argc, char** argv) {
     TestOneType<double,double>();
 
 
+    // the types most used for image pipelines
+    benchmark::thread_pool pool;
+    TestTiledPipeline<uint8_t, uint16_t>( pool );
+    TestTiledPipeline<uint16_t, uint32_t>( pool );
+    TestTiledPipeline<float,float>( pool );
+
+    TestGaussianBlur<uint8_t, uint16_t>();
+    TestGaussianBlur<uint16_t, uint32_t>();
+    TestGaussianBlur<float,float>();
+
+
 #if WORKS_BUT_SLOW
     TestOneType<long double,long double>();
 #endif
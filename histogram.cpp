@@ -17,6 +17,17 @@ Assumptions:
     2) The compiler should recognize ineffecient histogram idioms and substitute efficient methods.
         NOTE: Best methods depend greatly on the CPU architecture (cache, branching, vector, etc.).
 
+    3) Private histograms per thread, merged at the end, should scale with threads until memory bandwidth runs out.
+        Shared atomic bins will scale poorly, and worst of all on skewed data.
+
+    4) Histograms with more bins than fit in cache will be limited by cache misses,
+        and partitioning the data first can keep each group of bins in cache.
+
+    5) Quantile sketches will be much faster than exact quantiles, with known error bounds.
+
+
+NOTE - the quantile sketch labels include the largest value and rank errors at the 50, 90, 99 and 99.9 percentiles.
+
 
 */
 
@@ -27,9 +38,17 @@ Assumptions:
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_algorithms.h"
+#include "benchmark_threads.h"
 
 /******************************************************************************/
 /******************************************************************************/
@@ -72,6 +91,8 @@ uint32_t histogram32F[ float_hist_size ];
 uint64_t histogram64F[ float_hist_size ];
 uint64_t referenceHistogramF[ float_hist_size ];
 
+std::deque<std::string> gLabels;
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -742,6 +763,954 @@ void test_histogramFloat5(const T* input, const int count, X* histogram, const T
 /******************************************************************************/
 /******************************************************************************/
 
+/*
+    Threaded histograms, for large images and data streams.
+    Each thread counts a contiguous chunk into its own private bins, then the private histograms are merged:
+        serial merge        the calling thread adds all the private histograms
+        tree merge          pairs of histograms are added in parallel, log2(threads) rounds
+        bin range merge     each thread sums one range of bins across all the private histograms (vectorizes)
+    The shared atomic version has every thread increment one histogram, which is slow when values repeat,
+        because every thread contends for the same cache lines.
+    Skewed data puts most values in one bin, which also causes store to load stalls in a single thread.
+*/
+
+// map each input type to a bin, with one extra bin to collect rejected values
+struct byte_binner {
+    static const size_t bins = 256;
+    size_t operator()( uint8_t value ) const { return value; }
+};
+
+struct short_binner {
+    static const size_t bins = 65536;
+    size_t operator()( uint16_t value ) const { return value; }
+};
+
+struct float_binner {
+    static const size_t bins = float_hist_size;
+    float_binner( float minV, float maxV ) : minVal(minV), scale( (float_hist_size-1) / double(maxV - minV) ) {}
+    size_t operator()( float value ) const {
+        int index = int( scale * (value - minVal) );
+        return (index >= 0 && index < float_hist_size) ? size_t(index) : bins;    // reject NaN and out of range values
+    }
+    float minVal;
+    double scale;
+};
+
+/******************************************************************************/
+
+template<typename T, typename Binner>
+void count_bins( const T *input, size_t count, const Binner &binner, uint64_t *bins ) {
+    for (size_t j = 0; j < count; ++j)
+        bins[ binner( input[j] ) ] += 1;
+}
+
+/******************************************************************************/
+
+// 4 interleaved sub-histograms so repeated values don't wait on the previous store, as in test_histogram5
+// 32 bit sub-histograms stay in L1 for small bin counts, and are added to the 64 bit bins every 2^30 items
+template<typename T, typename Binner>
+void count_bins4( const T *input, size_t count, const Binner &binner, uint64_t *bins ) {
+    const size_t stride = Binner::bins + 1;
+    const size_t piece = size_t(1) << 30;
+    std::vector<uint32_t> storage( 4*stride );
+    uint32_t *sub = storage.data();
+    
+    for (size_t start = 0; start < count; start += piece) {
+        const size_t end = std::min( count, start + piece );
+        std::fill( sub, sub + 4*stride, 0 );
+        size_t j;
+        for (j = start; (j + 4) <= end; j += 4) {
+            sub[ 0*stride + binner( input[j+0] ) ] += 1;
+            sub[ 1*stride + binner( input[j+1] ) ] += 1;
+            sub[ 2*stride + binner( input[j+2] ) ] += 1;
+            sub[ 3*stride + binner( input[j+3] ) ] += 1;
+        }
+        for ( ; j < end; ++j)
+            sub[ binner( input[j] ) ] += 1;
+        for (size_t k = 0; k < stride; ++k)
+            bins[k] += uint64_t(sub[k]) + sub[stride+k] + sub[2*stride+k] + sub[3*stride+k];
+    }
+}
+
+/******************************************************************************/
+
+enum histogram_merge { kMergeSerial, kMergeTree, kMergeBinRanges };
+
+// Private bins are allocated once and reused, each thread's bins start on their own cache line.
+template<typename T, typename Binner>
+struct threaded_histogram {
+    threaded_histogram( benchmark::thread_pool &threads, const Binner &b ) :
+        pool(threads), binner(b), stride( (Binner::bins + 1 + 7) & ~size_t(7) ),
+        privateBins( threads.size() * stride ), sharedBins( new std::atomic<uint64_t>[ Binner::bins + 1 ] ) {}
+
+    // result needs Binner::bins entries, rejected values are not returned
+    void count_private( int threads, const T *input, size_t count, bool interleaved, histogram_merge merge, uint64_t *result ) {
+        const size_t chunk = (count + threads - 1) / threads;
+        
+        pool.run( threads, [&]( int t ) {
+            const size_t start = std::min( count, t * chunk );
+            const size_t end = std::min( count, start + chunk );
+            uint64_t *bins = privateBins.data() + t * stride;
+            std::fill( bins, bins + stride, 0 );
+            if (interleaved)
+                count_bins4( input + start, end - start, binner, bins );
+            else
+                count_bins( input + start, end - start, binner, bins );
+        } );
+        
+        switch (merge) {
+            case kMergeSerial:
+                merge_serial( threads, result );
+                break;
+            case kMergeTree:
+                merge_tree( threads, result );
+                break;
+            case kMergeBinRanges:
+                merge_bin_ranges( threads, result );
+                break;
+        }
+    }
+
+    void merge_serial( int threads, uint64_t *result ) {
+        const uint64_t *bins = privateBins.data();
+        std::copy( bins, bins + Binner::bins, result );
+        for (int t = 1; t < threads; ++t) {
+            bins = privateBins.data() + t * stride;
+            for (size_t k = 0; k < Binner::bins; ++k)
+                result[k] += bins[k];
+        }
+    }
+
+    // each round adds histogram t+step into histogram t, for t a multiple of 2*step
+    void merge_tree( int threads, uint64_t *result ) {
+        for (int step = 1; step < threads; step *= 2) {
+            const int pairs = (threads - step + 2*step - 1) / (2*step);
+            pool.run( pairs, [&]( int p ) {
+                uint64_t *target = privateBins.data() + (2*step*p) * stride;
+                const uint64_t *source = target + step * stride;
+                for (size_t k = 0; k < Binner::bins; ++k)
+                    target[k] += source[k];
+            } );
+        }
+        std::copy( privateBins.data(), privateBins.data() + Binner::bins, result );
+    }
+
+    // ranges are whole cache lines of results, to avoid false sharing
+    void merge_bin_ranges( int threads, uint64_t *result ) {
+        const size_t lineItems = 64 / sizeof(uint64_t);
+        size_t range = (Binner::bins + threads - 1) / threads;
+        range = ((range + lineItems - 1) / lineItems) * lineItems;
+        const int ranges = int( (Binner::bins + range - 1) / range );
+        
+        pool.run( ranges, [&]( int r ) {
+            const size_t start = r * range;
+            const size_t end = std::min( Binner::bins, start + range );
+            const uint64_t *bins = privateBins.data();
+            std::copy( bins + start, bins + end, result + start );
+            for (int t = 1; t < threads; ++t) {
+                bins = privateBins.data() + t * stride;
+                for (size_t k = start; k < end; ++k)
+                    result[k] += bins[k];
+            }
+        } );
+    }
+
+    void count_atomic( int threads, const T *input, size_t count, uint64_t *result ) {
+        std::atomic<uint64_t> *shared = sharedBins.get();
+        for (size_t k = 0; k <= Binner::bins; ++k)
+            shared[k].store( 0, std::memory_order_relaxed );
+        
+        const size_t chunk = (count + threads - 1) / threads;
+        pool.run( threads, [&]( int t ) {
+            const size_t start = std::min( count, t * chunk );
+            const size_t end = std::min( count, start + chunk );
+            for (size_t j = start; j < end; ++j)
+                shared[ binner( input[j] ) ].fetch_add( 1, std::memory_order_relaxed );
+        } );
+        
+        for (size_t k = 0; k < Binner::bins; ++k)
+            result[k] = shared[k].load( std::memory_order_relaxed );
+    }
+
+    benchmark::thread_pool &pool;
+    Binner binner;
+    const size_t stride;
+    std::vector<uint64_t> privateBins;
+    std::unique_ptr< std::atomic<uint64_t>[] > sharedBins;
+};
+
+/******************************************************************************/
+
+// input sizes in bytes, from L2 resident to well beyond most L3 caches
+// with enough memory, add larger sizes here to test multi-gigabyte streams
+const size_t threaded_histogram_bytes[] = { size_t(1) << 20, size_t(1) << 24, size_t(1) << 28 };
+
+/******************************************************************************/
+
+// Each data set gets its own summary, timed with the wall clock, 1..N threads.
+// Scaling efficiency is the speedup over one thread of the same method divided by the number of threads.
+template<typename T, typename Binner>
+void test_threaded_histogram( benchmark::thread_pool &pool, const std::vector<int> &threadCounts,
+                              const T *input, size_t count, const Binner &binner, bool interleaved,
+                              const std::string &name ) {
+    const double workBudget = double(SIZE) * double(iterations) / 4.0;
+    const int repeats = std::max( 1, int(workBudget / double(count)) );
+    
+    std::vector<uint64_t> reference( Binner::bins, 0 );
+    std::vector<uint64_t> result( Binner::bins );
+    {
+        std::vector<uint64_t> bins( Binner::bins + 1, 0 );
+        count_bins( input, count, binner, bins.data() );
+        std::copy( bins.begin(), bins.begin() + Binner::bins, reference.begin() );
+    }
+    
+    threaded_histogram<T,Binner> engine( pool, binner );
+    
+    struct method {
+        const char *label;
+        int kind;       // a merge, or -1 for shared atomic
+        bool interleaved;
+    };
+    const method methods[] = {
+        { "private bins, serial merge", kMergeSerial, false },
+        { "private bins, tree merge", kMergeTree, false },
+        { "private bins, bin range merge", kMergeBinRanges, false },
+        { "private 4 way bins, tree merge", kMergeTree, true },
+        { "shared atomic bins", -1, false },
+    };
+    
+    for (const method &m : methods) {
+        if (m.interleaved && !interleaved)
+            continue;
+        double oneThread = 0.0;
+        
+        for (int threads : threadCounts) {
+            start_wall_timer();
+            for (int i = 0; i < repeats; ++i) {
+                if (m.kind < 0)
+                    engine.count_atomic( threads, input, count, result.data() );
+                else
+                    engine.count_private( threads, input, count, m.interleaved, histogram_merge(m.kind), result.data() );
+            }
+            double elapsed = wall_timer();
+            
+            if (threads == 1)
+                oneThread = elapsed;
+            double efficiency = (elapsed > 0.0) ? 100.0 * oneThread / (elapsed * threads) : 0.0;
+            
+            char suffix[ 100 ];
+            snprintf( suffix, sizeof(suffix), " %d threads, %.0f%% efficiency", threads, efficiency );
+            gLabels.push_back( name + " " + m.label + suffix );
+            record_result( elapsed, gLabels.back().c_str() );
+            
+            if (result != reference)
+                printf("test %s failed\n", gLabels.back().c_str() );
+        }
+    }
+    
+    summarize( name.c_str(), int(count), repeats, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+
+// uniform data, and skewed data with 7 of every 8 values in one bin
+template<typename T, typename Binner, typename Generator>
+void TestThreadedHistogramType( benchmark::thread_pool &pool, const std::vector<int> &threadCounts,
+                                const Binner &binner, Generator generate, T common, bool interleaved,
+                                const std::string &myTypeName ) {
+    for (size_t bytes : threaded_histogram_bytes) {
+        const size_t count = bytes / sizeof(T);
+        std::vector<T> data( count );
+        
+        scrand( init_value + 48 );
+        for (size_t j = 0; j < count; ++j)
+            data[j] = generate();
+        test_threaded_histogram( pool, threadCounts, data.data(), count, binner, interleaved,
+                                 myTypeName + " uniform " + std::to_string(bytes >> 20) + "MB" );
+        
+        for (size_t j = 0; j < count; ++j)
+            if ((crand64() & 7) != 0)
+                data[j] = common;
+        test_threaded_histogram( pool, threadCounts, data.data(), count, binner, interleaved,
+                                 myTypeName + " skewed " + std::to_string(bytes >> 20) + "MB" );
+    }
+}
+
+/******************************************************************************/
+
+void TestThreadedHistograms( benchmark::thread_pool &pool )
+{
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < pool.size(); threads *= 2)
+        threadCounts.push_back( threads );
+    threadCounts.push_back( pool.size() );
+    
+    gLabels.clear();
+    
+    TestThreadedHistogramType<uint8_t>( pool, threadCounts, byte_binner(),
+                                        []() { return uint8_t( crand64() ); }, uint8_t(42), true, "uint8_t" );
+    
+    TestThreadedHistogramType<uint16_t>( pool, threadCounts, short_binner(),
+                                         []() { return uint16_t( crand64() ); }, uint16_t(4242), false, "uint16_t" );
+    
+    // same value range as the single threaded float tests, including some rejected values
+    TestThreadedHistogramType<float>( pool, threadCounts, float_binner( -200.0f, 16000.0f ),
+                                      []() { return -400.0f + float( crand64() & 0x00FFFFFF ) * (20400.0f / 16777215.0f); },
+                                      1000.0f, false, "float" );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    2D joint histograms, as used for image registration (mutual information) and color analysis.
+    Two 8 bit channels give 65536 bins, which fit in L2 but not L1.
+*/
+
+// baseline - index by both values
+void joint_histogram1( const uint8_t *first, const uint8_t *second, size_t count, uint32_t *bins ) {
+    std::fill( bins, bins + 65536, 0 );
+    for (size_t j = 0; j < count; ++j)
+        bins[ (size_t(first[j]) << 8) | second[j] ] += 1;
+}
+
+/******************************************************************************/
+
+// unroll 4X, alternate between two histograms and sum at the end
+void joint_histogram2( const uint8_t *first, const uint8_t *second, size_t count, uint32_t *bins ) {
+    static uint32_t bins1[ 65536 ];     // static because MSVC won't allocate that much on the stack!
+    std::fill( bins, bins + 65536, 0 );
+    std::fill( bins1, bins1 + 65536, 0 );
+    size_t j;
+    for (j = 0; j < (count & ~size_t(3)); j += 4) {
+        size_t index0 = (size_t(first[j+0]) << 8) | second[j+0];
+        size_t index1 = (size_t(first[j+1]) << 8) | second[j+1];
+        size_t index2 = (size_t(first[j+2]) << 8) | second[j+2];
+        size_t index3 = (size_t(first[j+3]) << 8) | second[j+3];
+        bins[ index0 ] += 1;
+        bins1[ index1 ] += 1;
+        bins[ index2 ] += 1;
+        bins1[ index3 ] += 1;
+    }
+    for ( ; j < count; ++j)
+        bins[ (size_t(first[j]) << 8) | second[j] ] += 1;
+    for (j = 0; j < 65536; ++j)
+        bins[j] += bins1[j];
+}
+
+/******************************************************************************/
+
+// fewer, coarser bins: 64x64 fits in L1
+void joint_histogram_coarse( const uint8_t *first, const uint8_t *second, size_t count, uint32_t *bins ) {
+    std::fill( bins, bins + 4096, 0 );
+    for (size_t j = 0; j < count; ++j)
+        bins[ (size_t(first[j] >> 2) << 6) | (second[j] >> 2) ] += 1;
+}
+
+/******************************************************************************/
+
+// float pairs mapped to a 256x256 grid, rejecting values outside the range
+void joint_histogram_float( const float *first, const float *second, size_t count, float minVal, float maxVal, uint32_t *bins ) {
+    const float scale = 255.0f / (maxVal - minVal);
+    std::fill( bins, bins + 65536, 0 );
+    for (size_t j = 0; j < count; ++j) {
+        int x = int( scale * (first[j] - minVal) );
+        int y = int( scale * (second[j] - minVal) );
+        if (x >= 0 && x < 256 && y >= 0 && y < 256)    // reject NaN and out of range values
+            bins[ (x << 8) | y ] += 1;
+    }
+}
+
+/******************************************************************************/
+
+// compares all the bins against a reference, used by the joint and wide histogram tests
+template<typename Func>
+void test_bin_histogram( Func func, uint32_t *bins, size_t binCount, const std::vector<uint32_t> &reference, const std::string label ) {
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        func( bins );
+    
+    if (!std::equal( bins, bins + binCount, reference.begin() ))
+        printf("test %s failed\n", label.c_str() );
+
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+// a 1024x1024 image pair, with the second channel correlated with the first
+void TestJointHistograms()
+{
+    const size_t count = 1024*1024;
+    const int base_iterations = iterations;
+    std::vector<uint8_t> first( count ), second( count );
+    std::vector<float> firstF( count ), secondF( count );
+    std::vector<uint32_t> bins( 65536 ), reference( 65536 ), referenceCoarse( 4096 ), referenceF( 65536 );
+    
+    scrand( init_value + 49 );
+    for (size_t j = 0; j < count; ++j) {
+        first[j] = uint8_t( crand64() );
+        second[j] = uint8_t( first[j] + (crand64() & 31) );
+        firstF[j] = float( first[j] ) + 0.25f;
+        secondF[j] = float( second[j] ) - 16.0f;
+    }
+    
+    joint_histogram1( first.data(), second.data(), count, reference.data() );
+    
+    // the other references come from the full histogram: coarse bins sum 4x4 blocks,
+    // float pairs land one bin per value after the +0.25 and -16 offsets, rejecting second values below 16
+    for (size_t x = 0; x < 256; ++x)
+        for (size_t y = 0; y < 256; ++y) {
+            const uint32_t value = reference[ (x << 8) | y ];
+            referenceCoarse[ ((x >> 2) << 6) | (y >> 2) ] += value;
+            if (y >= 16)
+                referenceF[ (x << 8) | (y - 16) ] += value;
+        }
+    
+    iterations = std::max( 1, int( (int64_t(base_iterations) * SIZE) / int64_t(count) ) );
+    gLabels.clear();
+    
+    test_bin_histogram( [&]( uint32_t *b ) { joint_histogram1( first.data(), second.data(), count, b ); },
+                          bins.data(), 65536, reference, "uint8_t 256x256 joint histogram1" );
+    test_bin_histogram( [&]( uint32_t *b ) { joint_histogram2( first.data(), second.data(), count, b ); },
+                          bins.data(), 65536, reference, "uint8_t 256x256 joint histogram2" );
+    test_bin_histogram( [&]( uint32_t *b ) { joint_histogram_coarse( first.data(), second.data(), count, b ); },
+                          bins.data(), 4096, referenceCoarse, "uint8_t 64x64 joint histogram" );
+    test_bin_histogram( [&]( uint32_t *b ) { joint_histogram_float( firstF.data(), secondF.data(), count, 0.0f, 255.0f, b ); },
+                          bins.data(), 65536, referenceF, "float 256x256 joint histogram" );
+    
+    summarize("joint histogram", int(count), iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Wide histograms: 2^16 to 2^20 bins, indexed by the top bits of 32 bit values.
+    Once the bins are out of L1 (and then L2), each increment is a cache miss.
+    Partitioning by the top bits first makes each group of bins small enough to stay in cache,
+        at the cost of an extra pass over the data.
+*/
+
+void wide_histogram1( const uint32_t *input, size_t count, int bits, uint32_t *bins ) {
+    const int shift = 32 - bits;
+    std::fill( bins, bins + (size_t(1) << bits), 0 );
+    for (size_t j = 0; j < count; ++j)
+        bins[ input[j] >> shift ] += 1;
+}
+
+/******************************************************************************/
+
+// unroll 4X, with all the loads first so the misses overlap
+void wide_histogram2( const uint32_t *input, size_t count, int bits, uint32_t *bins ) {
+    const int shift = 32 - bits;
+    std::fill( bins, bins + (size_t(1) << bits), 0 );
+    size_t j;
+    for (j = 0; j < (count & ~size_t(3)); j += 4) {
+        uint32_t index0 = input[j+0] >> shift;
+        uint32_t index1 = input[j+1] >> shift;
+        uint32_t index2 = input[j+2] >> shift;
+        uint32_t index3 = input[j+3] >> shift;
+        bins[ index0 ] += 1;
+        bins[ index1 ] += 1;
+        bins[ index2 ] += 1;
+        bins[ index3 ] += 1;
+    }
+    for ( ; j < count; ++j)
+        bins[ input[j] >> shift ] += 1;
+}
+
+/******************************************************************************/
+
+// scatter bin indices into 256 partitions by their top 8 bits, then count each partition
+// scratch holds count indices, and is allocated by the caller
+void wide_histogram_partitioned( const uint32_t *input, size_t count, int bits, uint32_t *bins, uint32_t *scratch ) {
+    const int shift = 32 - bits;
+    const size_t partitions = 256;
+    size_t start[ partitions + 1 ];
+    size_t fill[ partitions ];
+    
+    std::fill( bins, bins + (size_t(1) << bits), 0 );
+    std::fill( start, start + partitions + 1, 0 );
+    
+    for (size_t j = 0; j < count; ++j)
+        start[ (input[j] >> 24) + 1 ] += 1;
+    for (size_t p = 0; p < partitions; ++p) {
+        start[p+1] += start[p];
+        fill[p] = start[p];
+    }
+    
+    for (size_t j = 0; j < count; ++j) {
+        uint32_t value = input[j];
+        scratch[ fill[ value >> 24 ]++ ] = value >> shift;
+    }
+    
+    for (size_t p = 0; p < partitions; ++p)
+        for (size_t j = start[p]; j < start[p+1]; ++j)
+            bins[ scratch[j] ] += 1;
+}
+
+/******************************************************************************/
+
+void TestWideHistograms()
+{
+    const size_t count = size_t(1) << 22;
+    const int base_iterations = iterations;
+    const int bitSizes[] = { 16, 18, 20 };
+    std::vector<uint32_t> input( count ), scratch( count );
+    std::vector<uint32_t> bins( size_t(1) << 20 ), reference( size_t(1) << 20 );
+    
+    scrand( init_value + 4949 );
+    for (size_t j = 0; j < count; ++j)
+        input[j] = uint32_t( crand64() );
+    
+    iterations = std::max( 1, int( (int64_t(base_iterations) * SIZE) / int64_t(count) ) );
+    
+    for (int bits : bitSizes) {
+        const size_t binCount = size_t(1) << bits;
+        wide_histogram1( input.data(), count, bits, reference.data() );
+        gLabels.clear();
+        
+        std::string name( "uint32_t " + std::to_string(binCount) + " bin histogram" );
+        test_bin_histogram( [&]( uint32_t *b ) { wide_histogram1( input.data(), count, bits, b ); },
+                              bins.data(), binCount, reference, name + "1" );
+        test_bin_histogram( [&]( uint32_t *b ) { wide_histogram2( input.data(), count, bits, b ); },
+                              bins.data(), binCount, reference, name + "2" );
+        test_bin_histogram( [&]( uint32_t *b ) { wide_histogram_partitioned( input.data(), count, bits, b, scratch.data() ); },
+                              bins.data(), binCount, reference, name + " partitioned" );
+        
+        summarize( name.c_str(), int(count), iterations, kDontShowGMeans, kDontShowPenalty );
+    }
+    
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Streaming quantile sketches, for percentiles of large metric streams
+    Each keeps a small summary instead of every sample:
+        log buckets         DDSketch style, bucket boundaries grow by (1+alpha)/(1-alpha),
+                            so every quantile is within a relative error alpha of the true value
+        log-linear buckets  the same idea, indexed with the exponent and top mantissa bits instead of log()
+        KLL                 a stack of compactors that sort and keep every other item, giving rank error ~ 1/k
+        t-digest            sorted centroids that are small near the tails and large near the median
+    Exact quantiles need every sample, and a sort or nth_element for each query.
+    All of them take the lower quantile: the value of rank floor(q*(n-1)) in sorted order.
+    Only positive samples are handled by the bucket sketches, as for latencies.
+*/
+
+const double kPi = 3.14159265358979323846;
+
+/******************************************************************************/
+
+// exact, sort all the samples
+struct quantile_sort {
+    void add( double value ) { samples.push_back( value ); sorted = false; }
+    double quantile( double q ) {
+        if (!sorted) {
+            std::sort( samples.begin(), samples.end() );
+            sorted = true;
+        }
+        return samples[ size_t( q * (samples.size() - 1) ) ];
+    }
+    std::vector<double> samples;
+    bool sorted = false;
+};
+
+/******************************************************************************/
+
+// exact, partial ordering for each quantile
+struct quantile_nth_element {
+    void add( double value ) { samples.push_back( value ); }
+    double quantile( double q ) {
+        auto nth = samples.begin() + size_t( q * (samples.size() - 1) );
+        std::nth_element( samples.begin(), nth, samples.end() );
+        return *nth;
+    }
+    std::vector<double> samples;
+};
+
+/******************************************************************************/
+
+// DDSketch style, the index is the log base gamma of the value
+// indices are clamped, which covers about 1e-18 to 1e17 for alpha = 1%
+struct quantile_log_buckets {
+    static const int kMinIndex = -2048;
+    static const int kBuckets = 4096;
+    
+    explicit quantile_log_buckets( double alpha = 0.01 ) :
+        gamma( (1.0 + alpha) / (1.0 - alpha) ), inverse_log_gamma( 1.0 / std::log( gamma ) ),
+        counts( kBuckets, 0 ), total(0) {}
+    
+    void add( double value ) {
+        int index = int( std::ceil( std::log( value ) * inverse_log_gamma ) ) - kMinIndex;
+        index = std::min( std::max( index, 0 ), kBuckets - 1 );
+        counts[ index ] += 1;
+        total += 1;
+    }
+    
+    double quantile( double q ) const {
+        const uint64_t rank = uint64_t( q * (total - 1) );
+        uint64_t seen = 0;
+        int index = 0;
+        for ( ; index < kBuckets - 1; ++index) {
+            seen += counts[index];
+            if (seen > rank)
+                break;
+        }
+        // the bucket covers (gamma^(i-1), gamma^i], return the value with equal relative error to both ends
+        return 2.0 * std::pow( gamma, double(index + kMinIndex) ) / (gamma + 1.0);
+    }
+    
+    double gamma;
+    double inverse_log_gamma;
+    std::vector<uint64_t> counts;
+    uint64_t total;
+};
+
+/******************************************************************************/
+
+// log-linear buckets: the binary exponent and the top 6 mantissa bits
+// each bucket is at most 1/64 of its lower bound wide, so the midpoint is within 0.8%
+struct quantile_loglinear_buckets {
+    static const int kMantissaBits = 6;
+    static const int kMinExponent = -64;
+    static const int kExponents = 128;
+    static const int kBuckets = kExponents << kMantissaBits;
+    
+    quantile_loglinear_buckets() : counts( kBuckets, 0 ), total(0) {}
+    
+    static int bucket( double value ) {
+        uint64_t bits;
+        memcpy( &bits, &value, sizeof(bits) );
+        int exponent = int( (bits >> 52) & 0x7ff ) - 1023 - kMinExponent;
+        if (exponent < 0)
+            return 0;
+        if (exponent >= kExponents)
+            return kBuckets - 1;
+        return (exponent << kMantissaBits) | int( (bits >> (52 - kMantissaBits)) & ((1 << kMantissaBits) - 1) );
+    }
+    
+    void add( double value ) {
+        counts[ bucket( value ) ] += 1;
+        total += 1;
+    }
+    
+    double quantile( double q ) const {
+        const uint64_t rank = uint64_t( q * (total - 1) );
+        uint64_t seen = 0;
+        int index = 0;
+        for ( ; index < kBuckets - 1; ++index) {
+            seen += counts[index];
+            if (seen > rank)
+                break;
+        }
+        int exponent = (index >> kMantissaBits) + kMinExponent;
+        double mantissa = 1.0 + (double(index & ((1 << kMantissaBits) - 1)) + 0.5) / double(1 << kMantissaBits);
+        return std::ldexp( mantissa, exponent );
+    }
+    
+    std::vector<uint64_t> counts;
+    uint64_t total;
+};
+
+/******************************************************************************/
+
+// KLL: level h holds items of weight 2^h, lower levels get geometrically smaller capacities
+// when a level fills it is sorted, and a random half (odd or even positions) moves up a level
+struct quantile_kll {
+    explicit quantile_kll( int size = 200 ) : k(size), levels(1), seed(0x2545F4914F6CDD1DULL) {
+        update_capacities();
+    }
+    
+    // capacities only change when a level is added
+    void update_capacities() {
+        const size_t height = levels.size();
+        capacities.resize( height );
+        for (size_t level = 0; level < height; ++level) {
+            double scale = std::pow( 2.0 / 3.0, double(height - 1 - level) );
+            capacities[level] = std::max( size_t(2), size_t( std::ceil( k * scale ) ) );
+        }
+    }
+    
+    void add( double value ) {
+        levels[0].push_back( value );
+        if (levels[0].size() >= capacities[0])
+            compress();
+    }
+    
+    void compress() {
+        for (size_t h = 0; h < levels.size(); ++h) {
+            if (levels[h].size() < capacities[h])
+                continue;
+            if (h + 1 == levels.size()) {
+                levels.emplace_back();
+                update_capacities();
+            }
+            std::vector<double> &level = levels[h];
+            std::sort( level.begin(), level.end() );
+            
+            // xorshift, one random bit per compaction
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            
+            size_t odd = level.size() & 1;
+            double leftover = level.back();
+            for (size_t j = size_t(seed & 1); j + odd < level.size(); j += 2)
+                levels[h+1].push_back( level[j] );
+            level.clear();
+            if (odd)
+                level.push_back( leftover );
+        }
+    }
+    
+    double quantile( double q ) const {
+        std::vector< std::pair<double,uint64_t> > weighted;
+        uint64_t total = 0;
+        for (size_t h = 0; h < levels.size(); ++h)
+            for (double value : levels[h]) {
+                weighted.push_back( std::make_pair( value, uint64_t(1) << h ) );
+                total += uint64_t(1) << h;
+            }
+        std::sort( weighted.begin(), weighted.end() );
+        const uint64_t rank = uint64_t( q * (total - 1) );
+        uint64_t seen = 0;
+        for (const auto &item : weighted) {
+            seen += item.second;
+            if (seen > rank)
+                return item.first;
+        }
+        return weighted.back().first;
+    }
+    
+    int k;
+    std::vector< std::vector<double> > levels;
+    std::vector<size_t> capacities;
+    uint64_t seed;
+};
+
+/******************************************************************************/
+
+// merging t-digest: samples are buffered, sorted, and merged into the centroids
+// the k1 scale function limits each centroid to one unit of k = compression/(2 pi) * asin(2q - 1)
+struct quantile_tdigest {
+    struct centroid {
+        double mean;
+        double weight;
+        bool operator<( const centroid &other ) const { return mean < other.mean; }
+    };
+    
+    explicit quantile_tdigest( double compression = 200.0 ) :
+        delta(compression), total(0.0), minimum(HUGE_VAL), maximum(-HUGE_VAL) {
+        buffer.reserve( size_t(10 * delta) );
+    }
+    
+    void add( double value ) {
+        buffer.push_back( value );
+        if (buffer.size() >= size_t(10 * delta))
+            flush();
+    }
+    
+    double scale( double q ) const { return delta / (2.0 * kPi) * std::asin( 2.0 * q - 1.0 ); }
+    double scale_inverse( double k ) const {
+        if (k >= delta / 4.0)
+            return 1.0;
+        return (std::sin( k * (2.0 * kPi) / delta ) + 1.0) / 2.0;
+    }
+    
+    void flush() {
+        if (buffer.empty())
+            return;
+        std::sort( buffer.begin(), buffer.end() );
+        minimum = std::min( minimum, buffer.front() );
+        maximum = std::max( maximum, buffer.back() );
+        
+        merged.clear();
+        size_t c = 0, b = 0;
+        while (c < centroids.size() || b < buffer.size()) {
+            if (b == buffer.size() || (c < centroids.size() && centroids[c].mean < buffer[b]))
+                merged.push_back( centroids[c++] );
+            else {
+                centroid single = { buffer[b++], 1.0 };
+                merged.push_back( single );
+            }
+        }
+        total += double(buffer.size());
+        buffer.clear();
+        
+        centroids.clear();
+        centroid current = merged[0];
+        double before = 0.0;
+        double limit = total * scale_inverse( scale( 0.0 ) + 1.0 );
+        for (size_t j = 1; j < merged.size(); ++j) {
+            const centroid &next = merged[j];
+            if (before + current.weight + next.weight <= limit) {
+                current.mean += (next.mean - current.mean) * next.weight / (current.weight + next.weight);
+                current.weight += next.weight;
+            } else {
+                before += current.weight;
+                centroids.push_back( current );
+                limit = total * scale_inverse( scale( before / total ) + 1.0 );
+                current = next;
+            }
+        }
+        centroids.push_back( current );
+    }
+    
+    // interpolate between centroid centers, pinned to the minimum and maximum
+    double quantile( double q ) {
+        flush();
+        const double target = q * (total - 1.0) + 0.5;
+        double before = 0.0;
+        double previous_center = 0.0;
+        double previous_mean = minimum;
+        for (const centroid &item : centroids) {
+            double center = before + item.weight / 2.0;
+            if (target < center) {
+                if (center == previous_center)
+                    return item.mean;
+                double t = (target - previous_center) / (center - previous_center);
+                return previous_mean + t * (item.mean - previous_mean);
+            }
+            before += item.weight;
+            previous_center = center;
+            previous_mean = item.mean;
+        }
+        if (total == previous_center)
+            return maximum;
+        double t = (target - previous_center) / (total - previous_center);
+        return previous_mean + t * (maximum - previous_mean);
+    }
+    
+    double delta;
+    double total;
+    double minimum, maximum;
+    std::vector<double> buffer;
+    std::vector<centroid> centroids;
+    std::vector<centroid> merged;
+};
+
+/******************************************************************************/
+
+const double sketch_quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+const size_t sketch_quantile_count = sizeof(sketch_quantiles) / sizeof(sketch_quantiles[0]);
+
+// maximum relative value error and rank error, over the quantiles
+struct sketch_accuracy {
+    double value_error;
+    double rank_error;
+};
+
+sketch_accuracy measure_sketch_accuracy( const std::vector<double> &sorted, const double *estimates ) {
+    sketch_accuracy result = { 0.0, 0.0 };
+    const double n = double( sorted.size() );
+    for (size_t k = 0; k < sketch_quantile_count; ++k) {
+        double q = sketch_quantiles[k];
+        double exact = sorted[ size_t( q * (sorted.size() - 1) ) ];
+        double lower = double( std::lower_bound( sorted.begin(), sorted.end(), estimates[k] ) - sorted.begin() );
+        double upper = double( std::upper_bound( sorted.begin(), sorted.end(), estimates[k] ) - sorted.begin() );
+        double rank = q * (n - 1.0);
+        // any rank inside a run of equal values is exact
+        double rank_error = (rank < lower) ? (lower - rank) : ((rank > upper) ? (rank - upper) : 0.0);
+        result.value_error = std::max( result.value_error, std::fabs( estimates[k] - exact ) / std::fabs( exact ) );
+        result.rank_error = std::max( result.rank_error, rank_error / n );
+    }
+    return result;
+}
+
+/******************************************************************************/
+
+// which error each method bounds: bucket sketches bound the relative value error, KLL and t-digest bound the rank error
+enum sketch_bound {
+    kBoundValue,
+    kBoundRank
+};
+
+/******************************************************************************/
+
+// time building the sketch from every sample and reading the quantiles
+// the test fails if the error this method guarantees is over maxError
+template<typename Sketch>
+void test_quantile_sketch( const std::vector<double> &samples, const std::vector<double> &sorted,
+                           Sketch prototype, sketch_bound bound, double maxError, const std::string label ) {
+    double estimates[ sketch_quantile_count ];
+    const double * volatile source = samples.data();
+    const size_t count = samples.size();
+    
+    start_timer();
+    
+    for (int i = 0; i < iterations; ++i) {
+        Sketch sketch( prototype );
+        for (size_t j = 0; j < count; ++j)
+            sketch.add( source[j] );
+        for (size_t k = 0; k < sketch_quantile_count; ++k)
+            estimates[k] = sketch.quantile( sketch_quantiles[k] );
+    }
+    
+    double elapsed = timer();
+    
+    sketch_accuracy accuracy = measure_sketch_accuracy( sorted, estimates );
+    char buffer[ 100 ];
+    snprintf( buffer, sizeof(buffer), ", value error %.2f%%, rank error %.3f%%",
+              100.0 * accuracy.value_error, 100.0 * accuracy.rank_error );
+    gLabels.push_back( label + buffer );
+    
+    double error = (bound == kBoundValue) ? accuracy.value_error : accuracy.rank_error;
+    if (error > maxError)
+        printf("test %s failed\n", gLabels.back().c_str() );
+    
+    record_result( elapsed, gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+// log normal samples, a long tailed latency distribution
+void TestQuantileSketches()
+{
+    const size_t count = size_t(1) << 20;
+    const int base_iterations = iterations;
+    std::vector<double> samples( count );
+    
+    scrand( init_value + 494949 );
+    for (size_t j = 0; j < count; j += 2) {
+        // Box-Muller
+        double u1 = (double( uint64_t(crand64()) >> 11 ) + 1.0) / 9007199254740993.0;
+        double u2 = double( uint64_t(crand64()) >> 11 ) / 9007199254740992.0;
+        double radius = std::sqrt( -2.0 * std::log( u1 ) );
+        samples[j] = std::exp( 3.0 + 1.0 * radius * std::cos( 2.0 * kPi * u2 ) );
+        if (j + 1 < count)
+            samples[j+1] = std::exp( 3.0 + 1.0 * radius * std::sin( 2.0 * kPi * u2 ) );
+    }
+    
+    std::vector<double> sorted( samples );
+    std::sort( sorted.begin(), sorted.end() );
+    
+    iterations = std::max( 1, int( (int64_t(base_iterations) * SIZE) / (16 * int64_t(count)) ) );
+    gLabels.clear();
+    
+    test_quantile_sketch( samples, sorted, quantile_sort(), kBoundValue, 0.0, "exact quantiles, sort" );
+    test_quantile_sketch( samples, sorted, quantile_nth_element(), kBoundValue, 0.0, "exact quantiles, nth_element" );
+    test_quantile_sketch( samples, sorted, quantile_log_buckets( 0.01 ), kBoundValue, 0.01, "log buckets 1%" );
+    test_quantile_sketch( samples, sorted, quantile_loglinear_buckets(), kBoundValue, 0.008, "log-linear buckets" );
+    test_quantile_sketch( samples, sorted, quantile_kll( 200 ), kBoundRank, 0.01, "KLL k=200" );
+    test_quantile_sketch( samples, sorted, quantile_kll( 800 ), kBoundRank, 0.004, "KLL k=800" );
+    test_quantile_sketch( samples, sorted, quantile_tdigest( 100.0 ), kBoundRank, 0.005, "t-digest 100" );
+    test_quantile_sketch( samples, sorted, quantile_tdigest( 500.0 ), kBoundRank, 0.002, "t-digest 500" );
+    
+    summarize("quantile sketch", int(count), iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 int main(int argc, char** argv) {
 
     // output command for documentation:
@@ -879,6 +1848,19 @@ int main(int argc, char** argv) {
     summarize("double histogram", SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
 
 
+
+// threaded, large inputs
+    benchmark::thread_pool pool;
+    TestThreadedHistograms( pool );
+
+
+
+// 2D, wide bins, and quantile sketches
+    TestJointHistograms();
+    TestWideHistograms();
+    TestQuantileSketches();
+
+
     return 0;
 }
 
@@ -20,6 +20,18 @@ Assumptions:
 
     3) std::inner_product will be well optimized for all types and containers.
 
+    4) Compensated inner products (Dot2) will cost a few times the simple loop,
+        and will be much more accurate when the products cancel.
+
+    5) The compiler will vectorize mixed precision inner products (8 or 16 bit inputs, 32 bit sums)
+        using the widening multiply-add instructions of the target CPU.
+
+
+NOTE - the accuracy tests report the relative error against a double-double reference.
+        Compensated methods need IEEE rounding, and are broken by fast math options.
+
+NOTE - the mixed precision data is chosen so every summation order gives an exact result.
+
 
 */
 
@@ -33,7 +45,9 @@ Assumptions:
 #include <cstdlib>
 #include <numeric>
 #include <algorithm>
+#include <cstring>
 #include <deque>
+#include <memory>
 #include <string>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
@@ -210,14 +224,14 @@ T inner_product6(Iter first, Iter second, const size_t count)
         T value5 = first[j+5] * second[j+5];
         T value6 = first[j+6] * second[j+6];
         T value7 = first[j+7] * second[j+7];
-        T value8 = first[j+0] * second[j+8];
-        T value9 = first[j+1] * second[j+9];
-        T valueA = first[j+2] * second[j+10];
-        T valueB = first[j+3] * second[j+11];
-        T valueC = first[j+4] * second[j+12];
-        T valueD = first[j+5] * second[j+13];
-        T valueE = first[j+6] * second[j+14];
-        T valueF = first[j+7] * second[j+15];
+        T value8 = first[j+8] * second[j+8];
+        T value9 = first[j+9] * second[j+9];
+        T valueA = first[j+10] * second[j+10];
+        T valueB = first[j+11] * second[j+11];
+        T valueC = first[j+12] * second[j+12];
+        T valueD = first[j+13] * second[j+13];
+        T valueE = first[j+14] * second[j+14];
+        T valueF = first[j+15] * second[j+15];
         sum += value0;
         sum += value1;
         sum += value2;
@@ -347,14 +361,14 @@ T inner_product10(Iter first, Iter second, const size_t count)
         T value5 = first[j+5] * second[j+5];
         T value6 = first[j+6] * second[j+6];
         T value7 = first[j+7] * second[j+7];
-        T value8 = first[j+0] * second[j+8];
-        T value9 = first[j+1] * second[j+9];
-        T valueA = first[j+2] * second[j+10];
-        T valueB = first[j+3] * second[j+11];
-        T valueC = first[j+4] * second[j+12];
-        T valueD = first[j+5] * second[j+13];
-        T valueE = first[j+6] * second[j+14];
-        T valueF = first[j+7] * second[j+15];
+        T value8 = first[j+8] * second[j+8];
+        T value9 = first[j+9] * second[j+9];
+        T valueA = first[j+10] * second[j+10];
+        T valueB = first[j+11] * second[j+11];
+        T valueC = first[j+12] * second[j+12];
+        T valueD = first[j+13] * second[j+13];
+        T valueE = first[j+14] * second[j+14];
+        T valueF = first[j+15] * second[j+15];
         sum += value0;
         sum1 += value1;
         sum2 += value2;
@@ -382,6 +396,159 @@ T inner_product10(Iter first, Iter second, const size_t count)
 /******************************************************************************/
 /******************************************************************************/
 
+/*
+    Accurate inner products
+    Products add rounding error of their own, so compensating the sum alone (Kahan) is not enough
+        when the products cancel.
+    Dot2 (Ogita, Rump, and Oishi) keeps the exact error of each product and each addition,
+        and is about as accurate as computing in twice the precision.
+*/
+
+// Kahan summation of the rounded products
+template<typename Iter, typename T>
+T inner_product_kahan(Iter first, Iter second, const size_t count)
+{
+    T sum( 0 );
+    T compensation( 0 );
+    for (size_t j = 0; j < count; ++j) {
+        T y = T(first[j] * second[j]) - compensation;
+        T t = sum + y;
+        compensation = (t - sum) - y;
+        sum = t;
+    }
+    return sum;
+}
+
+/******************************************************************************/
+
+// pairwise sum of the products, in blocks of 64
+template<typename Iter, typename T>
+T inner_product_pairwise(Iter first, Iter second, const size_t count)
+{
+    const size_t block = 64;
+    if (count <= block) {
+        T sum[4] = { 0, 0, 0, 0 };
+        size_t j;
+        for (j = 0; j < (count & ~size_t(3)); j += 4) {
+            sum[0] += first[j+0] * second[j+0];
+            sum[1] += first[j+1] * second[j+1];
+            sum[2] += first[j+2] * second[j+2];
+            sum[3] += first[j+3] * second[j+3];
+        }
+        for (; j < count; ++j) {
+            sum[0] += first[j] * second[j];
+        }
+        return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    }
+    
+    size_t half = (count / 2 + block - 1) & ~(block - 1);
+    return inner_product_pairwise<Iter,T>( first, second, half )
+         + inner_product_pairwise<Iter,T>( first + half, second + half, count - half );
+}
+
+/******************************************************************************/
+
+// a*b == product + error exactly, using a fused multiply add
+// NOTE - without FMA enabled in the compiler flags, std::fma is a slow library call
+template<typename T>
+inline void two_product_fma( T a, T b, T &product, T &error ) {
+    product = a * b;
+    error = std::fma( a, b, -product );
+}
+
+// a*b == product + error exactly, using Veltkamp splitting (Dekker), no FMA needed
+// NOTE - breaks if the compiler contracts these into fused multiply adds (-ffp-contract=fast)
+template<typename T>
+inline void two_product_split( T a, T b, T &product, T &error ) {
+    const T factor = (sizeof(T) > 4) ? T(134217729.0) : T(4097.0);     // 2^ceil(mantissa/2) + 1
+    T ca = factor * a;
+    T a_hi = ca - (ca - a);
+    T a_lo = a - a_hi;
+    T cb = factor * b;
+    T b_hi = cb - (cb - b);
+    T b_lo = b - b_hi;
+    product = a * b;
+    error = a_lo * b_lo - (((product - a_hi * b_hi) - a_lo * b_hi) - a_hi * b_lo);
+}
+
+/******************************************************************************/
+
+// Dot2, with FMA for the product errors
+template<typename Iter, typename T>
+T inner_product_dot2(Iter first, Iter second, const size_t count)
+{
+    T sum( 0 );
+    T error( 0 );
+    for (size_t j = 0; j < count; ++j) {
+        T product, product_error, s, sum_error;
+        two_product_fma( T(first[j]), T(second[j]), product, product_error );
+        two_sum( sum, product, s, sum_error );
+        sum = s;
+        error += sum_error + product_error;
+    }
+    return sum + error;
+}
+
+/******************************************************************************/
+
+// Dot2, with splitting for the product errors
+template<typename Iter, typename T>
+T inner_product_dot2_split(Iter first, Iter second, const size_t count)
+{
+    T sum( 0 );
+    T error( 0 );
+    for (size_t j = 0; j < count; ++j) {
+        T product, product_error, s, sum_error;
+        two_product_split( T(first[j]), T(second[j]), product, product_error );
+        two_sum( sum, product, s, sum_error );
+        sum = s;
+        error += sum_error + product_error;
+    }
+    return sum + error;
+}
+
+/******************************************************************************/
+
+// Dot2 with 4 independent lanes made to look like vectors, combined at the end
+template<typename Iter, typename T>
+T inner_product_dot2_blocked(Iter first, Iter second, const size_t count)
+{
+    T sum[4] = { 0, 0, 0, 0 };
+    T error[4] = { 0, 0, 0, 0 };
+    size_t j, k;
+    
+    for (j = 0; j < (count & ~size_t(3)); j += 4) {
+        for (k = 0; k < 4; ++k) {
+            T product, product_error, s, sum_error;
+            two_product_split( T(first[j+k]), T(second[j+k]), product, product_error );
+            two_sum( sum[k], product, s, sum_error );
+            sum[k] = s;
+            error[k] += sum_error + product_error;
+        }
+    }
+    
+    for (k = 0; j < count; ++j, ++k) {
+        T product, product_error, s, sum_error;
+        two_product_split( T(first[j]), T(second[j]), product, product_error );
+        two_sum( sum[k], product, s, sum_error );
+        sum[k] = s;
+        error[k] += sum_error + product_error;
+    }
+    
+    T result( 0 );
+    T total_error( 0 );
+    for (k = 0; k < 4; ++k) {
+        T s, e;
+        two_sum( result, sum[k], s, e );
+        result = s;
+        total_error += e + error[k];
+    }
+    return result + total_error;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 std::deque<std::string> gLabels;
 
 template <typename T, typename Summer>
@@ -510,6 +677,489 @@ void TestOneType()
 /******************************************************************************/
 /******************************************************************************/
 
+// time an inner product on real data, with the relative error against an exact reference in the label
+template <typename T, typename Summer>
+void test_inner_product_accuracy( const T* first, const T* second, const size_t count, Summer func,
+                                const std::string label, const double_double &reference ) {
+    const T expected = func( first, second, count );
+    char buffer[ 100 ];
+    snprintf( buffer, sizeof(buffer), ", relative error %.1e", reference.relative_error( expected ) );
+    
+    // the data doesn't change, so keep the compiler from moving the calculation out of the loop
+    const T * volatile source = first;
+
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        T sum = func( source, second, count );
+        if (sum != expected)
+            printf("test %s failed, result not reproducible\n", label.c_str() );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label + buffer );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template<typename T>
+void TestOneAccuracy( const T *data, const T *dataB, const size_t count, const std::string &name )
+{
+    std::string myTypeName( getTypeName<T>() );
+    
+    gLabels.clear();
+    
+    double_double reference;
+    for (size_t j = 0; j < count; ++j)
+        reference.add_product( double(data[j]), double(dataB[j]) );
+
+    test_inner_product_accuracy( data, dataB, count, inner_product_std<const T*,T>, myTypeName + " std::inner_product", reference );
+    test_inner_product_accuracy( data, dataB, count, inner_product1<const T*,T>, myTypeName + " inner_product1", reference );
+    test_inner_product_accuracy( data, dataB, count, inner_product10<const T*,T>, myTypeName + " inner_product10", reference );
+    test_inner_product_accuracy( data, dataB, count, inner_product_kahan<const T*,T>, myTypeName + " inner_product_kahan", reference );
+    test_inner_product_accuracy( data, dataB, count, inner_product_pairwise<const T*,T>, myTypeName + " inner_product_pairwise", reference );
+    test_inner_product_accuracy( data, dataB, count, inner_product_dot2<const T*,T>, myTypeName + " inner_product_dot2", reference );
+    test_inner_product_accuracy( data, dataB, count, inner_product_dot2_split<const T*,T>, myTypeName + " inner_product_dot2_split", reference );
+    test_inner_product_accuracy( data, dataB, count, inner_product_dot2_blocked<const T*,T>, myTypeName + " inner_product_dot2_blocked", reference );
+    
+    std::string temp1( myTypeName + " inner_product accuracy " + name );
+    summarize(temp1.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+
+template<typename T>
+void TestAccuracy()
+{
+    T data[SIZE];
+    T dataB[SIZE];
+    
+    scrand( 4242 );
+    fill_mixed_magnitudes( data, SIZE );
+    fill_mixed_magnitudes( dataB, SIZE );
+    TestOneAccuracy( data, dataB, SIZE, "mixed magnitudes" );
+    
+    // large products that cancel at the end of the sequence
+    const size_t pairs = SIZE / 4;
+    for (size_t j = 0; j < pairs; ++j) {
+        T large = T( double( uint64_t(crand64()) & 0xFFFFF ) * 10.0 );
+        data[ 2*j + 1 ] = large;
+        data[ SIZE - 1 - 2*j ] = -large;
+        dataB[ SIZE - 1 - 2*j ] = dataB[ 2*j + 1 ];
+    }
+    TestOneAccuracy( data, dataB, SIZE, "cancelling" );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Mixed precision dot products
+    Quantized data is stored in 8 or 16 bits, but the products are accumulated in 32 bits.
+    CPUs have instructions for this: pmaddwd (int16 pairs to int32), vpdpbusd (uint8 x int8, groups of 4 to int32),
+        vdpbf16ps (bfloat16 pairs to float), and F16C conversions from half float.
+    Each kernel has a simple loop (which the compiler may or may not vectorize), a loop grouped the same way
+        as the instructions so the compiler has an easier time.
+*/
+
+// simple loop, widen each value before multiplying
+template<typename A, typename B, typename R>
+R dot_widen1( const A *first, const B *second, const size_t count )
+{
+    R sum(0);
+    for (size_t j = 0; j < count; ++j) {
+        sum += R(first[j]) * R(second[j]);
+    }
+    return sum;
+}
+
+/******************************************************************************/
+
+// N adjacent products summed into each of 16 lanes, like pmaddwd (N = 2) and vpdpbusd (N = 4)
+template<typename A, typename B, typename R, size_t N>
+R dot_widen_groups( const A *first, const B *second, const size_t count )
+{
+    const size_t lanes = 16;
+    R sum[ lanes ] = { 0 };
+    size_t j, k, n;
+    
+    for (j = 0; j < (count - (count % (lanes*N))); j += lanes*N) {
+        for (k = 0; k < lanes; ++k) {
+            R group(0);
+            for (n = 0; n < N; ++n)
+                group += R(first[j + k*N + n]) * R(second[j + k*N + n]);
+            sum[k] += group;
+        }
+    }
+    
+    R result(0);
+    for (k = 0; k < lanes; ++k)
+        result += sum[k];
+
+    for (; j < count; ++j)
+        result += R(first[j]) * R(second[j]);
+    
+    return result;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+// 16 bit floating point formats, stored as uint16_t
+// bfloat16 is the top half of a float, so conversion is a shift
+
+inline float bf16_to_float( uint16_t value ) {
+    uint32_t bits = uint32_t(value) << 16;
+    float result;
+    memcpy( &result, &bits, sizeof(result) );
+    return result;
+}
+
+// round to nearest even (NaN is not handled)
+inline uint16_t float_to_bf16( float value ) {
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof(bits) );
+    bits += 0x7fff + ((bits >> 16) & 1);
+    return uint16_t( bits >> 16 );
+}
+
+/******************************************************************************/
+
+// IEEE half float: move the exponent and mantissa into place, then fix the exponent bias with a multiply
+// correct for zero, denormals and normal values, without branches (infinity and NaN are not handled)
+inline float half_to_float( uint16_t value ) {
+    uint32_t bits = uint32_t(value & 0x7fff) << 13;
+    float magnitude;
+    memcpy( &magnitude, &bits, sizeof(magnitude) );
+    magnitude *= 5.192296858534828e+33f;      // 2^112 = 2^(127-15)
+    memcpy( &bits, &magnitude, sizeof(bits) );
+    bits |= uint32_t(value & 0x8000) << 16;
+    float result;
+    memcpy( &result, &bits, sizeof(result) );
+    return result;
+}
+
+// round to nearest even, for values in the normal half float range (smaller values go to zero)
+inline uint16_t float_to_half( float value ) {
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof(bits) );
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7fffffff;
+    if (magnitude < 0x38800000)         // below 2^-14
+        return uint16_t( sign );
+    if (magnitude >= 0x477ff000)        // rounds above 65504
+        return uint16_t( sign | 0x7c00 );
+    magnitude -= uint32_t(127 - 15) << 23;
+    magnitude += 0x0fff + ((magnitude >> 13) & 1);
+    return uint16_t( sign | (magnitude >> 13) );
+}
+
+/******************************************************************************/
+
+struct bf16_converter {
+    float operator()( uint16_t value ) const { return bf16_to_float( value ); }
+};
+
+struct half_converter {
+    float operator()( uint16_t value ) const { return half_to_float( value ); }
+};
+
+/******************************************************************************/
+
+// simple loop, convert each value before multiplying
+template<typename Convert>
+float dot_convert1( const uint16_t *first, const uint16_t *second, const size_t count )
+{
+    Convert convert;
+    float sum(0);
+    for (size_t j = 0; j < count; ++j) {
+        sum += convert( first[j] ) * convert( second[j] );
+    }
+    return sum;
+}
+
+/******************************************************************************/
+
+// 16 lanes made to look like vectors, so the compiler can reorder the float additions
+template<typename Convert>
+float dot_convert_lanes( const uint16_t *first, const uint16_t *second, const size_t count )
+{
+    Convert convert;
+    const size_t lanes = 16;
+    float sum[ lanes ] = { 0 };
+    size_t j, k;
+    
+    for (j = 0; j < (count & ~(lanes-1)); j += lanes) {
+        for (k = 0; k < lanes; ++k)
+            sum[k] += convert( first[j+k] ) * convert( second[j+k] );
+    }
+    
+    float result(0);
+    for (k = 0; k < lanes; ++k)
+        result += sum[k];
+    
+    for (; j < count; ++j)
+        result += convert( first[j] ) * convert( second[j] );
+    
+    return result;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+// Batched dot products: one query against many stored vectors (similarity search)
+
+// one dot product per row
+template<typename A, typename B, typename R, R (*Dot)( const A *, const B *, const size_t )>
+void batch_dot_rows( const A *query, const B *rows, const size_t dims, const size_t count, R *results )
+{
+    for (size_t r = 0; r < count; ++r)
+        results[r] = Dot( query, rows + r*dims, dims );
+}
+
+/******************************************************************************/
+
+// four rows at once, so each query value is loaded once for four products
+template<typename A, typename B, typename R>
+void batch_dot_widen_4rows( const A *query, const B *rows, const size_t dims, const size_t count, R *results )
+{
+    size_t r = 0;
+    
+    for ( ; r < (count & ~size_t(3)); r += 4) {
+        const B *row0 = rows + (r+0)*dims;
+        const B *row1 = rows + (r+1)*dims;
+        const B *row2 = rows + (r+2)*dims;
+        const B *row3 = rows + (r+3)*dims;
+        R sum0(0), sum1(0), sum2(0), sum3(0);
+        for (size_t j = 0; j < dims; ++j) {
+            R q = R(query[j]);
+            sum0 += q * R(row0[j]);
+            sum1 += q * R(row1[j]);
+            sum2 += q * R(row2[j]);
+            sum3 += q * R(row3[j]);
+        }
+        results[r+0] = sum0;
+        results[r+1] = sum1;
+        results[r+2] = sum2;
+        results[r+3] = sum3;
+    }
+    
+    for ( ; r < count; ++r)
+        results[r] = dot_widen1<A,B,R>( query, rows + r*dims, dims );
+}
+
+/******************************************************************************/
+
+// four rows at once, and the query is converted only once
+template<typename Convert>
+void batch_dot_convert_4rows( const uint16_t *query, const uint16_t *rows, const size_t dims, const size_t count, float *results )
+{
+    Convert convert;
+    std::unique_ptr<float[]> query_storage( new float[ dims ] );
+    float *converted = query_storage.get();
+    
+    for (size_t j = 0; j < dims; ++j)
+        converted[j] = convert( query[j] );
+    
+    size_t r = 0;
+    for ( ; r < (count & ~size_t(3)); r += 4) {
+        const uint16_t *row0 = rows + (r+0)*dims;
+        const uint16_t *row1 = rows + (r+1)*dims;
+        const uint16_t *row2 = rows + (r+2)*dims;
+        const uint16_t *row3 = rows + (r+3)*dims;
+        float sum0(0), sum1(0), sum2(0), sum3(0);
+        for (size_t j = 0; j < dims; ++j) {
+            float q = converted[j];
+            sum0 += q * convert( row0[j] );
+            sum1 += q * convert( row1[j] );
+            sum2 += q * convert( row2[j] );
+            sum3 += q * convert( row3[j] );
+        }
+        results[r+0] = sum0;
+        results[r+1] = sum1;
+        results[r+2] = sum2;
+        results[r+3] = sum3;
+    }
+    
+    for ( ; r < count; ++r)
+        results[r] = dot_convert1<Convert>( query, rows + r*dims, dims );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+template <typename A, typename B, typename R, typename Dot>
+void test_mixed_dot( const A* first, const B* second, const size_t count, Dot func, const R expected, const std::string label) {
+
+    // the data doesn't change, so keep the compiler from moving the calculation out of the loop
+    const A * volatile source = first;
+
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        R sum = func( source, second, count );
+        if (sum != expected)
+            printf("test %s failed\n", label.c_str());
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template <typename A, typename B, typename R, typename Batch>
+void test_batch_dot( const A* query, const B* rows, const size_t dims, const size_t count, R *results,
+                    Batch func, const R *expected, const std::string label) {
+
+    const A * volatile source = query;
+
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        func( source, rows, dims, count, results );
+        if (!std::equal( results, results+count, expected ))
+            printf("test %s failed\n", label.c_str());
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+// small integers divided by 4 are exact in both 16 bit float formats,
+// and keep every partial sum exact in float, so all summation orders give the same answer
+inline float random_quarter() {
+    return float( int( uint64_t(crand64()) % 64 ) - 32 ) * 0.25f;
+}
+
+/******************************************************************************/
+
+void TestMixedPrecision()
+{
+    gLabels.clear();
+    
+    uint8_t dataU8[SIZE];
+    int8_t dataS8[SIZE];
+    int16_t dataS16[SIZE];
+    int16_t dataS16B[SIZE];
+    uint16_t dataBF16[SIZE], dataBF16B[SIZE];
+    uint16_t dataHalf[SIZE], dataHalfB[SIZE];
+    
+    scrand( init_value + 46 );
+    for (size_t j = 0; j < SIZE; ++j) {
+        dataU8[j] = uint8_t( crand64() );
+        dataS8[j] = int8_t( crand64() );
+        // small enough that SIZE products can't overflow int32
+        dataS16[j] = int16_t( int( uint64_t(crand64()) % 512 ) - 256 );
+        dataS16B[j] = int16_t( int( uint64_t(crand64()) % 512 ) - 256 );
+        float a = random_quarter();
+        float b = random_quarter();
+        dataBF16[j] = float_to_bf16( a );
+        dataBF16B[j] = float_to_bf16( b );
+        dataHalf[j] = float_to_half( a );
+        dataHalfB[j] = float_to_half( b );
+    }
+    
+    const int32_t expectedU8S8 = int32_t( dot_widen1<uint8_t,int8_t,int64_t>( dataU8, dataS8, SIZE ) );
+    const int32_t expectedS16 = int32_t( dot_widen1<int16_t,int16_t,int64_t>( dataS16, dataS16B, SIZE ) );
+    const float expectedBF16 = dot_convert1<bf16_converter>( dataBF16, dataBF16B, SIZE );
+    const float expectedHalf = dot_convert1<half_converter>( dataHalf, dataHalfB, SIZE );
+    
+    test_mixed_dot( dataU8, dataS8, SIZE, dot_widen1<uint8_t,int8_t,int32_t>, expectedU8S8, "uint8_t x int8_t to int32_t simple" );
+    test_mixed_dot( dataU8, dataS8, SIZE, dot_widen_groups<uint8_t,int8_t,int32_t,4>, expectedU8S8, "uint8_t x int8_t to int32_t groups of 4" );
+
+    test_mixed_dot( dataS16, dataS16B, SIZE, dot_widen1<int16_t,int16_t,int32_t>, expectedS16, "int16_t x int16_t to int32_t simple" );
+    test_mixed_dot( dataS16, dataS16B, SIZE, dot_widen_groups<int16_t,int16_t,int32_t,2>, expectedS16, "int16_t x int16_t to int32_t groups of 2" );
+
+    test_mixed_dot( dataBF16, dataBF16B, SIZE, dot_convert1<bf16_converter>, expectedBF16, "bfloat16 to float simple" );
+    test_mixed_dot( dataBF16, dataBF16B, SIZE, dot_convert_lanes<bf16_converter>, expectedBF16, "bfloat16 to float lanes" );
+
+    test_mixed_dot( dataHalf, dataHalfB, SIZE, dot_convert1<half_converter>, expectedHalf, "half float to float simple" );
+    test_mixed_dot( dataHalf, dataHalfB, SIZE, dot_convert_lanes<half_converter>, expectedHalf, "half float to float lanes" );
+    
+    summarize("mixed precision inner_product", SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+
+// one query against a table of vectors, small enough to stay in cache
+void TestBatchDot()
+{
+    const size_t dims = 256;
+    const size_t rows = 1024;
+    const size_t total = dims * rows;
+    const int saved_iterations = iterations;
+    
+    // keep the number of products the same as the single tests
+    iterations = std::max( 1, int( (int64_t(iterations) * SIZE) / int64_t(total) ) );
+    
+    gLabels.clear();
+    
+    std::unique_ptr<uint8_t[]> queryU8( new uint8_t[ dims ] );
+    std::unique_ptr<int8_t[]> tableS8( new int8_t[ total ] );
+    std::unique_ptr<int16_t[]> queryS16( new int16_t[ dims ] );
+    std::unique_ptr<int16_t[]> tableS16( new int16_t[ total ] );
+    std::unique_ptr<uint16_t[]> queryBF16( new uint16_t[ dims ] );
+    std::unique_ptr<uint16_t[]> tableBF16( new uint16_t[ total ] );
+    std::unique_ptr<int32_t[]> resultsInt( new int32_t[ rows ] );
+    std::unique_ptr<int32_t[]> expectedU8S8( new int32_t[ rows ] );
+    std::unique_ptr<int32_t[]> expectedS16( new int32_t[ rows ] );
+    std::unique_ptr<float[]> resultsFloat( new float[ rows ] );
+    std::unique_ptr<float[]> expectedBF16( new float[ rows ] );
+    
+    scrand( init_value + 4646 );
+    for (size_t j = 0; j < dims; ++j) {
+        queryU8[j] = uint8_t( crand64() );
+        queryS16[j] = int16_t( crand64() );
+        queryBF16[j] = float_to_bf16( random_quarter() );
+    }
+    for (size_t j = 0; j < total; ++j) {
+        tableS8[j] = int8_t( crand64() );
+        tableS16[j] = int16_t( int( uint64_t(crand64()) % 512 ) - 256 );
+        tableBF16[j] = float_to_bf16( random_quarter() );
+    }
+    
+    batch_dot_rows< uint8_t, int8_t, int32_t, dot_widen1<uint8_t,int8_t,int32_t> >( queryU8.get(), tableS8.get(), dims, rows, expectedU8S8.get() );
+    batch_dot_rows< int16_t, int16_t, int32_t, dot_widen1<int16_t,int16_t,int32_t> >( queryS16.get(), tableS16.get(), dims, rows, expectedS16.get() );
+    batch_dot_rows< uint16_t, uint16_t, float, dot_convert1<bf16_converter> >( queryBF16.get(), tableBF16.get(), dims, rows, expectedBF16.get() );
+    
+    test_batch_dot( queryU8.get(), tableS8.get(), dims, rows, resultsInt.get(),
+                    batch_dot_rows< uint8_t, int8_t, int32_t, dot_widen1<uint8_t,int8_t,int32_t> >,
+                    expectedU8S8.get(), "uint8_t x int8_t batch simple rows" );
+    test_batch_dot( queryU8.get(), tableS8.get(), dims, rows, resultsInt.get(),
+                    batch_dot_rows< uint8_t, int8_t, int32_t, dot_widen_groups<uint8_t,int8_t,int32_t,4> >,
+                    expectedU8S8.get(), "uint8_t x int8_t batch rows of groups" );
+    test_batch_dot( queryU8.get(), tableS8.get(), dims, rows, resultsInt.get(),
+                    batch_dot_widen_4rows<uint8_t,int8_t,int32_t>,
+                    expectedU8S8.get(), "uint8_t x int8_t batch 4 rows at once" );
+
+    test_batch_dot( queryS16.get(), tableS16.get(), dims, rows, resultsInt.get(),
+                    batch_dot_rows< int16_t, int16_t, int32_t, dot_widen1<int16_t,int16_t,int32_t> >,
+                    expectedS16.get(), "int16_t x int16_t batch simple rows" );
+    test_batch_dot( queryS16.get(), tableS16.get(), dims, rows, resultsInt.get(),
+                    batch_dot_widen_4rows<int16_t,int16_t,int32_t>,
+                    expectedS16.get(), "int16_t x int16_t batch 4 rows at once" );
+
+    test_batch_dot( queryBF16.get(), tableBF16.get(), dims, rows, resultsFloat.get(),
+                    batch_dot_rows< uint16_t, uint16_t, float, dot_convert1<bf16_converter> >,
+                    expectedBF16.get(), "bfloat16 batch simple rows" );
+    test_batch_dot( queryBF16.get(), tableBF16.get(), dims, rows, resultsFloat.get(),
+                    batch_dot_convert_4rows<bf16_converter>,
+                    expectedBF16.get(), "bfloat16 batch 4 rows at once" );
+    
+    summarize("batched inner_product", total, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    iterations = saved_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 int main(int argc, char** argv) {
 
     // output command for documentation:
@@ -535,6 +1185,12 @@ int main(int argc, char** argv) {
     TestOneType<float>();
     TestOneType<double>();
     TestOneType<long double>();
+    
+    TestAccuracy<float>();
+    TestAccuracy<double>();
+    
+    TestMixedPrecision();
+    TestBatchDot();
 
 
     return 0;
@@ -24,6 +24,15 @@ Assumptions:
     5) using std::endl will generally be slower than outputting '\n', because std::endl causes a stream flush.
         (this really should be revisited by the standards committee -- it is causing confusion and very poor performance)
 
+    6) Large aligned block IO should be limited by memory bandwidth, not by the number of system calls.
+ 
+    7) Zero-copy methods (mmap, sendfile, copy_file_range) should be faster than copying through a user buffer.
+
+    8) Asynchronous IO (io_uring) should approach the device or page cache bandwidth with a modest queue depth.
+
+    9) Multiple threads writing to one FILE or stream will serialize on a lock,
+        and buffering per thread or handing lines to a single writer thread should scale better.
+
 
 **** NOTE: Order of tests and sync calls has an effect with GCC, sync=true must be tested before sync=false
 
@@ -36,10 +45,14 @@ Assumptions:
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <deque>
+#include <vector>
+#include <algorithm>
 using namespace std;
 #include <ctime>
 #include "benchmark_timer.h"
 #include "benchmark_results.h"
+#include "benchmark_threads.h"
 
 #include <errno.h>
 #include <fcntl.h>
@@ -56,6 +69,21 @@ using namespace std;
 
 #ifndef _WIN32
 #include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
 #endif
 
 /******************************************************************************/
@@ -71,6 +99,9 @@ typedef enum testIOMode {
 
 uint64_t gGlobalSum = 0;
 
+// so all label strings stay alive until we print the results
+std::deque<std::string> gLabels;
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -544,6 +575,987 @@ void test_iostreams_in(int n, const char *filename, bool sync, const string &lab
 
 }
 
+#ifndef _WIN32
+/******************************************************************************/
+/******************************************************************************/
+
+// Block IO: no formatting, just moving bytes between memory and files.
+// Compares the buffered copies above against large aligned transfers, zero-copy and asynchronous APIs.
+// These are timed with a wall clock, because clock() doesn't see time spent waiting on the device
+//    or work done by kernel threads on our behalf.
+
+typedef enum blockIOMethod {
+    BLOCK_STDIO = 1,        // fread/fwrite, 1 MB blocks
+    BLOCK_POSIX = 2,        // read/write, 4 KB blocks (a typical buffer size)
+    BLOCK_PREAD = 3,        // pread/pwrite, 1 MB aligned blocks
+    BLOCK_VECTOR = 4,       // readv/writev, 16 x 64 KB pieces per call
+    BLOCK_MMAP = 5,         // mmap, no copy for read, one memcpy for write
+    BLOCK_DIRECT = 6,       // O_DIRECT (F_NOCACHE on MacOS), 1 MB aligned blocks
+    BLOCK_URING = 7,        // io_uring, 1 MB blocks, gQueueDepth requests in flight
+} blockIOMethod;
+
+typedef enum copyIOMethod {
+    COPY_READWRITE = 1,     // read/write through a 1 MB user buffer
+    COPY_MMAP = 2,          // mmap the source, write directly from the mapping
+    COPY_SENDFILE = 3,      // sendfile, file to file stays in the kernel
+    COPY_FILE_RANGE = 4,    // copy_file_range, stays in the kernel, may share extents
+} copyIOMethod;
+
+const size_t kSmallBlock = 4*1024;
+const size_t kLargeBlock = 1024*1024;
+const int kVectorPieces = 16;
+const size_t kIOAlignment = 4096;
+
+// IO system calls made by the current test (for stdio, this counts library calls)
+uint64_t gIOCalls = 0;
+
+// io_uring requests kept in flight, may be changed from the command line
+int gQueueDepth = 8;
+
+/******************************************************************************/
+
+static uint8_t *allocate_aligned(size_t bytes) {
+    void *result = NULL;
+    if (posix_memalign( &result, kIOAlignment, bytes ) != 0) {
+        fprintf(stderr,"Could not allocate %llu bytes\n", (unsigned long long)bytes );
+        exit(-3);
+    }
+    return (uint8_t *)result;
+}
+
+/******************************************************************************/
+
+// order independent, so asynchronous completions can be summed as they arrive
+static uint64_t checksum_block(const uint8_t *data, size_t bytes) {
+    const uint64_t *words = (const uint64_t *)data;
+    uint64_t sum = 0;
+    for (size_t i = 0; i < bytes/sizeof(uint64_t); ++i)
+        sum += words[i];
+    return sum;
+}
+
+/******************************************************************************/
+
+static bool write_blocks(int fd, const uint8_t *data, size_t bytes, size_t block) {
+    size_t done = 0;
+    while (done < bytes) {
+        size_t len = std::min( block, bytes - done );
+        ssize_t written = write( fd, data + done, len );
+        gIOCalls++;
+        if (written <= 0)
+            return false;
+        done += written;
+    }
+    return true;
+}
+
+/******************************************************************************/
+
+static bool read_blocks(int fd, uint8_t *buffer, size_t bytes, size_t block, uint64_t &sum) {
+    size_t done = 0;
+    while (done < bytes) {
+        size_t len = std::min( block, bytes - done );
+        ssize_t got = read( fd, buffer, len );
+        gIOCalls++;
+        if (got <= 0)
+            return false;
+        sum += checksum_block( buffer, got );
+        done += got;
+    }
+    return true;
+}
+
+/******************************************************************************/
+
+// both O_DIRECT and pread/pwrite use the same aligned block loop
+static bool pwrite_blocks(int fd, const uint8_t *data, size_t bytes) {
+    size_t done = 0;
+    while (done < bytes) {
+        size_t len = std::min( kLargeBlock, bytes - done );
+        ssize_t written = pwrite( fd, data + done, len, (off_t)done );
+        gIOCalls++;
+        if (written <= 0)
+            return false;
+        done += written;
+    }
+    return true;
+}
+
+/******************************************************************************/
+
+static bool pread_blocks(int fd, uint8_t *buffer, size_t bytes, uint64_t &sum) {
+    size_t done = 0;
+    while (done < bytes) {
+        size_t len = std::min( kLargeBlock, bytes - done );
+        ssize_t got = pread( fd, buffer, len, (off_t)done );
+        gIOCalls++;
+        if (got <= 0)
+            return false;
+        sum += checksum_block( buffer, got );
+        done += got;
+    }
+    return true;
+}
+
+/******************************************************************************/
+
+static bool writev_blocks(int fd, const uint8_t *data, size_t bytes) {
+    const size_t piece = kLargeBlock / kVectorPieces;
+    struct iovec vec[ kVectorPieces ];
+    size_t done = 0;
+    while (done < bytes) {
+        int count = 0;
+        size_t total = 0;
+        for ( ; count < kVectorPieces && (done+total) < bytes; ++count) {
+            size_t len = std::min( piece, bytes - (done+total) );
+            vec[count].iov_base = (void *)(data + done + total);
+            vec[count].iov_len = len;
+            total += len;
+        }
+        ssize_t written = writev( fd, vec, count );
+        gIOCalls++;
+        if (written != (ssize_t)total)
+            return false;
+        done += total;
+    }
+    return true;
+}
+
+/******************************************************************************/
+
+static bool readv_blocks(int fd, uint8_t *buffer, size_t bytes, uint64_t &sum) {
+    const size_t piece = kLargeBlock / kVectorPieces;
+    struct iovec vec[ kVectorPieces ];
+    size_t done = 0;
+    while (done < bytes) {
+        int count = 0;
+        size_t total = 0;
+        for ( ; count < kVectorPieces && (done+total) < bytes; ++count) {
+            size_t len = std::min( piece, bytes - (done+total) );
+            vec[count].iov_base = (void *)(buffer + total);
+            vec[count].iov_len = len;
+            total += len;
+        }
+        ssize_t got = readv( fd, vec, count );
+        gIOCalls++;
+        if (got != (ssize_t)total)
+            return false;
+        sum += checksum_block( buffer, total );
+        done += total;
+    }
+    return true;
+}
+
+/******************************************************************************/
+
+// open for unbuffered IO, returns -1 if the OS or filesystem doesn't allow it
+static int open_direct(const char *filename, int flags) {
+    const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+#if defined(O_DIRECT)
+    int fd = open( filename, flags | O_DIRECT, mode );
+    gIOCalls++;
+    return fd;
+#elif defined(F_NOCACHE)
+    int fd = open( filename, flags, mode );
+    gIOCalls++;
+    if (fd >= 0) {
+        fcntl( fd, F_NOCACHE, 1 );
+        gIOCalls++;
+    }
+    return fd;
+#else
+    return -1;
+#endif
+}
+
+/******************************************************************************/
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAS_IO_URING    1
+#endif
+#endif
+
+#if HAS_IO_URING
+
+// We use the raw system calls, so the benchmark does not depend on liburing.
+
+struct uring_queue {
+    int fd;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ring;
+    void *cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    size_t sqes_size;
+};
+
+/******************************************************************************/
+
+static bool uring_setup(uring_queue &q, unsigned depth) {
+    struct io_uring_params params;
+    memset( &params, 0, sizeof(params) );
+    
+    q.fd = (int) syscall( __NR_io_uring_setup, depth, &params );
+    gIOCalls++;
+    if (q.fd < 0)
+        return false;
+
+    q.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    q.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    q.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    bool single_mmap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+    single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#endif
+    if (single_mmap)
+        q.sq_ring_size = q.cq_ring_size = std::max( q.sq_ring_size, q.cq_ring_size );
+
+    q.sq_ring = mmap( NULL, q.sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, q.fd, IORING_OFF_SQ_RING );
+    gIOCalls++;
+    q.cq_ring = q.sq_ring;
+    if (!single_mmap && q.sq_ring != MAP_FAILED) {
+        q.cq_ring = mmap( NULL, q.cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, q.fd, IORING_OFF_CQ_RING );
+        gIOCalls++;
+    }
+    q.sqes = (struct io_uring_sqe *) mmap( NULL, q.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, q.fd, IORING_OFF_SQES );
+    gIOCalls++;
+    if (q.sq_ring == MAP_FAILED || q.cq_ring == MAP_FAILED || q.sqes == MAP_FAILED) {
+        close( q.fd );
+        return false;
+    }
+
+    uint8_t *sq = (uint8_t *)q.sq_ring;
+    uint8_t *cq = (uint8_t *)q.cq_ring;
+    q.sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    q.sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    q.sq_array = (unsigned *)(sq + params.sq_off.array);
+    q.cq_head = (unsigned *)(cq + params.cq_off.head);
+    q.cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    q.cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    q.cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return true;
+}
+
+/******************************************************************************/
+
+static void uring_teardown(uring_queue &q) {
+    munmap( q.sqes, q.sqes_size );
+    if (q.cq_ring != q.sq_ring)
+        munmap( q.cq_ring, q.cq_ring_size );
+    munmap( q.sq_ring, q.sq_ring_size );
+    close( q.fd );
+}
+
+/******************************************************************************/
+
+static void uring_queue_vector(uring_queue &q, int opcode, int fd, struct iovec *vec, uint64_t offset, uint64_t tag) {
+    unsigned tail = *q.sq_tail;
+    unsigned index = tail & *q.sq_mask;
+    struct io_uring_sqe *sqe = &q.sqes[index];
+    memset( sqe, 0, sizeof(*sqe) );
+    sqe->opcode = (uint8_t)opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)vec;
+    sqe->len = 1;
+    sqe->off = offset;
+    sqe->user_data = tag;
+    q.sq_array[index] = index;
+    __atomic_store_n( q.sq_tail, tail + 1, __ATOMIC_RELEASE );
+}
+
+/******************************************************************************/
+
+static bool uring_next_completion(uring_queue &q, struct io_uring_cqe &result) {
+    unsigned head = *q.cq_head;
+    if (head == __atomic_load_n( q.cq_tail, __ATOMIC_ACQUIRE ))
+        return false;
+    result = q.cqes[ head & *q.cq_mask ];
+    __atomic_store_n( q.cq_head, head + 1, __ATOMIC_RELEASE );
+    return true;
+}
+
+/******************************************************************************/
+
+// keep up to gQueueDepth 1 MB requests in flight, checksum reads as they complete
+static bool uring_blocks(uring_queue &q, int fd, const uint8_t *source, uint8_t *buffers, size_t bytes, uint64_t &sum) {
+    const bool writing = (source != NULL);
+    const int opcode = writing ? IORING_OP_WRITEV : IORING_OP_READV;
+    std::vector<struct iovec> vec( gQueueDepth );
+    std::vector<unsigned> freeSlots;
+    for (int slot = gQueueDepth-1; slot >= 0; --slot)
+        freeSlots.push_back( slot );
+    
+    size_t next = 0;
+    size_t done = 0;
+    while (done < bytes) {
+        unsigned queued = 0;
+        while (!freeSlots.empty() && next < bytes) {
+            unsigned slot = freeSlots.back();
+            freeSlots.pop_back();
+            vec[slot].iov_base = writing ? (void *)(source + next) : (void *)(buffers + slot*kLargeBlock);
+            vec[slot].iov_len = std::min( kLargeBlock, bytes - next );
+            uring_queue_vector( q, opcode, fd, &vec[slot], next, slot );
+            next += vec[slot].iov_len;
+            queued++;
+        }
+        
+        gIOCalls++;
+        if (syscall( __NR_io_uring_enter, q.fd, queued, 1, IORING_ENTER_GETEVENTS, NULL, 0 ) < 0)
+            return false;
+        
+        struct io_uring_cqe cqe;
+        while (uring_next_completion( q, cqe )) {
+            unsigned slot = (unsigned)cqe.user_data;
+            if (cqe.res != (int)vec[slot].iov_len)  // failed or short transfer
+                return false;
+            if (!writing)
+                sum += checksum_block( (const uint8_t *)vec[slot].iov_base, cqe.res );
+            done += cqe.res;
+            freeSlots.push_back( slot );
+        }
+    }
+    return true;
+}
+
+#endif  // HAS_IO_URING
+
+/******************************************************************************/
+/******************************************************************************/
+
+// returns false if the method is not supported here
+bool block_write_file(const char *filename, const uint8_t *source, size_t bytes, const blockIOMethod method, void *queue )
+{
+    const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    bool result = false;
+    int fd = -1;
+
+    switch( method ) {
+        case BLOCK_STDIO:
+            {
+            FILE *out = fopen( filename, "wb" );
+            gIOCalls++;
+            if (out == NULL)
+                return false;
+            size_t done = 0;
+            result = true;
+            while (done < bytes) {
+                size_t len = std::min( kLargeBlock, bytes - done );
+                gIOCalls++;
+                if (fwrite( source + done, 1, len, out ) != len) {
+                    result = false;
+                    break;
+                }
+                done += len;
+            }
+            fclose( out );
+            gIOCalls++;
+            }
+            return result;
+        case BLOCK_POSIX:
+        case BLOCK_PREAD:
+        case BLOCK_VECTOR:
+        case BLOCK_URING:
+            fd = open( filename, O_CREAT | O_WRONLY | O_TRUNC, mode );
+            gIOCalls++;
+            if (fd < 0)
+                return false;
+            if (method == BLOCK_POSIX)
+                result = write_blocks( fd, source, bytes, kSmallBlock );
+            else if (method == BLOCK_PREAD)
+                result = pwrite_blocks( fd, source, bytes );
+            else if (method == BLOCK_VECTOR)
+                result = writev_blocks( fd, source, bytes );
+#if HAS_IO_URING
+            else {
+                uint64_t unused = 0;
+                result = uring_blocks( *(uring_queue *)queue, fd, source, NULL, bytes, unused );
+            }
+#endif
+            break;
+        case BLOCK_MMAP:
+            {
+            fd = open( filename, O_CREAT | O_RDWR | O_TRUNC, mode );
+            gIOCalls++;
+            if (fd < 0)
+                return false;
+            gIOCalls += 3;      // ftruncate, mmap, munmap
+            if (ftruncate( fd, (off_t)bytes ) != 0)
+                break;
+            void *mapped = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+            if (mapped == MAP_FAILED)
+                break;
+            memcpy( mapped, source, bytes );
+            munmap( mapped, bytes );
+            result = true;
+            }
+            break;
+        case BLOCK_DIRECT:
+            fd = open_direct( filename, O_CREAT | O_WRONLY | O_TRUNC );
+            if (fd < 0)
+                return false;
+            result = pwrite_blocks( fd, source, bytes );
+            break;
+        default:
+            fprintf (stderr, "Unknown mode %d", int(method) );
+            exit(-1);
+            break;
+    }
+
+    close( fd );
+    gIOCalls++;
+    return result;
+}
+
+/******************************************************************************/
+
+// returns false if the method is not supported here
+bool block_read_file(const char *filename, uint8_t *buffer, size_t bytes, const blockIOMethod method, void *queue, uint64_t &sum )
+{
+    bool result = false;
+    int fd = -1;
+
+    switch( method ) {
+        case BLOCK_STDIO:
+            {
+            FILE *input = fopen( filename, "rb" );
+            gIOCalls++;
+            if (input == NULL)
+                return false;
+            size_t done = 0;
+            result = true;
+            while (done < bytes) {
+                size_t len = std::min( kLargeBlock, bytes - done );
+                gIOCalls++;
+                if (fread( buffer, 1, len, input ) != len) {
+                    result = false;
+                    break;
+                }
+                sum += checksum_block( buffer, len );
+                done += len;
+            }
+            fclose( input );
+            gIOCalls++;
+            }
+            return result;
+        case BLOCK_POSIX:
+        case BLOCK_PREAD:
+        case BLOCK_VECTOR:
+        case BLOCK_URING:
+            fd = open( filename, O_RDONLY );
+            gIOCalls++;
+            if (fd < 0)
+                return false;
+            if (method == BLOCK_POSIX)
+                result = read_blocks( fd, buffer, bytes, kSmallBlock, sum );
+            else if (method == BLOCK_PREAD)
+                result = pread_blocks( fd, buffer, bytes, sum );
+            else if (method == BLOCK_VECTOR)
+                result = readv_blocks( fd, buffer, bytes, sum );
+#if HAS_IO_URING
+            else
+                result = uring_blocks( *(uring_queue *)queue, fd, NULL, buffer, bytes, sum );
+#endif
+            break;
+        case BLOCK_MMAP:
+            {
+            fd = open( filename, O_RDONLY );
+            gIOCalls++;
+            if (fd < 0)
+                return false;
+            gIOCalls += 2;      // mmap, munmap
+            void *mapped = mmap( NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if (mapped == MAP_FAILED)
+                break;
+            sum += checksum_block( (const uint8_t *)mapped, bytes );
+            munmap( mapped, bytes );
+            result = true;
+            }
+            break;
+        case BLOCK_DIRECT:
+            fd = open_direct( filename, O_RDONLY );
+            if (fd < 0)
+                return false;
+            result = pread_blocks( fd, buffer, bytes, sum );
+            break;
+        default:
+            fprintf (stderr, "Unknown mode %d", int(method) );
+            exit(-1);
+            break;
+    }
+
+    close( fd );
+    gIOCalls++;
+    return result;
+}
+
+/******************************************************************************/
+
+// returns false if the method is not supported here
+bool block_copy_file(const char *source, const char *dest, size_t bytes, uint8_t *buffer, const copyIOMethod method )
+{
+    const mode_t mode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+    bool result = false;
+    
+    int fdIn = open( source, O_RDONLY );
+    int fdOut = open( dest, O_CREAT | O_WRONLY | O_TRUNC, mode );
+    gIOCalls += 4;      // open, open, close, close
+    if (fdIn < 0 || fdOut < 0) {
+        close( fdIn );
+        close( fdOut );
+        return false;
+    }
+
+    switch( method ) {
+        case COPY_READWRITE:
+            {
+            size_t done = 0;
+            result = true;
+            while (done < bytes) {
+                size_t len = std::min( kLargeBlock, bytes - done );
+                gIOCalls += 2;
+                if (read( fdIn, buffer, len ) != (ssize_t)len
+                    || write( fdOut, buffer, len ) != (ssize_t)len) {
+                    result = false;
+                    break;
+                }
+                done += len;
+            }
+            }
+            break;
+        case COPY_MMAP:
+            {
+            gIOCalls += 2;      // mmap, munmap
+            void *mapped = mmap( NULL, bytes, PROT_READ, MAP_PRIVATE, fdIn, 0 );
+            if (mapped == MAP_FAILED)
+                break;
+            result = write_blocks( fdOut, (const uint8_t *)mapped, bytes, bytes );
+            munmap( mapped, bytes );
+            }
+            break;
+        case COPY_SENDFILE:
+#if defined(__linux__)
+            {
+            off_t offset = 0;
+            result = true;
+            while ((size_t)offset < bytes) {
+                gIOCalls++;
+                if (sendfile( fdOut, fdIn, &offset, bytes - offset ) <= 0) {
+                    result = false;
+                    break;
+                }
+            }
+            }
+#endif
+            break;
+        case COPY_FILE_RANGE:
+#if defined(__linux__) && defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 27)
+            {
+            size_t done = 0;
+            result = true;
+            while (done < bytes) {
+                gIOCalls++;
+                ssize_t copied = copy_file_range( fdIn, NULL, fdOut, NULL, bytes - done, 0 );
+                if (copied <= 0) {
+                    result = false;
+                    break;
+                }
+                done += copied;
+            }
+            }
+#endif
+            break;
+        default:
+            fprintf (stderr, "Unknown mode %d", int(method) );
+            exit(-1);
+            break;
+    }
+
+    close( fdIn );
+    close( fdOut );
+    return result;
+}
+
+/******************************************************************************/
+
+static void record_block_result(double time, const string &label, uint64_t calls, int repeats) {
+    gLabels.push_back( label + " (" + std::to_string( calls / repeats ) + " calls)" );
+    record_result( time, gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+void test_block_out(const char *filename, const uint8_t *source, size_t bytes, int repeats, const string &label, const blockIOMethod method )
+{
+    void *queue = NULL;
+#if HAS_IO_URING
+    uring_queue uring;
+    if (method == BLOCK_URING) {
+        if (!uring_setup( uring, gQueueDepth )) {
+            fprintf(stderr,"%s skipped, io_uring is not available (errno %d)\n", label.c_str(), errno );
+            return;
+        }
+        queue = &uring;
+    }
+#else
+    if (method == BLOCK_URING)
+        return;
+#endif
+
+    bool supported = true;
+    gIOCalls = 0;
+    start_wall_timer();
+    for (int i = 0; i < repeats; ++i) {
+        if (!block_write_file( filename, source, bytes, method, queue )) {
+            fprintf(stderr,"%s skipped, not supported here (errno %d)\n", label.c_str(), errno );
+            supported = false;
+            break;
+        }
+    }
+    double elapsed = wall_timer();
+    
+#if HAS_IO_URING
+    if (queue != NULL)
+        uring_teardown( uring );
+#endif
+
+    if (supported)
+        record_block_result( elapsed, label, gIOCalls, repeats );
+}
+
+/******************************************************************************/
+
+void test_block_in(const char *filename, uint8_t *buffer, size_t bytes, int repeats, uint64_t expected, const string &label, const blockIOMethod method )
+{
+    void *queue = NULL;
+#if HAS_IO_URING
+    uring_queue uring;
+    if (method == BLOCK_URING) {
+        if (!uring_setup( uring, gQueueDepth )) {
+            fprintf(stderr,"%s skipped, io_uring is not available (errno %d)\n", label.c_str(), errno );
+            return;
+        }
+        queue = &uring;
+    }
+#else
+    if (method == BLOCK_URING)
+        return;
+#endif
+
+    bool supported = true;
+    gIOCalls = 0;
+    start_wall_timer();
+    for (int i = 0; i < repeats; ++i) {
+        uint64_t sum = 0;
+        if (!block_read_file( filename, buffer, bytes, method, queue, sum )) {
+            fprintf(stderr,"%s skipped, not supported here (errno %d)\n", label.c_str(), errno );
+            supported = false;
+            break;
+        }
+        if (sum != expected) {
+            std::cerr << "test " << label << " failed, got " << sum << ", expected " << expected << std::endl;
+            break;
+        }
+    }
+    double elapsed = wall_timer();
+    
+#if HAS_IO_URING
+    if (queue != NULL)
+        uring_teardown( uring );
+#endif
+
+    if (supported)
+        record_block_result( elapsed, label, gIOCalls, repeats );
+}
+
+/******************************************************************************/
+
+void test_block_copy(const char *source, const char *dest, uint8_t *buffer, size_t bytes, int repeats, uint64_t expected, const string &label, const copyIOMethod method )
+{
+    gIOCalls = 0;
+    start_wall_timer();
+    for (int i = 0; i < repeats; ++i) {
+        if (!block_copy_file( source, dest, bytes, buffer, method )) {
+            fprintf(stderr,"%s skipped, not supported here (errno %d)\n", label.c_str(), errno );
+            remove( dest );
+            return;
+        }
+    }
+    double elapsed = wall_timer();
+    
+    // check the copy, outside the timed loop
+    uint64_t sum = 0;
+    uint64_t calls = gIOCalls;
+    if (!block_read_file( dest, buffer, bytes, BLOCK_PREAD, NULL, sum ) || sum != expected)
+        std::cerr << "test " << label << " failed, got " << sum << ", expected " << expected << std::endl;
+    
+    record_block_result( elapsed, label, calls, repeats );
+}
+
+#endif  // !_WIN32
+
+/******************************************************************************/
+/******************************************************************************/
+
+// Concurrent writers: several threads writing formatted log lines to one file.
+// Timed with a wall clock, and each line's latency is recorded so we can report the tail.
+
+typedef enum writerMode {
+    WRITER_SHARED_FILE = 1,     // fprintf to one FILE*, relying on the implicit stdio lock
+    WRITER_SHARED_STREAM = 2,   // operator<< to one ofstream, guarded by a mutex (streams are not thread safe)
+    WRITER_LOCAL_BUFFER = 3,    // format into a per-thread buffer, merged into the file at the end
+    WRITER_RING_BUFFER = 4,     // lock-free ring buffer, drained by a single writer thread
+} writerMode;
+
+/******************************************************************************/
+
+// bounded multi-producer, single consumer queue of preformatted lines
+// producers claim a slot with an atomic increment, and publish it with a sequence number
+class line_ring {
+public:
+    static const int kLineLength = 120;
+
+    explicit line_ring(size_t capacity) : slots(capacity), mask(capacity-1), head(0), tail(0) {
+        for (size_t i = 0; i < capacity; ++i)
+            slots[i].sequence.store( i, std::memory_order_relaxed );
+    }
+
+    void push(const char *text, int length) {
+        size_t position = tail.load( std::memory_order_relaxed );
+        line_slot *slot;
+        for (;;) {
+            slot = &slots[ position & mask ];
+            size_t sequence = slot->sequence.load( std::memory_order_acquire );
+            intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0) {
+                if (tail.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ))
+                    break;
+            } else if (difference < 0) {
+                std::this_thread::yield();      // full, wait for the writer thread to catch up
+                position = tail.load( std::memory_order_relaxed );
+            } else
+                position = tail.load( std::memory_order_relaxed );
+        }
+        memcpy( slot->text, text, length );
+        slot->length = length;
+        slot->sequence.store( position + 1, std::memory_order_release );
+    }
+
+    // only called from the writer thread, returns length or -1 if empty
+    int pop(char *text) {
+        line_slot *slot = &slots[ head & mask ];
+        if (slot->sequence.load( std::memory_order_acquire ) != head + 1)
+            return -1;
+        int length = slot->length;
+        memcpy( text, slot->text, length );
+        slot->sequence.store( head + mask + 1, std::memory_order_release );
+        head++;
+        return length;
+    }
+
+private:
+    struct line_slot {
+        std::atomic<size_t> sequence;
+        int length;
+        char text[ kLineLength ];
+    };
+    
+    std::vector<line_slot> slots;
+    const size_t mask;
+    size_t head;                            // only touched by the writer thread
+    alignas(64) std::atomic<size_t> tail;   // keep producers off the writer thread's cache line
+};
+
+/******************************************************************************/
+
+static inline int format_log_line(char *buffer, size_t size, int writer, int line) {
+    return snprintf( buffer, size, "writer %d line %d value %.3f\n", writer, line, line * 0.25 );
+}
+
+/******************************************************************************/
+
+static uint64_t count_lines(const char *filename) {
+    FILE *input = fopen( filename, "rb" );
+    if (input == NULL)
+        return 0;
+    uint64_t lines = 0;
+    int c;
+    while ((c = getc(input)) != EOF)
+        if (c == '\n')
+            lines++;
+    fclose( input );
+    return lines;
+}
+
+/******************************************************************************/
+
+// latency lines for the current group of tests, printed after the summary
+std::string gLatencyReport;
+
+/******************************************************************************/
+
+static void record_latency_report(const string &label, std::vector< std::vector<uint32_t> > &latencies) {
+    std::vector<uint32_t> all;
+    uint32_t worstWriterP99 = 0;
+    for (auto &writer : latencies) {
+        if (writer.empty())
+            continue;
+        std::sort( writer.begin(), writer.end() );
+        worstWriterP99 = std::max( worstWriterP99, writer[ (writer.size() * 99) / 100 ] );
+        all.insert( all.end(), writer.begin(), writer.end() );
+    }
+    if (all.empty())
+        return;
+    std::sort( all.begin(), all.end() );
+    const size_t n = all.size();
+    char text[ 400 ];
+    snprintf( text, sizeof(text), "%s latency: p50 %u ns, p99 %u ns, p99.9 %u ns, max %u ns, worst writer p99 %u ns\n",
+            label.c_str(), all[ n/2 ], all[ (n*99)/100 ], all[ (n*999)/1000 ], all.back(), worstWriterP99 );
+    gLatencyReport += text;
+}
+
+/******************************************************************************/
+
+void test_concurrent_writers(benchmark::thread_pool &pool, const char *filename, int writers, int lines,
+                            const string &label, const writerMode mode )
+{
+    typedef std::chrono::steady_clock clock_type;
+    const int linesPerWriter = lines / writers;
+    std::vector< std::vector<uint32_t> > latencies( writers );
+    for (auto &writer : latencies)
+        writer.reserve( linesPerWriter );
+
+    FILE *stdio_target = NULL;
+    ofstream stream_target;
+    std::mutex stream_lock;
+    std::vector<std::string> buffers( writers );
+    line_ring ring( (mode == WRITER_RING_BUFFER) ? 64*1024 : 1 );
+    std::atomic<bool> producing( true );
+
+    if (mode == WRITER_SHARED_STREAM)
+        stream_target.open( filename );
+    else
+        stdio_target = fopen( filename, "w" );
+
+    auto record_latency = [&]( int writer, clock_type::time_point before ) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>( clock_type::now() - before ).count();
+        latencies[writer].push_back( (uint32_t) std::min( elapsed, (decltype(elapsed))UINT32_MAX ) );
+    };
+
+    auto one_writer = [&]( int writer ) {
+        char line[ line_ring::kLineLength ];
+        switch( mode ) {
+            case WRITER_SHARED_FILE:
+                for (int i = 0; i < linesPerWriter; ++i) {
+                    auto before = clock_type::now();
+                    fprintf( stdio_target, "writer %d line %d value %.3f\n", writer, i, i * 0.25 );
+                    record_latency( writer, before );
+                }
+                break;
+            case WRITER_SHARED_STREAM:
+                for (int i = 0; i < linesPerWriter; ++i) {
+                    auto before = clock_type::now();
+                    {
+                    std::lock_guard<std::mutex> guard( stream_lock );
+                    stream_target << "writer " << writer << " line " << i << " value " << (i * 0.25) << '\n';
+                    }
+                    record_latency( writer, before );
+                }
+                break;
+            case WRITER_LOCAL_BUFFER:
+                buffers[writer].reserve( linesPerWriter * 40 );
+                for (int i = 0; i < linesPerWriter; ++i) {
+                    auto before = clock_type::now();
+                    int length = format_log_line( line, sizeof(line), writer, i );
+                    buffers[writer].append( line, length );
+                    record_latency( writer, before );
+                }
+                break;
+            case WRITER_RING_BUFFER:
+                for (int i = 0; i < linesPerWriter; ++i) {
+                    auto before = clock_type::now();
+                    int length = format_log_line( line, sizeof(line), writer, i );
+                    ring.push( line, length );
+                    record_latency( writer, before );
+                }
+                break;
+            default:
+                fprintf (stderr, "Unknown mode %d", int(mode) );
+                exit(-1);
+                break;
+        }
+    };
+
+    // the last pool thread drains the ring while the others produce
+    auto drain_ring = [&]() {
+        const size_t chunk = 64*1024;
+        std::vector<char> pending( chunk + line_ring::kLineLength );
+        size_t used = 0;
+        for (;;) {
+            int length = ring.pop( &pending[used] );
+            if (length < 0) {
+                if (!producing.load( std::memory_order_acquire )) {
+                    length = ring.pop( &pending[used] );    // one last look after the producers finish
+                    if (length < 0)
+                        break;
+                } else {
+                    std::this_thread::yield();
+                    continue;
+                }
+            }
+            used += length;
+            if (used >= chunk) {
+                fwrite( &pending[0], 1, used, stdio_target );
+                used = 0;
+            }
+        }
+        fwrite( &pending[0], 1, used, stdio_target );
+    };
+
+    std::atomic<int> producersLeft( writers );
+
+    start_wall_timer();
+    if (mode == WRITER_RING_BUFFER) {
+        pool.run( writers+1, [&]( int index ) {
+            if (index == writers) {
+                drain_ring();
+            } else {
+                one_writer( index );
+                if (producersLeft.fetch_sub( 1 ) == 1)
+                    producing.store( false, std::memory_order_release );
+            }
+        } );
+    } else
+        pool.run( writers, one_writer );
+
+    if (mode == WRITER_LOCAL_BUFFER)
+        for (auto &buffer : buffers)
+            fwrite( buffer.data(), 1, buffer.size(), stdio_target );
+
+    if (mode == WRITER_SHARED_STREAM)
+        stream_target.close();
+    else
+        fclose( stdio_target );
+    double elapsed = wall_timer();
+
+    uint64_t expected = (uint64_t)linesPerWriter * writers;
+    uint64_t found = count_lines( filename );
+    if (found != expected)
+        std::cerr << "test " << label << " failed, got " << found << " lines, expected " << expected << std::endl;
+
+    gLabels.push_back( label );
+    record_result( elapsed, gLabels.back().c_str() );
+    record_latency_report( label, latencies );
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -632,13 +1644,16 @@ int main (int argc, char *argv[])
 
     // report that a filename is required
     if (argc < 2) {
-        printf("usage: %s reportfile [outputfile] [count]\n", argv[0] );
+        printf("usage: %s reportfile [outputfile] [count] [queue depth]\n", argv[0] );
         exit(1);
     }
 
     char *reportfilename = argv[1];
     const char *filename = (2 < argc) ? argv[2] : defaultName;
     const int count = (3 < argc) ? atoi(argv[3]) : 5000000;
+#ifndef _WIN32
+    if (4 < argc) gQueueDepth = std::max( 1, atoi(argv[4]) );
+#endif
     
     
     // open up our reporting file (so we can catch failures early)
@@ -839,9 +1854,87 @@ int main (int argc, char *argv[])
     
     // output results
     summarize2(report_file, "iostreams posix", 1, count/posix_scale, false );
+
+
+    // Block IO moves about 64 bytes per count through each method, for each file size.
+    // Operations per second are reported as MB per second.
+    const size_t blockSizes[] = { 64*1024, 4*1024*1024, 64*1024*1024 };
+    const size_t maxBlockSize = 64*1024*1024;
+    const size_t blockTotal = std::max( (size_t)count * 64, maxBlockSize );
+    string copyname = string(filename) + ".copy";
+
+    uint8_t *blockSource = allocate_aligned( maxBlockSize );
+    uint8_t *blockBuffer = allocate_aligned( std::max( maxBlockSize, gQueueDepth * kLargeBlock ) );
+    for (size_t j = 0; j < maxBlockSize; ++j)
+        blockSource[j] = (uint8_t)( (j * 2654435761ULL) >> 24 );
+
+    for (size_t sizeIndex = 0; sizeIndex < sizeof(blockSizes)/sizeof(blockSizes[0]); ++sizeIndex) {
+        const size_t bytes = blockSizes[sizeIndex];
+        const int repeats = (int)(blockTotal / bytes);
+        const uint64_t expected = checksum_block( blockSource, bytes );
+        const string sizeLabel = (bytes < kLargeBlock) ? std::to_string( bytes / 1024 ) + " KB"
+                                                       : std::to_string( bytes / kLargeBlock ) + " MB";
+        const string queueLabel = " depth " + std::to_string( gQueueDepth );
+
+        test_block_out( filename, blockSource, bytes, repeats, "fwrite " + sizeLabel, BLOCK_STDIO );
+        test_block_in( filename, blockBuffer, bytes, repeats, expected, "fread " + sizeLabel, BLOCK_STDIO );
+        
+        test_block_out( filename, blockSource, bytes, repeats, "write 4 KB blocks " + sizeLabel, BLOCK_POSIX );
+        test_block_in( filename, blockBuffer, bytes, repeats, expected, "read 4 KB blocks " + sizeLabel, BLOCK_POSIX );
+        
+        test_block_out( filename, blockSource, bytes, repeats, "pwrite 1 MB blocks " + sizeLabel, BLOCK_PREAD );
+        test_block_in( filename, blockBuffer, bytes, repeats, expected, "pread 1 MB blocks " + sizeLabel, BLOCK_PREAD );
+        
+        test_block_out( filename, blockSource, bytes, repeats, "writev " + sizeLabel, BLOCK_VECTOR );
+        test_block_in( filename, blockBuffer, bytes, repeats, expected, "readv " + sizeLabel, BLOCK_VECTOR );
+        
+        test_block_out( filename, blockSource, bytes, repeats, "mmap write " + sizeLabel, BLOCK_MMAP );
+        test_block_in( filename, blockBuffer, bytes, repeats, expected, "mmap read " + sizeLabel, BLOCK_MMAP );
+        
+        test_block_out( filename, blockSource, bytes, repeats, "direct write " + sizeLabel, BLOCK_DIRECT );
+        test_block_in( filename, blockBuffer, bytes, repeats, expected, "direct read " + sizeLabel, BLOCK_DIRECT );
+        
+        test_block_out( filename, blockSource, bytes, repeats, "io_uring write" + queueLabel + " " + sizeLabel, BLOCK_URING );
+        test_block_in( filename, blockBuffer, bytes, repeats, expected, "io_uring read" + queueLabel + " " + sizeLabel, BLOCK_URING );
+        
+        // make sure we have a good source file, then test file to file copies
+        block_write_file( filename, blockSource, bytes, BLOCK_PREAD, NULL );
+        test_block_copy( filename, copyname.c_str(), blockBuffer, bytes, repeats, expected, "copy read/write " + sizeLabel, COPY_READWRITE );
+        test_block_copy( filename, copyname.c_str(), blockBuffer, bytes, repeats, expected, "copy mmap/write " + sizeLabel, COPY_MMAP );
+        test_block_copy( filename, copyname.c_str(), blockBuffer, bytes, repeats, expected, "copy sendfile " + sizeLabel, COPY_SENDFILE );
+        test_block_copy( filename, copyname.c_str(), blockBuffer, bytes, repeats, expected, "copy copy_file_range " + sizeLabel, COPY_FILE_RANGE );
+
+        // output results
+        gLabels.push_back( "iostreams block IO " + sizeLabel );
+        summarize2(report_file, gLabels.back().c_str(), (int)bytes, repeats, false );
+    }
+
+    free( blockSource );
+    free( blockBuffer );
+    remove( copyname.c_str() );
 #endif  // !_WIN32
 
 
+    // concurrent writers, reported as lines per second
+    {
+    const int maxWriters = std::max( 4, benchmark::hardware_threads() );
+    benchmark::thread_pool pool( maxWriters + 1 );
+    for (int writers = 1; writers <= maxWriters; writers *= 2) {
+        const string writerLabel = " " + std::to_string( writers ) + ((writers == 1) ? " writer" : " writers");
+        
+        test_concurrent_writers( pool, filename, writers, count, "shared FILE" + writerLabel, WRITER_SHARED_FILE );
+        test_concurrent_writers( pool, filename, writers, count, "shared ostream with mutex" + writerLabel, WRITER_SHARED_STREAM );
+        test_concurrent_writers( pool, filename, writers, count, "per-thread buffers" + writerLabel, WRITER_LOCAL_BUFFER );
+        test_concurrent_writers( pool, filename, writers, count, "ring buffer and writer thread" + writerLabel, WRITER_RING_BUFFER );
+    }
+
+    // output results
+    summarize2(report_file, "iostreams concurrent writers", 1, count, false );
+    fprintf( report_file, "%s\n", gLatencyReport.c_str() );
+    gLatencyReport.clear();
+    }
+
+
     // done with reports
     fclose(report_file);
     
@@ -26,8 +26,17 @@ Assumptions:
 
 
 
-TODO - lookup and interpolate (int16_t, int32_t, int64_t, float, double)
-TODO - 2D and 3D LUTs, simple and interpolated
+    3) Interpolated lookups will be limited by table reads more than by arithmetic,
+        and the compiler will use vector gathers where the CPU has them.
+
+    4) 3D tetrahedral interpolation will be faster than trilinear, with fewer table reads.
+
+
+
+NOTE - interpolated tables are verified with linear contents, so interpolation must be exact
+        (up to rounding).
+
+TODO - 3D lookups on coherent image data, instead of random pixels
 
 */
 
@@ -40,9 +49,13 @@ TODO - 2D and 3D LUTs, simple and interpolated
 #include <cmath>
 #include <cstdlib>
 #include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_algorithms.h"
+#include "benchmark_typenames.h"
 
 /******************************************************************************/
 /******************************************************************************/
@@ -991,6 +1004,651 @@ void test_lut8(const T* input, T *result, const int count, const T* LUT, const c
 /******************************************************************************/
 /******************************************************************************/
 
+/*
+    Interpolated lookup tables
+
+    Positions are 16.16 fixed point table coordinates, or floats scaled to the table size.
+    Tables have one extra entry, so the last interval can interpolate without a test.
+    Small tables stay in L1 cache, large tables don't fit in L2 (and random positions defeat prefetch).
+
+    "strip" versions compute indices and fractions for a strip of values first,
+        then do all the table reads in a loop with no other work, which compilers can turn into gathers.
+    "slope" versions store each entry with the difference to the next entry,
+        so an interpolation reads one cache line and needs one multiply-add.
+*/
+
+const int INTERP_COUNT = 100000;
+const int INTERP_STRIP = 256;
+
+/******************************************************************************/
+
+template <typename T>
+inline T interpolate_fixed( T a, T b, uint32_t frac ) {
+    if (std::numeric_limits<T>::is_integer)
+        return T( a + ((int64_t(b) - int64_t(a)) * int64_t(frac) >> 16) );
+    else
+        return a + (b - a) * (T(frac) * T(1.0/65536.0));
+}
+
+/******************************************************************************/
+
+template <typename T>
+inline T interpolate_slope( T base, T slope, uint32_t frac ) {
+    if (std::numeric_limits<T>::is_integer)
+        return T( base + (int64_t(slope) * int64_t(frac) >> 16) );
+    else
+        return base + slope * (T(frac) * T(1.0/65536.0));
+}
+
+/******************************************************************************/
+
+// baseline - a trivial loop
+template <typename T>
+void interp_lut1(const uint32_t *positions, T *result, const int count, const T *LUT) {
+    for (int j = 0; j < count; ++j) {
+        uint32_t index = positions[j] >> 16;
+        result[j] = interpolate_fixed( LUT[index], LUT[index+1], positions[j] & 0xFFFF );
+    }
+}
+
+/******************************************************************************/
+
+// unroll 4X, so several table reads are in flight at once
+template <typename T>
+void interp_lut2(const uint32_t *positions, T *result, const int count, const T *LUT) {
+    int j;
+    for (j = 0; j < (count - 3); j += 4) {
+        uint32_t p0 = positions[j+0];
+        uint32_t p1 = positions[j+1];
+        uint32_t p2 = positions[j+2];
+        uint32_t p3 = positions[j+3];
+        
+        T a0 = LUT[ p0 >> 16 ], b0 = LUT[ (p0 >> 16) + 1 ];
+        T a1 = LUT[ p1 >> 16 ], b1 = LUT[ (p1 >> 16) + 1 ];
+        T a2 = LUT[ p2 >> 16 ], b2 = LUT[ (p2 >> 16) + 1 ];
+        T a3 = LUT[ p3 >> 16 ], b3 = LUT[ (p3 >> 16) + 1 ];
+        
+        result[j+0] = interpolate_fixed( a0, b0, p0 & 0xFFFF );
+        result[j+1] = interpolate_fixed( a1, b1, p1 & 0xFFFF );
+        result[j+2] = interpolate_fixed( a2, b2, p2 & 0xFFFF );
+        result[j+3] = interpolate_fixed( a3, b3, p3 & 0xFFFF );
+    }
+    for (; j < count; ++j) {
+        uint32_t index = positions[j] >> 16;
+        result[j] = interpolate_fixed( LUT[index], LUT[index+1], positions[j] & 0xFFFF );
+    }
+}
+
+/******************************************************************************/
+
+// strip mined, gather friendly
+template <typename T>
+void interp_lut3(const uint32_t *positions, T *result, const int count, const T *LUT) {
+    int32_t index[ INTERP_STRIP ];
+    T low[ INTERP_STRIP ], high[ INTERP_STRIP ];
+    
+    for (int k = 0; k < count; k += INTERP_STRIP) {
+        int end = std::min( INTERP_STRIP, count - k );
+        const uint32_t *pos = positions + k;
+        
+        for (int j = 0; j < end; ++j)
+            index[j] = int32_t( pos[j] >> 16 );
+        
+        for (int j = 0; j < end; ++j) {
+            low[j] = LUT[ index[j] ];
+            high[j] = LUT[ index[j] + 1 ];
+        }
+        
+        for (int j = 0; j < end; ++j)
+            result[k+j] = interpolate_fixed( low[j], high[j], pos[j] & 0xFFFF );
+    }
+}
+
+/******************************************************************************/
+
+// base and slope pairs, one cache line per lookup
+template <typename T>
+void interp_lut4(const uint32_t *positions, T *result, const int count, const T *slopeLUT) {
+    for (int j = 0; j < count; ++j) {
+        uint32_t index = positions[j] >> 16;
+        result[j] = interpolate_slope( slopeLUT[2*index], slopeLUT[2*index+1], positions[j] & 0xFFFF );
+    }
+}
+
+/******************************************************************************/
+
+// float positions in [0,1]
+template <typename T>
+void interp_float_lut1(const T *positions, T *result, const int count, const T *LUT, const int entries) {
+    const T scale = T(entries - 1);
+    for (int j = 0; j < count; ++j) {
+        T pos = positions[j] * scale;
+        int index = std::min( int(pos), entries - 2 );
+        T frac = pos - T(index);
+        result[j] = LUT[index] + (LUT[index+1] - LUT[index]) * frac;
+    }
+}
+
+/******************************************************************************/
+
+// float positions, strip mined, gather friendly
+template <typename T>
+void interp_float_lut3(const T *positions, T *result, const int count, const T *LUT, const int entries) {
+    const T scale = T(entries - 1);
+    int32_t index[ INTERP_STRIP ];
+    T frac[ INTERP_STRIP ], low[ INTERP_STRIP ], high[ INTERP_STRIP ];
+    
+    for (int k = 0; k < count; k += INTERP_STRIP) {
+        int end = std::min( INTERP_STRIP, count - k );
+        
+        for (int j = 0; j < end; ++j) {
+            T pos = positions[k+j] * scale;
+            index[j] = std::min( int32_t(pos), int32_t(entries - 2) );
+            frac[j] = pos - T(index[j]);
+        }
+        
+        for (int j = 0; j < end; ++j) {
+            low[j] = LUT[ index[j] ];
+            high[j] = LUT[ index[j] + 1 ];
+        }
+        
+        for (int j = 0; j < end; ++j)
+            result[k+j] = low[j] + (high[j] - low[j]) * frac[j];
+    }
+}
+
+/******************************************************************************/
+
+// float positions, base and slope pairs
+template <typename T>
+void interp_float_lut4(const T *positions, T *result, const int count, const T *slopeLUT, const int entries) {
+    const T scale = T(entries - 1);
+    for (int j = 0; j < count; ++j) {
+        T pos = positions[j] * scale;
+        int index = std::min( int(pos), entries - 2 );
+        T frac = pos - T(index);
+        result[j] = slopeLUT[2*index] + slopeLUT[2*index+1] * frac;
+    }
+}
+
+/******************************************************************************/
+
+// uniform in [0,1)
+inline double random_unit() {
+    return double( uint64_t( crand64() ) >> 11 ) * (1.0 / 9007199254740992.0);
+}
+
+/******************************************************************************/
+
+// a ramp, so interpolated results can be checked against the position
+template <typename T>
+void fill_ramp_LUT( std::vector<T> &LUT, std::vector<T> &slopeLUT, int entries, double step ) {
+    LUT.resize( entries );
+    slopeLUT.resize( 2*entries );
+    for (int i = 0; i < entries; ++i)
+        LUT[i] = T( i * step );
+    for (int i = 0; i < entries; ++i) {
+        slopeLUT[2*i] = LUT[i];
+        slopeLUT[2*i+1] = (i+1 < entries) ? T(LUT[i+1] - LUT[i]) : T(0);
+    }
+}
+
+/******************************************************************************/
+
+template <typename T>
+void verify_interpolated( const T *result, const std::vector<double> &expected, double tolerance, const char *label ) {
+    for (size_t j = 0; j < expected.size(); ++j) {
+        if (std::abs( double(result[j]) - expected[j] ) > tolerance) {
+            printf("test %s failed (got %g, expected %g)\n", label, double(result[j]), expected[j]);
+            break;
+        }
+    }
+}
+
+/******************************************************************************/
+
+template <typename T>
+void TestInterpolated1D( int indexBits ) {
+    const int entries = (1 << indexBits) + 1;
+    const bool isInteger = std::numeric_limits<T>::is_integer;
+    // keep ramp values inside the type
+    const double step = isInteger ? std::min( 37.0, double( std::numeric_limits<T>::max() ) / entries ) : 0.37;
+    std::string myTypeName( getTypeName<T>() );
+    
+    std::vector<T> LUT, slopeLUT;
+    fill_ramp_LUT( LUT, slopeLUT, entries, step );
+    
+    std::vector<uint32_t> positions( INTERP_COUNT );
+    std::vector<T> result( INTERP_COUNT );
+    std::vector<double> expected( INTERP_COUNT );
+    for (int j = 0; j < INTERP_COUNT; ++j) {
+        positions[j] = uint32_t( uint64_t( crand64() ) % (uint64_t(entries - 1) << 16) );
+        uint32_t index = positions[j] >> 16;
+        double delta = (double(LUT[index+1]) - double(LUT[index])) * double(positions[j] & 0xFFFF) / 65536.0;
+        expected[j] = double(LUT[index]) + (isInteger ? std::floor( delta ) : delta);
+    }
+    const double tolerance = isInteger ? 0.0 : 1.0e-5 * (entries * step);
+    
+    iterations = std::max( 1, (int)(((uint64_t)base_iterations * SIZE_SMALL) / (32 * (uint64_t)INTERP_COUNT)) );
+    
+    std::string prefix = myTypeName + " interpolated lookup table " + std::to_string(entries) + " entries";
+    std::string labels[4] = { prefix + " simple", prefix + " unrolled", prefix + " strip", prefix + " slope" };
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        interp_lut1( &positions[0], &result[0], INTERP_COUNT, &LUT[0] );
+    record_result( timer(), labels[0].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[0].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        interp_lut2( &positions[0], &result[0], INTERP_COUNT, &LUT[0] );
+    record_result( timer(), labels[1].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[1].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        interp_lut3( &positions[0], &result[0], INTERP_COUNT, &LUT[0] );
+    record_result( timer(), labels[2].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[2].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        interp_lut4( &positions[0], &result[0], INTERP_COUNT, &slopeLUT[0] );
+    record_result( timer(), labels[3].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[3].c_str() );
+    
+    summarize( prefix.c_str(), INTERP_COUNT, iterations, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+
+template <typename T>
+void TestInterpolatedFloat1D( int indexBits ) {
+    const int entries = (1 << indexBits) + 1;
+    const double step = 0.37;
+    std::string myTypeName( getTypeName<T>() );
+    
+    std::vector<T> LUT, slopeLUT;
+    fill_ramp_LUT( LUT, slopeLUT, entries, step );
+    
+    std::vector<T> positions( INTERP_COUNT );
+    std::vector<T> result( INTERP_COUNT );
+    std::vector<double> expected( INTERP_COUNT );
+    for (int j = 0; j < INTERP_COUNT; ++j) {
+        positions[j] = T( random_unit() );
+        expected[j] = double(positions[j]) * (entries - 1) * step;
+    }
+    const double tolerance = (sizeof(T) == 4 ? 1.0e-5 : 1.0e-12) * (entries * step);
+    
+    iterations = std::max( 1, (int)(((uint64_t)base_iterations * SIZE_SMALL) / (32 * (uint64_t)INTERP_COUNT)) );
+    
+    std::string prefix = myTypeName + " interpolated lookup table " + std::to_string(entries) + " entries, float positions,";
+    std::string labels[3] = { prefix + " simple", prefix + " strip", prefix + " slope" };
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        interp_float_lut1( &positions[0], &result[0], INTERP_COUNT, &LUT[0], entries );
+    record_result( timer(), labels[0].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[0].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        interp_float_lut3( &positions[0], &result[0], INTERP_COUNT, &LUT[0], entries );
+    record_result( timer(), labels[1].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[1].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        interp_float_lut4( &positions[0], &result[0], INTERP_COUNT, &slopeLUT[0], entries );
+    record_result( timer(), labels[2].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[2].c_str() );
+    
+    summarize( prefix.c_str(), INTERP_COUNT, iterations, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    2D lookup tables, one float result per (x,y) pair
+    The grid has size x size nodes covering [0,1] in each direction.
+*/
+
+inline void grid_position( float value, float scale, int size, int &index, float &frac ) {
+    float pos = value * scale;
+    index = std::min( int(pos), size - 2 );
+    frac = pos - float(index);
+}
+
+/******************************************************************************/
+
+void lookup2D_nearest(const float *xy, float *result, const int count, const float *LUT, const int size) {
+    const float scale = float(size - 1);
+    for (int j = 0; j < count; ++j) {
+        int x = int( xy[2*j+0] * scale + 0.5f );
+        int y = int( xy[2*j+1] * scale + 0.5f );
+        result[j] = LUT[ y*size + x ];
+    }
+}
+
+/******************************************************************************/
+
+void lookup2D_bilinear(const float *xy, float *result, const int count, const float *LUT, const int size) {
+    const float scale = float(size - 1);
+    for (int j = 0; j < count; ++j) {
+        int x, y;
+        float fx, fy;
+        grid_position( xy[2*j+0], scale, size, x, fx );
+        grid_position( xy[2*j+1], scale, size, y, fy );
+        const float *cell = LUT + y*size + x;
+        float top = cell[0] + (cell[1] - cell[0]) * fx;
+        float bottom = cell[size] + (cell[size+1] - cell[size]) * fx;
+        result[j] = top + (bottom - top) * fy;
+    }
+}
+
+/******************************************************************************/
+
+// strip mined, gather friendly
+void lookup2D_bilinear_strip(const float *xy, float *result, const int count, const float *LUT, const int size) {
+    const float scale = float(size - 1);
+    int32_t offset[ INTERP_STRIP ];
+    float fx[ INTERP_STRIP ], fy[ INTERP_STRIP ];
+    
+    for (int k = 0; k < count; k += INTERP_STRIP) {
+        int end = std::min( INTERP_STRIP, count - k );
+        
+        for (int j = 0; j < end; ++j) {
+            int x, y;
+            grid_position( xy[2*(k+j)+0], scale, size, x, fx[j] );
+            grid_position( xy[2*(k+j)+1], scale, size, y, fy[j] );
+            offset[j] = y*size + x;
+        }
+        
+        for (int j = 0; j < end; ++j) {
+            const float *cell = LUT + offset[j];
+            float top = cell[0] + (cell[1] - cell[0]) * fx[j];
+            float bottom = cell[size] + (cell[size+1] - cell[size]) * fx[j];
+            result[k+j] = top + (bottom - top) * fy[j];
+        }
+    }
+}
+
+/******************************************************************************/
+
+// grid values are a plane, so bilinear interpolation is exact
+void TestLookup2D( int size ) {
+    std::vector<float> LUT( size*size );
+    for (int y = 0; y < size; ++y)
+        for (int x = 0; x < size; ++x)
+            LUT[y*size+x] = float( (0.25*x + 0.75*y) / (size - 1) );
+    
+    std::vector<float> xy( 2*INTERP_COUNT );
+    std::vector<float> result( INTERP_COUNT );
+    std::vector<double> expected( INTERP_COUNT ), expectedNearest( INTERP_COUNT );
+    for (int j = 0; j < INTERP_COUNT; ++j) {
+        xy[2*j+0] = float( random_unit() );
+        xy[2*j+1] = float( random_unit() );
+        expected[j] = 0.25*xy[2*j+0] + 0.75*xy[2*j+1];
+        int x = int( xy[2*j+0] * float(size - 1) + 0.5f );
+        int y = int( xy[2*j+1] * float(size - 1) + 0.5f );
+        expectedNearest[j] = LUT[ y*size + x ];
+    }
+    
+    iterations = std::max( 1, (int)(((uint64_t)base_iterations * SIZE_SMALL) / (64 * (uint64_t)INTERP_COUNT)) );
+    
+    std::string prefix = std::string("float 2D lookup table ") + std::to_string(size) + "x" + std::to_string(size);
+    std::string labels[3] = { prefix + " nearest", prefix + " bilinear", prefix + " bilinear strip" };
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        lookup2D_nearest( &xy[0], &result[0], INTERP_COUNT, &LUT[0], size );
+    record_result( timer(), labels[0].c_str() );
+    verify_interpolated( &result[0], expectedNearest, 0.0, labels[0].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        lookup2D_bilinear( &xy[0], &result[0], INTERP_COUNT, &LUT[0], size );
+    record_result( timer(), labels[1].c_str() );
+    verify_interpolated( &result[0], expected, 1.0e-5, labels[1].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        lookup2D_bilinear_strip( &xy[0], &result[0], INTERP_COUNT, &LUT[0], size );
+    record_result( timer(), labels[2].c_str() );
+    verify_interpolated( &result[0], expected, 1.0e-5, labels[2].c_str() );
+    
+    summarize( prefix.c_str(), INTERP_COUNT, iterations, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    3D color lookup tables, RGB in and RGB out, like color management
+    The grid has size^3 nodes of 3 floats, in the same units as the pixels.
+    Random pixels touch the whole table, real images are more coherent.
+*/
+
+template <typename T>
+inline float pixel_scale() { return std::numeric_limits<T>::is_integer ? float(std::numeric_limits<T>::max()) : 1.0f; }
+
+/******************************************************************************/
+
+template <typename T>
+inline T to_channel( float value ) {
+    if (!std::numeric_limits<T>::is_integer)
+        return T(value);
+    value = std::min( std::max( value + 0.5f, 0.0f ), float(std::numeric_limits<T>::max()) );
+    return T(value);
+}
+
+/******************************************************************************/
+
+template <typename T>
+void lookup3D_nearest(const T *rgb, T *result, const int count, const float *LUT, const int size) {
+    const float scale = float(size - 1) / pixel_scale<T>();
+    for (int j = 0; j < count; ++j) {
+        int r = int( rgb[3*j+0] * scale + 0.5f );
+        int g = int( rgb[3*j+1] * scale + 0.5f );
+        int b = int( rgb[3*j+2] * scale + 0.5f );
+        const float *node = LUT + 3*((r*size + g)*size + b);
+        result[3*j+0] = to_channel<T>( node[0] );
+        result[3*j+1] = to_channel<T>( node[1] );
+        result[3*j+2] = to_channel<T>( node[2] );
+    }
+}
+
+/******************************************************************************/
+
+// 8 corners per pixel
+template <typename T>
+void lookup3D_trilinear(const T *rgb, T *result, const int count, const float *LUT, const int size) {
+    const float scale = float(size - 1) / pixel_scale<T>();
+    const int strideR = 3*size*size, strideG = 3*size, strideB = 3;
+    for (int j = 0; j < count; ++j) {
+        int r, g, b;
+        float fr, fg, fb;
+        grid_position( float(rgb[3*j+0]), scale, size, r, fr );
+        grid_position( float(rgb[3*j+1]), scale, size, g, fg );
+        grid_position( float(rgb[3*j+2]), scale, size, b, fb );
+        const float *c000 = LUT + r*strideR + g*strideG + b*strideB;
+        for (int c = 0; c < 3; ++c) {
+            float c00 = c000[c] + (c000[c+strideB] - c000[c]) * fb;
+            float c01 = c000[c+strideG] + (c000[c+strideG+strideB] - c000[c+strideG]) * fb;
+            float c10 = c000[c+strideR] + (c000[c+strideR+strideB] - c000[c+strideR]) * fb;
+            float c11 = c000[c+strideR+strideG] + (c000[c+strideR+strideG+strideB] - c000[c+strideR+strideG]) * fb;
+            float c0 = c00 + (c01 - c00) * fg;
+            float c1 = c10 + (c11 - c10) * fg;
+            result[3*j+c] = to_channel<T>( c0 + (c1 - c0) * fr );
+        }
+    }
+}
+
+/******************************************************************************/
+
+// 4 corners per pixel, chosen by the order of the fractions
+template <typename T>
+void lookup3D_tetrahedral(const T *rgb, T *result, const int count, const float *LUT, const int size) {
+    const float scale = float(size - 1) / pixel_scale<T>();
+    const int strideR = 3*size*size, strideG = 3*size, strideB = 3;
+    for (int j = 0; j < count; ++j) {
+        int r, g, b;
+        float fr, fg, fb;
+        grid_position( float(rgb[3*j+0]), scale, size, r, fr );
+        grid_position( float(rgb[3*j+1]), scale, size, g, fg );
+        grid_position( float(rgb[3*j+2]), scale, size, b, fb );
+        const float *c000 = LUT + r*strideR + g*strideG + b*strideB;
+        const float *c111 = c000 + strideR + strideG + strideB;
+        
+        // walk from c000 to c111 along the largest fraction first
+        const float *corner1, *corner2;
+        float f1, f2, f3;
+        if (fr >= fg) {
+            if (fg >= fb) {
+                corner1 = c000 + strideR; corner2 = c000 + strideR + strideG; f1 = fr; f2 = fg; f3 = fb;
+            } else if (fr >= fb) {
+                corner1 = c000 + strideR; corner2 = c000 + strideR + strideB; f1 = fr; f2 = fb; f3 = fg;
+            } else {
+                corner1 = c000 + strideB; corner2 = c000 + strideR + strideB; f1 = fb; f2 = fr; f3 = fg;
+            }
+        } else {
+            if (fb >= fg) {
+                corner1 = c000 + strideB; corner2 = c000 + strideG + strideB; f1 = fb; f2 = fg; f3 = fr;
+            } else if (fb >= fr) {
+                corner1 = c000 + strideG; corner2 = c000 + strideG + strideB; f1 = fg; f2 = fb; f3 = fr;
+            } else {
+                corner1 = c000 + strideG; corner2 = c000 + strideR + strideG; f1 = fg; f2 = fr; f3 = fb;
+            }
+        }
+        
+        for (int c = 0; c < 3; ++c) {
+            float value = c000[c] + (corner1[c] - c000[c]) * f1
+                        + (corner2[c] - corner1[c]) * f2 + (c111[c] - corner2[c]) * f3;
+            result[3*j+c] = to_channel<T>( value );
+        }
+    }
+}
+
+/******************************************************************************/
+
+// strip mined trilinear, gather friendly
+template <typename T>
+void lookup3D_trilinear_strip(const T *rgb, T *result, const int count, const float *LUT, const int size) {
+    const float scale = float(size - 1) / pixel_scale<T>();
+    const int strideR = 3*size*size, strideG = 3*size, strideB = 3;
+    int32_t offset[ INTERP_STRIP ];
+    float fr[ INTERP_STRIP ], fg[ INTERP_STRIP ], fb[ INTERP_STRIP ];
+    
+    for (int k = 0; k < count; k += INTERP_STRIP) {
+        int end = std::min( INTERP_STRIP, count - k );
+        const T *pixels = rgb + 3*k;
+        
+        for (int j = 0; j < end; ++j) {
+            int r, g, b;
+            grid_position( float(pixels[3*j+0]), scale, size, r, fr[j] );
+            grid_position( float(pixels[3*j+1]), scale, size, g, fg[j] );
+            grid_position( float(pixels[3*j+2]), scale, size, b, fb[j] );
+            offset[j] = r*strideR + g*strideG + b*strideB;
+        }
+        
+        for (int c = 0; c < 3; ++c) {
+            const float *channel = LUT + c;
+            for (int j = 0; j < end; ++j) {
+                const float *c000 = channel + offset[j];
+                float c00 = c000[0] + (c000[strideB] - c000[0]) * fb[j];
+                float c01 = c000[strideG] + (c000[strideG+strideB] - c000[strideG]) * fb[j];
+                float c10 = c000[strideR] + (c000[strideR+strideB] - c000[strideR]) * fb[j];
+                float c11 = c000[strideR+strideG] + (c000[strideR+strideG+strideB] - c000[strideR+strideG]) * fb[j];
+                float c0 = c00 + (c01 - c00) * fg[j];
+                float c1 = c10 + (c11 - c10) * fg[j];
+                result[3*(k+j)+c] = to_channel<T>( c0 + (c1 - c0) * fr[j] );
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+
+// each output channel is a weighted sum of the inputs, so trilinear and tetrahedral results are exact
+const float kColorMatrix[3][3] = { { 0.6f, 0.3f, 0.1f }, { 0.2f, 0.7f, 0.1f }, { 0.1f, 0.2f, 0.7f } };
+
+template <typename T>
+void TestLookup3D( int size ) {
+    const float maxValue = pixel_scale<T>();
+    const bool isInteger = std::numeric_limits<T>::is_integer;
+    std::string myTypeName( getTypeName<T>() );
+    
+    std::vector<float> LUT( 3*size*size*size );
+    for (int r = 0; r < size; ++r)
+        for (int g = 0; g < size; ++g)
+            for (int b = 0; b < size; ++b) {
+                const float in[3] = { r * maxValue / (size-1), g * maxValue / (size-1), b * maxValue / (size-1) };
+                float *node = &LUT[ 3*((r*size + g)*size + b) ];
+                for (int c = 0; c < 3; ++c)
+                    node[c] = kColorMatrix[c][0]*in[0] + kColorMatrix[c][1]*in[1] + kColorMatrix[c][2]*in[2];
+            }
+    
+    std::vector<T> rgb( 3*INTERP_COUNT );
+    std::vector<T> result( 3*INTERP_COUNT );
+    std::vector<double> expected( 3*INTERP_COUNT ), expectedNearest( 3*INTERP_COUNT );
+    for (auto &value : rgb) {
+        if (isInteger)
+            value = T( uint64_t( crand64() ) % (uint64_t(maxValue) + 1) );
+        else
+            value = T( random_unit() );
+    }
+    for (int j = 0; j < INTERP_COUNT; ++j) {
+        // the nearest grid node holds the matrix applied to the input rounded to the grid
+        double nearest[3];
+        for (int k = 0; k < 3; ++k) {
+            int node = int( double(rgb[3*j+k]) * (size - 1) / maxValue + 0.5 );
+            nearest[k] = double(node) * maxValue / (size - 1);
+        }
+        for (int c = 0; c < 3; ++c) {
+            expected[3*j+c] = kColorMatrix[c][0]*double(rgb[3*j+0]) + kColorMatrix[c][1]*double(rgb[3*j+1]) + kColorMatrix[c][2]*double(rgb[3*j+2]);
+            expectedNearest[3*j+c] = kColorMatrix[c][0]*nearest[0] + kColorMatrix[c][1]*nearest[1] + kColorMatrix[c][2]*nearest[2];
+        }
+    }
+    // rounding to integer channels, or float error relative to 1.0
+    const double tolerance = isInteger ? 1.0 : 1.0e-5;
+    
+    iterations = std::max( 1, (int)(((uint64_t)base_iterations * SIZE_SMALL) / (128 * (uint64_t)INTERP_COUNT)) );
+    
+    std::string prefix = myTypeName + " 3D lookup table " + std::to_string(size) + "^3";
+    std::string labels[4] = { prefix + " nearest", prefix + " trilinear", prefix + " tetrahedral", prefix + " trilinear strip" };
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        lookup3D_nearest( &rgb[0], &result[0], INTERP_COUNT, &LUT[0], size );
+    record_result( timer(), labels[0].c_str() );
+    verify_interpolated( &result[0], expectedNearest, tolerance, labels[0].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        lookup3D_trilinear( &rgb[0], &result[0], INTERP_COUNT, &LUT[0], size );
+    record_result( timer(), labels[1].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[1].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        lookup3D_tetrahedral( &rgb[0], &result[0], INTERP_COUNT, &LUT[0], size );
+    record_result( timer(), labels[2].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[2].c_str() );
+    
+    start_timer();
+    for (int i = 0; i < iterations; ++i)
+        lookup3D_trilinear_strip( &rgb[0], &result[0], INTERP_COUNT, &LUT[0], size );
+    record_result( timer(), labels[3].c_str() );
+    verify_interpolated( &result[0], expected, tolerance, labels[3].c_str() );
+    
+    summarize( prefix.c_str(), INTERP_COUNT, iterations, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 int main(int argc, char** argv) {
 
     // output command for documentation:
@@ -1221,6 +1879,43 @@ int main(int argc, char** argv) {
 
 
 
+// interpolated 1D, in cache and out of cache tables
+    TestInterpolated1D<int16_t>( 8 );
+    TestInterpolated1D<int16_t>( 20 );
+    TestInterpolated1D<int32_t>( 8 );
+    TestInterpolated1D<int32_t>( 20 );
+    TestInterpolated1D<int64_t>( 8 );
+    TestInterpolated1D<int64_t>( 20 );
+    TestInterpolated1D<float>( 8 );
+    TestInterpolated1D<float>( 20 );
+    TestInterpolated1D<double>( 8 );
+    TestInterpolated1D<double>( 20 );
+    
+    TestInterpolatedFloat1D<float>( 8 );
+    TestInterpolatedFloat1D<float>( 20 );
+    TestInterpolatedFloat1D<double>( 8 );
+    TestInterpolatedFloat1D<double>( 20 );
+
+
+// 2D
+    TestLookup2D( 33 );
+    TestLookup2D( 1025 );
+
+
+// 3D color tables
+    TestLookup3D<uint8_t>( 17 );
+    TestLookup3D<uint8_t>( 33 );
+    TestLookup3D<uint16_t>( 17 );
+    TestLookup3D<uint16_t>( 33 );
+    TestLookup3D<uint16_t>( 65 );
+    TestLookup3D<uint16_t>( 129 );
+    TestLookup3D<float>( 17 );
+    TestLookup3D<float>( 33 );
+    TestLookup3D<float>( 65 );
+    TestLookup3D<float>( 129 );
+
+
+
     return 0;
 }
 
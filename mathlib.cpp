@@ -14,28 +14,15 @@ Assumptions:
     
     2) Trivial mathlib functions are implemented as fast macros.
 
+    3) Evaluating a function over a whole array with a branch free polynomial will be
+        faster than calling the library once per value, at a known cost in accuracy.
+
 
 
 TODO:
 
 //double nan( const char * );    // can't easily test performance of this!
 
-double fma( double, double, double );
-double scalbn( double, int );
-double scalbln( double, long int );
-double nextafter( double, double );
-double fdim( double, double );
-double remquo( double, double, int * );
-double modf( double, double * );
-
-float fmaf( float, float, float );
-float scalbnf( float, int );
-float scalblnf( float, long int );
-float nextafterf( float, float );
-float fdimf( float, float );
-float remquof( float, float, int * );
-float modff( float, float * );
-
 exp10?
 
 */
@@ -48,6 +35,12 @@ exp10?
 #include <ctime>
 #include <cstdlib>
 #include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <string>
+#include <deque>
+#include <vector>
+#include <algorithm>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 
@@ -454,6 +447,55 @@ template <typename T, typename T2>
 
 /******************************************************************************/
 
+template <typename T>
+    struct mathlib_fma {
+      static T do_shift(T input, T v1) { return (fma(input,v1,v1)); }
+    };
+
+/******************************************************************************/
+
+template <typename T, typename T2>
+    struct mathlib_scalbn {
+      static T do_shift(T input, T2 v1) { return (scalbn(input,v1)); }
+    };
+
+/******************************************************************************/
+
+template <typename T, typename T2>
+    struct mathlib_scalbln {
+      static T do_shift(T input, T2 v1) { return (scalbln(input,long(v1))); }
+    };
+
+/******************************************************************************/
+
+template <typename T>
+    struct mathlib_nextafter {
+      static T do_shift(T input, T v1) { return (nextafter(input,v1)); }
+    };
+
+/******************************************************************************/
+
+template <typename T>
+    struct mathlib_fdim {
+      static T do_shift(T input, T v1) { return (fdim(input,v1)); }
+    };
+
+/******************************************************************************/
+
+template <typename T>
+    struct mathlib_remquo {
+      static T do_shift(T input, T v1) { int quo; T rem = remquo(input,v1,&quo); return (rem + quo); }
+    };
+
+/******************************************************************************/
+
+template <typename T>
+    struct mathlib_modf {
+      static T do_shift(T input) { T whole; T frac = modf(input,&whole); return (frac + whole); }
+    };
+
+/******************************************************************************/
+
 template <typename T>
     struct mathlib_isgreater {
       static bool do_shift(T input, T v1) { return (isgreater(input,v1)); }
@@ -882,6 +924,55 @@ template <typename T, typename T2>
 
 /******************************************************************************/
 
+template <typename T>
+    struct mathlib_fmaf {
+      static T do_shift(T input, T v1) { return (fmaf(input,v1,v1)); }
+    };
+
+/******************************************************************************/
+
+template <typename T, typename T2>
+    struct mathlib_scalbnf {
+      static T do_shift(T input, T2 v1) { return (scalbnf(input,v1)); }
+    };
+
+/******************************************************************************/
+
+template <typename T, typename T2>
+    struct mathlib_scalblnf {
+      static T do_shift(T input, T2 v1) { return (scalblnf(input,long(v1))); }
+    };
+
+/******************************************************************************/
+
+template <typename T>
+    struct mathlib_nextafterf {
+      static T do_shift(T input, T v1) { return (nextafterf(input,v1)); }
+    };
+
+/******************************************************************************/
+
+template <typename T>
+    struct mathlib_fdimf {
+      static T do_shift(T input, T v1) { return (fdimf(input,v1)); }
+    };
+
+/******************************************************************************/
+
+template <typename T>
+    struct mathlib_remquof {
+      static T do_shift(T input, T v1) { int quo; T rem = remquof(input,v1,&quo); return (rem + quo); }
+    };
+
+/******************************************************************************/
+
+template <typename T>
+    struct mathlib_modff {
+      static T do_shift(T input) { T whole; T frac = modff(input,&whole); return (frac + whole); }
+    };
+
+/******************************************************************************/
+
 template <typename T>
     struct mathlib_expm1f {
       static double do_shift(T input) { return (expm1f(input)); }
@@ -974,6 +1065,368 @@ template <typename T>
 /******************************************************************************/
 /******************************************************************************/
 
+// Batch math functions
+// Feature pipelines evaluate exp and log over whole columns, so a call per value is wasted work.
+// These kernels use only multiplies, adds, compares and bit operations with no branches,
+//    so the compiler can vectorize the loops in exp_many and log_many.
+// The accuracy level picks the polynomial length, trading speed for ULPs.
+
+enum batchAccuracy {
+    kAccuracyLow = 0,
+    kAccuracyMedium = 1,
+    kAccuracyHigh = 2
+};
+
+const char *accuracy_names[] = { "low", "medium", "high" };
+
+template <typename T>
+    struct batch_accuracy;
+
+// exp polynomial degree, and log series terms after the first
+template <>
+    struct batch_accuracy<double> {
+      static constexpr int exp_degree(int level) { return (level == kAccuracyLow) ? 5 : (level == kAccuracyMedium) ? 8 : 13; }
+      static constexpr int log_terms(int level) { return (level == kAccuracyLow) ? 2 : (level == kAccuracyMedium) ? 4 : 9; }
+      static constexpr double max_relative(int level) { return (level == kAccuracyLow) ? 1.0e-5 : (level == kAccuracyMedium) ? 1.0e-9 : 1.0e-15; }
+    };
+
+template <>
+    struct batch_accuracy<float> {
+      static constexpr int exp_degree(int level) { return (level == kAccuracyLow) ? 3 : (level == kAccuracyMedium) ? 5 : 7; }
+      static constexpr int log_terms(int level) { return (level == kAccuracyLow) ? 1 : (level == kAccuracyMedium) ? 2 : 4; }
+      static constexpr double max_relative(int level) { return (level == kAccuracyLow) ? 1.0e-2 : (level == kAccuracyMedium) ? 1.0e-5 : 1.0e-6; }
+    };
+
+/******************************************************************************/
+
+inline uint64_t double_bits(double x) { uint64_t result; memcpy( &result, &x, sizeof(result) ); return result; }
+inline double bits_double(uint64_t x) { double result; memcpy( &result, &x, sizeof(result) ); return result; }
+inline uint32_t float_bits(float x) { uint32_t result; memcpy( &result, &x, sizeof(result) ); return result; }
+inline float bits_float(uint32_t x) { float result; memcpy( &result, &x, sizeof(result) ); return result; }
+
+// Branch free select using bit masks.
+// The compiler will not turn a floating point ?: into a vector blend when the compare might trap,
+//    but it will vectorize this (doubles need 64 bit integer compares, SSE4.2 and later on x86).
+inline double blend(bool condition, double a, double b) {
+    uint64_t mask = condition ? ~0ULL : 0ULL;
+    return bits_double( (mask & double_bits(a)) | (~mask & double_bits(b)) );
+}
+
+inline float blend(bool condition, float a, float b) {
+    uint32_t mask = condition ? ~0U : 0U;
+    return bits_float( (mask & float_bits(a)) | (~mask & float_bits(b)) );
+}
+
+// Taylor coefficients 1/k!
+const double kExpCoefficients[] = {
+    1.0, 1.0, 1.0/2.0, 1.0/6.0, 1.0/24.0, 1.0/120.0, 1.0/720.0, 1.0/5040.0, 1.0/40320.0,
+    1.0/362880.0, 1.0/3628800.0, 1.0/39916800.0, 1.0/479001600.0, 1.0/6227020800.0
+};
+
+// series for 2*atanh(s) = 2s + 2s*(z/3 + z^2/5 + ...), coefficients 2/(2k+1)
+const double kLogCoefficients[] = {
+    0.0, 2.0/3.0, 2.0/5.0, 2.0/7.0, 2.0/9.0, 2.0/11.0, 2.0/13.0, 2.0/15.0, 2.0/17.0, 2.0/19.0
+};
+
+// the loops have constant counts, so they are unrolled completely
+template <typename T, int degree>
+inline T exp_polynomial(T r) {
+    T p = T(kExpCoefficients[degree]);
+    for (int k = degree-1; k >= 0; --k)
+        p = p * r + T(kExpCoefficients[k]);
+    return p;
+}
+
+template <typename T, int terms>
+inline T log_polynomial(T z) {
+    T p = T(kLogCoefficients[terms]);
+    for (int k = terms-1; k >= 1; --k)
+        p = p * z + T(kLogCoefficients[k]);
+    return p * z;
+}
+
+/******************************************************************************/
+
+// exp(x) = 2^n * exp(r), with n = round(x/ln2) and |r| <= ln2/2
+// 2^n is built from exponent bits in two halves, so results near overflow and subnormal results still work.
+template <int accuracy>
+inline double exp_kernel(double x) {
+    const double log2e = 1.44269504088896340736;
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    const double shifter = 6755399441055744.0;      // 1.5 * 2^52, adding it rounds to an integer in the low bits
+    const int degree = batch_accuracy<double>::exp_degree(accuracy);
+
+    double xc = blend( x < -746.0, -746.0, x );
+    xc = blend( xc > 709.79, 709.79, xc );
+    double t = xc * log2e + shifter;
+    double n = t - shifter;
+    double r = (xc - n * ln2_hi) - n * ln2_lo;
+    double p = exp_polynomial<double, degree>( r );
+
+    uint64_t u = double_bits(t) - double_bits(shifter) + 2048;     // n + 2048, always positive
+    uint64_t u1 = u >> 1;
+    uint64_t u2 = u - u1;
+    double result = p * bits_double( (u1 - 1) << 52 ) * bits_double( (u2 - 1) << 52 );
+
+    result = blend( x > 709.782712893384, HUGE_VAL, result );
+    result = blend( x < -745.2, 0.0, result );
+    result = blend( x != x, x, result );
+    return result;
+}
+
+template <int accuracy>
+inline float exp_kernel(float x) {
+    const float log2e = 1.44269504088896340736f;
+    const float ln2_hi = 6.93145751953125e-01f;
+    const float ln2_lo = 1.42860676533018704e-06f;
+    const float shifter = 12582912.0f;      // 1.5 * 2^23
+    const int degree = batch_accuracy<float>::exp_degree(accuracy);
+
+    float xc = blend( x < -104.0f, -104.0f, x );
+    xc = blend( xc > 88.73f, 88.73f, xc );
+    float t = xc * log2e + shifter;
+    float n = t - shifter;
+    float r = (xc - n * ln2_hi) - n * ln2_lo;
+    float p = exp_polynomial<float, degree>( r );
+
+    uint32_t u = float_bits(t) - float_bits(shifter) + 256;     // n + 256, always positive
+    uint32_t u1 = u >> 1;
+    uint32_t u2 = u - u1;
+    float result = p * bits_float( (u1 - 1) << 23 ) * bits_float( (u2 - 1) << 23 );
+
+    result = blend( x > 88.7228391f, HUGE_VALF, result );
+    result = blend( x < -103.98f, 0.0f, result );
+    result = blend( x != x, x, result );
+    return result;
+}
+
+/******************************************************************************/
+
+// log(x) = e*ln2 + log(m), with m in [sqrt(1/2), sqrt(2))
+// log(m) = f - f*f/2 + s*(f*f/2 + R), with f = m-1, s = f/(2+f), and R the atanh series in s*s
+template <int accuracy>
+inline double log_kernel(double x) {
+    const double ln2_hi = 6.93147180369123816490e-01;
+    const double ln2_lo = 1.90821492927058770002e-10;
+    const uint64_t sqrt_half = 0x3FE6A09E667F3BCDULL;
+    const int terms = batch_accuracy<double>::log_terms(accuracy);
+
+    bool tiny = x < DBL_MIN;
+    double xs = blend( tiny, x * 18014398509481984.0, x );      // scale subnormals by 2^54
+    double bias = blend( tiny, 4503599627370496.0 + 1023.0 + 54.0, 4503599627370496.0 + 1023.0 );
+
+    uint64_t ix = double_bits(xs) + (double_bits(1.0) - sqrt_half);
+    double e = bits_double( 0x4330000000000000ULL | (ix >> 52) ) - bias;
+    double m = bits_double( (ix & 0x000FFFFFFFFFFFFFULL) + sqrt_half );
+
+    double f = m - 1.0;
+    double hfsq = 0.5 * f * f;
+    double s = f / (2.0 + f);
+    double R = log_polynomial<double, terms>( s * s );
+    double result = e * ln2_hi + (f - (hfsq - (s * (hfsq + R) + e * ln2_lo)));
+
+    result = blend( x == HUGE_VAL, x, result );
+    result = blend( x == 0.0, -HUGE_VAL, result );
+    result = blend( (x < 0.0) | (x != x), double(NAN), result );
+    return result;
+}
+
+template <int accuracy>
+inline float log_kernel(float x) {
+    const float ln2_hi = 6.9313812256e-01f;
+    const float ln2_lo = 9.0580006145e-06f;
+    const uint32_t sqrt_half = 0x3F3504F3;
+    const int terms = batch_accuracy<float>::log_terms(accuracy);
+
+    bool tiny = x < FLT_MIN;
+    float xs = blend( tiny, x * 33554432.0f, x );      // scale subnormals by 2^25
+    float bias = blend( tiny, 8388608.0f + 127.0f + 25.0f, 8388608.0f + 127.0f );
+
+    uint32_t ix = float_bits(xs) + (float_bits(1.0f) - sqrt_half);
+    float e = bits_float( 0x4B000000 | (ix >> 23) ) - bias;
+    float m = bits_float( (ix & 0x007FFFFF) + sqrt_half );
+
+    float f = m - 1.0f;
+    float hfsq = 0.5f * f * f;
+    float s = f / (2.0f + f);
+    float R = log_polynomial<float, terms>( s * s );
+    float result = e * ln2_hi + (f - (hfsq - (s * (hfsq + R) + e * ln2_lo)));
+
+    result = blend( x == HUGE_VALF, x, result );
+    result = blend( x == 0.0f, -HUGE_VALF, result );
+    result = blend( (x < 0.0f) | (x != x), float(NAN), result );
+    return result;
+}
+
+/******************************************************************************/
+
+template <int accuracy = kAccuracyHigh>
+void exp_many(const double *input, double *output, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        output[i] = exp_kernel<accuracy>( input[i] );
+}
+
+template <int accuracy = kAccuracyHigh>
+void exp_many(const float *input, float *output, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        output[i] = exp_kernel<accuracy>( input[i] );
+}
+
+template <int accuracy = kAccuracyHigh>
+void log_many(const double *input, double *output, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        output[i] = log_kernel<accuracy>( input[i] );
+}
+
+template <int accuracy = kAccuracyHigh>
+void log_many(const float *input, float *output, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        output[i] = log_kernel<accuracy>( input[i] );
+}
+
+/******************************************************************************/
+
+template <typename T, int accuracy>
+    struct batch_exp {
+      static void do_many(const T *input, T *output, size_t count) { exp_many<accuracy>(input, output, count); }
+      static long double reference(long double x) { return expl(x); }
+      static double max_relative() { return batch_accuracy<T>::max_relative(accuracy); }
+    };
+
+template <typename T, int accuracy>
+    struct batch_log {
+      static void do_many(const T *input, T *output, size_t count) { log_many<accuracy>(input, output, count); }
+      static long double reference(long double x) { return logl(x); }
+      static double max_relative() { return batch_accuracy<T>::max_relative(accuracy); }
+    };
+
+// the library, one call per value, for comparison
+template <typename T>
+    struct batch_libm_exp {
+      static void do_many(const T *input, T *output, size_t count) {
+        for (size_t i = 0; i < count; ++i)
+            output[i] = std::exp( input[i] );
+      }
+      static long double reference(long double x) { return expl(x); }
+      static double max_relative() { return batch_accuracy<T>::max_relative(kAccuracyHigh); }
+    };
+
+template <typename T>
+    struct batch_libm_log {
+      static void do_many(const T *input, T *output, size_t count) {
+        for (size_t i = 0; i < count; ++i)
+            output[i] = std::log( input[i] );
+      }
+      static long double reference(long double x) { return logl(x); }
+      static double max_relative() { return batch_accuracy<T>::max_relative(kAccuracyHigh); }
+    };
+
+/******************************************************************************/
+
+// Error in units in the last place of T, against a long double reference.
+// Where long double is the same as double, the double results are only compared against the library.
+template <typename T>
+long double ulp_error(T result, long double reference) {
+    if ((long double)result == reference)
+        return 0.0L;
+    T rounded = T(reference);
+    if (!std::isfinite(rounded) || !std::isfinite(result))
+        return (result == rounded) ? 0.0L : HUGE_VALL;
+    T magnitude = std::fabs(rounded);
+    long double ulp = (long double)std::nextafter( magnitude, T(HUGE_VAL) ) - (long double)magnitude;
+    return fabsl( (long double)result - reference ) / ulp;
+}
+
+// inputs over the whole useful domain, plus a dense set near the middle
+template <typename T>
+void fill_exp_sweep( std::vector<T> &values ) {
+    const T low = (sizeof(T) == sizeof(float)) ? T(-87.0) : T(-707.0);
+    const T high = (sizeof(T) == sizeof(float)) ? T(88.0) : T(709.0);
+    const size_t half = values.size() / 2;
+    for (size_t i = 0; i < half; ++i)
+        values[i] = low + (high - low) * (T(i) / T(half));
+    for (size_t i = half; i < values.size(); ++i)
+        values[i] = T(-4.0) + T(8.0) * (T(i - half) / T(values.size() - half));
+}
+
+template <typename T>
+void fill_log_sweep( std::vector<T> &values ) {
+    const T lowExp = (sizeof(T) == sizeof(float)) ? T(-125.0) : T(-1020.0);
+    const T highExp = (sizeof(T) == sizeof(float)) ? T(127.0) : T(1020.0);
+    const size_t half = values.size() / 2;
+    for (size_t i = 0; i < half; ++i)
+        values[i] = std::exp2( lowExp + (highExp - lowExp) * (T(i) / T(half)) );
+    for (size_t i = half; i < values.size(); ++i)
+        values[i] = T(0.5) + T(1.5) * (T(i - half) / T(values.size() - half));
+}
+
+template <typename T, typename Batch>
+double max_ulp_error( const std::vector<T> &input ) {
+    std::vector<T> output( input.size() );
+    Batch::do_many( &input[0], &output[0], input.size() );
+    long double worst = 0.0L;
+    for (size_t i = 0; i < input.size(); ++i)
+        worst = std::max( worst, ulp_error( output[i], Batch::reference( (long double)input[i] ) ) );
+    return (double)worst;
+}
+
+/******************************************************************************/
+
+std::deque<std::string> gLabels;
+
+template <typename T, typename Batch>
+void test_batch(const T *input, T *output, int count, const std::vector<T> &sweep, const char *label) {
+  char buffer[200];
+  snprintf( buffer, sizeof(buffer), "%s, max %.3g ulp", label, max_ulp_error<T, Batch>( sweep ) );
+  gLabels.push_back( buffer );
+
+  start_timer();
+  
+  for(int i = 0; i < iterations; ++i) {
+    Batch::do_many( input, output, count );
+  }
+  
+  record_result( timer(), gLabels.back().c_str() );
+
+  for (int n = 0; n < count; ++n) {
+    long double expected = Batch::reference( (long double)input[n] );
+    if (fabsl( (long double)output[n] - expected ) > Batch::max_relative() * fabsl( expected )) {
+        printf("test %i failed\n", current_test);
+        break;
+    }
+  }
+}
+
+/******************************************************************************/
+
+template <typename T>
+void test_batch_functions(const char *type_label) {
+    static T inputExp[SIZE], inputLog[SIZE], output[SIZE];
+    for (int n = 0; n < SIZE; ++n) {
+        inputExp[n] = T(-20.0) + T(40.0) * T(n) / T(SIZE);
+        inputLog[n] = T(init_value) * T(1.0e-3) + T(1000.0) * T(n) / T(SIZE);
+    }
+
+    std::vector<T> expSweep( 1 << 17 );
+    std::vector<T> logSweep( 1 << 17 );
+    fill_exp_sweep( expSweep );
+    fill_log_sweep( logSweep );
+
+    std::string prefix( type_label );
+    test_batch<T, batch_libm_exp<T> >( inputExp, output, SIZE, expSweep, (prefix + " exp loop").c_str() );
+    test_batch<T, batch_exp<T, kAccuracyHigh> >( inputExp, output, SIZE, expSweep, (prefix + " exp_many high").c_str() );
+    test_batch<T, batch_exp<T, kAccuracyMedium> >( inputExp, output, SIZE, expSweep, (prefix + " exp_many medium").c_str() );
+    test_batch<T, batch_exp<T, kAccuracyLow> >( inputExp, output, SIZE, expSweep, (prefix + " exp_many low").c_str() );
+    test_batch<T, batch_libm_log<T> >( inputLog, output, SIZE, logSweep, (prefix + " log loop").c_str() );
+    test_batch<T, batch_log<T, kAccuracyHigh> >( inputLog, output, SIZE, logSweep, (prefix + " log_many high").c_str() );
+    test_batch<T, batch_log<T, kAccuracyMedium> >( inputLog, output, SIZE, logSweep, (prefix + " log_many medium").c_str() );
+    test_batch<T, batch_log<T, kAccuracyLow> >( inputLog, output, SIZE, logSweep, (prefix + " log_many low").c_str() );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 
 int main(int argc, char** argv) {
     double temp = 1.010203;
@@ -1056,6 +1509,13 @@ int main(int argc, char** argv) {
     test_variable1<double, mathlib_copysign<double> >(dataDouble,SIZE,var1Double_1,"double copysign");
     test_variable1<double, int, mathlib_ldexp<double, int> >(dataDouble,SIZE,var1Int,"double ldexp");
     test_variable1ptr<double, int, mathlib_frexp<double, int> >(dataDouble,SIZE,var1Int,"double frexp");
+    test_variable1<double, mathlib_fma<double> >(dataDouble,SIZE,var1Double_1,"double fma");
+    test_variable1<double, int, mathlib_scalbn<double, int> >(dataDouble,SIZE,var1Int,"double scalbn");
+    test_variable1<double, int, mathlib_scalbln<double, int> >(dataDouble,SIZE,var1Int,"double scalbln");
+    test_variable1<double, mathlib_nextafter<double> >(dataDouble,SIZE,var1Double_1,"double nextafter");
+    test_variable1<double, mathlib_fdim<double> >(dataDouble,SIZE,var1Double_1,"double fdim");
+    test_variable1<double, mathlib_remquo<double> >(dataDouble,SIZE,var1Double_1,"double remquo");
+    test_constant<double, mathlib_modf<double> >(dataDouble,SIZE,"double modf");
     
 #if defined(_WIN32) || defined(_MACHTYPES_H_)
 // these are missing on Linux - may be controled by C99 flag? __USE_ISOC99
@@ -1091,6 +1551,10 @@ int main(int argc, char** argv) {
     summarize("double mathlib", SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
 
 
+    test_batch_functions<double>("double");
+    summarize("double mathlib batch", SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
 
 
 
@@ -1160,6 +1624,13 @@ int main(int argc, char** argv) {
     test_variable1<float, mathlib_copysignf<float> >(dataFloat,SIZE,var1Float_1,"float copysign");
     test_variable1<float, int, mathlib_ldexpf<float, int> >(dataFloat,SIZE,var1Int,"float ldexp");
     test_variable1ptr<float, int, mathlib_frexpf<float, int> >(dataFloat,SIZE,var1Int,"float frexp");
+    test_variable1<float, mathlib_fmaf<float> >(dataFloat,SIZE,var1Float_1,"float fma");
+    test_variable1<float, int, mathlib_scalbnf<float, int> >(dataFloat,SIZE,var1Int,"float scalbn");
+    test_variable1<float, int, mathlib_scalblnf<float, int> >(dataFloat,SIZE,var1Int,"float scalbln");
+    test_variable1<float, mathlib_nextafterf<float> >(dataFloat,SIZE,var1Float_1,"float nextafter");
+    test_variable1<float, mathlib_fdimf<float> >(dataFloat,SIZE,var1Float_1,"float fdim");
+    test_variable1<float, mathlib_remquof<float> >(dataFloat,SIZE,var1Float_1,"float remquo");
+    test_constant<float, mathlib_modff<float> >(dataFloat,SIZE,"float modf");
     
 #if defined(_WIN32) || defined(_MACHTYPES_H_)
 // these are missing on Linux - may be controled by C99 flag? __USE_ISOC99
@@ -1189,6 +1660,10 @@ int main(int argc, char** argv) {
     summarize("float mathlib", SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
 
 
+    test_batch_functions<float>("float");
+    summarize("float mathlib batch", SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
     
     return 0;
 }
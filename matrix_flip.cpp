@@ -16,11 +16,14 @@ Assumptions:
     2) The compiler will apply appropriate loop transforms for less optimal
         matrix rotation patterns.
 
+    3) Register tiled and cache oblivious transposes will stay fast
+        as the matrix grows past each level of cache.
 
 
 
 
-TODO:  more cache blocking
+
+TODO:  more cache blocking for flips
 
 DEFERRED: 90 degree rotate inplace on non-square matrices may be possible with an 8 element ring.
         But the logic to keep it straight seems really ugly...
@@ -1074,6 +1077,109 @@ struct transpose9 {
     }
 };
 
+/******************************************************************************/
+
+// Transpose one TILE x TILE block through a local tile the compiler can keep in registers.
+// With fixed sizes, compilers can turn this into vector loads, shuffles and stores.
+template <typename T, size_t TILE>
+inline void transpose_register_tile(const T *src, T *dst, ptrdiff_t sRowStep, ptrdiff_t dRowStep) {
+    T tile[TILE][TILE];
+    for (size_t r = 0; r < TILE; ++r)
+        for (size_t c = 0; c < TILE; ++c)
+            tile[r][c] = src[ r*sRowStep + c ];
+    for (size_t c = 0; c < TILE; ++c)
+        for (size_t r = 0; r < TILE; ++r)
+            dst[ c*dRowStep + r ] = tile[r][c];
+}
+
+// cache block, then transpose register tiles inside each block
+// Negative row steps are allowed, so the 90 degree rotates can use this with flipped pointers.
+template <typename T, size_t TILE>
+void transpose_tiled(const T *src, T *dst, size_t rows, size_t cols, ptrdiff_t sRowStep, ptrdiff_t dRowStep) {
+    const ptrdiff_t blockSize = 64;     // must be a multiple of TILE
+    const ptrdiff_t tile = TILE;
+    const ptrdiff_t R = rows, C = cols;
+    
+    for ( ptrdiff_t jj = 0; jj < R; jj += blockSize ) {
+        ptrdiff_t jend = std::min( jj + blockSize, R );
+        for ( ptrdiff_t kk = 0; kk < C; kk += blockSize ) {
+            ptrdiff_t kend = std::min( kk + blockSize, C );
+            
+            ptrdiff_t j;
+            for ( j = jj; j + tile <= jend; j += tile ) {
+                ptrdiff_t k;
+                for ( k = kk; k + tile <= kend; k += tile )
+                    transpose_register_tile<T,TILE>( src + j*sRowStep + k, dst + k*dRowStep + j, sRowStep, dRowStep );
+                for ( ; k < kend; ++k )
+                    for ( ptrdiff_t r = 0; r < tile; ++r )
+                        dst[ k*dRowStep + (j+r) ] = src[ (j+r)*sRowStep + k ];
+            }
+            for ( ; j < jend; ++j )
+                for ( ptrdiff_t k = kk; k < kend; ++k )
+                    dst[ k*dRowStep + j ] = src[ j*sRowStep + k ];
+        }
+    }
+}
+
+/******************************************************************************/
+
+// Cache oblivious recursion: split the longer side in half until the block is small,
+//    so some level of the recursion fits each level of cache without knowing the sizes.
+template <typename LEAF>
+void recursive_blocks(size_t r0, size_t r1, size_t c0, size_t c1, size_t leafSize, LEAF &leaf) {
+    size_t rows = r1 - r0, cols = c1 - c0;
+    if (rows <= leafSize && cols <= leafSize) {
+        leaf( r0, r1, c0, c1 );
+    } else if (rows >= cols) {
+        size_t mid = r0 + rows/2;
+        recursive_blocks( r0, mid, c0, c1, leafSize, leaf );
+        recursive_blocks( mid, r1, c0, c1, leafSize, leaf );
+    } else {
+        size_t mid = c0 + cols/2;
+        recursive_blocks( r0, r1, c0, mid, leafSize, leaf );
+        recursive_blocks( r0, r1, mid, c1, leafSize, leaf );
+    }
+}
+
+// the leaf blocks still use register tiles
+template <typename T>
+void transpose_recursive(const T *src, T *dst, size_t rows, size_t cols, ptrdiff_t sRowStep, ptrdiff_t dRowStep) {
+    auto leaf = [=]( size_t r0, size_t r1, size_t c0, size_t c1 ) {
+        transpose_tiled<T,8>( src + r0*sRowStep + c0, dst + c0*dRowStep + r0, r1 - r0, c1 - c0, sRowStep, dRowStep );
+    };
+    recursive_blocks( 0, rows, 0, cols, 32, leaf );
+}
+
+/******************************************************************************/
+
+// cache block, with 4x4 register tiles
+template <typename T >
+struct transpose10 {
+    void operator()(const T *src, T *dst, size_t rows, size_t cols, int sRowStep, int dRowStep) {
+        transpose_tiled<T,4>( src, dst, rows, cols, sRowStep, dRowStep );
+    }
+};
+
+/******************************************************************************/
+
+// cache block, with 8x8 register tiles
+template <typename T >
+struct transpose11 {
+    void operator()(const T *src, T *dst, size_t rows, size_t cols, int sRowStep, int dRowStep) {
+        transpose_tiled<T,8>( src, dst, rows, cols, sRowStep, dRowStep );
+    }
+};
+
+/******************************************************************************/
+
+// cache oblivious recursive transpose
+template <typename T >
+struct transpose12 {
+    void operator()(const T *src, T *dst, size_t rows, size_t cols, int sRowStep, int dRowStep) {
+        transpose_recursive( src, dst, rows, cols, sRowStep, dRowStep );
+    }
+};
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -1352,6 +1458,88 @@ struct transpose_inplace8 {
     }
 };
 
+/******************************************************************************/
+
+// assert( rows == cols );
+// cache oblivious recursion: transpose the two diagonal quarters in place,
+//    then swap the off diagonal quarters with each other, splitting them recursively
+template <typename T >
+struct transpose_inplace9 {
+    void operator()(T *src, size_t cols, int sRowStep) {
+        diagonal( src, 0, cols, sRowStep );
+    }
+
+private:
+    static const size_t leafSize = 32;
+
+    static void diagonal(T *src, size_t lo, size_t hi, ptrdiff_t sRowStep) {
+        if (hi - lo <= leafSize) {
+            for ( size_t k = lo; k < hi; ++k )
+                for ( size_t j = k+1; j < hi; ++j )
+                    std::swap( src[ k*sRowStep+j ], src[ j*sRowStep+k ] );
+            return;
+        }
+        size_t mid = lo + (hi - lo)/2;
+        diagonal( src, lo, mid, sRowStep );
+        diagonal( src, mid, hi, sRowStep );
+        
+        auto leaf = [=]( size_t r0, size_t r1, size_t c0, size_t c1 ) {
+            for ( size_t k = r0; k < r1; ++k )
+                for ( size_t j = c0; j < c1; ++j )
+                    std::swap( src[ k*sRowStep+j ], src[ j*sRowStep+k ] );
+        };
+        recursive_blocks( lo, mid, mid, hi, leafSize, leaf );
+    }
+};
+
+/******************************************************************************/
+
+// assert( rows == cols );
+// work in 8x8 register tiles, swapping pairs of tiles across the diagonal
+template <typename T >
+struct transpose_inplace10 {
+    void operator()(T *src, size_t cols, int sRowStep) {
+        const size_t tile = 8;
+        T upper[ tile ][ tile ];
+        T lower[ tile ][ tile ];
+        size_t kk;
+        
+        for ( kk = 0; kk + tile <= cols; kk += tile ) {
+            // diagonal tile
+            for (size_t r = 0; r < tile; ++r)
+                for (size_t c = 0; c < tile; ++c)
+                    upper[r][c] = src[ (kk+r)*sRowStep + (kk+c) ];
+            for (size_t r = 0; r < tile; ++r)
+                for (size_t c = 0; c < tile; ++c)
+                    src[ (kk+r)*sRowStep + (kk+c) ] = upper[c][r];
+            
+            size_t jj;
+            for ( jj = kk + tile; jj + tile <= cols; jj += tile ) {
+                for (size_t r = 0; r < tile; ++r)
+                    for (size_t c = 0; c < tile; ++c) {
+                        upper[r][c] = src[ (kk+r)*sRowStep + (jj+c) ];
+                        lower[r][c] = src[ (jj+r)*sRowStep + (kk+c) ];
+                    }
+                for (size_t r = 0; r < tile; ++r)
+                    for (size_t c = 0; c < tile; ++c) {
+                        src[ (kk+r)*sRowStep + (jj+c) ] = lower[c][r];
+                        src[ (jj+r)*sRowStep + (kk+c) ] = upper[c][r];
+                    }
+            }
+            
+            // leftover columns
+            for (size_t m = kk; m < kk + tile; ++m)
+                for ( size_t j = jj; j < cols; ++j )
+                    std::swap( src[ m*sRowStep+j ], src[ j*sRowStep+m ] );
+        }
+        
+        // leftover corner
+        for ( ; kk < cols; ++kk )
+            for ( size_t j = kk+1 ; j < cols; ++j )
+                std::swap( src[ kk*sRowStep+j ], src[ j*sRowStep+kk ] );
+    }
+};
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -1481,6 +1669,27 @@ struct rotate90CW_6 {
     }
 };
 
+/******************************************************************************/
+
+// rotate clockwise is a transpose of the source with the rows in reverse order,
+//    so use the tiled transpose with a negative source row step
+template <typename T >
+struct rotate90CW_7 {
+    void operator()(const T *src, T *dst, size_t rows, size_t cols, int sRowStep, int dRowStep) {
+        transpose_tiled<T,8>( src + (rows-1)*sRowStep, dst, rows, cols, -ptrdiff_t(sRowStep), dRowStep );
+    }
+};
+
+/******************************************************************************/
+
+// cache oblivious recursive version of the same
+template <typename T >
+struct rotate90CW_8 {
+    void operator()(const T *src, T *dst, size_t rows, size_t cols, int sRowStep, int dRowStep) {
+        transpose_recursive( src + (rows-1)*sRowStep, dst, rows, cols, -ptrdiff_t(sRowStep), dRowStep );
+    }
+};
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -1743,6 +1952,17 @@ struct rotate90CW_inplace7 {
     }
 };
 
+/******************************************************************************/
+
+// cache oblivious transpose, then reverse each row
+template <typename T >
+struct rotate90CW_inplace8 {
+    void operator()(T *src, size_t cols, int sRowStep) {
+        transpose_inplace9<T>()( src, cols, sRowStep );
+        flipHorizontal_inplace2<T>()( src, cols, cols, sRowStep );
+    }
+};
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -1875,6 +2095,27 @@ struct rotate90CCW_6 {
     }
 };
 
+/******************************************************************************/
+
+// rotate counterclockwise is a transpose with the destination rows in reverse order,
+//    so use the tiled transpose with a negative destination row step
+template <typename T >
+struct rotate90CCW_7 {
+    void operator()(const T *src, T *dst, size_t rows, size_t cols, int sRowStep, int dRowStep) {
+        transpose_tiled<T,8>( src, dst + (cols-1)*dRowStep, rows, cols, sRowStep, -ptrdiff_t(dRowStep) );
+    }
+};
+
+/******************************************************************************/
+
+// cache oblivious recursive version of the same
+template <typename T >
+struct rotate90CCW_8 {
+    void operator()(const T *src, T *dst, size_t rows, size_t cols, int sRowStep, int dRowStep) {
+        transpose_recursive( src, dst + (cols-1)*dRowStep, rows, cols, sRowStep, -ptrdiff_t(dRowStep) );
+    }
+};
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -2064,6 +2305,17 @@ struct rotate90CCW_inplace6 {
     }
 };
 
+/******************************************************************************/
+
+// cache oblivious transpose, then reverse the order of the rows
+template <typename T >
+struct rotate90CCW_inplace7 {
+    void operator()(T *src, size_t cols, int sRowStep) {
+        transpose_inplace9<T>()( src, cols, sRowStep );
+        flipVertical_inplace3<T>()( src, cols, cols, sRowStep );
+    }
+};
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -2430,6 +2682,54 @@ void test_rotate90CCW_inplace(const T *src, T *dst, size_t rows, size_t cols, MM
     }
 }
 
+/******************************************************************************/
+
+// matrix sizes from L1 resident to well past the last level cache, in bytes
+const size_t sweep_bytes[] = { 16*1024, 256*1024, 4*1024*1024, 64*1024*1024 };
+
+// Square matrices of growing size, comparing naive, blocked, register tiled and cache oblivious versions.
+// Each size gets its own summary, with about the same number of elements moved per test.
+template< typename T>
+void TestSizeSweep(const std::string &myTypeName, int base_iterations)
+{
+    const double elementBudget = double(base_iterations) * double(SIZE) / 24.0;
+    
+    for (size_t bytes : sweep_bytes) {
+        const size_t n = (size_t) sqrt( double(bytes / sizeof(T)) );
+        
+        std::unique_ptr<T[]> dX( new T[n * n] );
+        std::unique_ptr<T[]> dY( new T[n * n] );
+        T *dataX = dX.get();
+        T *dataY = dY.get();
+        ::fill_random( dataX, dataX+(n*n) );
+        
+        iterations = std::max( 1, int( elementBudget / double(n*n) ) );
+        std::string size_name( " " + std::to_string(n) + "x" + std::to_string(n) );
+        
+        test_transpose( dataX, dataY, n, n, transpose1<T>(), myTypeName + " matrix transpose1" + size_name );
+        test_transpose( dataX, dataY, n, n, transpose9<T>(), myTypeName + " matrix transpose9" + size_name );
+        test_transpose( dataX, dataY, n, n, transpose10<T>(), myTypeName + " matrix transpose10" + size_name );
+        test_transpose( dataX, dataY, n, n, transpose11<T>(), myTypeName + " matrix transpose11" + size_name );
+        test_transpose( dataX, dataY, n, n, transpose12<T>(), myTypeName + " matrix transpose12" + size_name );
+        
+        test_rotate90CW( dataX, dataY, n, n, rotate90CW_1<T>(), myTypeName + " matrix rotate90CW_1" + size_name );
+        test_rotate90CW( dataX, dataY, n, n, rotate90CW_7<T>(), myTypeName + " matrix rotate90CW_7" + size_name );
+        test_rotate90CW( dataX, dataY, n, n, rotate90CW_8<T>(), myTypeName + " matrix rotate90CW_8" + size_name );
+        
+        test_transpose_inplace( dataX, dataY, n, n, transpose_inplace1<T>(), myTypeName + " matrix transpose_inplace1" + size_name );
+        test_transpose_inplace( dataX, dataY, n, n, transpose_inplace9<T>(), myTypeName + " matrix transpose_inplace9" + size_name );
+        test_transpose_inplace( dataX, dataY, n, n, transpose_inplace10<T>(), myTypeName + " matrix transpose_inplace10" + size_name );
+        
+        test_rotate90CW_inplace( dataX, dataY, n, n, rotate90CW_inplace1<T>(), myTypeName + " matrix rotate90CW_inplace1" + size_name );
+        test_rotate90CW_inplace( dataX, dataY, n, n, rotate90CW_inplace8<T>(), myTypeName + " matrix rotate90CW_inplace8" + size_name );
+        
+        std::string temp( myTypeName + " matrix transpose and rotate" + size_name );
+        summarize( temp.c_str(), int(n*n), iterations, kDontShowGMeans, kDontShowPenalty );
+    }
+    
+    iterations = base_iterations;
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -2494,6 +2794,9 @@ void TestOneType()
     test_transpose( dataX, dataY, HEIGHT, WIDTH, transpose7<T>(), myTypeName + " matrix transpose7" );
     test_transpose( dataX, dataY, HEIGHT, WIDTH, transpose8<T>(), myTypeName + " matrix transpose8" );
     test_transpose( dataX, dataY, HEIGHT, WIDTH, transpose9<T>(), myTypeName + " matrix transpose9" );
+    test_transpose( dataX, dataY, HEIGHT, WIDTH, transpose10<T>(), myTypeName + " matrix transpose10" );
+    test_transpose( dataX, dataY, HEIGHT, WIDTH, transpose11<T>(), myTypeName + " matrix transpose11" );
+    test_transpose( dataX, dataY, HEIGHT, WIDTH, transpose12<T>(), myTypeName + " matrix transpose12" );
 
     std::string temp4( myTypeName + " matrix transpose" );
     summarize( temp4.c_str(), (HEIGHT*WIDTH), iterations, kDontShowGMeans, kDontShowPenalty );
@@ -2505,6 +2808,8 @@ void TestOneType()
     test_rotate90CW( dataX, dataY, HEIGHT, WIDTH, rotate90CW_4<T>(), myTypeName + " matrix rotate90CW_4" );
     test_rotate90CW( dataX, dataY, HEIGHT, WIDTH, rotate90CW_5<T>(), myTypeName + " matrix rotate90CW_5" );
     test_rotate90CW( dataX, dataY, HEIGHT, WIDTH, rotate90CW_6<T>(), myTypeName + " matrix rotate90CW_6" );
+    test_rotate90CW( dataX, dataY, HEIGHT, WIDTH, rotate90CW_7<T>(), myTypeName + " matrix rotate90CW_7" );
+    test_rotate90CW( dataX, dataY, HEIGHT, WIDTH, rotate90CW_8<T>(), myTypeName + " matrix rotate90CW_8" );
     
     std::string temp5( myTypeName + " matrix rotate90Clockwise" );
     summarize( temp5.c_str(), (HEIGHT*WIDTH), iterations, kDontShowGMeans, kDontShowPenalty );
@@ -2516,6 +2821,8 @@ void TestOneType()
     test_rotate90CCW( dataX, dataY, HEIGHT, WIDTH, rotate90CCW_4<T>(), myTypeName + " matrix rotate90CW_4" );
     test_rotate90CCW( dataX, dataY, HEIGHT, WIDTH, rotate90CCW_5<T>(), myTypeName + " matrix rotate90CW_5" );
     test_rotate90CCW( dataX, dataY, HEIGHT, WIDTH, rotate90CCW_6<T>(), myTypeName + " matrix rotate90CW_6" );
+    test_rotate90CCW( dataX, dataY, HEIGHT, WIDTH, rotate90CCW_7<T>(), myTypeName + " matrix rotate90CCW_7" );
+    test_rotate90CCW( dataX, dataY, HEIGHT, WIDTH, rotate90CCW_8<T>(), myTypeName + " matrix rotate90CCW_8" );
     
     std::string temp6( myTypeName + " matrix rotate90CounterClockwise" );
     summarize( temp6.c_str(), (HEIGHT*WIDTH), iterations, kDontShowGMeans, kDontShowPenalty );
@@ -2578,6 +2885,8 @@ void TestOneType()
     test_transpose_inplace( dataX, dataY, minSize, minSize, transpose_inplace6<T>(), myTypeName + " matrix transpose_inplace6" );
     test_transpose_inplace( dataX, dataY, minSize, minSize, transpose_inplace7<T>(), myTypeName + " matrix transpose_inplace7" );
     test_transpose_inplace( dataX, dataY, minSize, minSize, transpose_inplace8<T>(), myTypeName + " matrix transpose_inplace8" );
+    test_transpose_inplace( dataX, dataY, minSize, minSize, transpose_inplace9<T>(), myTypeName + " matrix transpose_inplace9" );
+    test_transpose_inplace( dataX, dataY, minSize, minSize, transpose_inplace10<T>(), myTypeName + " matrix transpose_inplace10" );
     
     std::string temp10( myTypeName + " matrix transpose inplace" );
     summarize( temp10.c_str(), (minSize*minSize), iterations, kDontShowGMeans, kDontShowPenalty );
@@ -2591,6 +2900,7 @@ void TestOneType()
     test_rotate90CW_inplace( dataX, dataY, minSize, minSize, rotate90CW_inplace5<T>(), myTypeName + " matrix rotate90CW_inplace5" );
     test_rotate90CW_inplace( dataX, dataY, minSize, minSize, rotate90CW_inplace6<T>(), myTypeName + " matrix rotate90CW_inplace6" );
     test_rotate90CW_inplace( dataX, dataY, minSize, minSize, rotate90CW_inplace7<T>(), myTypeName + " matrix rotate90CW_inplace7" );
+    test_rotate90CW_inplace( dataX, dataY, minSize, minSize, rotate90CW_inplace8<T>(), myTypeName + " matrix rotate90CW_inplace8" );
     
     std::string temp11( myTypeName + " matrix rotate90Clockwise inplace" );
     summarize( temp11.c_str(), (minSize*minSize), iterations, kDontShowGMeans, kDontShowPenalty );
@@ -2602,12 +2912,15 @@ void TestOneType()
     test_rotate90CCW_inplace( dataX, dataY, minSize, minSize, rotate90CCW_inplace4<T>(), myTypeName + " matrix rotate90CCW_inplace4" );
     test_rotate90CCW_inplace( dataX, dataY, minSize, minSize, rotate90CCW_inplace5<T>(), myTypeName + " matrix rotate90CCW_inplace5" );
     test_rotate90CCW_inplace( dataX, dataY, minSize, minSize, rotate90CCW_inplace6<T>(), myTypeName + " matrix rotate90CCW_inplace6" );
+    test_rotate90CCW_inplace( dataX, dataY, minSize, minSize, rotate90CCW_inplace7<T>(), myTypeName + " matrix rotate90CCW_inplace7" );
     
     std::string temp12( myTypeName + " matrix rotate90CounterClockwise inplace" );
     summarize( temp12.c_str(), (minSize*minSize), iterations, kDontShowGMeans, kDontShowPenalty );
     
 
     iterations = base_iterations;
+    
+    TestSizeSweep<T>( myTypeName, base_iterations );
 }
 
 /******************************************************************************/
@@ -19,6 +19,14 @@ Assumptions:
     3) The compiler will at least apply the textbook optimizations
         for matrix multiplication.
 
+    4) A packed, cache blocked multiply with a register blocked micro-kernel
+        will be much faster than any of the simple loop nests, for all shapes.
+
+    5) Splitting the output into tiles across threads will scale close to linearly
+        with the number of cores, once the matrices are large enough.
+
+    6) A sub cubic algorithm will beat the packed multiply for large enough matrices.
+
 
 
 NOTE - the techniques used to optimize a matrix multiply, if done generally, help many other problems.
@@ -36,11 +44,12 @@ SEE ALSO:
     Tiling/blocking for GPU calculation
         https://devblogs.nvidia.com/cutlass-linear-algebra-cuda/
 
-TODO - sub cubic algorithms
+NOTE - Strassen trades accuracy for speed, the error grows with the depth of recursion.
     https://en.wikipedia.org/wiki/Matrix_multiplication_algorithm
     https://en.wikipedia.org/wiki/Strassen_algorithm
 
-TODO - threaded matrix multiplies ?
+NOTE - the threaded multiply is limited by memory bandwidth and shared cache for large matrices,
+        and by the cost of starting the threads for small matrices.
 
 */
 
@@ -53,9 +62,14 @@ TODO - threaded matrix multiplies ?
 #include <deque>
 #include <string>
 #include <memory>
+#include <vector>
+#include <algorithm>
+#include <limits>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_typenames.h"
+#include "benchmark_cache.h"
+#include "benchmark_threads.h"
 
 /******************************************************************************/
 
@@ -1133,6 +1147,202 @@ struct matmul_JKI_blocked_unrolled3 {
 /******************************************************************************/
 /******************************************************************************/
 
+// Packed GEMM, in the style of GotoBLAS and BLIS
+// C(MxN) += A(MxK) * B(KxN), all row major with leading dimensions
+// Blocks of A and B are copied into contiguous buffers sized for the caches, in the order
+//    the micro-kernel reads them, and the micro-kernel keeps an MR x NR block of C in registers.
+// The micro-kernel is plain C++ written so the compiler can vectorize the NR loop.
+
+// The register block is sized for 16 byte vectors, the width every current desktop and mobile target has.
+// Wider vectors still work, the compiler just uses fewer of them per row.
+const size_t kGemmVectorBytes = 16;
+
+// register block, two vectors wide, with enough rows to hide the multiply-add latency
+// MR must be even
+template <typename T>
+struct gemm_register_block {
+    static const size_t NR = 2 * kGemmVectorBytes / sizeof(T);
+    static const size_t MR = 4;
+};
+
+struct gemm_blocking {
+    size_t MC;      // rows of A packed at once, sized for L2
+    size_t KC;      // depth of each packed panel, sized for L1
+    size_t NC;      // columns of B packed at once, sized for L3
+};
+
+/******************************************************************************/
+
+inline size_t round_down_clamp( size_t value, size_t multiple, size_t low, size_t high ) {
+    value -= value % multiple;
+    if (value < low)    value = low;
+    if (value > high)   value = high;
+    return value;
+}
+
+template <typename T>
+gemm_blocking choose_gemm_blocking( const benchmark::cache_sizes &caches ) {
+    const size_t MR = gemm_register_block<T>::MR;
+    const size_t NR = gemm_register_block<T>::NR;
+    gemm_blocking result;
+    
+    // an MR x KC sliver of A and a KC x NR sliver of B share half of L1, leaving room for C
+    result.KC = round_down_clamp( (caches.L1 / 2) / ((MR + NR) * sizeof(T)), 8, 32, 1024 );
+    
+    // an MC x KC block of A takes half of L2
+    result.MC = round_down_clamp( (caches.L2 / 2) / (result.KC * sizeof(T)), MR, MR, 4096 );
+    
+    // a KC x NC panel of B takes half of L3 (shared, so be modest), or all of L2 without one
+    size_t outer = (caches.L3 != 0) ? (caches.L3 / 2) : caches.L2;
+    result.NC = round_down_clamp( outer / (result.KC * sizeof(T)), NR, NR, 4096 );
+
+    return result;
+}
+
+/******************************************************************************/
+
+template <typename T>
+class packed_gemm {
+public:
+    static const size_t MR = gemm_register_block<T>::MR;
+    static const size_t NR = gemm_register_block<T>::NR;
+
+    explicit packed_gemm( const gemm_blocking &blocks ) :
+        blocking( blocks ),
+        bufferA( ((blocks.MC + MR - 1) / MR) * MR * blocks.KC ),
+        bufferB( ((blocks.NC + NR - 1) / NR) * NR * blocks.KC ) {}
+
+    void operator()( size_t M, size_t N, size_t K,
+                    const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc ) {
+        for (size_t jc = 0; jc < N; jc += blocking.NC) {
+            size_t nc = std::min( blocking.NC, N - jc );
+            
+            for (size_t pc = 0; pc < K; pc += blocking.KC) {
+                size_t kc = std::min( blocking.KC, K - pc );
+                pack_B( kc, nc, B + pc*ldb + jc, ldb );
+                
+                for (size_t ic = 0; ic < M; ic += blocking.MC) {
+                    size_t mc = std::min( blocking.MC, M - ic );
+                    pack_A( mc, kc, A + ic*lda + pc, lda );
+                    
+                    for (size_t jr = 0; jr < nc; jr += NR) {
+                        for (size_t ir = 0; ir < mc; ir += MR) {
+                            micro_kernel( kc, &bufferA[ir*kc], &bufferB[jr*kc],
+                                        C + (ic+ir)*ldc + jc + jr, ldc,
+                                        std::min( MR, mc - ir ), std::min( NR, nc - jr ) );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    const gemm_blocking &blocks() const { return blocking; }
+
+private:
+    // MR row slivers, column by column, zero padded at the bottom edge
+    void pack_A( size_t mc, size_t kc, const T *A, size_t lda ) {
+        for (size_t ir = 0; ir < mc; ir += MR) {
+            T *dest = &bufferA[ir*kc];
+            size_t rows = std::min( MR, mc - ir );
+            for (size_t p = 0; p < kc; ++p) {
+                for (size_t i = 0; i < MR; ++i)
+                    dest[p*MR + i] = (i < rows) ? A[(ir+i)*lda + p] : T(0);
+            }
+        }
+    }
+
+    // NR column slivers, row by row, zero padded at the right edge
+    void pack_B( size_t kc, size_t nc, const T *B, size_t ldb ) {
+        for (size_t jr = 0; jr < nc; jr += NR) {
+            T *dest = &bufferB[jr*kc];
+            size_t cols = std::min( NR, nc - jr );
+            for (size_t p = 0; p < kc; ++p) {
+                const T *source = B + p*ldb + jr;
+                if (cols == NR) {
+                    for (size_t j = 0; j < NR; ++j)
+                        dest[p*NR + j] = source[j];
+                } else {
+                    for (size_t j = 0; j < NR; ++j)
+                        dest[p*NR + j] = (j < cols) ? source[j] : T(0);
+                }
+            }
+        }
+    }
+
+    // Two rows of the MR x NR block of C stay in registers for the length of the panel.
+    // Keeping the whole block as one 2D accumulator is better in theory, but GCC often
+    //    vectorizes the K loop as a reduction instead, and runs 10x slower.
+    static void micro_kernel( size_t kc, const T *Ap, const T *Bp, T *C, size_t ldc, size_t mr, size_t nr ) {
+        for (size_t i = 0; i < MR; i += 2) {
+            T acc0[NR], acc1[NR];
+            for (size_t j = 0; j < NR; ++j) {
+                acc0[j] = T(0);
+                acc1[j] = T(0);
+            }
+
+            for (size_t p = 0; p < kc; ++p) {
+                const T a0 = Ap[p*MR + i];
+                const T a1 = Ap[p*MR + i + 1];
+                const T *b = Bp + p*NR;
+                for (size_t j = 0; j < NR; ++j) {
+                    acc0[j] += a0 * b[j];
+                    acc1[j] += a1 * b[j];
+                }
+            }
+
+            if (i + 1 < mr && nr == NR) {
+                for (size_t j = 0; j < NR; ++j) {
+                    C[i*ldc + j] += acc0[j];
+                    C[(i+1)*ldc + j] += acc1[j];
+                }
+            } else {
+                for (size_t j = 0; j < nr; ++j) {
+                    if (i < mr)
+                        C[i*ldc + j] += acc0[j];
+                    if (i + 1 < mr)
+                        C[(i+1)*ldc + j] += acc1[j];
+                }
+            }
+        }
+    }
+
+    gemm_blocking blocking;
+    std::vector<T> bufferA;
+    std::vector<T> bufferB;
+};
+
+/******************************************************************************/
+
+template <typename T>
+packed_gemm<T> &shared_packed_gemm() {
+    static packed_gemm<T> gemm( choose_gemm_blocking<T>( benchmark::detect_cache_sizes() ) );
+    return gemm;
+}
+
+// same interface as the simple versions above
+template <typename T >
+struct matmul_packed {
+    void operator()(const T xx[HEIGHT*WIDTH], const T yy[WIDTH*HEIGHT], T zz[HEIGHT*WIDTH], size_t rows, size_t cols) {
+        shared_packed_gemm<T>()( rows, cols, cols, xx, cols, yy, cols, zz, cols );
+    }
+};
+
+// simple general version for comparison, IKJ order vectorizes well
+template <typename T>
+void gemm_naive_IKJ( size_t M, size_t N, size_t K,
+                    const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc ) {
+    for (size_t i = 0; i < M; ++i) {
+        for (size_t k = 0; k < K; ++k) {
+            T temp = A[i*lda + k];
+            for (size_t j = 0; j < N; ++j)
+                C[i*ldc + j] += temp * B[k*ldb + j];
+        }
+    }
+}
+
+/******************************************************************************/
+
 template <typename T>
 void zero_matrix(T zz[HEIGHT*WIDTH], size_t rows, size_t cols) {
     T value = T(0);
@@ -1370,12 +1580,531 @@ void verify_matmul( T xx[HEIGHT*WIDTH], T yy[WIDTH*HEIGHT], T zz[HEIGHT*WIDTH],
     if (!matrix_equal( master_result, zz, rows, cols ))
         printf("matmul_JKI_blocked_unrolled3 failed verification\n");
 
+    zero_matrix(zz, rows, cols);
+    matmul_packed<T>()( xx, yy, zz, rows, cols );
+    if (!matrix_equal( master_result, zz, rows, cols ))
+        printf("matmul_packed failed verification\n");
+
+}
+
+/******************************************************************************/
+
+// odd sizes to exercise the edges of every block level
+template <typename T>
+void verify_packed_gemm() {
+    const size_t shapes[][3] = { {1,1,1}, {7,5,3}, {37,53,71}, {129,257,300}, {600,30,1100}, {13,4100,9} };
+    
+    for (const auto &shape : shapes) {
+        size_t M = shape[0], N = shape[1], K = shape[2];
+        std::vector<T> A( M*K ), B( K*N ), expected( M*N, T(0) ), C( M*N, T(0) );
+        for (size_t i = 0; i < M*K; ++i)
+            A[i] = T( (i*7) % 5 );
+        for (size_t i = 0; i < K*N; ++i)
+            B[i] = T( (i*3) % 7 );
+
+        gemm_naive_IKJ( M, N, K, &A[0], K, &B[0], N, &expected[0], N );
+        shared_packed_gemm<T>()( M, N, K, &A[0], K, &B[0], N, &C[0], N );
+
+        for (size_t i = 0; i < M*N; ++i) {
+            if (!tolerance_equal( C[i], expected[i] )) {
+                printf("packed gemm %zux%zux%zu failed verification\n", M, N, K );
+                break;
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+
+struct gemm_shape {
+    size_t M, N, K;
+};
+
+// square, then skinny shapes common in ML and solvers
+const gemm_shape gemm_shapes[] = {
+    { 64, 64, 64 },
+    { 256, 256, 256 },
+    { 1024, 1024, 1024 },
+    { 2048, 2048, 2048 },
+    { 4096, 4096, 32 },     // rank-k update
+    { 4096, 32, 4096 },     // panel times matrix
+    { 32, 4096, 4096 },     // short and wide
+    { 16384, 64, 64 },      // tall and thin
+};
+
+template <typename T, typename GEMM >
+void test_gemm_shape(const gemm_shape &shape, size_t repeats, std::vector<T> &A, std::vector<T> &B, std::vector<T> &C,
+                    GEMM multiplier, const std::string label) {
+    start_timer();
+
+    for (size_t i = 0; i < repeats; ++i) {
+        std::fill( C.begin(), C.end(), T(0) );
+        multiplier( shape.M, shape.N, shape.K, &A[0], shape.K, &B[0], shape.N, &C[0], shape.N );
+    }
+    
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+    
+    T expected = T(shape.K) * T(init_value) * T(init_value);
+    if (!tolerance_equal( C[0], expected ) || !tolerance_equal( C[C.size()-1], expected ))
+        printf("test %s failed\n", label.c_str() );
+}
+
+// Each shape gets its own summary, counting operations in thousands of FLOPs,
+//    so "M per second" reads as GFLOP/s.
+template <typename T>
+void test_gemm_shapes(const std::string &myTypeName) {
+    const gemm_blocking &blocks = shared_packed_gemm<T>().blocks();
+    printf("\n%s packed gemm blocking MC %zu, KC %zu, NC %zu, register block %zu x %zu\n",
+            myTypeName.c_str(), blocks.MC, blocks.KC, blocks.NC,
+            packed_gemm<T>::MR, packed_gemm<T>::NR );
+    
+    // about the same amount of work for each shape
+    const double flopBudget = 2.0e7 * double(iterations);
+
+    for (const auto &shape : gemm_shapes) {
+        std::vector<T> A( shape.M * shape.K, T(init_value) );
+        std::vector<T> B( shape.K * shape.N, T(init_value) );
+        std::vector<T> C( shape.M * shape.N );
+        
+        double flops = 2.0 * shape.M * shape.N * shape.K;
+        size_t repeats = std::max( size_t(1), size_t(flopBudget / flops) );
+        
+        char shapeName[ 100 ];
+        snprintf( shapeName, sizeof(shapeName), " %zux%zux%zu", shape.M, shape.N, shape.K );
+        std::string name( myTypeName + " gemm" + shapeName );
+        
+        test_gemm_shape( shape, repeats, A, B, C, gemm_naive_IKJ<T>, name + " naive IKJ" );
+        test_gemm_shape( shape, repeats, A, B, C, shared_packed_gemm<T>(), name + " packed" );
+        
+        summarize( name.c_str(), int(flops / 1000.0), (int)repeats, kDontShowGMeans, kDontShowPenalty );
+    }
+}
+
+/******************************************************************************/
+
+// Threaded GEMM
+// C is cut into 2D tiles, and each thread multiplies whole tiles with its own packed_gemm,
+//    so no two threads write the same part of C and the packing buffers are never shared.
+// Each tile packs its own panels of A and B, which costs a little extra packing
+//    but needs no synchronization beyond handing out the tiles.
+template <typename T>
+class threaded_gemm {
+public:
+    static const size_t MR = gemm_register_block<T>::MR;
+    static const size_t NR = gemm_register_block<T>::NR;
+
+    threaded_gemm( const gemm_blocking &blocks, int maxThreads ) : blocking( blocks ) {
+        for (int i = 0; i < maxThreads; ++i)
+            workers.emplace_back( blocks );
+    }
+
+    void operator()( benchmark::thread_pool &pool, int threads, size_t M, size_t N, size_t K,
+                    const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc ) {
+        threads = std::min( threads, int(workers.size()) );
+        
+        size_t tileM, tileN;
+        choose_tiles( M, N, threads, tileM, tileN );
+        const size_t tilesDown = (M + tileM - 1) / tileM;
+        const size_t tilesAcross = (N + tileN - 1) / tileN;
+        const int tiles = int(tilesDown * tilesAcross);
+
+        std::atomic<int> next( 0 );
+        pool.run( threads, [&]( int index ) {
+            packed_gemm<T> &gemm = workers[ index ];
+            int tile;
+            while ((tile = next.fetch_add(1)) < tiles) {
+                size_t row = (tile / tilesAcross) * tileM;
+                size_t col = (tile % tilesAcross) * tileN;
+                gemm( std::min( tileM, M - row ), std::min( tileN, N - col ), K,
+                        A + row*lda, lda, B + col, ldb, C + row*ldc + col, ldc );
+            }
+        } );
+    }
+
+private:
+    // Start with one cache block per tile, then split the longer side until there are
+    //    enough tiles to balance the load, without going below a few register blocks.
+    void choose_tiles( size_t M, size_t N, int threads, size_t &tileM, size_t &tileN ) const {
+        tileM = std::min( blocking.MC, M );
+        tileN = std::min( blocking.NC, N );
+        const size_t wanted = (threads > 1) ? 4 * size_t(threads) : 1;
+        
+        for (;;) {
+            size_t tiles = ((M + tileM - 1) / tileM) * ((N + tileN - 1) / tileN);
+            if (tiles >= wanted)
+                break;
+            if (tileN >= tileM && tileN >= 8*NR)
+                tileN = ((tileN / 2 + NR - 1) / NR) * NR;
+            else if (tileM >= 8*MR)
+                tileM = ((tileM / 2 + MR - 1) / MR) * MR;
+            else
+                break;
+        }
+    }
+
+    gemm_blocking blocking;
+    std::vector< packed_gemm<T> > workers;
+};
+
+/******************************************************************************/
+
+// odd sizes again, with a fixed number of threads so the tiling is exercised on any machine
+template <typename T>
+void verify_threaded_gemm() {
+    const size_t shapes[][3] = { {1,1,1}, {7,5,3}, {37,53,71}, {129,257,300}, {600,30,1100}, {13,4100,9}, {500,500,40} };
+    const int threads = 4;
+    
+    benchmark::thread_pool pool( threads );
+    threaded_gemm<T> gemm( shared_packed_gemm<T>().blocks(), threads );
+    
+    for (const auto &shape : shapes) {
+        size_t M = shape[0], N = shape[1], K = shape[2];
+        std::vector<T> A( M*K ), B( K*N ), expected( M*N, T(0) ), C( M*N, T(0) );
+        for (size_t i = 0; i < M*K; ++i)
+            A[i] = T( (i*7) % 5 );
+        for (size_t i = 0; i < K*N; ++i)
+            B[i] = T( (i*3) % 7 );
+
+        gemm_naive_IKJ( M, N, K, &A[0], K, &B[0], N, &expected[0], N );
+        gemm( pool, threads, M, N, K, &A[0], K, &B[0], N, &C[0], N );
+
+        for (size_t i = 0; i < M*N; ++i) {
+            if (!tolerance_equal( C[i], expected[i] )) {
+                printf("threaded gemm %zux%zux%zu failed verification\n", M, N, K );
+                break;
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+
+// square sizes from L2 resident to well beyond most L3 caches (all three matrices)
+const size_t gemm_thread_sizes[] = { 256, 512, 1024, 2048 };
+
+// Each size gets its own summary, timed with the wall clock, 1..N threads.
+// Scaling efficiency is the speedup over one thread divided by the number of threads.
+template <typename T>
+void test_gemm_threads(benchmark::thread_pool &pool, const std::string &myTypeName) {
+    threaded_gemm<T> gemm( shared_packed_gemm<T>().blocks(), pool.size() );
+    
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < pool.size(); threads *= 2)
+        threadCounts.push_back( threads );
+    threadCounts.push_back( pool.size() );
+    
+    const double flopBudget = 2.0e7 * double(iterations);
+
+    for (size_t size : gemm_thread_sizes) {
+        std::vector<T> A( size * size, T(init_value) );
+        std::vector<T> B( size * size, T(init_value) );
+        std::vector<T> C( size * size );
+        
+        double flops = 2.0 * size * size * size;
+        size_t repeats = std::max( size_t(1), size_t(flopBudget / flops) );
+        
+        std::string name( myTypeName + " threaded gemm " + std::to_string(size) );
+        double oneThread = 0.0;
+        
+        for (int threads : threadCounts) {
+            start_wall_timer();
+            for (size_t i = 0; i < repeats; ++i) {
+                std::fill( C.begin(), C.end(), T(0) );
+                gemm( pool, threads, size, size, size, &A[0], size, &B[0], size, &C[0], size );
+            }
+            double elapsed = wall_timer();
+            
+            if (threads == 1)
+                oneThread = elapsed;
+            double efficiency = (elapsed > 0.0) ? 100.0 * oneThread / (elapsed * threads) : 0.0;
+            
+            char suffix[ 100 ];
+            snprintf( suffix, sizeof(suffix), " %d threads, %.0f%% efficiency", threads, efficiency );
+            gLabels.push_back( name + suffix );
+            record_result( elapsed, gLabels.back().c_str() );
+            
+            T expected = T(size) * T(init_value) * T(init_value);
+            if (!tolerance_equal( C[0], expected ) || !tolerance_equal( C[C.size()-1], expected ))
+                printf("test %s failed\n", gLabels.back().c_str() );
+        }
+        
+        summarize( name.c_str(), int(flops / 1000.0), (int)repeats, kDontShowGMeans, kDontShowPenalty );
+    }
+}
+
+/******************************************************************************/
+
+// Strassen-Winograd multiply, 7 half size multiplies and 15 additions per level
+// Recurses until the matrices are no larger than the crossover, then uses the packed multiply.
+// Odd sizes peel off the last row and column, and fix them up with the packed multiply.
+// Temporaries come from one workspace, 4 half size blocks per level, reused by each child.
+// C = A * B, square only
+template <typename T>
+class strassen_gemm {
+public:
+    explicit strassen_gemm( size_t crossover ) : limit( std::max( crossover, size_t(1) ) ) {}
+
+    void operator()( size_t n, const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc ) {
+        size_t needed = workspace_size( n );
+        if (workspace.size() < needed)
+            workspace.resize( needed );
+        multiply( n, A, lda, B, ldb, C, ldc, workspace.data() );
+    }
+
+    size_t crossover() const { return limit; }
+
+private:
+    size_t workspace_size( size_t n ) const {
+        if (n <= limit)
+            return 0;
+        size_t half = n / 2;
+        return 4 * half * half + workspace_size( half );
+    }
+
+    static void add( size_t n, const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc ) {
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < n; ++j)
+                C[i*ldc + j] = A[i*lda + j] + B[i*ldb + j];
+    }
+
+    static void subtract( size_t n, const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc ) {
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < n; ++j)
+                C[i*ldc + j] = A[i*lda + j] - B[i*ldb + j];
+    }
+
+    static void accumulate( size_t n, const T *A, size_t lda, T *C, size_t ldc ) {
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = 0; j < n; ++j)
+                C[i*ldc + j] += A[i*lda + j];
+    }
+
+    static void zero( size_t rows, size_t cols, T *C, size_t ldc ) {
+        for (size_t i = 0; i < rows; ++i)
+            std::fill( C + i*ldc, C + i*ldc + cols, T(0) );
+    }
+
+    void multiply( size_t n, const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc, T *work ) {
+        packed_gemm<T> &gemm = shared_packed_gemm<T>();
+
+        if (n <= limit) {
+            zero( n, n, C, ldc );
+            gemm( n, n, n, A, lda, B, ldb, C, ldc );
+            return;
+        }
+        
+        if (n & 1) {
+            size_t m = n - 1;
+            multiply( m, A, lda, B, ldb, C, ldc, work );
+            // rank 1 update of the even part, then the last column and row
+            gemm( m, m, 1, A + m, lda, B + m*ldb, ldb, C, ldc );
+            zero( m, 1, C + m, ldc );
+            gemm( m, 1, n, A, lda, B + m, ldb, C + m, ldc );
+            zero( 1, n, C + m*ldc, ldc );
+            gemm( 1, n, n, A + m*lda, lda, B, ldb, C + m*ldc, ldc );
+            return;
+        }
+
+        const size_t h = n / 2;
+        const T *A11 = A,           *A12 = A + h,           *A21 = A + h*lda,       *A22 = A + h*lda + h;
+        const T *B11 = B,           *B12 = B + h,           *B21 = B + h*ldb,       *B22 = B + h*ldb + h;
+        T *C11 = C,                 *C12 = C + h,           *C21 = C + h*ldc,       *C22 = C + h*ldc + h;
+        T *S = work;
+        T *U = work + h*h;
+        T *X = work + 2*h*h;
+        T *Y = work + 3*h*h;
+        T *next = work + 4*h*h;
+
+        multiply( h, A11, lda, B11, ldb, X, h, next );         // M1
+        multiply( h, A12, lda, B21, ldb, C11, ldc, next );     // M2
+        accumulate( h, X, h, C11, ldc );                        // C11 = M1 + M2
+
+        add( h, A21, lda, A22, lda, S, h );                     // S1
+        subtract( h, B12, ldb, B11, ldb, U, h );                // T1
+        multiply( h, S, h, U, h, C22, ldc, next );              // M5
+
+        subtract( h, S, h, A11, lda, S, h );                    // S2
+        subtract( h, B22, ldb, U, h, U, h );                    // T2
+        multiply( h, S, h, U, h, C12, ldc, next );              // M6
+        accumulate( h, X, h, C12, ldc );                        // U2 = M1 + M6
+
+        subtract( h, A12, lda, S, h, S, h );                    // S4
+        multiply( h, S, h, B22, ldb, X, h, next );              // M3
+        subtract( h, U, h, B21, ldb, U, h );                    // T4
+        multiply( h, A22, lda, U, h, C21, ldc, next );          // M4
+
+        subtract( h, A11, lda, A21, lda, S, h );                // S3
+        subtract( h, B22, ldb, B12, ldb, U, h );                // T3
+        multiply( h, S, h, U, h, Y, h, next );                  // M7
+        accumulate( h, C12, ldc, Y, h );                        // U3 = U2 + M7
+
+        subtract( h, Y, h, C21, ldc, C21, ldc );                // C21 = U3 - M4
+        accumulate( h, C22, ldc, C12, ldc );                    // U4 = U2 + M5
+        accumulate( h, X, h, C12, ldc );                        // C12 = U4 + M3
+        accumulate( h, Y, h, C22, ldc );                        // C22 = U3 + M5
+    }
+
+    size_t limit;
+    std::vector<T> workspace;
+};
+
+/******************************************************************************/
+
+// odd sizes with a tiny crossover, to exercise the recursion and the peeling
+template <typename T>
+void verify_strassen() {
+    const size_t sizes[] = { 1, 2, 3, 16, 65, 127, 200, 301 };
+    strassen_gemm<T> strassen( 8 );
+    
+    for (size_t n : sizes) {
+        std::vector<T> A( n*n ), B( n*n ), expected( n*n, T(0) ), C( n*n, T(7) );
+        for (size_t i = 0; i < n*n; ++i) {
+            A[i] = T( (i*7) % 5 );
+            B[i] = T( (i*3) % 7 );
+        }
+
+        gemm_naive_IKJ( n, n, n, &A[0], n, &B[0], n, &expected[0], n );
+        strassen( n, &A[0], n, &B[0], n, &C[0], n );
+
+        for (size_t i = 0; i < n*n; ++i) {
+            if (!tolerance_equal( C[i], expected[i] )) {
+                printf("strassen %zu failed verification\n", n );
+                break;
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+
+// small values, with fractions for the floating point types, so rounding errors show up
+template <typename T>
+void fill_random_matrix( std::vector<T> &matrix, uint32_t seed ) {
+    const double scale = std::numeric_limits<T>::is_integer ? 4.0 : 1.0;
+    for (auto &value : matrix) {
+        seed = seed * 1664525 + 1013904223;
+        double unit = double(seed >> 8) * (2.0 / 16777216.0) - 1.0;
+        value = T( unit * scale );
+    }
+}
+
+// largest error, relative to the largest value in the reference result
+template <typename T>
+double relative_error( const std::vector<T> &result, const std::vector<T> &reference ) {
+    double worst = 0.0, largest = 0.0;
+    for (size_t i = 0; i < result.size(); ++i) {
+        worst = std::max( worst, fabs( double(result[i]) - double(reference[i]) ) );
+        largest = std::max( largest, fabs( double(reference[i]) ) );
+    }
+    return (largest > 0.0) ? (worst / largest) : worst;
+}
+
+/******************************************************************************/
+
+// Time one level of Strassen against the packed multiply at growing sizes.
+// The crossover is the largest size where the packed multiply still won,
+//    or the largest size tried if Strassen never wins.
+template <typename T>
+size_t tune_strassen_crossover() {
+    const size_t minSize = 32;
+    const size_t maxSize = 1024;
+    const int runs = 3;
+    
+    for (size_t n = minSize; n <= maxSize; n *= 2) {
+        std::vector<T> A( n*n ), B( n*n ), C( n*n );
+        fill_random_matrix( A, 1 );
+        fill_random_matrix( B, 2 );
+        strassen_gemm<T> oneLevel( n / 2 );
+        
+        // repeat small sizes so the clock can resolve them
+        const size_t repeats = std::max( size_t(1), (maxSize / n) * (maxSize / n) * (maxSize / n) / 8 );
+        
+        double packedTime = 1.0e30, strassenTime = 1.0e30;
+        for (int run = 0; run < runs; ++run) {
+            start_timer();
+            for (size_t i = 0; i < repeats; ++i) {
+                std::fill( C.begin(), C.end(), T(0) );
+                shared_packed_gemm<T>()( n, n, n, &A[0], n, &B[0], n, &C[0], n );
+            }
+            packedTime = std::min( packedTime, timer() );
+            
+            start_timer();
+            for (size_t i = 0; i < repeats; ++i)
+                oneLevel( n, &A[0], n, &B[0], n, &C[0], n );
+            strassenTime = std::min( strassenTime, timer() );
+        }
+        
+        if (strassenTime < packedTime)
+            return n / 2;
+    }
+    
+    return maxSize;
+}
+
+/******************************************************************************/
+
+// square sizes, the naive reference gets too slow beyond the last size with an error check
+const size_t strassen_sizes[] = { 256, 512, 1024, 2048 };
+const size_t strassen_max_reference = 1024;
+
+// Each size gets its own summary, counting the classical operations in thousands,
+//    so "M per second" reads as effective GFLOP/s.
+// Errors are against matmul_IJK in the same type.
+template <typename T>
+void test_strassen(const std::string &myTypeName) {
+    strassen_gemm<T> strassen( tune_strassen_crossover<T>() );
+    printf("\n%s strassen crossover %zu\n", myTypeName.c_str(), strassen.crossover() );
+    
+    const double flopBudget = 2.0e7 * double(iterations);
+
+    for (size_t n : strassen_sizes) {
+        std::vector<T> A( n*n ), B( n*n ), C( n*n ), reference;
+        fill_random_matrix( A, 1 );
+        fill_random_matrix( B, 2 );
+        
+        if (n <= strassen_max_reference) {
+            reference.resize( n*n, T(0) );
+            matmul_IJK<T>()( &A[0], &B[0], &reference[0], n, n );
+        }
+        
+        double flops = 2.0 * n * n * n;
+        size_t repeats = std::max( size_t(1), size_t(flopBudget / flops) );
+        std::string name( myTypeName + " strassen " + std::to_string(n) );
+        char suffix[ 100 ];
+
+        start_timer();
+        for (size_t i = 0; i < repeats; ++i) {
+            std::fill( C.begin(), C.end(), T(0) );
+            shared_packed_gemm<T>()( n, n, n, &A[0], n, &B[0], n, &C[0], n );
+        }
+        double elapsed = timer();
+        if (reference.empty())
+            snprintf( suffix, sizeof(suffix), " packed" );
+        else
+            snprintf( suffix, sizeof(suffix), " packed, error %.3g", relative_error( C, reference ) );
+        gLabels.push_back( name + suffix );
+        record_result( elapsed, gLabels.back().c_str() );
+
+        start_timer();
+        for (size_t i = 0; i < repeats; ++i)
+            strassen( n, &A[0], n, &B[0], n, &C[0], n );
+        elapsed = timer();
+        if (reference.empty())
+            snprintf( suffix, sizeof(suffix), " strassen-winograd" );
+        else
+            snprintf( suffix, sizeof(suffix), " strassen-winograd, error %.3g", relative_error( C, reference ) );
+        gLabels.push_back( name + suffix );
+        record_result( elapsed, gLabels.back().c_str() );
+        
+        summarize( name.c_str(), int(flops / 1000.0), (int)repeats, kDontShowGMeans, kDontShowPenalty );
+    }
 }
 
 /******************************************************************************/
 /******************************************************************************/
 template< typename T>
-void TestOneType()
+void TestOneType(benchmark::thread_pool &pool)
 {
     std::string myTypeName( getTypeName<T>() );
     
@@ -1429,9 +2158,20 @@ void TestOneType()
     test_matmul( dataX, dataY, dataZ, HEIGHT, WIDTH, matmul_JKI_blocked_unrolled2<T>(), myTypeName + " matrix multiply JKI blocked unrolled2" );
     test_matmul( dataX, dataY, dataZ, HEIGHT, WIDTH, matmul_JKI_blocked_unrolled3<T>(), myTypeName + " matrix multiply JKI blocked unrolled3" );
 
+    test_matmul( dataX, dataY, dataZ, HEIGHT, WIDTH, matmul_packed<T>(), myTypeName + " matrix multiply packed" );
+
     std::string temp1( myTypeName + " matrix multiply" );
     summarize( temp1.c_str(), (2*HEIGHT*WIDTH*WIDTH), iterations, kDontShowGMeans, kDontShowPenalty );
 
+    verify_packed_gemm<T>();
+    test_gemm_shapes<T>( myTypeName );
+
+    verify_threaded_gemm<T>();
+    test_gemm_threads<T>( pool, myTypeName );
+
+    verify_strassen<T>();
+    test_strassen<T>( myTypeName );
+
 }
 
 /******************************************************************************/
@@ -1449,16 +2189,18 @@ int main(int argc, char** argv) {
     if (argc > 2) init_value = (double) atof(argv[2]);
 
 
-    TestOneType<int32_t>();
-    TestOneType<float>();
+    benchmark::thread_pool pool;
+
+    TestOneType<int32_t>( pool );
+    TestOneType<float>( pool );
 
     iterations /= 2;
-    TestOneType<double>();
+    TestOneType<double>( pool );
 
 
 #if WORKS_BUT_SLOW
-    TestOneType<int64_t>();
-    TestOneType<long double>();
+    TestOneType<int64_t>( pool );
+    TestOneType<long double>( pool );
 #endif
     
     return 0;
@@ -11,6 +11,13 @@ Assumptions:
     1) the compiler will recognize matrix vector multiplication patterns
         and substitute optimal patterns
 
+    2) Splitting the rows across threads will scale with the number of cores
+        until the matrix no longer fits in cache, then with memory bandwidth
+
+    3) Sparse matrix vector products are limited by memory bandwidth,
+        and storage formats that let the compiler vectorize across rows (ELLPACK, SELL-C-sigma)
+        will get closer to the bandwidth limit than CSR
+
 
 
 NOTE - the techniques used to optimize a matrix vector product, if done generally, can help many other problems.
@@ -30,10 +37,14 @@ NOTE - ccox - int32 is sometimes slower than double, despite double using twice
 #include <deque>
 #include <string>
 #include <memory>
+#include <vector>
+#include <algorithm>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_typenames.h"
 #include "benchmark_algorithms.h"
+#include "benchmark_threads.h"
+#include "benchmark_cache.h"
 
 /******************************************************************************/
 
@@ -1095,6 +1106,541 @@ void verify_matvecmul( T xx[WIDTH], T yy[HEIGHT], T zz[HEIGHT*WIDTH], int rows,
 }
 
 
+/******************************************************************************/
+
+// Row parallel matrix vector product
+// Each thread gets whole bands of rows, so every thread reads its own part of the matrix
+//    and writes its own part of the result, and only the input vector is shared.
+// The kernel is the same as matvecmul_IJ_temp1, for a range of rows.
+template <typename T>
+void matvecmul_rows(const T *xx, T *yy, const T *zz, size_t cols, size_t rowStart, size_t rowEnd) {
+    for (size_t i = rowStart; i < rowEnd; ++i) {
+        T temp = yy[i];
+        const T *zI = zz + i*cols;
+        for (size_t j = 0; j < cols; ++j) {
+            temp += zI[j] * xx[j];
+        }
+        yy[i] = temp;
+    }
+}
+
+// Several bands per thread, so a slow thread does not hold up the rest.
+// Bands are a whole number of cache lines of results, to avoid false sharing in yy.
+template <typename T>
+void matvecmul_threaded(benchmark::thread_pool &pool, int threads,
+                        const T *xx, T *yy, const T *zz, size_t rows, size_t cols) {
+    const size_t lineItems = std::max( size_t(1), 64 / sizeof(T) );
+    size_t band = (rows + 8*threads - 1) / (8*threads);
+    band = ((band + lineItems - 1) / lineItems) * lineItems;
+    const int bands = int( (rows + band - 1) / band );
+
+    std::atomic<int> next( 0 );
+    pool.run( threads, [&]( int ) {
+        int index;
+        while ((index = next.fetch_add(1)) < bands) {
+            size_t start = index * band;
+            matvecmul_rows( xx, yy, zz, cols, start, std::min( rows, start + band ) );
+        }
+    } );
+}
+
+/******************************************************************************/
+
+// an odd size, with a fixed number of threads so the banding is exercised on any machine
+template <typename T>
+void verify_matvecmul_threaded(T xx[WIDTH], T yy[HEIGHT], T zz[HEIGHT*WIDTH], int rows, int cols) {
+    const int threads = 4;
+    benchmark::thread_pool pool( threads );
+    
+    benchmark::fill_ascending( xx, xx+cols );
+    fill_matrix_pattern1( zz, rows, cols );
+    
+    std::unique_ptr<T[]> master( new T[ HEIGHT ] );
+    T *master_result = master.get();
+    ::fill( master_result, master_result+HEIGHT, 0 );
+    matvecmul_IJ<T>()( xx, master_result, zz, rows, cols );
+
+    const int oddRows = rows - 3;
+    ::fill( yy, yy+HEIGHT, 0 );
+    matvecmul_threaded( pool, threads, xx, yy, zz, oddRows, cols );
+    if (!vector_equal( master_result, yy, oddRows ) || yy[oddRows] != T(0))
+        printf("matvecmul_threaded failed verification\n");
+}
+
+/******************************************************************************/
+
+// square sizes from L2 resident to well beyond most L3 caches
+const size_t matvec_thread_sizes[] = { 256, 1024, 4096 };
+
+// Each size gets its own summary, timed with the wall clock, 1..N threads.
+// Scaling efficiency is the speedup over one thread divided by the number of threads.
+// Large sizes are limited by memory bandwidth, so expect efficiency to fall off there.
+template <typename T>
+void test_matvecmul_threads(benchmark::thread_pool &pool, const std::string &myTypeName) {
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < pool.size(); threads *= 2)
+        threadCounts.push_back( threads );
+    threadCounts.push_back( pool.size() );
+    
+    // about a quarter of the work of the fixed size tests, for each thread count
+    const double workBudget = double(HEIGHT*WIDTH) * double(iterations) / 4.0;
+
+    for (size_t size : matvec_thread_sizes) {
+        std::vector<T> xx( size, T(init_value) );
+        std::vector<T> yy( size );
+        std::vector<T> zz( size * size, T(init_value) );
+        
+        int repeats = std::max( 1, int(workBudget / double(size * size)) );
+        
+        std::string name( myTypeName + " threaded matrix vector product " + std::to_string(size) );
+        double oneThread = 0.0;
+        
+        for (int threads : threadCounts) {
+            start_wall_timer();
+            for (int i = 0; i < repeats; ++i) {
+                std::fill( yy.begin(), yy.end(), T(0) );
+                matvecmul_threaded( pool, threads, &xx[0], &yy[0], &zz[0], size, size );
+            }
+            double elapsed = wall_timer();
+            
+            if (threads == 1)
+                oneThread = elapsed;
+            double efficiency = (elapsed > 0.0) ? 100.0 * oneThread / (elapsed * threads) : 0.0;
+            
+            char suffix[ 100 ];
+            snprintf( suffix, sizeof(suffix), " %d threads, %.0f%% efficiency", threads, efficiency );
+            gLabels.push_back( name + suffix );
+            record_result( elapsed, gLabels.back().c_str() );
+            
+            T expected = T(size) * T(init_value) * T(init_value);
+            if (!tolerance_equal<T>( yy[0], expected ) || !tolerance_equal<T>( yy[size-1], expected ))
+                printf("test %s failed\n", gLabels.back().c_str() );
+        }
+        
+        summarize( name.c_str(), int(size * size), repeats, kDontShowGMeans, kDontShowPenalty );
+    }
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+// Sparse matrix vector product
+// One generated matrix is converted to each storage format, and each kernel computes y = A * x.
+//    CSR         compressed rows, the common interchange format
+//    ELLPACK     every row padded to the longest row, stored column by column
+//                so consecutive rows can be processed together
+//    SELL-C-sigma    slices of C rows, each padded only to its own longest row,
+//                after sorting rows by length within windows of sigma rows
+// The column major kernels are written so the compiler can vectorize across rows.
+
+typedef uint32_t sparse_index;
+
+template <typename T>
+struct csr_matrix {
+    size_t rows, cols;
+    std::vector<sparse_index> row_start;       // rows+1 entries
+    std::vector<sparse_index> column;
+    std::vector<T> value;
+    
+    size_t nonzeros() const { return value.size(); }
+};
+
+template <typename T>
+struct ell_matrix {
+    size_t rows, cols, width;
+    std::vector<sparse_index> column;           // width x rows, column major
+    std::vector<T> value;
+};
+
+template <typename T>
+struct sell_matrix {
+    size_t rows, cols, slice_height, sigma;
+    std::vector<sparse_index> permutation;      // sorted position to original row
+    std::vector<size_t> slice_start;            // slices+1 entries
+    std::vector<sparse_index> slice_width;
+    std::vector<sparse_index> column;           // each slice is width x slice_height, column major
+    std::vector<T> value;
+};
+
+/******************************************************************************/
+
+enum sparsePattern { kSparseRandom, kSparseBanded, kSparsePowerLaw };
+
+// simple LCG, we only need reproducible and roughly uniform
+struct sparse_random {
+    uint64_t state;
+    explicit sparse_random( uint64_t seed ) : state( seed ) {}
+    uint32_t next() {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return uint32_t( state >> 32 );
+    }
+    double unit() { return (next() + 0.5) * (1.0 / 4294967296.0); }
+};
+
+// Random rows have 8 to 24 entries anywhere in the row.
+// Banded rows have 17 entries on the diagonal band, like a 1D stencil of radius 8.
+// Power law rows have a Pareto distributed length (alpha 2.2, minimum 4), like web and social graphs.
+template <typename T>
+void generate_sparse( csr_matrix<T> &matrix, size_t rows, size_t cols, sparsePattern pattern, uint64_t seed ) {
+    const size_t bandRadius = 8;
+    const size_t maxLength = std::min( cols, size_t(16384) );
+    sparse_random rng( seed );
+    std::vector<sparse_index> columns;
+
+    matrix.rows = rows;
+    matrix.cols = cols;
+    matrix.row_start.assign( 1, 0 );
+    matrix.column.clear();
+    matrix.value.clear();
+
+    for (size_t i = 0; i < rows; ++i) {
+        columns.clear();
+        if (pattern == kSparseBanded) {
+            size_t first = (i > bandRadius) ? (i - bandRadius) : 0;
+            size_t last = std::min( cols - 1, i + bandRadius );
+            for (size_t j = first; j <= last; ++j)
+                columns.push_back( sparse_index(j) );
+        } else {
+            size_t length;
+            if (pattern == kSparseRandom)
+                length = 8 + rng.next() % 17;
+            else
+                length = size_t( 4.0 * pow( rng.unit(), -1.0 / 1.2 ) );
+            length = std::min( length, maxLength );
+            for (size_t k = 0; k < length; ++k)
+                columns.push_back( sparse_index( rng.next() % cols ) );
+            std::sort( columns.begin(), columns.end() );
+            columns.erase( std::unique( columns.begin(), columns.end() ), columns.end() );
+        }
+        
+        for (auto j : columns) {
+            matrix.column.push_back( j );
+            matrix.value.push_back( T( 1 + (rng.next() & 3) ) );
+        }
+        matrix.row_start.push_back( sparse_index( matrix.column.size() ) );
+    }
+}
+
+/******************************************************************************/
+
+// returns false if the padding would be too large to be worth storing
+template <typename T>
+bool convert_to_ell( ell_matrix<T> &ell, const csr_matrix<T> &csr, double maxPadding ) {
+    size_t width = 0;
+    for (size_t i = 0; i < csr.rows; ++i)
+        width = std::max( width, size_t( csr.row_start[i+1] - csr.row_start[i] ) );
+    
+    ell.rows = csr.rows;
+    ell.cols = csr.cols;
+    ell.width = width;
+    ell.column.clear();
+    ell.value.clear();
+    if (double(width * csr.rows) > maxPadding * double(csr.nonzeros()))
+        return false;
+    
+    // padding reads x[0] and multiplies by zero
+    ell.column.assign( width * csr.rows, 0 );
+    ell.value.assign( width * csr.rows, T(0) );
+    for (size_t i = 0; i < csr.rows; ++i) {
+        size_t start = csr.row_start[i];
+        size_t length = csr.row_start[i+1] - start;
+        for (size_t k = 0; k < length; ++k) {
+            ell.column[ k*csr.rows + i ] = csr.column[ start + k ];
+            ell.value[ k*csr.rows + i ] = csr.value[ start + k ];
+        }
+    }
+    return true;
+}
+
+template <typename T>
+void convert_to_sell( sell_matrix<T> &sell, const csr_matrix<T> &csr, size_t sliceHeight, size_t sigma ) {
+    const size_t rows = csr.rows;
+    const size_t slices = (rows + sliceHeight - 1) / sliceHeight;
+    
+    sell.rows = rows;
+    sell.cols = csr.cols;
+    sell.slice_height = sliceHeight;
+    sell.sigma = sigma;
+    
+    // sort by decreasing length inside each window, so rows in a slice have similar lengths
+    sell.permutation.resize( rows );
+    for (size_t i = 0; i < rows; ++i)
+        sell.permutation[i] = sparse_index(i);
+    auto longer = [&csr]( sparse_index a, sparse_index b ) {
+        return (csr.row_start[a+1] - csr.row_start[a]) > (csr.row_start[b+1] - csr.row_start[b]);
+    };
+    for (size_t start = 0; start < rows; start += sigma)
+        std::stable_sort( sell.permutation.begin() + start,
+                        sell.permutation.begin() + std::min( rows, start + sigma ), longer );
+    
+    sell.slice_start.assign( 1, 0 );
+    sell.slice_width.clear();
+    for (size_t s = 0; s < slices; ++s) {
+        size_t width = 0;
+        for (size_t r = s*sliceHeight; r < std::min( rows, (s+1)*sliceHeight ); ++r) {
+            size_t row = sell.permutation[r];
+            width = std::max( width, size_t( csr.row_start[row+1] - csr.row_start[row] ) );
+        }
+        sell.slice_width.push_back( sparse_index(width) );
+        sell.slice_start.push_back( sell.slice_start.back() + width * sliceHeight );
+    }
+    
+    sell.column.assign( sell.slice_start.back(), 0 );
+    sell.value.assign( sell.slice_start.back(), T(0) );
+    for (size_t r = 0; r < rows; ++r) {
+        size_t s = r / sliceHeight, lane = r % sliceHeight;
+        size_t row = sell.permutation[r];
+        size_t start = csr.row_start[row];
+        size_t length = csr.row_start[row+1] - start;
+        for (size_t k = 0; k < length; ++k) {
+            sell.column[ sell.slice_start[s] + k*sliceHeight + lane ] = csr.column[ start + k ];
+            sell.value[ sell.slice_start[s] + k*sliceHeight + lane ] = csr.value[ start + k ];
+        }
+    }
+}
+
+/******************************************************************************/
+
+template <typename T>
+void spmv_csr_rows( const csr_matrix<T> &A, const T *x, T *y, size_t rowStart, size_t rowEnd ) {
+    const sparse_index *row_start = A.row_start.data();
+    const sparse_index *column = A.column.data();
+    const T *value = A.value.data();
+    for (size_t i = rowStart; i < rowEnd; ++i) {
+        T sum = T(0);
+        for (sparse_index k = row_start[i]; k < row_start[i+1]; ++k)
+            sum += value[k] * x[ column[k] ];
+        y[i] = sum;
+    }
+}
+
+// one row at a time, walking down the columns of the ELL storage
+template <typename T>
+void spmv_ell_rows( const ell_matrix<T> &A, const T *x, T *y, size_t rowStart, size_t rowEnd ) {
+    const size_t rows = A.rows, width = A.width;
+    const sparse_index *column = A.column.data();
+    const T *value = A.value.data();
+    for (size_t i = rowStart; i < rowEnd; ++i) {
+        T sum = T(0);
+        for (size_t k = 0; k < width; ++k)
+            sum += value[k*rows + i] * x[ column[k*rows + i] ];
+        y[i] = sum;
+    }
+}
+
+// a range of rows at a time, the inner loop runs across rows and vectorizes (gathering from x)
+template <typename T>
+void spmv_ell_columns( const ell_matrix<T> &A, const T *x, T *y, size_t rowStart, size_t rowEnd ) {
+    const size_t rows = A.rows, width = A.width;
+    const sparse_index *column = A.column.data();
+    const T *value = A.value.data();
+    for (size_t i = rowStart; i < rowEnd; ++i)
+        y[i] = T(0);
+    for (size_t k = 0; k < width; ++k) {
+        const sparse_index *columnK = column + k*rows;
+        const T *valueK = value + k*rows;
+        for (size_t i = rowStart; i < rowEnd; ++i)
+            y[i] += valueK[i] * x[ columnK[i] ];
+    }
+}
+
+// a slice at a time, with the slice rows in a small accumulator that vectorizes
+const size_t kSellMaxSlice = 64;
+
+template <typename T>
+void spmv_sell_slices( const sell_matrix<T> &A, const T *x, T *y, size_t sliceStart, size_t sliceEnd ) {
+    const size_t height = A.slice_height;
+    const sparse_index *column = A.column.data();
+    const T *value = A.value.data();
+    for (size_t s = sliceStart; s < sliceEnd; ++s) {
+        T sum[ kSellMaxSlice ];
+        for (size_t r = 0; r < height; ++r)
+            sum[r] = T(0);
+        
+        const size_t base = A.slice_start[s];
+        const size_t width = A.slice_width[s];
+        for (size_t k = 0; k < width; ++k) {
+            const sparse_index *columnK = column + base + k*height;
+            const T *valueK = value + base + k*height;
+            for (size_t r = 0; r < height; ++r)
+                sum[r] += valueK[r] * x[ columnK[r] ];
+        }
+        
+        size_t count = std::min( height, A.rows - s*height );
+        for (size_t r = 0; r < count; ++r)
+            y[ A.permutation[ s*height + r ] ] = sum[r];
+    }
+}
+
+/******************************************************************************/
+
+// Hand out chunks of rows (or slices) to the threads, small enough to balance power law rows.
+template <typename KERNEL>
+void spmv_threaded( benchmark::thread_pool &pool, int threads, size_t count, size_t chunk, KERNEL kernel ) {
+    if (threads <= 1) {
+        kernel( 0, count );
+        return;
+    }
+    const int chunks = int( (count + chunk - 1) / chunk );
+    std::atomic<int> next( 0 );
+    pool.run( threads, [&]( int ) {
+        int index;
+        while ((index = next.fetch_add(1)) < chunks) {
+            size_t start = index * chunk;
+            kernel( start, std::min( count, start + chunk ) );
+        }
+    } );
+}
+
+/******************************************************************************/
+
+// Streaming read bandwidth, the roofline for SpMV since it does 2 flops per 12 or more bytes.
+// The buffer is sized to miss in the last level cache.
+double measure_read_bandwidth( benchmark::thread_pool &pool, int threads ) {
+    benchmark::cache_sizes caches = benchmark::detect_cache_sizes();
+    size_t bytes = std::min( std::max( 2 * caches.L3, size_t(64) << 20 ), size_t(256) << 20 );
+    size_t count = bytes / sizeof(uint64_t);
+    size_t chunk = count / (4*threads) + 1;
+    std::vector<uint64_t> buffer( count, 1 );
+    std::vector<uint64_t> sums( 8 * (4*threads + 1), 0 );     // one per chunk, spaced out to avoid false sharing
+    
+    double best = 1.0e30;
+    for (int run = 0; run < 3; ++run) {
+        start_wall_timer();
+        spmv_threaded( pool, threads, count, chunk, [&]( size_t start, size_t end ) {
+            uint64_t sum = 0;
+            for (size_t i = start; i < end; ++i)
+                sum += buffer[i];
+            sums[ 8 * (start / chunk) ] += sum;
+        } );
+        best = std::min( best, wall_timer() );
+    }
+    
+    uint64_t total = 0;
+    for (auto sum : sums)
+        total += sum;
+    if (total != 3 * count)
+        printf("read bandwidth test failed\n");
+    
+    return double(bytes) / best;
+}
+
+/******************************************************************************/
+
+template <typename T>
+bool sparse_result_equal( std::vector<T> &result, std::vector<T> &expected ) {
+    for (size_t i = 0; i < result.size(); ++i)
+        if (!tolerance_equal<T>( result[i], expected[i] ))
+            return false;
+    return true;
+}
+
+// Effective bandwidth counts the bytes a perfect CSR kernel must move: every nonzero and its
+//    index, the row offsets, x once and y once. Padding and extra passes over x show up as lower numbers.
+template <typename T, typename KERNEL>
+void test_spmv( const csr_matrix<T> &csr, std::vector<T> &y, std::vector<T> &expected,
+                int threads, double bandwidth, int repeats, KERNEL kernel, const std::string &label ) {
+    start_wall_timer();
+    for (int i = 0; i < repeats; ++i)
+        kernel();
+    double elapsed = wall_timer();
+    
+    double bytes = double(csr.nonzeros()) * (sizeof(T) + sizeof(sparse_index))
+                    + double(csr.rows + 1) * sizeof(sparse_index)
+                    + double(csr.cols + csr.rows) * sizeof(T);
+    double effective = (elapsed > 0.0) ? (bytes * repeats / elapsed) : 0.0;
+    
+    char suffix[ 100 ];
+    snprintf( suffix, sizeof(suffix), " %d threads, %.1f GB/s, %.0f%% of roofline",
+            threads, effective * 1.0e-9, 100.0 * effective / bandwidth );
+    gLabels.push_back( label + suffix );
+    record_result( elapsed, gLabels.back().c_str() );
+    
+    if (!sparse_result_equal( y, expected ))
+        printf("test %s failed\n", gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template <typename T>
+void test_sparse_matvec( benchmark::thread_pool &pool, const std::string &myTypeName ) {
+    // large enough to be memory bound, about 4 million nonzeros
+    const size_t rows = 256 * 1024;
+    const size_t sliceHeight = std::min( kSellMaxSlice, 64 / sizeof(T) );     // one cache line of values
+    const size_t sigma = 1024;
+    const size_t rowChunk = 1024;
+    
+    const int maxThreads = pool.size();
+    const double bandwidth1 = measure_read_bandwidth( pool, 1 );
+    const double bandwidthN = measure_read_bandwidth( pool, maxThreads );
+    printf("\nread bandwidth %.1f GB/s 1 thread, %.1f GB/s %d threads\n",
+            bandwidth1 * 1.0e-9, bandwidthN * 1.0e-9, maxThreads );
+    
+    const struct { sparsePattern pattern; const char *name; } patterns[] = {
+        { kSparseRandom, "random" },
+        { kSparseBanded, "banded" },
+        { kSparsePowerLaw, "power law" },
+    };
+    
+    for (const auto &item : patterns) {
+        csr_matrix<T> csr;
+        ell_matrix<T> ell;
+        sell_matrix<T> sell;
+        generate_sparse( csr, rows, rows, item.pattern, 42 );
+        bool haveELL = convert_to_ell( ell, csr, 4.0 );
+        convert_to_sell( sell, csr, sliceHeight, sigma );
+        
+        std::vector<T> x( rows ), y( rows ), expected( rows );
+        for (size_t i = 0; i < rows; ++i)
+            x[i] = T( 1 + (i % 7) );
+        spmv_csr_rows( csr, x.data(), expected.data(), 0, rows );
+        
+        // roughly the same number of multiply-adds as the dense tests
+        const size_t nonzeros = csr.nonzeros();
+        const int repeats = std::max( 1, int( double(HEIGHT*WIDTH) * double(iterations) / (8.0 * nonzeros) ) );
+        const size_t slices = sell.slice_width.size();
+        
+        std::string name( myTypeName + " sparse matrix vector product " + item.name );
+        printf("\n%s: %zu rows, %zu nonzeros, ELL width %zu, SELL-%zu-%zu padding %.2f\n",
+                name.c_str(), rows, nonzeros, ell.width, sliceHeight, sigma,
+                double(sell.value.size()) / double(nonzeros) );
+        
+        for (int threads : { 1, maxThreads }) {
+            const double bandwidth = (threads == 1) ? bandwidth1 : bandwidthN;
+            
+            test_spmv( csr, y, expected, threads, bandwidth, repeats, [&]() {
+                    spmv_threaded( pool, threads, rows, rowChunk, [&]( size_t start, size_t end ) {
+                        spmv_csr_rows( csr, x.data(), y.data(), start, end ); } ); },
+                name + " CSR" );
+            
+            if (haveELL) {
+                test_spmv( csr, y, expected, threads, bandwidth, repeats, [&]() {
+                        spmv_threaded( pool, threads, rows, rowChunk, [&]( size_t start, size_t end ) {
+                            spmv_ell_rows( ell, x.data(), y.data(), start, end ); } ); },
+                    name + " ELL rows" );
+                test_spmv( csr, y, expected, threads, bandwidth, repeats, [&]() {
+                        spmv_threaded( pool, threads, rows, rowChunk, [&]( size_t start, size_t end ) {
+                            spmv_ell_columns( ell, x.data(), y.data(), start, end ); } ); },
+                    name + " ELL columns" );
+            }
+            
+            test_spmv( csr, y, expected, threads, bandwidth, repeats, [&]() {
+                    spmv_threaded( pool, threads, slices, rowChunk / sliceHeight, [&]( size_t start, size_t end ) {
+                        spmv_sell_slices( sell, x.data(), y.data(), start, end ); } ); },
+                name + " SELL-C-sigma" );
+            
+            if (maxThreads == 1)
+                break;
+        }
+        
+        if (!haveELL)
+            printf("%s ELL skipped, padding would be %.1f times the nonzeros\n",
+                    name.c_str(), double(ell.width * rows) / double(nonzeros) );
+
+        summarize( name.c_str(), int(nonzeros), repeats, kDontShowGMeans, kDontShowPenalty );
+    }
+}
+
 /******************************************************************************/
 
 // test/plot cache performance for different block sizes
@@ -1308,7 +1854,7 @@ void plot_cacheblock_sizes() {
 /******************************************************************************/
 
 template< typename T>
-void TestOneType()
+void TestOneType(benchmark::thread_pool &pool)
 {
     std::string myTypeName( getTypeName<T>() );
     
@@ -1363,6 +1909,9 @@ void TestOneType()
     std::string temp1( myTypeName + " matrix vector product" );
     summarize( temp1.c_str(), (HEIGHT*WIDTH), iterations, kDontShowGMeans, kDontShowPenalty );
 
+    verify_matvecmul_threaded( dataX, dataY, dataZ, HEIGHT, WIDTH );
+    test_matvecmul_threads<T>( pool, myTypeName );
+
 }
 
 /******************************************************************************/
@@ -1382,16 +1931,21 @@ int main(int argc, char** argv) {
 
 
 
-    TestOneType<int32_t>();
-    TestOneType<float>();
+    benchmark::thread_pool pool;
+
+    TestOneType<int32_t>( pool );
+    TestOneType<float>( pool );
     
     iterations /= 2;
-    TestOneType<double>();
+    TestOneType<double>( pool );
+
+    test_sparse_matvec<float>( pool, getTypeName<float>() );
+    test_sparse_matvec<double>( pool, getTypeName<double>() );
 
 
 #if WORKS_BUT_SLOW
-    TestOneType<int64_t>();
-    TestOneType<long double>();
+    TestOneType<int64_t>( pool );
+    TestOneType<long double>( pool );
 #endif
 
 
@@ -14,6 +14,12 @@ Assumptions:
     2) The compiler may recognize ineffecient minimum or maximum idioms and substitute efficient methods.
 
     3) The compiler will unroll and vectorize as needed to get best performance.
+
+    4) Finding the minimum or maximum in a deque or list should cost little more than reaching the data.
+
+    5) Finding a position (argmin or argmax) should vectorize, keeping a position per lane.
+
+    6) Selecting the largest k values should cost much less than sorting, and be close to one pass for small k.
  
 
 Conclusions:
@@ -30,6 +36,13 @@ NOTE - min or max between two sequences is tested in minmax.cpp.
 
 NOTE - pin values in sequence, see minmax.cpp
 
+NOTE - The container tests run the finders and functors over vector, deque, list, forward_list and our own linked lists.
+        Position finders reach linked lists through a forward_indexer.
+        Pooled lists can also be searched in pool order, one block of nodes at a time, with plain pointers.
+        Portable code cannot see the blocks inside a std::deque, so deques only use their iterators.
+
+NOTE - Top-k returns the k largest values in descending order.
+
 */
 
 /******************************************************************************/
@@ -41,12 +54,19 @@ NOTE - pin values in sequence, see minmax.cpp
 #include <cmath>
 #include <cstdlib>
 #include <algorithm>
+#include <type_traits>
+#include <vector>
 #include <deque>
+#include <list>
+#include <forward_list>
+#include <functional>
+#include <limits>
 #include <string>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_algorithms.h"
 #include "benchmark_typenames.h"
+#include "benchmark_containers.h"
 
 /******************************************************************************/
 /******************************************************************************/
@@ -230,6 +250,30 @@ std::pair<size_t,size_t> find_minmax_position( Iter first, size_t count) {
     return result;
 }
 
+/******************************************************************************/
+
+// unordered: search the node pool of a pooled list, one block of nodes at a time
+// unused nodes are replaced by a value already in the list, so they can't change the result
+template< typename PooledList, typename T >
+std::pair<T,T> find_minmax_pool_blocks( const PooledList *list, const PooledList * ) {
+    std::pair<T,T> result( list->front(), list->front() );
+    list->for_each_block( [&result]( const auto *node, const auto *node_end ) {
+        const T seed_value = result.first;
+        T min_value = result.first;
+        T max_value = result.second;
+        for ( ; node != node_end; ++node) {
+            T value = node->in_use() ? node->value : seed_value;
+            if (value < min_value)
+                min_value = value;
+            if (value > max_value)
+                max_value = value;
+        }
+        result.first = min_value;
+        result.second = max_value;
+    } );
+    return result;
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -1943,6 +1987,741 @@ void test_minmax_position_unrolled(T* first, size_t count, const std::string lab
 /******************************************************************************/
 /******************************************************************************/
 
+/*
+    Position finding that vectorizes
+    Each lane keeps its own best value and position, and the lanes are combined at the end.
+    Ties go to the lowest position, to match min_element and max_element.
+*/
+
+template< bool FindMax, typename T >
+inline bool is_better( T a, T b ) {
+    return FindMax ? (a > b) : (a < b);
+}
+
+/******************************************************************************/
+
+// combine lanes, preferring the earlier position on ties
+template< bool FindMax, typename T, typename Position >
+size_t reduce_lane_positions( const T *values, const Position *positions, size_t lanes ) {
+    T best = values[0];
+    size_t best_position = size_t(positions[0]);
+    for (size_t k = 1; k < lanes; ++k) {
+        if (is_better<FindMax>( values[k], best )
+            || (values[k] == best && size_t(positions[k]) < best_position)) {
+            best = values[k];
+            best_position = size_t(positions[k]);
+        }
+    }
+    return best_position;
+}
+
+/******************************************************************************/
+
+template< bool FindMax, typename T >
+size_t find_extreme_position_scalar( const T *first, size_t count ) {
+    T best = first[0];
+    size_t best_position = 0;
+    for (size_t k = 1; k < count; ++k) {
+        if (is_better<FindMax>( first[k], best )) {
+            best = first[k];
+            best_position = k;
+        }
+    }
+    return best_position;
+}
+
+/******************************************************************************/
+
+// find the value with a reduction (which vectorizes), then search for it
+template< bool FindMax, typename T >
+size_t find_extreme_position_two_pass( const T *first, size_t count ) {
+    T best = first[0];
+    for (size_t k = 1; k < count; ++k)
+        best = is_better<FindMax>( first[k], best ) ? first[k] : best;
+    return size_t( std::find( first, first+count, best ) - first );
+}
+
+/******************************************************************************/
+
+// reduce each block to a value, remember the best block, then search only that block
+// touches the data a little more than once, instead of twice
+template< bool FindMax, typename T >
+size_t find_extreme_position_blocks( const T *first, size_t count ) {
+    const size_t block_size = 256;
+    T best = first[0];
+    size_t best_block = 0;
+    
+    for (size_t start = 0; start < count; start += block_size) {
+        const size_t end = std::min( count, start + block_size );
+        T block_best = first[start];
+        for (size_t k = start+1; k < end; ++k)
+            block_best = is_better<FindMax>( first[k], block_best ) ? first[k] : block_best;
+        if (is_better<FindMax>( block_best, best )) {
+            best = block_best;
+            best_block = start;
+        }
+    }
+    
+    return size_t( std::find( first+best_block, first+count, best ) - first );
+}
+
+/******************************************************************************/
+
+// 8 lanes written out so the compiler can turn them into vector compares and selects
+template< bool FindMax, typename T >
+size_t find_extreme_position_lanes( const T *first, size_t count ) {
+    const size_t lanes = 8;
+    if (count < lanes)
+        return find_extreme_position_scalar<FindMax>( first, count );
+    
+    T best[ lanes ];
+    size_t position[ lanes ];
+    size_t j, k;
+    
+    for (k = 0; k < lanes; ++k) {
+        best[k] = first[k];
+        position[k] = k;
+    }
+    
+    for (j = lanes; j < (count & ~(lanes-1)); j += lanes) {
+        for (k = 0; k < lanes; ++k) {
+            T value = first[j+k];
+            bool better = is_better<FindMax>( value, best[k] );
+            best[k] = better ? value : best[k];
+            position[k] = better ? (j+k) : position[k];
+        }
+    }
+    
+    size_t result = reduce_lane_positions<FindMax>( best, position, lanes );
+    T result_value = first[result];
+    for ( ; j < count; ++j) {
+        if (is_better<FindMax>( first[j], result_value )) {
+            result_value = first[j];
+            result = j;
+        }
+    }
+    return result;
+}
+
+/******************************************************************************/
+
+// minimum and maximum positions in one pass
+template< typename T >
+std::pair<size_t,size_t> find_minmax_position_lanes( const T *first, size_t count ) {
+    const size_t lanes = 8;
+    if (count < lanes)
+        return std::pair<size_t,size_t>( find_extreme_position_scalar<false>( first, count ),
+                                         find_extreme_position_scalar<true>( first, count ) );
+    
+    T min_value[ lanes ], max_value[ lanes ];
+    size_t min_position[ lanes ], max_position[ lanes ];
+    size_t j, k;
+    
+    for (k = 0; k < lanes; ++k) {
+        min_value[k] = max_value[k] = first[k];
+        min_position[k] = max_position[k] = k;
+    }
+    
+    for (j = lanes; j < (count & ~(lanes-1)); j += lanes) {
+        for (k = 0; k < lanes; ++k) {
+            T value = first[j+k];
+            bool smaller = value < min_value[k];
+            bool larger = value > max_value[k];
+            min_value[k] = smaller ? value : min_value[k];
+            min_position[k] = smaller ? (j+k) : min_position[k];
+            max_value[k] = larger ? value : max_value[k];
+            max_position[k] = larger ? (j+k) : max_position[k];
+        }
+    }
+    
+    size_t minpos = reduce_lane_positions<false>( min_value, min_position, lanes );
+    size_t maxpos = reduce_lane_positions<true>( max_value, max_position, lanes );
+    T min_result = first[minpos];
+    T max_result = first[maxpos];
+    for ( ; j < count; ++j) {
+        if (first[j] < min_result) {
+            min_result = first[j];
+            minpos = j;
+        }
+        if (first[j] > max_result) {
+            max_result = first[j];
+            maxpos = j;
+        }
+    }
+    return std::pair<size_t,size_t>( minpos, maxpos );
+}
+
+/******************************************************************************/
+
+// minimum and maximum positions, from block values
+template< typename T >
+std::pair<size_t,size_t> find_minmax_position_blocks( const T *first, size_t count ) {
+    const size_t block_size = 256;
+    T min_value = first[0];
+    T max_value = first[0];
+    size_t min_block = 0;
+    size_t max_block = 0;
+    
+    for (size_t start = 0; start < count; start += block_size) {
+        const size_t end = std::min( count, start + block_size );
+        T block_min = first[start];
+        T block_max = first[start];
+        for (size_t k = start+1; k < end; ++k) {
+            block_min = (first[k] < block_min) ? first[k] : block_min;
+            block_max = (first[k] > block_max) ? first[k] : block_max;
+        }
+        if (block_min < min_value) {
+            min_value = block_min;
+            min_block = start;
+        }
+        if (block_max > max_value) {
+            max_value = block_max;
+            max_block = start;
+        }
+    }
+    
+    return std::pair<size_t,size_t>( size_t( std::find( first+min_block, first+count, min_value ) - first ),
+                                     size_t( std::find( first+max_block, first+count, max_value ) - first ) );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+template < typename T, typename Finder >
+void test_min_position_finder(const T* first, size_t count, Finder func, const std::string label) {
+    
+    // the data doesn't change, so keep the compiler from moving the search out of the loop
+    const T * volatile source = first;
+    
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        size_t minpos = func( source, count );
+        check_min_position( minpos, label );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template < typename T, typename Finder >
+void test_max_position_finder(const T* first, size_t count, Finder func, const std::string label) {
+    
+    const T * volatile source = first;
+    
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        size_t maxpos = func( source, count );
+        check_max_position( maxpos, label );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template < typename T, typename Finder >
+void test_minmax_position_finder(const T* first, size_t count, Finder func, const std::string label) {
+    
+    const T * volatile source = first;
+    
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        std::pair<size_t,size_t> result = func( source, count );
+        check_min_position( result.first, label );
+        check_max_position( result.second, label );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Top-k: the k largest values, in descending order.
+    Selection only has to order the winners, so it should cost much less than a full sort.
+    scratch is allocated once by the caller, so the timing doesn't include allocation.
+*/
+
+template< typename T >
+void topk_partial_sort_copy( const T *first, size_t count, size_t k, T *result, std::vector<T> & ) {
+    std::partial_sort_copy( first, first+count, result, result+k, std::greater<T>() );
+}
+
+/******************************************************************************/
+
+template< typename T >
+void topk_partial_sort( const T *first, size_t count, size_t k, T *result, std::vector<T> &scratch ) {
+    scratch.assign( first, first+count );
+    std::partial_sort( scratch.begin(), scratch.begin()+k, scratch.end(), std::greater<T>() );
+    std::copy( scratch.begin(), scratch.begin()+k, result );
+}
+
+/******************************************************************************/
+
+template< typename T >
+void topk_nth_element( const T *first, size_t count, size_t k, T *result, std::vector<T> &scratch ) {
+    scratch.assign( first, first+count );
+    std::nth_element( scratch.begin(), scratch.begin()+(k-1), scratch.end(), std::greater<T>() );
+    std::sort( scratch.begin(), scratch.begin()+k, std::greater<T>() );
+    std::copy( scratch.begin(), scratch.begin()+k, result );
+}
+
+/******************************************************************************/
+
+// keep the k largest seen in a min-heap, the smallest winner is on top
+template< typename T >
+void topk_heap( const T *first, size_t count, size_t k, T *result, std::vector<T> &scratch ) {
+    scratch.assign( first, first+k );
+    std::make_heap( scratch.begin(), scratch.end(), std::greater<T>() );
+    for (size_t j = k; j < count; ++j) {
+        if (first[j] > scratch.front()) {
+            std::pop_heap( scratch.begin(), scratch.end(), std::greater<T>() );
+            scratch.back() = first[j];
+            std::push_heap( scratch.begin(), scratch.end(), std::greater<T>() );
+        }
+    }
+    std::sort_heap( scratch.begin(), scratch.end(), std::greater<T>() );
+    std::copy( scratch.begin(), scratch.end(), result );
+}
+
+/******************************************************************************/
+
+// replace the top of the heap and sift down once, instead of pop and push
+template< typename T >
+void topk_heap_replace( const T *first, size_t count, size_t k, T *result, std::vector<T> &scratch ) {
+    scratch.assign( first, first+k );
+    T *heap = scratch.data();
+    std::make_heap( heap, heap+k, std::greater<T>() );
+    
+    for (size_t j = k; j < count; ++j) {
+        T value = first[j];
+        if (value <= heap[0])
+            continue;
+        size_t parent = 0;
+        size_t child = 1;
+        while (child < k) {
+            if ((child+1) < k && heap[child+1] < heap[child])
+                ++child;
+            if (!(heap[child] < value))
+                break;
+            heap[parent] = heap[child];
+            parent = child;
+            child = 2*parent + 1;
+        }
+        heap[parent] = value;
+    }
+    
+    std::sort_heap( heap, heap+k, std::greater<T>() );
+    std::copy( heap, heap+k, result );
+}
+
+/******************************************************************************/
+
+// Most values lose to the current k'th largest, so test a block at a time with a compare that vectorizes,
+// and only collect candidates from blocks that have a winner.
+// When the candidate buffer fills, select the best k again to raise the threshold.
+template< typename T >
+void topk_threshold( const T *first, size_t count, size_t k, T *result, std::vector<T> &scratch ) {
+    const size_t block = 16;
+    const size_t capacity = 2*k + block;
+    scratch.resize( capacity );
+    T *buffer = scratch.data();
+    
+    std::copy( first, first+k, buffer );
+    std::nth_element( buffer, buffer+(k-1), buffer+k, std::greater<T>() );
+    T threshold = buffer[k-1];
+    size_t used = k;
+    size_t j = k;
+    
+    for ( ; (j + block) <= count; j += block) {
+        bool any = false;
+        for (size_t m = 0; m < block; ++m)
+            any |= (first[j+m] > threshold);
+        if (!any)
+            continue;
+        
+        for (size_t m = 0; m < block; ++m) {
+            buffer[used] = first[j+m];
+            used += (first[j+m] > threshold);
+        }
+        
+        if (used > (capacity - block)) {
+            std::nth_element( buffer, buffer+(k-1), buffer+used, std::greater<T>() );
+            threshold = buffer[k-1];
+            used = k;
+        }
+    }
+    
+    for ( ; j < count; ++j)
+        if (first[j] > threshold)
+            buffer[used++] = first[j];
+    
+    std::nth_element( buffer, buffer+(k-1), buffer+used, std::greater<T>() );
+    std::sort( buffer, buffer+k, std::greater<T>() );
+    std::copy( buffer, buffer+k, result );
+}
+
+/******************************************************************************/
+
+// compare exchange without branches, so whole stages of the network vectorize
+template< bool Descending, typename T >
+inline void compare_exchange( T &a, T &b ) {
+    T low = (b < a) ? b : a;
+    T high = (b < a) ? a : b;
+    a = Descending ? high : low;
+    b = Descending ? low : high;
+}
+
+/******************************************************************************/
+
+// count must be a power of 2
+// every comparator goes the same direction, because the first step of each merge compares mirrored positions
+template< bool Descending, typename T >
+void bitonic_sort( T *data, size_t count ) {
+    for (size_t size = 2; size <= count; size *= 2) {
+        for (size_t start = 0; start < count; start += size)
+            for (size_t m = 0; m < size/2; ++m)
+                compare_exchange<Descending>( data[start+m], data[start+size-1-m] );
+        for (size_t stride = size/4; stride > 0; stride /= 2)
+            for (size_t start = 0; start < count; start += 2*stride)
+                for (size_t m = 0; m < stride; ++m)
+                    compare_exchange<Descending>( data[start+m], data[start+m+stride] );
+    }
+}
+
+/******************************************************************************/
+
+// Keep the best K sorted descending.  Sort each new block of K ascending,
+// take the larger of each mirrored pair (a bitonic sequence holding the best K),
+// then sort that with the last half of a bitonic merge.
+// K is k rounded up to a power of 2, and a short last block is padded with the lowest value.
+// Blocks without a value above the current K'th are skipped.
+template< typename T >
+void topk_bitonic( const T *first, size_t count, size_t k, T *result, std::vector<T> &scratch ) {
+    size_t K = 1;
+    while (K < k)
+        K *= 2;
+    if (count < K) {
+        std::partial_sort_copy( first, first+count, result, result+k, std::greater<T>() );
+        return;
+    }
+    
+    scratch.resize( 2*K );
+    T *top = scratch.data();
+    T *block = top + K;
+    
+    std::copy( first, first+K, top );
+    bitonic_sort<true>( top, K );
+    
+    for (size_t j = K; j < count; j += K) {
+        const size_t length = std::min( K, count - j );
+        
+        // most blocks have no winners once the top fills up
+        bool any = false;
+        for (size_t m = 0; m < length; ++m)
+            any |= (first[j+m] > top[K-1]);
+        if (!any)
+            continue;
+        
+        std::copy( first+j, first+j+length, block );
+        std::fill( block+length, block+K, std::numeric_limits<T>::lowest() );
+        bitonic_sort<false>( block, K );
+        
+        for (size_t m = 0; m < K; ++m)
+            top[m] = (block[m] > top[m]) ? block[m] : top[m];
+        
+        for (size_t stride = K/2; stride > 0; stride /= 2)
+            for (size_t start = 0; start < K; start += 2*stride)
+                for (size_t m = 0; m < stride; ++m)
+                    compare_exchange<true>( top[start+m], top[start+m+stride] );
+    }
+    
+    std::copy( top, top+k, result );
+}
+
+/******************************************************************************/
+
+template < typename T, typename Selector >
+void test_topk(const T* first, size_t count, size_t k, Selector func, const T *expected, const std::string label) {
+    
+    std::vector<T> scratch;
+    std::vector<T> result( k );
+    scratch.reserve( count + 2*k + 16 );
+    
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        func( first, count, k, result.data(), scratch );
+        if (!std::equal( result.begin(), result.end(), expected ))
+            printf("test %s failed\n", label.c_str());
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+// Container tests
+// Iter only needs to be a forward iterator, position finders use an indexed iterator for the same data
+
+template < typename T, typename Iter >
+void test_container_min_element(Iter first, Iter last, const std::string label) {
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        Iter min_value = std::min_element( first, last );
+        check_min_result( T(*min_value), label );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template < typename T, typename Iter >
+void test_container_max_element(Iter first, Iter last, const std::string label) {
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        Iter max_value = std::max_element( first, last );
+        check_max_result( T(*max_value), label );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template < typename T, typename Iter >
+void test_container_minmax_element(Iter first, Iter last, const std::string label) {
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        auto result = std::minmax_element( first, last );
+        check_min_result( T(*(result.first)), label );
+        check_max_result( T(*(result.second)), label );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template < typename T, typename Iter, typename MinMaxFinder >
+void test_container_minmax(Iter first, Iter last, MinMaxFinder finder, const std::string label) {
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        std::pair<T,T> result = finder( first, last );
+        check_min_result( result.first, label );
+        check_max_result( result.second, label );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template < typename T, typename Iter, typename MinFunctor >
+void test_container_value(Iter first, Iter last, MinFunctor findMin, const std::string label)
+{
+    const bool isMax( findMin( 4, 2 ) == 4 );
+    
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        Iter current = first;
+        T min_value = *current++;
+        while (current != last) {
+            min_value = findMin( *current++, min_value );
+        }
+        
+        if (isMax)
+            check_max_result( min_value, label);
+        else
+            check_min_result( min_value, label);
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+template < typename T, typename Iter >
+void test_container_positions(Iter first, size_t count, const std::string label)
+{
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        check_min_position( find_minimum_position( first, count ), label );
+        check_max_position( find_maximum_position( first, count ), label );
+        check_max_last_position( find_maximum_last_position( first, count ), label );
+        auto result = find_minmax_position<Iter,T>( first, count );
+        check_min_position( result.first, label );
+        check_max_position( result.second, label );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+// the bitwise functors only work for integers
+template < typename T, typename Iter >
+void TestContainerBitwiseFunctors( Iter first, Iter last, const std::string &label, std::true_type )
+{
+    test_container_value<T>( first, last, min_functor3<T>(), label + " minimum value sequence5");
+    test_container_value<T>( first, last, min_functor4<T>(), label + " minimum value sequence6");
+    test_container_value<T>( first, last, max_functor3<T>(), label + " maximum value sequence5");
+    test_container_value<T>( first, last, max_functor4<T>(), label + " maximum value sequence6");
+}
+
+template < typename T, typename Iter >
+void TestContainerBitwiseFunctors( Iter, Iter, const std::string &, std::false_type ) {}
+
+/******************************************************************************/
+
+// every finder and functor, on one container
+template < typename T, typename Iter, typename IndexIter >
+void TestOneContainer( Iter first, Iter last, IndexIter indexed, const std::string label )
+{
+    test_container_min_element<T>( first, last, label + " minimum value std::min_element");
+    test_container_max_element<T>( first, last, label + " maximum value std::max_element");
+    test_container_minmax_element<T>( first, last, label + " minmax value std::minmax_element");
+    test_container_minmax<T>( first, last, find_minmax<Iter,T>, label + " minmax value find_minmax");
+    
+    test_container_value<T>( first, last, min_std_functor<T>(), label + " minimum value std::min");
+    test_container_value<T>( first, last, min_functor1<T>(), label + " minimum value sequence3");
+    test_container_value<T>( first, last, min_functor2<T>(), label + " minimum value sequence4");
+    test_container_value<T>( first, last, min_functor5<T>(), label + " minimum value sequence7");
+    test_container_value<T>( first, last, min_functor6<T>(), label + " minimum value sequence8");
+    
+    test_container_value<T>( first, last, max_std_functor<T>(), label + " maximum value std::max");
+    test_container_value<T>( first, last, max_functor1<T>(), label + " maximum value sequence3");
+    test_container_value<T>( first, last, max_functor2<T>(), label + " maximum value sequence4");
+    test_container_value<T>( first, last, max_functor5<T>(), label + " maximum value sequence7");
+    test_container_value<T>( first, last, max_functor6<T>(), label + " maximum value sequence8");
+    
+    TestContainerBitwiseFunctors<T>( first, last, label, std::is_integral<T>() );
+    
+    test_container_positions<T>( indexed, SIZE, label + " minmax positions");
+}
+
+/******************************************************************************/
+
+// linked lists reach the position finders through a forward_indexer
+template < typename T, typename Iter >
+void TestOneForwardContainer( Iter first, Iter last, const std::string label )
+{
+    forward_cursor<Iter> cursor( first );
+    TestOneContainer<T>( first, last, forward_indexer<Iter>( cursor ), label );
+}
+
+/******************************************************************************/
+
+template < typename T, typename PooledList >
+void TestOnePooledList( PooledList &list, const std::string label )
+{
+    TestOneForwardContainer<T>( list.cbegin(), list.cend(), label );
+    test_container_minmax<T>( &list, &list, find_minmax_pool_blocks<PooledList,T>, label + " minmax value pool blocks");
+}
+
+/******************************************************************************/
+
+// run the value and position finders over each standard sequence container and our own linked lists, pooled and not
+template<typename T>
+void TestContainers()
+{
+    std::string myTypeName( getTypeName<T>() );
+    const int base_iterations = iterations;
+    
+    T data[SIZE];
+
+    // seed the random number generator so we get repeatable results
+    scrand( (int)init_value + 123 );
+    fill_random( data, data+SIZE );
+    
+    gMinResult = find_minimum<const T*,T>( data, data+SIZE );
+    gMaxResult = find_maximum<const T*,T>( data, data+SIZE );
+    gMinPosition = find_minimum_position( data, SIZE );
+    gMaxPosition = find_maximum_position( data, SIZE );
+    gMaxLastPosition = find_maximum_last_position( data, SIZE );
+    
+    sequence_containers<T> containers( data, data+SIZE );
+    
+    
+    TestOneContainer<T>( containers.dataVector.cbegin(), containers.dataVector.cend(), containers.dataVector.cbegin(), myTypeName + " vector" );
+    std::string temp1( myTypeName + " vector minmax_sequence" );
+    summarize(temp1.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    // deque iterators check for the end of each block
+    iterations = base_iterations / 4;
+    
+    TestOneContainer<T>( containers.dataDeque.cbegin(), containers.dataDeque.cend(), containers.dataDeque.cbegin(), myTypeName + " deque" );
+    std::string temp2( myTypeName + " deque minmax_sequence" );
+    summarize(temp2.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    
+    // pointer chasing is much slower
+    iterations = base_iterations / 32;
+    
+    TestOneForwardContainer<T>( containers.dataList.cbegin(), containers.dataList.cend(), myTypeName + " list" );
+    std::string temp3( myTypeName + " list minmax_sequence" );
+    summarize(temp3.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    TestOneForwardContainer<T>( containers.dataForwardList.cbegin(), containers.dataForwardList.cend(), myTypeName + " forward_list" );
+    std::string temp4( myTypeName + " forward_list minmax_sequence" );
+    summarize(temp4.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    TestOneForwardContainer<T>( containers.dataSingleList.cbegin(), containers.dataSingleList.cend(), myTypeName + " SingleLinkList" );
+    std::string temp5( myTypeName + " SingleLinkList minmax_sequence" );
+    summarize(temp5.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    TestOnePooledList<T>( containers.dataPooledSingleList, myTypeName + " PooledSingleLinkList" );
+    std::string temp6( myTypeName + " PooledSingleLinkList minmax_sequence" );
+    summarize(temp6.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    TestOneForwardContainer<T>( containers.dataDoubleList.cbegin(), containers.dataDoubleList.cend(), myTypeName + " DoubleLinkList" );
+    std::string temp7( myTypeName + " DoubleLinkList minmax_sequence" );
+    summarize(temp7.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    TestOnePooledList<T>( containers.dataPooledDoubleList, myTypeName + " PooledDoubleLinkList" );
+    std::string temp8( myTypeName + " PooledDoubleLinkList minmax_sequence" );
+    summarize(temp8.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 template<typename T>
 void TestOneType()
 {
@@ -2369,6 +3148,104 @@ void TestOneFloat()
 /******************************************************************************/
 /******************************************************************************/
 
+// argmin and argmax that vectorize
+template<typename T>
+void TestVectorPositions()
+{
+    std::string myTypeName( getTypeName<T>() );
+    const int base_iterations = iterations;
+    
+    T data[SIZE];
+
+    // seed the random number generator so we get repeatable results
+    scrand( (int)init_value + 123 );
+    fill_random( data, data+SIZE );
+    
+    gMinPosition = find_minimum_position( data, SIZE );
+    gMaxPosition = find_maximum_position( data, SIZE );
+    
+    // position tests are much slower, even at their best
+    iterations = base_iterations / 5;
+    
+    test_min_position_finder( data, SIZE, find_extreme_position_scalar<false,T>, myTypeName + " minimum position scalar");
+    test_min_position_finder( data, SIZE, find_extreme_position_two_pass<false,T>, myTypeName + " minimum position two pass");
+    test_min_position_finder( data, SIZE, find_extreme_position_blocks<false,T>, myTypeName + " minimum position blocks");
+    test_min_position_finder( data, SIZE, find_extreme_position_lanes<false,T>, myTypeName + " minimum position lanes");
+    test_max_position_finder( data, SIZE, find_extreme_position_scalar<true,T>, myTypeName + " maximum position scalar");
+    test_max_position_finder( data, SIZE, find_extreme_position_two_pass<true,T>, myTypeName + " maximum position two pass");
+    test_max_position_finder( data, SIZE, find_extreme_position_blocks<true,T>, myTypeName + " maximum position blocks");
+    test_max_position_finder( data, SIZE, find_extreme_position_lanes<true,T>, myTypeName + " maximum position lanes");
+    test_minmax_position_finder( data, SIZE, find_minmax_position_blocks<T>, myTypeName + " minmax position blocks");
+    test_minmax_position_finder( data, SIZE, find_minmax_position_lanes<T>, myTypeName + " minmax position lanes");
+    
+    std::string temp1( myTypeName + " vector position sequence" );
+    summarize(temp1.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+
+template<typename T>
+void TestOneTopK( const T *data, size_t k, const std::string &label )
+{
+    std::vector<T> sorted( data, data+SIZE );
+    std::sort( sorted.begin(), sorted.end(), std::greater<T>() );
+    const T *expected = sorted.data();
+    
+    test_topk( data, SIZE, k, topk_partial_sort_copy<T>, expected, label + " partial_sort_copy");
+    test_topk( data, SIZE, k, topk_partial_sort<T>, expected, label + " partial_sort");
+    test_topk( data, SIZE, k, topk_nth_element<T>, expected, label + " nth_element");
+    test_topk( data, SIZE, k, topk_heap<T>, expected, label + " heap");
+    test_topk( data, SIZE, k, topk_heap_replace<T>, expected, label + " heap replace top");
+    test_topk( data, SIZE, k, topk_threshold<T>, expected, label + " threshold filter");
+    test_topk( data, SIZE, k, topk_bitonic<T>, expected, label + " bitonic merge");
+    
+    summarize(label.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+
+// top-k selection over several data distributions and sizes of k
+template<typename T>
+void TestTopK()
+{
+    std::string myTypeName( getTypeName<T>() );
+    const int base_iterations = iterations;
+    const size_t k_values[] = { 8, 64, 512 };
+    
+    T data[SIZE];
+    
+    iterations = base_iterations / 400;
+    
+    for (size_t k : k_values) {
+        std::string prefix( myTypeName + " top " + std::to_string(k) );
+        
+        // random order, most values lose early
+        scrand( (int)init_value + 123 );
+        fill_random( data, data+SIZE );
+        TestOneTopK( data, k, prefix + " random" );
+        
+        // ascending, every value is a new winner
+        std::sort( data, data+SIZE );
+        TestOneTopK( data, k, prefix + " ascending" );
+        
+        // descending, the first k values win
+        std::reverse( data, data+SIZE );
+        TestOneTopK( data, k, prefix + " descending" );
+        
+        // few distinct values, lots of ties with the threshold
+        for (size_t j = 0; j < SIZE; ++j)
+            data[j] = T( uint64_t(crand64()) % 16 );
+        TestOneTopK( data, k, prefix + " few values" );
+    }
+    
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 int main(int argc, char** argv) {
 
     // output command for documentation:
@@ -2398,6 +3275,16 @@ int main(int argc, char** argv) {
     TestOneFloat<double>();
     TestOneFloat<long double>();
     
+    TestContainers<int32_t>();
+    TestContainers<double>();
+    
+    TestVectorPositions<int32_t>();
+    TestVectorPositions<float>();
+    TestVectorPositions<double>();
+    
+    TestTopK<int32_t>();
+    TestTopK<float>();
+    
     return 0;
 }
 
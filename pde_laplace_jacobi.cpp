@@ -15,6 +15,12 @@ Assumptions:
 
     2) Better implementations should be able to vectorize much of the computation.
 
+    3) On grids larger than the cache, several time steps per pass (temporal blocking)
+        will be faster than one pass per step, and row bands will scale across threads.
+
+    4) Time to a given tolerance depends more on the method than on the speed of each sweep.
+        Red-black SOR and multigrid should beat any Jacobi implementation by orders of magnitude.
+
 
 
 NOTE - Somehow LLVM is doing a better job vectorizing the reverse loops than the forward loops ????
@@ -29,8 +35,7 @@ NOTE - on large problems: Jacobi methods doesn't so much "converge" as "run out
 NOTE - with integer types: Jacobi methods probably won't "converge", but just oscillate and lose precision
 
 
-TODO - Jacobi 8 neighbors
-TODO - SOR 8 neighbors
+TODO - column tiling for the wavefront, for grids where blockSteps rows don't fit in cache
 
 */
 
@@ -46,10 +51,12 @@ TODO - SOR 8 neighbors
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <vector>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_typenames.h"
 #include "benchmark_shared_pde.h"
+#include "benchmark_threads.h"
 
 /******************************************************************************/
 
@@ -65,6 +72,13 @@ const int HEIGHT = 2000;
 const int SIZE = HEIGHT*WIDTH;
 
 
+// 8K square, 256 to 512 Meg per buffer, far larger than the last level cache
+const int LARGE_WIDTH = 8192;
+const int LARGE_HEIGHT = 8192;
+
+const int LARGE_SIZE = LARGE_HEIGHT*LARGE_WIDTH;
+
+
 // smaller buffers for testing convergence rate
 const int SMALL_WIDTH = 250;
 const int SMALL_HEIGHT = 300;
@@ -909,6 +923,173 @@ struct jacobi_sor2D_unrolled3 {
 /******************************************************************************/
 /******************************************************************************/
 
+/*
+    8 neighbors (9 point stencil)
+    
+        1 4 1
+        4 0 4
+        1 4 1
+    result divided by 20
+    
+    More accurate than 4 neighbors, and damps high frequencies better.
+*/
+template <typename T, typename TS>
+struct jacobi2D_8neighbors {
+    void operator()(const T *source, T *dest, int rows, int cols, int rowStep, int /* iter */) {
+        const bool isFloat = (T(2.9) > T(2.0));
+        const TS half = isFloat ? TS(0) : TS(10);
+
+        int x, y;
+        
+        for (y = 1; y < (rows-1); ++ y) {
+
+            for (x = 1; x < (cols-1); ++x) {
+            
+                TS sum = source[((y-1)*rowStep)+(x+0)];
+                sum +=   source[((y+0)*rowStep)+(x-1)];
+                sum +=   source[((y+0)*rowStep)+(x+1)];
+                sum +=   source[((y+1)*rowStep)+(x+0)];
+                
+                TS corners = source[((y-1)*rowStep)+(x-1)];
+                corners +=   source[((y-1)*rowStep)+(x+1)];
+                corners +=   source[((y+1)*rowStep)+(x-1)];
+                corners +=   source[((y+1)*rowStep)+(x+1)];
+                
+                T temp = T( (TS(4)*sum + corners + half) / TS(20) );
+                
+                dest[((y+0)*rowStep)+(x+0)] = temp;
+            }
+        }
+    }
+};
+
+/******************************************************************************/
+
+template <typename T, typename TS>
+struct jacobi_sor2D_8neighbors {
+    void operator()(T *source, T *dest, int rows, int cols, int rowStep, int /* iter */ ) {
+        const bool isFloat = (T(2.9) > T(2.0));
+        const TS half = isFloat ? TS(0) : TS(10);
+        const float orFactor = isFloat ? 1.9765 : 1.775;    // integer doesn't converge nearly as well
+        const int intShift = 6;     // shift = 7 barely fits in int16_t, leave some leeway
+        int x, y;
+
+        for (y = 1; y < (rows-1); ++ y) {
+
+            for (x = 1; x < (cols-1); ++x) {
+            
+                T old_value = dest[((y+0)*rowStep)+(x+0)];
+                TS sum = source[((y-1)*rowStep)+(x+0)];
+                sum +=   source[((y+0)*rowStep)+(x-1)];
+                sum +=   source[((y+0)*rowStep)+(x+1)];
+                sum +=   source[((y+1)*rowStep)+(x+0)];
+                
+                TS corners = source[((y-1)*rowStep)+(x-1)];
+                corners +=   source[((y-1)*rowStep)+(x+1)];
+                corners +=   source[((y+1)*rowStep)+(x-1)];
+                corners +=   source[((y+1)*rowStep)+(x+1)];
+                
+                T new_value = T( (TS(4)*sum + corners + half) / TS(20) );
+                T diff = new_value - old_value;
+                T temp = old_value + scaleValue( diff, orFactor, intShift );
+                
+                dest[((y+0)*rowStep)+(x+0)] = temp;
+            }
+        }
+
+    }
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Red-black Gauss-Seidel
+    Points where x+y is even are red, the rest are black.
+    Red points only depend on black points and vice versa, so each color can be updated
+        in any order (and vectorized), and the second color sees the new values of the first.
+    
+    Written into dest like the Jacobi versions: red from the old black values in source,
+        then black from the new red values in dest.
+    
+    The stride 2 loops are hard to vectorize, see the split layout below for a fix.
+*/
+template <typename T, typename TS>
+struct gauss_seidel2D_redblack {
+    void operator()(const T *source, T *dest, int rows, int cols, int rowStep, int /* iter */) {
+        const bool isFloat = (T(2.9) > T(2.0));
+        const TS half = isFloat ? TS(0) : TS(2);
+
+        int x, y;
+        
+        // red
+        for (y = 1; y < (rows-1); ++ y) {
+            for (x = (y & 1) ? 1 : 2; x < (cols-1); x += 2) {
+                TS sum = source[((y-1)*rowStep)+(x+0)];
+                sum +=   source[((y+0)*rowStep)+(x-1)];
+                sum +=   source[((y+0)*rowStep)+(x+1)];
+                sum +=   source[((y+1)*rowStep)+(x+0)];
+                dest[((y+0)*rowStep)+(x+0)] = T( (sum+half) / TS(4) );
+            }
+        }
+        
+        // black
+        for (y = 1; y < (rows-1); ++ y) {
+            for (x = (y & 1) ? 2 : 1; x < (cols-1); x += 2) {
+                TS sum = dest[((y-1)*rowStep)+(x+0)];
+                sum +=   dest[((y+0)*rowStep)+(x-1)];
+                sum +=   dest[((y+0)*rowStep)+(x+1)];
+                sum +=   dest[((y+1)*rowStep)+(x+0)];
+                dest[((y+0)*rowStep)+(x+0)] = T( (sum+half) / TS(4) );
+            }
+        }
+    }
+};
+
+/******************************************************************************/
+
+// red-black with over relaxation
+template <typename T, typename TS>
+struct sor2D_redblack {
+    void operator()(const T *source, T *dest, int rows, int cols, int rowStep, int /* iter */) {
+        const bool isFloat = (T(2.9) > T(2.0));
+        const TS half = isFloat ? TS(0) : TS(2);
+        const float orFactor = isFloat ? 1.9765 : 1.775;    // integer doesn't converge nearly as well
+        const int intShift = 6;     // shift = 7 barely fits in int16_t, leave some leeway
+
+        int x, y;
+        
+        // red
+        for (y = 1; y < (rows-1); ++ y) {
+            for (x = (y & 1) ? 1 : 2; x < (cols-1); x += 2) {
+                T old_value = source[((y+0)*rowStep)+(x+0)];
+                TS sum = source[((y-1)*rowStep)+(x+0)];
+                sum +=   source[((y+0)*rowStep)+(x-1)];
+                sum +=   source[((y+0)*rowStep)+(x+1)];
+                sum +=   source[((y+1)*rowStep)+(x+0)];
+                T diff = T( (sum+half) / TS(4) ) - old_value;
+                dest[((y+0)*rowStep)+(x+0)] = old_value + scaleValue( diff, orFactor, intShift );
+            }
+        }
+        
+        // black
+        for (y = 1; y < (rows-1); ++ y) {
+            for (x = (y & 1) ? 2 : 1; x < (cols-1); x += 2) {
+                T old_value = source[((y+0)*rowStep)+(x+0)];
+                TS sum = dest[((y-1)*rowStep)+(x+0)];
+                sum +=   dest[((y+0)*rowStep)+(x-1)];
+                sum +=   dest[((y+0)*rowStep)+(x+1)];
+                sum +=   dest[((y+1)*rowStep)+(x+0)];
+                T diff = T( (sum+half) / TS(4) ) - old_value;
+                dest[((y+0)*rowStep)+(x+0)] = old_value + scaleValue( diff, orFactor, intShift );
+            }
+        }
+    }
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
 // fill interior values with weighted average of edges
 template <typename T>
 void average_edges(T *source, int rows, int cols, int rowStep ) {
@@ -1075,6 +1256,8 @@ void TestOneType()
     testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, jacobi2D_unrolled<T,TS>(), myTypeName + " jacobi 2D unrolled");
     testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, jacobi2D_unrolled2<T,TS>(), myTypeName + " jacobi 2D unrolled2");
     testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, jacobi2D_unrolled3<T,TS>(), myTypeName + " jacobi 2D unrolled3");
+    testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, jacobi2D_8neighbors<T,TS>(), myTypeName + " jacobi 2D 8 neighbors");
+    testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, gauss_seidel2D_redblack<T,TS>(), myTypeName + " gauss-seidel 2D red-black");
     
     std::string temp1( myTypeName + " PDE_laplace_2D jacobi" );
     summarize( temp1.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
@@ -1088,6 +1271,8 @@ void TestOneType()
     convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, jacobi2D_unrolled<T,TS>(), myTypeName + " jacobi 2D unrolled");
     convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, jacobi2D_unrolled2<T,TS>(), myTypeName + " jacobi 2D unrolled2");
     convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, jacobi2D_unrolled3<T,TS>(), myTypeName + " jacobi 2D unrolled3");
+    convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, jacobi2D_8neighbors<T,TS>(), myTypeName + " jacobi 2D 8 neighbors");
+    convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, gauss_seidel2D_redblack<T,TS>(), myTypeName + " gauss-seidel 2D red-black");
 
 
 
@@ -1100,6 +1285,8 @@ void TestOneType()
     testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, jacobi_sor2D_unrolled<T,TS>(), myTypeName + " jacobi SOR 2D unrolled");
     testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, jacobi_sor2D_unrolled2<T,TS>(), myTypeName + " jacobi SOR 2D unrolled2");
     testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, jacobi_sor2D_unrolled3<T,TS>(), myTypeName + " jacobi SOR 2D unrolled3");
+    testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, jacobi_sor2D_8neighbors<T,TS>(), myTypeName + " jacobi SOR 2D 8 neighbors");
+    testLaplace2D<T,TS>( data_flat, data_flatDst, HEIGHT, WIDTH, WIDTH, sor2D_redblack<T,TS>(), myTypeName + " SOR 2D red-black");
     
     std::string temp2( myTypeName + " PDE_laplace_2D jacobi_SOR" );
     summarize( temp2.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
@@ -1113,12 +1300,746 @@ void TestOneType()
     convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, jacobi_sor2D_unrolled<T,TS>(), myTypeName + " jacobi SOR 2D unrolled");
     convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, jacobi_sor2D_unrolled2<T,TS>(), myTypeName + " jacobi SOR 2D unrolled2");
     convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, jacobi_sor2D_unrolled3<T,TS>(), myTypeName + " jacobi SOR 2D unrolled3");
+    convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, jacobi_sor2D_8neighbors<T,TS>(), myTypeName + " jacobi SOR 2D 8 neighbors");
+    convergenceLaplace2D<T,TS>( data_flat, data_flatDst, SMALL_HEIGHT, SMALL_WIDTH, SMALL_WIDTH, sor2D_redblack<T,TS>(), myTypeName + " SOR 2D red-black");
+
+
+
+    
+    iterations = base_iterations;
+
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Row band decomposition with halo exchange, and temporal blocking
+
+    Each thread owns a band of rows, plus private ghost rows above and below.
+    Before each block of time steps the ghost rows are copied from the neighboring bands,
+        then each band runs the whole block without talking to anyone.
+    With blockSteps > 1, the ghost zone is blockSteps rows deep, the ghost rows are
+        recomputed redundantly, and fewer exchanges are needed.
+
+    Within a band, a block runs as a wavefront: at each row position, step 1 computes that row,
+        step 2 the row above it, and so on. Only about blockSteps+2 rows of each buffer
+        are live at once, so the block runs from cache even when the grid is much larger
+        than the last level cache.
+    The usual 2 buffers are enough: a row is only overwritten after the last read of its old value.
+*/
+
+template <typename T, typename TS>
+inline void jacobi2D_row(const T *above, const T *center, const T *below, T *dest, int cols) {
+    const bool isFloat = (T(2.9) > T(2.0));
+    const TS half = isFloat ? TS(0) : TS(2);
+    
+    for (int x = 1; x < (cols-1); ++x) {
+        TS sum = above[x];
+        sum +=   center[x-1];
+        sum +=   center[x+1];
+        sum +=   below[x];
+        dest[x] = T( (sum+half) / TS(4) );
+    }
+}
+
+/******************************************************************************/
+
+template <typename T, typename TS>
+class jacobi2D_banded {
+public:
+    jacobi2D_banded( benchmark::thread_pool &p, int threadCount, int steps ) :
+        pool(p), threads(threadCount), blockSteps(steps), bands(threadCount) {}
+
+    // Runs steps time steps, with edges held constant.
+    // Both buffers must start with the same contents, returns the buffer holding the result.
+    T *operator()( T *current, T *other, int rows, int cols, int steps ) {
+        setup( rows, cols );
+        
+        for (int done = 0; done < steps; ) {
+            const int count = std::min( blockSteps, steps - done );
+            
+            if (threads == 1) {
+                run_block( bands[0], current, other, rows, cols, count );
+            } else {
+                pool.run( threads, [&]( int b ) { exchange( bands[b], current, cols ); } );
+                pool.run( threads, [&]( int b ) { run_block( bands[b], current, other, rows, cols, count ); } );
+            }
+            
+            if (count & 1)
+                std::swap( current, other );
+            done += count;
+        }
+        
+        return current;
+    }
+
+private:
+    struct band {
+        int start, end;         // rows owned
+        int lo, hi;             // rows computed, including ghost rows
+        std::vector<T> ghosts[2];
+        std::vector<T *> rowPtr[2];
+    };
+
+    void setup( int rows, int cols ) {
+        for (int b = 0; b < threads; ++b) {
+            band &info = bands[b];
+            info.start = int( (int64_t(rows) * b) / threads );
+            info.end = int( (int64_t(rows) * (b+1)) / threads );
+            info.lo = (threads == 1) ? 0 : std::max( 0, info.start - blockSteps );
+            info.hi = (threads == 1) ? rows : std::min( rows, info.end + blockSteps );
+            const int ghostRows = (info.start - info.lo) + (info.hi - info.end);
+            info.ghosts[0].resize( ghostRows * cols );
+            info.ghosts[1].resize( ghostRows * cols );
+            info.rowPtr[0].resize( info.hi - info.lo );
+            info.rowPtr[1].resize( info.hi - info.lo );
+        }
+    }
+
+    // ghost rows come from the neighbors' current buffer, in both of our buffers so fixed edge rows are valid
+    void exchange( band &info, const T *current, int cols ) {
+        T *ghost0 = info.ghosts[0].data();
+        T *ghost1 = info.ghosts[1].data();
+        for (int g = info.lo; g < info.hi; ++g) {
+            if (g >= info.start && g < info.end)
+                continue;
+            const T *source = current + size_t(g) * cols;
+            std::copy_n( source, cols, ghost0 );
+            std::copy_n( source, cols, ghost1 );
+            ghost0 += cols;
+            ghost1 += cols;
+        }
+    }
+
+    void run_block( band &info, T *current, T *other, int rows, int cols, int count ) {
+        // map each row the band computes to the shared buffers or the private ghost rows
+        T *buffers[2] = { current, other };
+        for (int k = 0; k < 2; ++k) {
+            T *ghost = info.ghosts[k].data();
+            for (int g = info.lo; g < info.hi; ++g) {
+                if (g >= info.start && g < info.end)
+                    info.rowPtr[k][g - info.lo] = buffers[k] + size_t(g) * cols;
+                else {
+                    info.rowPtr[k][g - info.lo] = ghost;
+                    ghost += cols;
+                }
+            }
+        }
+        T **rowsIn[2] = { info.rowPtr[0].data() - info.lo, info.rowPtr[1].data() - info.lo };
+        
+        // valid rows shrink by one per step from each ghost edge, the grid edges stay fixed
+        const int first = (info.lo == 0) ? 1 : info.lo + 1;
+        const int last = (info.hi == rows) ? rows - 2 : info.hi - 2;
+        
+        for (int wave = first; wave <= last + count - 1; ++wave) {
+            for (int s = 1; s <= count; ++s) {
+                const int r = wave - (s - 1);
+                const int rowLo = (info.lo == 0) ? 1 : info.lo + s;
+                const int rowHi = (info.hi == rows) ? rows - 2 : info.hi - 1 - s;
+                if (r < rowLo || r > rowHi)
+                    continue;
+                T **source = rowsIn[ (s - 1) & 1 ];
+                T **dest = rowsIn[ s & 1 ];
+                jacobi2D_row<T,TS>( source[r-1], source[r], source[r+1], dest[r], cols );
+            }
+        }
+    }
+
+    benchmark::thread_pool &pool;
+    int threads;
+    int blockSteps;
+    std::vector<band> bands;
+};
+
+/******************************************************************************/
+
+// every combination of bands and block sizes must match the plain sweep exactly
+template <typename T, typename TS>
+void verify_jacobi_banded( const std::string &myTypeName ) {
+    const int rows = 203, cols = 157, steps = 23;
+    benchmark::thread_pool pool( 4 );
+    std::vector<T> expectA( rows*cols ), expectB( rows*cols );
+    std::vector<T> testA( rows*cols ), testB( rows*cols );
+    
+    laplace_initial_conditions( expectA.data(), rows, cols );
+    expectB = expectA;
+    T *expected = expectA.data(), *expectOther = expectB.data();
+    for (int i = 0; i < steps; ++i) {
+        jacobi2D_simple<T,TS>()( expected, expectOther, rows, cols, cols, i );
+        std::swap( expected, expectOther );
+    }
+    
+    const int threadCounts[] = { 1, 2, 3, 4 };
+    const int blockCounts[] = { 1, 2, 5, 8 };
+    for (int threads : threadCounts)
+        for (int blockSteps : blockCounts) {
+            laplace_initial_conditions( testA.data(), rows, cols );
+            testB = testA;
+            jacobi2D_banded<T,TS> solver( pool, threads, blockSteps );
+            T *result = solver( testA.data(), testB.data(), rows, cols, steps );
+            if (!std::equal( result, result + rows*cols, expected ))
+                printf("test %s jacobi 2D banded, %d threads, %d steps per block failed\n", myTypeName.c_str(), threads, blockSteps );
+        }
+}
+
+/******************************************************************************/
+
+// same tolerances as convergenceLaplace2D
+// checked every 8 steps (or each block if larger), so all versions pay the same for checking
+template <typename T, typename TS>
+void convergenceBanded2D( benchmark::thread_pool &pool, int threads, int blockSteps, int rows, int cols, const std::string &label ) {
+    const bool isFloat = (T(2.9) > T(2.0));
+    const int checkSteps = std::max( blockSteps, 8 );
+    const TS total_tolerance = 10;
+    const T max_tolerance = isFloat ? 0.01 : 1;
+    const int limit = 10000;
+    
+    std::vector<T> bufferA( rows*cols ), bufferB( rows*cols );
+    T average = laplace_initial_conditions( bufferA.data(), rows, cols );
+    bufferB = bufferA;
+    T *current = bufferA.data(), *other = bufferB.data();
+    
+    jacobi2D_banded<T,TS> solver( pool, threads, blockSteps );
+    TS total = 0;
+    T max = 0;
+    int i = 0;
+    
+    start_wall_timer();
+    
+    while (i < limit) {
+        T *result = solver( current, other, rows, cols, checkSteps );
+        if (result != current)
+            std::swap( current, other );
+        i += checkSteps;
+        
+        // the other buffer holds the step before the last
+        total = total_difference<T,TS>( current, other, rows, cols );
+        max = max_difference( current, other, rows, cols );
+        if (total < total_tolerance || (total != total) || max < max_tolerance || (max != max))
+            break;
+    }
+    
+    double total_time = wall_timer();
+    
+    T center_delta = average - current[ (rows/2)*cols + (cols/2) ];
+
+    if ((total != total) || (max != max))
+        std::cout << label << " diverged to NaN";
+    else if (i >= limit && total > total_tolerance && max > max_tolerance)
+        std::cout << label << " did not converge";
+    else
+        std::cout << label << " converged";
+    
+    std::cout << " in " << i << " iterations";
+    std::cout << " ( total: " << total << ", max: " << max << ", center_delta: " << center_delta << ", time: " << total_time << ")\n";
+}
 
+/******************************************************************************/
 
+// Large grids, far bigger than the last level cache, where a single pass per step is memory bound.
+// Results are grid updates per second, using wall clock time.
+template< typename T, typename TS >
+void TestLargeGrid( benchmark::thread_pool &pool )
+{
+    const int base_iterations = iterations;
+    const int blockSizes[] = { 4, 8, 16 };
+    const int parallelBlock = 8;
 
+    std::string myTypeName( getTypeName<T>() );
+    
+    verify_jacobi_banded<T,TS>( myTypeName );
+    
+    std::vector<int> threadCounts;
+    for (int t = 1; t < pool.size(); t *= 2)
+        threadCounts.push_back( t );
+    threadCounts.push_back( pool.size() );
+    
+    std::vector<T> bufferA( LARGE_SIZE ), bufferB( LARGE_SIZE );
+    
+    // same number of updates as the smaller tests, in whole blocks
+    iterations = std::max( 16, int( (int64_t(base_iterations) * SIZE) / LARGE_SIZE ) );
+    iterations = (iterations + 15) & ~15;
+    
+    gLabels.clear();
+    char buffer[ 200 ];
+    
+    auto run = [&]( int threads, int blockSteps ) -> double {
+        laplace_initial_conditions( bufferA.data(), LARGE_HEIGHT, LARGE_WIDTH );
+        std::copy( bufferA.begin(), bufferA.end(), bufferB.begin() );
+        jacobi2D_banded<T,TS> solver( pool, threads, blockSteps );
+        start_wall_timer();
+        solver( bufferA.data(), bufferB.data(), LARGE_HEIGHT, LARGE_WIDTH, iterations );
+        return wall_timer();
+    };
+    
+    double single = run( 1, 1 );
+    snprintf( buffer, sizeof(buffer), "%s jacobi 2D %dx%d one pass per step", myTypeName.c_str(), LARGE_WIDTH, LARGE_HEIGHT );
+    gLabels.push_back( buffer );
+    record_result( single, gLabels.back().c_str() );
+    
+    for (int threads : threadCounts) {
+        if (threads == 1)
+            continue;
+        double elapsed = run( threads, 1 );
+        snprintf( buffer, sizeof(buffer), "%s jacobi 2D bands, %d threads, %.0f%% efficiency",
+                    myTypeName.c_str(), threads, 100.0 * single / (elapsed * threads) );
+        gLabels.push_back( buffer );
+        record_result( elapsed, gLabels.back().c_str() );
+    }
+    
+    double blockedSingle = 0.0;
+    for (int blockSteps : blockSizes) {
+        double elapsed = run( 1, blockSteps );
+        if (blockSteps == parallelBlock)
+            blockedSingle = elapsed;
+        snprintf( buffer, sizeof(buffer), "%s jacobi 2D wavefront, %d steps per block", myTypeName.c_str(), blockSteps );
+        gLabels.push_back( buffer );
+        record_result( elapsed, gLabels.back().c_str() );
+    }
+    
+    for (int threads : threadCounts) {
+        if (threads == 1)
+            continue;
+        double elapsed = run( threads, parallelBlock );
+        snprintf( buffer, sizeof(buffer), "%s jacobi 2D wavefront bands, %d steps per block, %d threads, %.0f%% efficiency",
+                    myTypeName.c_str(), parallelBlock, threads, 100.0 * blockedSingle / (elapsed * threads) );
+        gLabels.push_back( buffer );
+        record_result( elapsed, gLabels.back().c_str() );
+    }
+    
+    std::string temp1( myTypeName + " PDE_laplace_2D jacobi large grid" );
+    summarize( temp1.c_str(), LARGE_SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    // time to convergence, on the small grid: Jacobi needs on the order of rows^2 steps, so large grids would never finish
+    convergenceBanded2D<T,TS>( pool, 1, 1, SMALL_HEIGHT, SMALL_WIDTH, myTypeName + " jacobi 2D one pass per step" );
+    convergenceBanded2D<T,TS>( pool, 1, parallelBlock, SMALL_HEIGHT, SMALL_WIDTH, myTypeName + " jacobi 2D wavefront, 8 steps per block" );
+    if (pool.size() > 1)
+        convergenceBanded2D<T,TS>( pool, pool.size(), parallelBlock, SMALL_HEIGHT, SMALL_WIDTH,
+                                myTypeName + " jacobi 2D wavefront bands, 8 steps per block, " + std::to_string(pool.size()) + " threads" );
     
     iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Time to tolerance
+
+    Faster sweeps don't help much if the method needs many more of them.
+    Each solver runs until the largest update a Jacobi step would make (the residual)
+        drops below the tolerance, on a grid sized for multigrid (2^k + 1).
 
+    Red-black Gauss-Seidel needs about half the sweeps of Jacobi.
+    Red-black SOR with the optimal relaxation factor needs O(N) sweeps instead of O(N^2).
+    Multigrid needs a roughly constant number of V-cycles, each costing a few sweeps.
+*/
+
+// 2^7 + 1, small enough that Jacobi converges in reasonable time
+const int TOLERANCE_SIZE = 129;
+
+/******************************************************************************/
+
+// largest change a 4 neighbor Jacobi step would make
+template <typename T>
+T residual_laplace2D( const T *u, int rows, int cols ) {
+    T result = 0;
+    for (int y = 1; y < (rows-1); ++y) {
+        for (int x = 1; x < (cols-1); ++x) {
+            T sum = u[((y-1)*cols)+x] + u[(y*cols)+(x-1)] + u[(y*cols)+(x+1)] + u[((y+1)*cols)+x];
+            T diff = std::abs( sum / T(4) - u[(y*cols)+x] );
+            if (diff > result || diff != diff)
+                result = diff;
+        }
+    }
+    return result;
+}
+
+/******************************************************************************/
+
+// largest change an 8 neighbor Jacobi step would make
+template <typename T>
+T residual_laplace2D_8neighbors( const T *u, int rows, int cols ) {
+    T result = 0;
+    for (int y = 1; y < (rows-1); ++y) {
+        for (int x = 1; x < (cols-1); ++x) {
+            T sum = u[((y-1)*cols)+x] + u[(y*cols)+(x-1)] + u[(y*cols)+(x+1)] + u[((y+1)*cols)+x];
+            T corners = u[((y-1)*cols)+(x-1)] + u[((y-1)*cols)+(x+1)] + u[((y+1)*cols)+(x-1)] + u[((y+1)*cols)+(x+1)];
+            T diff = std::abs( (T(4)*sum + corners) / T(20) - u[(y*cols)+x] );
+            if (diff > result || diff != diff)
+                result = diff;
+        }
+    }
+    return result;
+}
+
+/******************************************************************************/
+
+// Jacobi with any of the calculators above, ping-ponging between 2 buffers
+template <typename T, typename MM>
+class jacobi_solver {
+public:
+    jacobi_solver( int size, bool eight ) : rows(size), cols(size), eightNeighbors(eight), iter(0),
+                                            source(size*size), dest(size*size) {
+        laplace_initial_conditions( source.data(), rows, cols );
+        dest = source;
+    }
+
+    void operator()() {
+        calculator( source.data(), dest.data(), rows, cols, cols, iter++ );
+        std::swap( source, dest );
+    }
+
+    T residual() const {
+        if (eightNeighbors)
+            return residual_laplace2D_8neighbors( source.data(), rows, cols );
+        return residual_laplace2D( source.data(), rows, cols );
+    }
+
+private:
+    int rows, cols;
+    bool eightNeighbors;
+    int iter;
+    MM calculator;
+    std::vector<T> source, dest;
+};
+
+/******************************************************************************/
+
+// in place red-black sweep, plain Gauss-Seidel when omega == 1
+template <typename T>
+void sor_redblack_inplace( T *u, int rows, int cols, T omega ) {
+    for (int color = 0; color < 2; ++color) {
+        for (int y = 1; y < (rows-1); ++y) {
+            for (int x = ((y + color) & 1) ? 1 : 2; x < (cols-1); x += 2) {
+                T sum = u[((y-1)*cols)+x] + u[(y*cols)+(x-1)] + u[(y*cols)+(x+1)] + u[((y+1)*cols)+x];
+                T old_value = u[(y*cols)+x];
+                u[(y*cols)+x] = old_value + omega * (sum / T(4) - old_value);
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+
+template <typename T>
+class redblack_solver {
+public:
+    redblack_solver( int size, T relax ) : rows(size), cols(size), omega(relax), data(size*size) {
+        laplace_initial_conditions( data.data(), rows, cols );
+    }
+
+    void operator()() {
+        sor_redblack_inplace( data.data(), rows, cols, omega );
+    }
+
+    T residual() const {
+        return residual_laplace2D( data.data(), rows, cols );
+    }
+
+    const T *values() const { return data.data(); }
+
+private:
+    int rows, cols;
+    T omega;
+    std::vector<T> data;
+};
+
+/******************************************************************************/
+
+/*
+    Red-black SOR with the colors stored separately
+    Each row is split into its red and black values, so every update is a unit stride loop.
+
+    Point (x,y) is red when x+y is even. In row y, color c holds x = 2*i + q with q = (y+c)&1,
+        so the neighbors of red[y][i] are black[y][i-1+q], black[y][i+q], black[y-1][i] and black[y+1][i].
+*/
+template <typename T>
+class redblack_split_solver {
+public:
+    redblack_split_solver( int size, T relax ) : rows(size), cols(size), half((size+1)/2), omega(relax),
+                                                red(size*half), black(size*half) {
+        std::vector<T> temp( rows*cols );
+        laplace_initial_conditions( temp.data(), rows, cols );
+        pack( temp.data() );
+    }
+
+    void operator()() {
+        update( red.data(), black.data(), 0 );
+        update( black.data(), red.data(), 1 );
+    }
+
+    T residual() const {
+        T result = 0;
+        for (int color = 0; color < 2; ++color) {
+            const T *mine = (color == 0) ? red.data() : black.data();
+            const T *other = (color == 0) ? black.data() : red.data();
+            for (int y = 1; y < (rows-1); ++y) {
+                const int q = (y + color) & 1;
+                const T *row = other + y*half;
+                for (int i = (2-q)/2; i <= (cols-2-q)/2; ++i) {
+                    T sum = row[i-half] + row[i-1+q] + row[i+q] + row[i+half];
+                    T diff = std::abs( sum / T(4) - mine[(y*half)+i] );
+                    if (diff > result || diff != diff)
+                        result = diff;
+                }
+            }
+        }
+        return result;
+    }
+
+    void pack( const T *source ) {
+        for (int y = 0; y < rows; ++y)
+            for (int x = 0; x < cols; ++x)
+                (((x + y) & 1) ? black : red)[(y*half) + (x/2)] = source[(y*cols)+x];
+    }
+
+    void unpack( T *dest ) const {
+        for (int y = 0; y < rows; ++y)
+            for (int x = 0; x < cols; ++x)
+                dest[(y*cols)+x] = (((x + y) & 1) ? black : red)[(y*half) + (x/2)];
+    }
+
+private:
+    void update( T *mine, const T *other, int color ) {
+        for (int y = 1; y < (rows-1); ++y) {
+            const int q = (y + color) & 1;
+            T *dest = mine + y*half;
+            const T *row = other + y*half;
+            const T *left = row - 1 + q;
+            const T *right = row + q;
+            const T *above = row - half;
+            const T *below = row + half;
+            for (int i = (2-q)/2; i <= (cols-2-q)/2; ++i) {
+                T sum = above[i] + left[i] + right[i] + below[i];
+                T old_value = dest[i];
+                dest[i] = old_value + omega * (sum / T(4) - old_value);
+            }
+        }
+    }
+
+    int rows, cols, half;
+    T omega;
+    std::vector<T> red, black;
+};
+
+/******************************************************************************/
+
+/*
+    Geometric multigrid, V(2,2) cycles
+    Smooth with red-black Gauss-Seidel, restrict the residual with full weighting,
+        correct on the coarser grid, then add back the bilinear interpolated correction.
+    Levels are (n-1)/2 + 1 points on a side, down to 3 (one unknown, solved exactly by one sweep).
+    Equations are 4*u - sum(neighbors) = f, with f scaled by the grid spacing squared.
+*/
+template <typename T>
+class multigrid_solver {
+public:
+    multigrid_solver( int size ) {
+        for (int n = size; n >= 3; n = (n-1)/2 + 1) {
+            sizes.push_back( n );
+            u.emplace_back( n*n, T(0) );
+            f.emplace_back( n*n, T(0) );
+            r.emplace_back( n*n, T(0) );
+            if ((n & 1) == 0)       // can't coarsen an even size
+                break;
+        }
+        laplace_initial_conditions( u[0].data(), size, size );
+    }
+
+    void operator()() {
+        vcycle( 0 );
+    }
+
+    T residual() const {
+        return residual_laplace2D( u[0].data(), sizes[0], sizes[0] );
+    }
+
+private:
+    void smooth( int level, int sweeps ) {
+        const int n = sizes[level];
+        T *v = u[level].data();
+        const T *rhs = f[level].data();
+        for (int s = 0; s < sweeps; ++s)
+            for (int color = 0; color < 2; ++color)
+                for (int y = 1; y < (n-1); ++y)
+                    for (int x = ((y + color) & 1) ? 1 : 2; x < (n-1); x += 2) {
+                        T sum = v[((y-1)*n)+x] + v[(y*n)+(x-1)] + v[(y*n)+(x+1)] + v[((y+1)*n)+x];
+                        v[(y*n)+x] = (sum + rhs[(y*n)+x]) / T(4);
+                    }
+    }
+
+    void compute_residual( int level ) {
+        const int n = sizes[level];
+        const T *v = u[level].data();
+        const T *rhs = f[level].data();
+        T *res = r[level].data();
+        for (int y = 1; y < (n-1); ++y)
+            for (int x = 1; x < (n-1); ++x) {
+                T sum = v[((y-1)*n)+x] + v[(y*n)+(x-1)] + v[(y*n)+(x+1)] + v[((y+1)*n)+x];
+                res[(y*n)+x] = rhs[(y*n)+x] + sum - T(4)*v[(y*n)+x];
+            }
+    }
+
+    // full weighting, times 4 for the doubled grid spacing
+    void restrict_residual( int level ) {
+        const int n = sizes[level];
+        const int nc = sizes[level+1];
+        const T *res = r[level].data();
+        T *rhs = f[level+1].data();
+        for (int y = 1; y < (nc-1); ++y)
+            for (int x = 1; x < (nc-1); ++x) {
+                const T *c = res + (2*y*n) + (2*x);
+                T edges = c[-n] + c[-1] + c[1] + c[n];
+                T corners = c[-n-1] + c[-n+1] + c[n-1] + c[n+1];
+                rhs[(y*nc)+x] = (T(4)*c[0] + T(2)*edges + corners) / T(4);
+            }
+    }
+
+    // bilinear interpolation of the coarse correction
+    void prolong_add( int level ) {
+        const int n = sizes[level];
+        const int nc = sizes[level+1];
+        const T *e = u[level+1].data();
+        T *v = u[level].data();
+        for (int y = 1; y < (n-1); ++y) {
+            const T *row0 = e + (y/2)*nc;
+            const T *row1 = (y & 1) ? row0 + nc : row0;
+            for (int x = 1; x < (n-1); ++x) {
+                const int j = x / 2;
+                T value = row0[j] + row1[j];
+                if (x & 1)
+                    value = (value + row0[j+1] + row1[j+1]) / T(2);
+                v[(y*n)+x] += value / T(2);
+            }
+        }
+    }
+
+    void vcycle( int level ) {
+        if (level + 1 == (int)sizes.size()) {
+            smooth( level, (sizes[level] == 3) ? 1 : 4*sizes[level] );
+            return;
+        }
+        smooth( level, 2 );
+        compute_residual( level );
+        restrict_residual( level );
+        std::fill( u[level+1].begin(), u[level+1].end(), T(0) );
+        vcycle( level + 1 );
+        prolong_add( level );
+        smooth( level, 2 );
+    }
+
+    std::vector<int> sizes;
+    std::vector< std::vector<T> > u, f, r;
+};
+
+/******************************************************************************/
+
+template <typename T, typename SOLVER>
+void toleranceLaplace2D( SOLVER &solver, int sweepsPerCheck, int maxSweeps, T tolerance, const std::string &label ) {
+    int i = 0;
+    T residual = 0;
+
+    start_timer();
+
+    while (i < maxSweeps) {
+        for (int k = 0; k < sweepsPerCheck; ++k)
+            solver();
+        i += sweepsPerCheck;
+        
+        residual = solver.residual();
+        if (!(residual > tolerance))
+            break;
+    }
+    
+    double total_time = timer();
+
+    if (residual != residual)
+        std::cout << label << " diverged to NaN";
+    else if (residual > tolerance)
+        std::cout << label << " did not converge";
+    else
+        std::cout << label << " converged";
+    
+    std::cout << " in " << i << " iterations";
+    std::cout << " ( residual: " << residual << ", time: " << total_time << ")\n";
+    
+    gLabels.push_back( label );
+    record_result( total_time, gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+// the split layout should give exactly the same results as the in place red-black sweep
+template <typename T>
+void verify_redblack_split( const std::string &myTypeName ) {
+    const T omega = T(1.8);
+    const int sizes[] = { 37, 52 };
+    
+    for (int size : sizes) {
+        redblack_solver<T> plain( size, omega );
+        redblack_split_solver<T> split( size, omega );
+        for (int s = 0; s < 25; ++s) {
+            plain();
+            split();
+        }
+        
+        std::vector<T> result( size*size );
+        split.unpack( result.data() );
+        
+        if (!std::equal( result.begin(), result.end(), plain.values() ))
+            printf("test %s failed\n", (myTypeName + " red-black SOR 2D split layout").c_str() );
+        if (plain.residual() != split.residual())
+            printf("test %s failed\n", (myTypeName + " red-black SOR 2D split layout residual").c_str() );
+    }
+}
+
+/******************************************************************************/
+
+template< typename T >
+void TestConvergenceRates()
+{
+    std::string myTypeName( getTypeName<T>() );
+    
+    gLabels.clear();
+    
+    verify_redblack_split<T>( myTypeName );
+
+    const int size = TOLERANCE_SIZE;
+    const T tolerance = (sizeof(T) > 4) ? T(1.0e-8) : T(1.0e-3);
+    const int maxSweeps = 100000;
+    const int sweepsPerCheck = 8;
+    const double pi = 3.14159265358979323846;
+    const T omega = T( 2.0 / (1.0 + sin( pi / double(size-1) )) );
+
+    {
+        jacobi_solver<T, jacobi2D_simple<T,T> > solver( size, false );
+        toleranceLaplace2D( solver, sweepsPerCheck, maxSweeps, tolerance, myTypeName + " jacobi 2D" );
+    }
+    {
+        jacobi_solver<T, jacobi2D_8neighbors<T,T> > solver( size, true );
+        toleranceLaplace2D( solver, sweepsPerCheck, maxSweeps, tolerance, myTypeName + " jacobi 2D 8 neighbors" );
+    }
+    {
+        redblack_solver<T> solver( size, T(1) );
+        toleranceLaplace2D( solver, sweepsPerCheck, maxSweeps, tolerance, myTypeName + " gauss-seidel 2D red-black" );
+    }
+    {
+        redblack_solver<T> solver( size, omega );
+        toleranceLaplace2D( solver, sweepsPerCheck, maxSweeps, tolerance, myTypeName + " SOR 2D red-black" );
+    }
+    {
+        redblack_split_solver<T> solver( size, omega );
+        toleranceLaplace2D( solver, sweepsPerCheck, maxSweeps, tolerance, myTypeName + " SOR 2D red-black split" );
+    }
+    {
+        multigrid_solver<T> solver( size );
+        toleranceLaplace2D( solver, 1, maxSweeps, tolerance, myTypeName + " multigrid 2D V(2,2)" );
+    }
+    
+    std::string temp1( myTypeName + " PDE_laplace_2D time to tolerance" );
+    summarize( temp1.c_str(), size*size, 1, kDontShowGMeans, kDontShowPenalty );
 }
 
 /******************************************************************************/
@@ -1147,6 +2068,18 @@ int main(int argc, char** argv) {
     TestOneType<double,double>();
     
     
+    benchmark::thread_pool pool;
+    
+    TestLargeGrid<float,float>( pool );
+    
+    TestLargeGrid<double,double>( pool );
+    
+    
+    TestConvergenceRates<float>();
+    
+    TestConvergenceRates<double>();
+    
+    
     return 0;
 }
 
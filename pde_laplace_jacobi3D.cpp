@@ -0,0 +1,633 @@
+/*
+    Copyright 2026 CppPerformanceBenchmarks contributors
+    Distributed under the MIT License (see accompanying file LICENSE_1_0_0.txt
+    or a copy at http://stlab.adobe.com/licenses.html )
+
+
+Goal:  Test compiler optimizations with 3D pde solvers using jacobi iteration
+        (common in fluid dynamics, thermal, and scientific computations)
+
+
+Assumptions:
+
+    1) The compiler should vectorize the inner loops, at least once the row pointers are hoisted
+        out of the loop.
+
+    2) On grids larger than the cache, 2.5D blocking (tiles in x and y, streaming through z)
+        will be faster than whole planes, because the 3 source planes of a tile stay in cache.
+
+    3) The 27 point stencil can share partial sums between neighboring points,
+        and will be much faster than summing 26 neighbors for every point.
+
+    4) Slabs of planes will scale across threads, until memory bandwidth runs out.
+
+
+
+NOTE - 27 point weights are 14 for faces, 3 for edges, 1 for corners, divided by 128
+        (the fourth order accurate compact stencil for the Laplacian)
+
+NOTE - grids that would need more than the memory limit (default 4 GB, 2nd command line argument) are skipped.
+
+NOTE - integer types are covered by the 2D tests (pde_laplace_jacobi.cpp), and are skipped here.
+
+TODO - temporal blocking in 3D, wavefront through z with several steps per pass
+
+*/
+
+#include "benchmark_stdint.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <ctime>
+#include <cstdlib>
+#include <cmath>
+#include <deque>
+#include <string>
+#include <memory>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+#include "benchmark_results.h"
+#include "benchmark_timer.h"
+#include "benchmark_typenames.h"
+#include "benchmark_shared_pde.h"
+#include "benchmark_threads.h"
+#include "benchmark_cache.h"
+
+/******************************************************************************/
+
+// this constant may need to be adjusted to give reasonable minimum times
+// For best results, times should be about 1.0 seconds for the minimum test run
+// this is the number of steps on the reference grid, other grids scale to the same number of updates
+int iterations = 200;
+
+
+// 128^3, 8 to 16 Meg per buffer
+const int REFERENCE_EDGE = 128;
+
+const int64_t REFERENCE_SIZE = int64_t(REFERENCE_EDGE) * REFERENCE_EDGE * REFERENCE_EDGE;
+
+
+// edge lengths of the cubes tested, from L2 resident to several GB
+const int grid_edges[] = { 32, 64, 128, 256, 512, 768, 1024 };
+
+
+// largest pair of buffers to allocate, in megabytes, may be changed from the command line
+double max_memory_MB = 4096.0;
+
+/******************************************************************************/
+
+std::deque<std::string> gLabels;
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    3D convolution
+    hard coded filter
+    faces are constant
+
+    7 point stencil, the 6 face neighbors
+    result divided by 6
+
+    All of the kernels update planes [zBegin, zEnd), so the threaded version can reuse them.
+*/
+template <typename T>
+struct jacobi3D_simple {
+    void operator()(const T *source, T *dest, int /* planes */, int rows, int cols, int zBegin, int zEnd) {
+        const T scale = T(1) / T(6);
+        const size_t planeStep = size_t(rows) * cols;
+        int x, y, z;
+
+        for (z = zBegin; z < zEnd; ++z) {
+            for (y = 1; y < (rows-1); ++y) {
+                for (x = 1; x < (cols-1); ++x) {
+                    size_t i = (z*planeStep) + (y*cols) + x;
+                    T sum = source[i-planeStep];
+                    sum +=  source[i-cols];
+                    sum +=  source[i-1];
+                    sum +=  source[i+1];
+                    sum +=  source[i+cols];
+                    sum +=  source[i+planeStep];
+                    dest[i] = sum * scale;
+                }
+            }
+        }
+    }
+};
+
+/******************************************************************************/
+
+// one row of the 7 point stencil, with the neighboring rows already located
+template <typename T>
+inline void jacobi3D_row7( const T *back, const T *north, const T *center, const T *south, const T *front,
+                            T *dest, int count ) {
+    const T scale = T(1) / T(6);
+    for (int x = 0; x < count; ++x) {
+        T sum = back[x];
+        sum +=  north[x];
+        sum +=  center[x-1];
+        sum +=  center[x+1];
+        sum +=  south[x];
+        sum +=  front[x];
+        dest[x] = sum * scale;
+    }
+}
+
+/******************************************************************************/
+
+// row pointers hoisted out of the inner loop, which should vectorize
+template <typename T>
+struct jacobi3D_rows {
+    void operator()(const T *source, T *dest, int /* planes */, int rows, int cols, int zBegin, int zEnd) {
+        const size_t planeStep = size_t(rows) * cols;
+
+        for (int z = zBegin; z < zEnd; ++z) {
+            for (int y = 1; y < (rows-1); ++y) {
+                const T *center = source + (z*planeStep) + (y*cols) + 1;
+                jacobi3D_row7( center - planeStep, center - cols, center, center + cols, center + planeStep,
+                                dest + (z*planeStep) + (y*cols) + 1, cols-2 );
+            }
+        }
+    }
+};
+
+/******************************************************************************/
+
+// tile sizes for 2.5D blocking, so the source planes and dest plane of a tile share half of L2
+struct tile_size3D {
+    int rows;
+    int cols;
+};
+
+template <typename T>
+tile_size3D choose_tile3D( int rows, int cols, size_t cache_bytes ) {
+    tile_size3D result;
+    const size_t points = (cache_bytes / 2) / (4 * sizeof(T));
+    result.cols = int( std::min( size_t(cols - 2), std::max( size_t(16), std::min( size_t(512), points / 16 ) ) ) );
+    result.rows = int( std::min( size_t(rows - 2), std::max( size_t(4), points / result.cols ) ) );
+    return result;
+}
+
+/******************************************************************************/
+
+/*
+    2.5D blocking
+    Split each plane into tiles, and stream each tile through z.
+    Each source point is loaded from memory once, and reused from cache by the 2 neighboring planes.
+*/
+template <typename T>
+struct jacobi3D_blocked {
+    jacobi3D_blocked() : cache_bytes( benchmark::detect_cache_sizes().L2 ) {}
+
+    void operator()(const T *source, T *dest, int /* planes */, int rows, int cols, int zBegin, int zEnd) {
+        const size_t planeStep = size_t(rows) * cols;
+        const tile_size3D tile = choose_tile3D<T>( rows, cols, cache_bytes );
+
+        for (int y0 = 1; y0 < (rows-1); y0 += tile.rows) {
+            const int yEnd = std::min( y0 + tile.rows, rows-1 );
+            for (int x0 = 1; x0 < (cols-1); x0 += tile.cols) {
+                const int count = std::min( tile.cols, (cols-1) - x0 );
+                for (int z = zBegin; z < zEnd; ++z) {
+                    for (int y = y0; y < yEnd; ++y) {
+                        const T *center = source + (z*planeStep) + (y*cols) + x0;
+                        jacobi3D_row7( center - planeStep, center - cols, center, center + cols, center + planeStep,
+                                        dest + (z*planeStep) + (y*cols) + x0, count );
+                    }
+                }
+            }
+        }
+    }
+
+    size_t cache_bytes;
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    27 point stencil, all neighbors in the 3x3x3 cube
+    faces * 14 + edges * 3 + corners
+    result divided by 128
+*/
+template <typename T>
+struct jacobi3D_27_simple {
+    void operator()(const T *source, T *dest, int /* planes */, int rows, int cols, int zBegin, int zEnd) {
+        const T scale = T(1) / T(128);
+        const size_t ps = size_t(rows) * cols;
+        const size_t rs = cols;
+        int x, y, z;
+
+        for (z = zBegin; z < zEnd; ++z) {
+            for (y = 1; y < (rows-1); ++y) {
+                for (x = 1; x < (cols-1); ++x) {
+                    size_t i = (z*ps) + (y*rs) + x;
+
+                    T faces = source[i-ps];
+                    faces +=  source[i-rs];
+                    faces +=  source[i-1];
+                    faces +=  source[i+1];
+                    faces +=  source[i+rs];
+                    faces +=  source[i+ps];
+
+                    T edges = source[i-ps-rs];
+                    edges +=  source[i-ps-1];
+                    edges +=  source[i-ps+1];
+                    edges +=  source[i-ps+rs];
+                    edges +=  source[i-rs-1];
+                    edges +=  source[i-rs+1];
+                    edges +=  source[i+rs-1];
+                    edges +=  source[i+rs+1];
+                    edges +=  source[i+ps-rs];
+                    edges +=  source[i+ps-1];
+                    edges +=  source[i+ps+1];
+                    edges +=  source[i+ps+rs];
+
+                    T corners = source[i-ps-rs-1];
+                    corners +=  source[i-ps-rs+1];
+                    corners +=  source[i-ps+rs-1];
+                    corners +=  source[i-ps+rs+1];
+                    corners +=  source[i+ps-rs-1];
+                    corners +=  source[i+ps-rs+1];
+                    corners +=  source[i+ps+rs-1];
+                    corners +=  source[i+ps+rs+1];
+
+                    dest[i] = (T(14)*faces + T(3)*edges + corners) * scale;
+                }
+            }
+        }
+    }
+};
+
+/******************************************************************************/
+
+// one row of the 27 point stencil, row[dz][dy] points at the row offset by (dz-1, dy-1), same order as above
+template <typename T>
+inline void jacobi3D_row27( const T * const row[3][3], T *dest, int count ) {
+    const T scale = T(1) / T(128);
+    const T *bn = row[0][0], *bc = row[0][1], *bs = row[0][2];
+    const T *cn = row[1][0], *cc = row[1][1], *cs = row[1][2];
+    const T *fn = row[2][0], *fc = row[2][1], *fs = row[2][2];
+
+    for (int x = 0; x < count; ++x) {
+        T faces = bc[x];
+        faces +=  cn[x];
+        faces +=  cc[x-1];
+        faces +=  cc[x+1];
+        faces +=  cs[x];
+        faces +=  fc[x];
+
+        T edges = bn[x];
+        edges +=  bc[x-1];
+        edges +=  bc[x+1];
+        edges +=  bs[x];
+        edges +=  cn[x-1];
+        edges +=  cn[x+1];
+        edges +=  cs[x-1];
+        edges +=  cs[x+1];
+        edges +=  fn[x];
+        edges +=  fc[x-1];
+        edges +=  fc[x+1];
+        edges +=  fs[x];
+
+        T corners = bn[x-1];
+        corners +=  bn[x+1];
+        corners +=  bs[x-1];
+        corners +=  bs[x+1];
+        corners +=  fn[x-1];
+        corners +=  fn[x+1];
+        corners +=  fs[x-1];
+        corners +=  fs[x+1];
+
+        dest[x] = (T(14)*faces + T(3)*edges + corners) * scale;
+    }
+}
+
+/******************************************************************************/
+
+template <typename T>
+struct jacobi3D_27_rows {
+    void operator()(const T *source, T *dest, int /* planes */, int rows, int cols, int zBegin, int zEnd) {
+        const size_t planeStep = size_t(rows) * cols;
+
+        for (int z = zBegin; z < zEnd; ++z) {
+            for (int y = 1; y < (rows-1); ++y) {
+                const T *center = source + (z*planeStep) + (y*cols) + 1;
+                const T *row[3][3];
+                for (int dz = 0; dz < 3; ++dz)
+                    for (int dy = 0; dy < 3; ++dy)
+                        row[dz][dy] = center + (dz-1)*ptrdiff_t(planeStep) + (dy-1)*cols;
+                jacobi3D_row27( row, dest + (z*planeStep) + (y*cols) + 1, cols-2 );
+            }
+        }
+    }
+};
+
+/******************************************************************************/
+
+/*
+    27 point stencil with shared partial sums
+    Looking down the x axis, the 9 rows around a point fall into 3 classes:
+        the center row, the 4 rows sharing a face (axis), and the 4 rows sharing an edge (diagonal).
+    With axis[x] and diagonal[x] summed once per column, each point needs
+        14 * (axis[x] + center[x-1] + center[x+1]) + 3 * (diagonal[x] + axis[x-1] + axis[x+1]) + diagonal[x-1] + diagonal[x+1]
+    or about 10 adds instead of 26.
+    The sums are in a different order, so results differ from the simple version by rounding.
+*/
+template <typename T>
+inline void jacobi3D_row27_sums( const T * const row[3][3], T *dest, int count ) {
+    const T scale = T(1) / T(128);
+    const int chunk = 256;
+    T axis[ chunk + 2 ];
+    T diagonal[ chunk + 2 ];
+
+    for (int start = 0; start < count; start += chunk) {
+        const int length = std::min( chunk, count - start );
+        const T *bn = row[0][0] + start, *bc = row[0][1] + start, *bs = row[0][2] + start;
+        const T *cn = row[1][0] + start, *cc = row[1][1] + start, *cs = row[1][2] + start;
+        const T *fn = row[2][0] + start, *fc = row[2][1] + start, *fs = row[2][2] + start;
+
+        // column sums, including one column on each side
+        for (int x = -1; x <= length; ++x) {
+            axis[x+1] = bc[x] + cn[x] + cs[x] + fc[x];
+            diagonal[x+1] = bn[x] + bs[x] + fn[x] + fs[x];
+        }
+
+        T *out = dest + start;
+        for (int x = 0; x < length; ++x) {
+            T faces = axis[x+1] + cc[x-1] + cc[x+1];
+            T edges = diagonal[x+1] + axis[x] + axis[x+2];
+            T corners = diagonal[x] + diagonal[x+2];
+            out[x] = (T(14)*faces + T(3)*edges + corners) * scale;
+        }
+    }
+}
+
+/******************************************************************************/
+
+template <typename T>
+struct jacobi3D_27_sums {
+    void operator()(const T *source, T *dest, int /* planes */, int rows, int cols, int zBegin, int zEnd) {
+        const size_t planeStep = size_t(rows) * cols;
+
+        for (int z = zBegin; z < zEnd; ++z) {
+            for (int y = 1; y < (rows-1); ++y) {
+                const T *center = source + (z*planeStep) + (y*cols) + 1;
+                const T *row[3][3];
+                for (int dz = 0; dz < 3; ++dz)
+                    for (int dy = 0; dy < 3; ++dy)
+                        row[dz][dy] = center + (dz-1)*ptrdiff_t(planeStep) + (dy-1)*cols;
+                jacobi3D_row27_sums( row, dest + (z*planeStep) + (y*cols) + 1, cols-2 );
+            }
+        }
+    }
+};
+
+/******************************************************************************/
+
+// 2.5D blocking with shared partial sums
+template <typename T>
+struct jacobi3D_27_blocked {
+    jacobi3D_27_blocked() : cache_bytes( benchmark::detect_cache_sizes().L2 ) {}
+
+    void operator()(const T *source, T *dest, int /* planes */, int rows, int cols, int zBegin, int zEnd) {
+        const size_t planeStep = size_t(rows) * cols;
+        const tile_size3D tile = choose_tile3D<T>( rows, cols, cache_bytes );
+
+        for (int y0 = 1; y0 < (rows-1); y0 += tile.rows) {
+            const int yEnd = std::min( y0 + tile.rows, rows-1 );
+            for (int x0 = 1; x0 < (cols-1); x0 += tile.cols) {
+                const int count = std::min( tile.cols, (cols-1) - x0 );
+                for (int z = zBegin; z < zEnd; ++z) {
+                    for (int y = y0; y < yEnd; ++y) {
+                        const T *center = source + (z*planeStep) + (y*cols) + x0;
+                        const T *row[3][3];
+                        for (int dz = 0; dz < 3; ++dz)
+                            for (int dy = 0; dy < 3; ++dy)
+                                row[dz][dy] = center + (dz-1)*ptrdiff_t(planeStep) + (dy-1)*cols;
+                        jacobi3D_row27_sums( row, dest + (z*planeStep) + (y*cols) + x0, count );
+                    }
+                }
+            }
+        }
+    }
+
+    size_t cache_bytes;
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Slabs of planes, one per thread, each running a serial kernel
+    Jacobi only reads the source buffer, so the slabs need no ghost planes or exchanges,
+        just a barrier between steps (the end of pool.run).
+*/
+template <typename T, typename MM>
+class jacobi3D_slabs {
+public:
+    // kernels are built once, outside the timed steps
+    jacobi3D_slabs( benchmark::thread_pool &threads, int count ) : pool(threads), threadCount(count), kernels(count) {}
+
+    void operator()(const T *source, T *dest, int planes, int rows, int cols, int zBegin, int zEnd) {
+        const int interior = zEnd - zBegin;
+        pool.run( threadCount, [&]( int t ) {
+            int lo = zBegin + int( (int64_t(interior) * t) / threadCount );
+            int hi = zBegin + int( (int64_t(interior) * (t+1)) / threadCount );
+            kernels[t]( source, dest, planes, rows, cols, lo, hi );
+        } );
+    }
+
+private:
+    benchmark::thread_pool &pool;
+    int threadCount;
+    std::vector<MM> kernels;
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
+template <typename T, typename MM >
+double testLaplace3D(T *source, T *dest, int edge, int steps, MM calculator) {
+
+    laplace_initial_conditions3D( source, edge, edge, edge );
+    std::copy_n( source, size_t(edge)*edge*edge, dest );
+
+    start_wall_timer();
+
+    for( int i = 0; i < steps; ++i ) {
+
+        calculator( source, dest, edge, edge, edge, 1, edge-1 );
+
+        // exchange buffers
+        std::swap( source, dest );
+    }
+
+    return wall_timer();
+}
+
+/******************************************************************************/
+
+void record3D( double time, const std::string &label ) {
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label );
+    record_result( time, gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+// odd sizes and a few steps, compared to the simple versions
+template <typename T, typename MM, typename REF>
+void verify_jacobi3D( MM calculator, REF reference, T tolerance, const std::string &label ) {
+    const int planes = 23, rows = 29, cols = 37;
+    const int steps = 6;
+    const size_t count = size_t(planes) * rows * cols;
+    std::vector<T> a( count ), b( count ), c( count ), d( count );
+
+    laplace_initial_conditions3D( a.data(), planes, rows, cols );
+    b = a;
+    c = a;
+    d = a;
+
+    T *src1 = a.data(), *dst1 = b.data();
+    T *src2 = c.data(), *dst2 = d.data();
+    for (int i = 0; i < steps; ++i) {
+        calculator( src1, dst1, planes, rows, cols, 1, planes-1 );
+        reference( src2, dst2, planes, rows, cols, 1, planes-1 );
+        std::swap( src1, dst1 );
+        std::swap( src2, dst2 );
+    }
+
+    if (max_difference( src1, src2, count ) > tolerance)
+        printf("test %s failed\n", label.c_str() );
+}
+
+/******************************************************************************/
+
+template <typename T>
+void verify3D( const std::string &myTypeName ) {
+    const T sumsTolerance = (sizeof(T) > 4) ? T(1.0e-10) : T(1.0e-3);
+
+    // small pool, so we test the slab boundaries on any machine
+    benchmark::thread_pool testPool( 4 );
+
+    verify_jacobi3D( jacobi3D_rows<T>(), jacobi3D_simple<T>(), T(0), myTypeName + " jacobi 3D 7 point rows" );
+    verify_jacobi3D( jacobi3D_blocked<T>(), jacobi3D_simple<T>(), T(0), myTypeName + " jacobi 3D 7 point blocked" );
+    jacobi3D_blocked<T> smallTiles;
+    smallTiles.cache_bytes = 4 * 10 * 16 * sizeof(T) * 2;      // 16 column by 10 row tiles
+    verify_jacobi3D( smallTiles, jacobi3D_simple<T>(), T(0), myTypeName + " jacobi 3D 7 point blocked small tiles" );
+    for (int t = 2; t <= 4; ++t)
+        verify_jacobi3D( jacobi3D_slabs< T, jacobi3D_blocked<T> >( testPool, t ), jacobi3D_simple<T>(), T(0),
+                        myTypeName + " jacobi 3D 7 point slabs " + std::to_string(t) );
+
+    verify_jacobi3D( jacobi3D_27_rows<T>(), jacobi3D_27_simple<T>(), T(0), myTypeName + " jacobi 3D 27 point rows" );
+    verify_jacobi3D( jacobi3D_27_sums<T>(), jacobi3D_27_simple<T>(), sumsTolerance, myTypeName + " jacobi 3D 27 point sums" );
+    verify_jacobi3D( jacobi3D_27_blocked<T>(), jacobi3D_27_sums<T>(), T(0), myTypeName + " jacobi 3D 27 point blocked" );
+    jacobi3D_27_blocked<T> smallTiles27;
+    smallTiles27.cache_bytes = smallTiles.cache_bytes;
+    verify_jacobi3D( smallTiles27, jacobi3D_27_sums<T>(), T(0), myTypeName + " jacobi 3D 27 point blocked small tiles" );
+    for (int t = 2; t <= 4; ++t)
+        verify_jacobi3D( jacobi3D_slabs< T, jacobi3D_27_blocked<T> >( testPool, t ), jacobi3D_27_sums<T>(), T(0),
+                        myTypeName + " jacobi 3D 27 point slabs " + std::to_string(t) );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+template< typename T >
+void TestOneSize( benchmark::thread_pool &pool, int edge )
+{
+    std::string myTypeName( getTypeName<T>() );
+    char buffer[ 200 ];
+
+    const size_t count = size_t(edge) * edge * edge;
+    const double megabytes = 2.0 * count * sizeof(T) / (1024.0 * 1024.0);
+    if (megabytes > max_memory_MB) {
+        printf("skipping %s %d^3, needs %.0f MB (limit %.0f MB)\n\n", myTypeName.c_str(), edge, megabytes, max_memory_MB );
+        return;
+    }
+
+    std::vector<T> bufferA( count ), bufferB( count );
+    T *source = bufferA.data();
+    T *dest = bufferB.data();
+
+    // same number of updates on every grid size, and an even number of steps
+    int steps = int( std::max( int64_t(2), (int64_t(iterations) * REFERENCE_SIZE) / int64_t(count) ) );
+    steps = (steps + 1) & ~1;
+
+    std::vector<int> threadCounts;
+    for (int t = 2; t < pool.size(); t *= 2)
+        threadCounts.push_back( t );
+    if (pool.size() > 1)
+        threadCounts.push_back( pool.size() );
+
+    gLabels.clear();
+
+    record3D( testLaplace3D( source, dest, edge, steps, jacobi3D_simple<T>() ), myTypeName + " jacobi 3D 7 point simple" );
+    record3D( testLaplace3D( source, dest, edge, steps, jacobi3D_rows<T>() ), myTypeName + " jacobi 3D 7 point rows" );
+    double single7 = testLaplace3D( source, dest, edge, steps, jacobi3D_blocked<T>() );
+    record3D( single7, myTypeName + " jacobi 3D 7 point blocked" );
+    for (int threads : threadCounts) {
+        double elapsed = testLaplace3D( source, dest, edge, steps, jacobi3D_slabs< T, jacobi3D_blocked<T> >( pool, threads ) );
+        snprintf( buffer, sizeof(buffer), "%s jacobi 3D 7 point slabs, %d threads, %.0f%% efficiency",
+                    myTypeName.c_str(), threads, 100.0 * single7 / (elapsed * threads) );
+        record3D( elapsed, buffer );
+    }
+
+    record3D( testLaplace3D( source, dest, edge, steps, jacobi3D_27_simple<T>() ), myTypeName + " jacobi 3D 27 point simple" );
+    record3D( testLaplace3D( source, dest, edge, steps, jacobi3D_27_rows<T>() ), myTypeName + " jacobi 3D 27 point rows" );
+    record3D( testLaplace3D( source, dest, edge, steps, jacobi3D_27_sums<T>() ), myTypeName + " jacobi 3D 27 point sums" );
+    double single27 = testLaplace3D( source, dest, edge, steps, jacobi3D_27_blocked<T>() );
+    record3D( single27, myTypeName + " jacobi 3D 27 point blocked" );
+    for (int threads : threadCounts) {
+        double elapsed = testLaplace3D( source, dest, edge, steps, jacobi3D_slabs< T, jacobi3D_27_blocked<T> >( pool, threads ) );
+        snprintf( buffer, sizeof(buffer), "%s jacobi 3D 27 point slabs, %d threads, %.0f%% efficiency",
+                    myTypeName.c_str(), threads, 100.0 * single27 / (elapsed * threads) );
+        record3D( elapsed, buffer );
+    }
+
+    snprintf( buffer, sizeof(buffer), "%s PDE_laplace_3D jacobi %d^3", myTypeName.c_str(), edge );
+    summarize( buffer, int(count), steps, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+
+template< typename T >
+void TestOneType( benchmark::thread_pool &pool )
+{
+    std::string myTypeName( getTypeName<T>() );
+
+    verify3D<T>( myTypeName );
+
+    for (int edge : grid_edges)
+        TestOneSize<T>( pool, edge );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+int main(int argc, char** argv) {
+
+    // output command for documentation:
+    int i;
+    for (i = 0; i < argc; ++i)
+        printf("%s ", argv[i] );
+    printf("\n");
+
+    if (argc > 1) iterations = atoi(argv[1]);
+    if (argc > 2) max_memory_MB = (double) atof(argv[2]);
+
+
+    benchmark::thread_pool pool;
+
+    TestOneType<float>( pool );
+
+    TestOneType<double>( pool );
+
+
+    return 0;
+}
+
+// the end
+/******************************************************************************/
+/******************************************************************************/
@@ -10,6 +10,14 @@ Goal: Examine performance of common random number generators and corresponding s
 Assumptions:
     1) Random number generation will be well optimized.
 
+    2) Generating values in bulk will be faster than one call at a time,
+        and the compiler will vectorize independent lanes or counter based blocks.
+
+    3) Independent per-thread streams will scale with the number of cores.
+
+    4) Distributions built directly on random bits (Lemire bounded integers, bit pattern doubles,
+        Ziggurat normal and exponential) will be faster than the standard library distributions.
+
 
 
 TODO - template tests take 30-45 minutes!
@@ -24,15 +32,19 @@ uint32_t arc4random_uniform(uint32_t upper_bound);
 
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 using namespace std;
 #include <time.h>
 #include <string>
 #include <deque>
 #include <random>
 #include <algorithm>
+#include <vector>
+#include <cmath>
 #include "benchmark_stdint.hpp"
 #include "benchmark_timer.h"
 #include "benchmark_results.h"
+#include "benchmark_threads.h"
 
 /******************************************************************************/
 /******************************************************************************/
@@ -125,6 +137,1187 @@ int32_t randr32_local( uint32_t *seed )
 /******************************************************************************/
 /******************************************************************************/
 
+// Modern generators, each usable as a C++11 UniformRandomBitGenerator,
+//    plus a bulk fill(buffer, count) and set_stream(n) for independent per-thread streams.
+// The bulk fills are written as independent lanes, or as pure functions of a counter,
+//    so the compiler can vectorize them (no intrinsics, see the README).
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t splitmix64(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// 64x64 -> 128 bit multiply, returns the low half and stores the high half
+static inline uint64_t mul64x64(uint64_t a, uint64_t b, uint64_t &high) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)a * b;
+    high = (uint64_t)(product >> 64);
+    return (uint64_t)product;
+#else
+    uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo;
+    uint64_t hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi;
+    uint64_t hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFF) + lo_hi;
+    high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    return (cross << 32) | (lo_lo & 0xFFFFFFFF);
+#endif
+}
+
+/******************************************************************************/
+
+// xoshiro256** by Blackman and Vigna
+// The state is a linear recurrence, so fill() can't reproduce the scalar sequence in parallel.
+// Instead fill() runs kLanes interleaved copies, each a jump (2^128 values) apart,
+//    and single calls continue one jump past the last lane so they never repeat lane output.
+class xoshiro256ss {
+public:
+    typedef uint64_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+    static const int kLanes = 8;
+
+    explicit xoshiro256ss(uint64_t value = 1) { seed(value); }
+
+    void seed(uint64_t value) {
+        uint64_t temp = value;
+        for (int j = 0; j < 4; ++j)
+            s[j] = splitmix64(temp);
+        lanesReady = false;
+    }
+
+    // only used for known answer tests
+    void set_state(uint64_t s0, uint64_t s1, uint64_t s2, uint64_t s3) {
+        s[0] = s0;  s[1] = s1;  s[2] = s2;  s[3] = s3;
+        lanesReady = false;
+    }
+
+    result_type operator()() {
+        const uint64_t result = rotl64(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl64(s[3], 45);
+        return result;
+    }
+
+    // equivalent to 2^128 calls
+    void jump() {
+        static const uint64_t JUMP[] = { 0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL };
+        uint64_t t[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < 4; ++i)
+            for (int b = 0; b < 64; ++b) {
+                if (JUMP[i] & (1ULL << b))
+                    for (int j = 0; j < 4; ++j)
+                        t[j] ^= s[j];
+                (*this)();
+            }
+        for (int j = 0; j < 4; ++j)
+            s[j] = t[j];
+        lanesReady = false;
+    }
+
+    // each stream covers the lanes plus the single call sequence
+    void set_stream(uint64_t stream) {
+        for (uint64_t i = 0; i < stream*(kLanes+1); ++i)
+            jump();
+    }
+
+    void fill(uint64_t *buffer, size_t count) {
+        if (!lanesReady)
+            setup_lanes();
+        
+        // work on local copies so the compiler knows the buffer doesn't alias the state
+        uint64_t s0[kLanes], s1[kLanes], s2[kLanes], s3[kLanes];
+        for (int j = 0; j < kLanes; ++j) {
+            s0[j] = lane[0][j];  s1[j] = lane[1][j];  s2[j] = lane[2][j];  s3[j] = lane[3][j];
+        }
+
+        const size_t whole = count - (count % kLanes);
+        size_t i = 0;
+        for ( ; i < whole; i += kLanes) {
+            for (int j = 0; j < kLanes; ++j) {
+                const uint64_t result = rotl64(s1[j] * 5, 7) * 9;
+                const uint64_t t = s1[j] << 17;
+                s2[j] ^= s0[j];
+                s3[j] ^= s1[j];
+                s1[j] ^= s2[j];
+                s0[j] ^= s3[j];
+                s2[j] ^= t;
+                s3[j] = rotl64(s3[j], 45);
+                buffer[i+j] = result;
+            }
+        }
+
+        for (int j = 0; j < kLanes; ++j) {
+            lane[0][j] = s0[j];  lane[1][j] = s1[j];  lane[2][j] = s2[j];  lane[3][j] = s3[j];
+        }
+
+        for ( ; i < count; ++i)
+            buffer[i] = (*this)();
+    }
+
+private:
+    void setup_lanes() {
+        xoshiro256ss temp(*this);
+        for (int j = 0; j < kLanes; ++j) {
+            for (int k = 0; k < 4; ++k)
+                lane[k][j] = temp.s[k];
+            temp.jump();
+        }
+        // single calls move past the lanes
+        for (int k = 0; k < 4; ++k)
+            s[k] = temp.s[k];
+        lanesReady = true;
+    }
+
+    uint64_t s[4];
+    uint64_t lane[4][kLanes];
+    bool lanesReady;
+};
+
+/******************************************************************************/
+
+// PCG64 (XSL RR 128/64) by O'Neill, 128 bit LCG state
+// fill() reproduces the scalar sequence: each lane leaps ahead kLanes steps at a time,
+//    giving independent multiply chains instead of one serial chain.
+class pcg64 {
+public:
+    typedef uint64_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+    static const int kLanes = 4;
+
+    explicit pcg64(uint64_t value = 1) : inc_hi(0), inc_lo(1) {
+        setup_leap();
+        seed(value);
+    }
+
+    void seed(uint64_t value) {
+        state_hi = state_lo = 0;
+        step();
+        add128( state_hi, state_lo, 0, value );
+        step();
+    }
+
+    void set_stream(uint64_t stream) {
+        inc_hi = stream >> 63;
+        inc_lo = (stream << 1) | 1;
+        setup_leap();
+    }
+
+    result_type operator()() {
+        step();
+        return output( state_hi, state_lo );
+    }
+
+    void fill(uint64_t *buffer, size_t count) {
+        const size_t whole = count - (count % kLanes);
+        uint64_t hi[kLanes], lo[kLanes];
+        size_t i = 0;
+        if (whole > 0) {
+            for (int j = 0; j < kLanes; ++j) {
+                step();
+                hi[j] = state_hi;
+                lo[j] = state_lo;
+                buffer[j] = output( hi[j], lo[j] );
+            }
+            i = kLanes;
+            for ( ; i < whole; i += kLanes) {
+                for (int j = 0; j < kLanes; ++j) {
+                    mul128( hi[j], lo[j], leap_mult_hi, leap_mult_lo );
+                    add128( hi[j], lo[j], leap_inc_hi, leap_inc_lo );
+                    buffer[i+j] = output( hi[j], lo[j] );
+                }
+            }
+            state_hi = hi[kLanes-1];
+            state_lo = lo[kLanes-1];
+        }
+        for ( ; i < count; ++i)
+            buffer[i] = (*this)();
+    }
+
+private:
+    static const uint64_t kMultHi = 0x2360ED051FC65DA4ULL;
+    static const uint64_t kMultLo = 0x4385DF649FCCF645ULL;
+
+    static inline void mul128(uint64_t &hi, uint64_t &lo, uint64_t m_hi, uint64_t m_lo) {
+        uint64_t high;
+        uint64_t low = mul64x64( lo, m_lo, high );
+        high += lo * m_hi + hi * m_lo;
+        hi = high;
+        lo = low;
+    }
+
+    static inline void add128(uint64_t &hi, uint64_t &lo, uint64_t a_hi, uint64_t a_lo) {
+        uint64_t low = lo + a_lo;
+        hi += a_hi + (low < lo);
+        lo = low;
+    }
+
+    static inline uint64_t output(uint64_t hi, uint64_t lo) {
+        uint64_t value = hi ^ lo;
+        int rot = int(hi >> 58);
+        return (value >> rot) | (value << ((-rot) & 63));
+    }
+
+    inline void step() {
+        mul128( state_hi, state_lo, kMultHi, kMultLo );
+        add128( state_hi, state_lo, inc_hi, inc_lo );
+    }
+
+    // compose kLanes steps: x -> x*mult + inc, applied kLanes times
+    void setup_leap() {
+        uint64_t m_hi = 0, m_lo = 1, c_hi = 0, c_lo = 0;
+        for (int j = 0; j < kLanes; ++j) {
+            mul128( m_hi, m_lo, kMultHi, kMultLo );
+            mul128( c_hi, c_lo, kMultHi, kMultLo );
+            add128( c_hi, c_lo, inc_hi, inc_lo );
+        }
+        leap_mult_hi = m_hi;  leap_mult_lo = m_lo;
+        leap_inc_hi = c_hi;  leap_inc_lo = c_lo;
+    }
+
+    uint64_t state_hi, state_lo;
+    uint64_t inc_hi, inc_lo;
+    uint64_t leap_mult_hi, leap_mult_lo;
+    uint64_t leap_inc_hi, leap_inc_lo;
+};
+
+/******************************************************************************/
+
+// wyrand by Wang Yi
+// The state is a Weyl sequence, so value i is a pure function of the seed and i.
+class wyrand {
+public:
+    typedef uint64_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    explicit wyrand(uint64_t value = 1) { seed(value); }
+
+    void seed(uint64_t value) { state = value; }
+
+    void set_stream(uint64_t stream) {
+        uint64_t temp = state ^ stream;
+        state = splitmix64( temp );
+    }
+
+    result_type operator()() {
+        state += kIncrement;
+        return mix( state );
+    }
+
+    void fill(uint64_t *buffer, size_t count) {
+        const uint64_t base = state;
+        for (size_t i = 0; i < count; ++i)
+            buffer[i] = mix( base + (i+1) * kIncrement );
+        state = base + count * kIncrement;
+    }
+
+private:
+    static const uint64_t kIncrement = 0xA0761D6478BD642FULL;
+    static const uint64_t kMix = 0xE7037ED1A0B428DBULL;
+
+    static inline uint64_t mix(uint64_t value) {
+        uint64_t high;
+        uint64_t low = mul64x64( value, value ^ kMix, high );
+        return high ^ low;
+    }
+
+    uint64_t state;
+};
+
+/******************************************************************************/
+
+// Philox 4x32-10 by Salmon, Moraes, Dror and Shaw (Random123)
+// Counter based: block n is a pure function of the key and n, so blocks can be computed in any order.
+class philox4x32 {
+public:
+    typedef uint64_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    explicit philox4x32(uint64_t value = 1) { seed(value); }
+
+    void seed(uint64_t value) {
+        key0 = uint32_t(value);
+        key1 = uint32_t(value >> 32);
+        counter = 0;
+        available = 0;
+    }
+
+    // the high key word selects the stream, so streams never overlap
+    void set_stream(uint64_t stream) {
+        key1 ^= uint32_t(stream + 1) * 0x9E3779B9U;
+        counter = 0;
+        available = 0;
+    }
+
+    static inline void block(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint32_t k0, uint32_t k1, uint32_t out[4]) {
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t product0 = uint64_t(0xD2511F53U) * c0;
+            const uint64_t product1 = uint64_t(0xCD9E8D57U) * c2;
+            const uint32_t hi0 = uint32_t(product0 >> 32), lo0 = uint32_t(product0);
+            const uint32_t hi1 = uint32_t(product1 >> 32), lo1 = uint32_t(product1);
+            c0 = hi1 ^ c1 ^ k0;
+            c1 = lo1;
+            c2 = hi0 ^ c3 ^ k1;
+            c3 = lo0;
+            k0 += 0x9E3779B9U;
+            k1 += 0xBB67AE85U;
+        }
+        out[0] = c0;  out[1] = c1;  out[2] = c2;  out[3] = c3;
+    }
+
+    result_type operator()() {
+        if (available == 0) {
+            uint32_t out[4];
+            block( uint32_t(counter), uint32_t(counter >> 32), 0, 0, key0, key1, out );
+            counter++;
+            saved[0] = (uint64_t(out[1]) << 32) | out[0];
+            saved[1] = (uint64_t(out[3]) << 32) | out[2];
+            available = 2;
+        }
+        return saved[ 2 - available-- ];
+    }
+
+    void fill(uint64_t *buffer, size_t count) {
+        size_t i = 0;
+        while (available > 0 && i < count)
+            buffer[i++] = (*this)();
+
+        const uint64_t base = counter;
+        const size_t blocks = (count - i) / 2;
+        uint64_t *out64 = buffer + i;
+        for (size_t b = 0; b < blocks; ++b) {
+            const uint64_t n = base + b;
+            uint32_t out[4];
+            block( uint32_t(n), uint32_t(n >> 32), 0, 0, key0, key1, out );
+            out64[2*b+0] = (uint64_t(out[1]) << 32) | out[0];
+            out64[2*b+1] = (uint64_t(out[3]) << 32) | out[2];
+        }
+        counter = base + blocks;
+        i += 2*blocks;
+
+        for ( ; i < count; ++i)
+            buffer[i] = (*this)();
+    }
+
+private:
+    uint64_t counter;
+    uint64_t saved[2];
+    uint32_t key0, key1;
+    int available;
+};
+
+/******************************************************************************/
+
+// Threefry 2x64-20 by Salmon, Moraes, Dror and Shaw (Random123)
+// Counter based, like Philox, but only uses adds, rotates and xors.
+class threefry2x64 {
+public:
+    typedef uint64_t result_type;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    explicit threefry2x64(uint64_t value = 1) { seed(value); }
+
+    void seed(uint64_t value) {
+        key0 = value;
+        key1 = 0;
+        counter = 0;
+        available = 0;
+    }
+
+    // the second key word selects the stream, so streams never overlap
+    void set_stream(uint64_t stream) {
+        key1 = stream + 1;
+        counter = 0;
+        available = 0;
+    }
+
+    static inline void block(uint64_t c0, uint64_t c1, uint64_t k0, uint64_t k1, uint64_t out[2]) {
+        const uint64_t k2 = 0x1BD11BDAA9FC1A22ULL ^ k0 ^ k1;
+        uint64_t x0 = c0 + k0;
+        uint64_t x1 = c1 + k1;
+        // written out, so every rotate count is a constant
+        four_rounds( x0, x1, 16, 42, 12, 31 );    x0 += k1;  x1 += k2 + 1;
+        four_rounds( x0, x1, 16, 32, 24, 21 );    x0 += k2;  x1 += k0 + 2;
+        four_rounds( x0, x1, 16, 42, 12, 31 );    x0 += k0;  x1 += k1 + 3;
+        four_rounds( x0, x1, 16, 32, 24, 21 );    x0 += k1;  x1 += k2 + 4;
+        four_rounds( x0, x1, 16, 42, 12, 31 );    x0 += k2;  x1 += k0 + 5;
+        out[0] = x0;
+        out[1] = x1;
+    }
+
+    result_type operator()() {
+        if (available == 0) {
+            block( counter, 0, key0, key1, saved );
+            counter++;
+            available = 2;
+        }
+        return saved[ 2 - available-- ];
+    }
+
+    void fill(uint64_t *buffer, size_t count) {
+        size_t i = 0;
+        while (available > 0 && i < count)
+            buffer[i++] = (*this)();
+
+        const uint64_t base = counter;
+        const size_t blocks = (count - i) / 2;
+        uint64_t *out64 = buffer + i;
+        for (size_t b = 0; b < blocks; ++b) {
+            uint64_t out[2];
+            block( base + b, 0, key0, key1, out );
+            out64[2*b+0] = out[0];
+            out64[2*b+1] = out[1];
+        }
+        counter = base + blocks;
+        i += 2*blocks;
+
+        for ( ; i < count; ++i)
+            buffer[i] = (*this)();
+    }
+
+private:
+    static inline void four_rounds(uint64_t &x0, uint64_t &x1, int r0, int r1, int r2, int r3) {
+        x0 += x1;  x1 = rotl64( x1, r0 );  x1 ^= x0;
+        x0 += x1;  x1 = rotl64( x1, r1 );  x1 ^= x0;
+        x0 += x1;  x1 = rotl64( x1, r2 );  x1 ^= x0;
+        x0 += x1;  x1 = rotl64( x1, r3 );  x1 ^= x0;
+    }
+
+    uint64_t counter;
+    uint64_t saved[2];
+    uint64_t key0, key1;
+    int available;
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
+// known answers, from the reference implementations
+void verify_generators()
+{
+    xoshiro256ss xoshiro;
+    xoshiro.set_state( 1, 2, 3, 4 );
+    uint64_t x0 = xoshiro();
+    uint64_t x1 = xoshiro();
+    uint64_t x2 = xoshiro();
+    if (x0 != 0x2D00ULL || x1 != 0 || x2 != 0x5A007080ULL)
+        printf("xoshiro256** known answer test failed\n");
+
+    uint32_t out32[4];
+    philox4x32::block( 0, 0, 0, 0, 0, 0, out32 );
+    if (out32[0] != 0x6627E8D5U || out32[1] != 0xE169C58DU || out32[2] != 0xBC57AC4CU || out32[3] != 0x9B00DBD8U)
+        printf("philox4x32-10 known answer test failed\n");
+    philox4x32::block( 0x243F6A88U, 0x85A308D3U, 0x13198A2EU, 0x03707344U, 0xA4093822U, 0x299F31D0U, out32 );
+    if (out32[0] != 0xD16CFE09U || out32[1] != 0x94FDCCEBU || out32[2] != 0x5001E420U || out32[3] != 0x24126EA1U)
+        printf("philox4x32-10 known answer test failed\n");
+
+    uint64_t out64[2];
+    threefry2x64::block( 0, 0, 0, 0, out64 );
+    if (out64[0] != 0xC2B6E3A8C2C69865ULL || out64[1] != 0x6F81ED42F350084DULL)
+        printf("threefry2x64-20 known answer test failed\n");
+    threefry2x64::block( 0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL, out64 );
+    if (out64[0] != 0x263C7D30BB0F0AF1ULL || out64[1] != 0x56BE8361D3311526ULL)
+        printf("threefry2x64-20 known answer test failed\n");
+}
+
+/******************************************************************************/
+
+// the values fill() should produce, from single calls
+template<class Gen>
+void reference_fill(Gen &gen, uint64_t *buffer, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        buffer[i] = gen();
+}
+
+// xoshiro256** interleaves lanes a jump apart, then single calls continue one jump past the last lane
+void reference_fill(xoshiro256ss &gen, uint64_t *buffer, size_t count)
+{
+    const int kLanes = xoshiro256ss::kLanes;
+    std::vector<xoshiro256ss> lanes;
+    for (int j = 0; j < kLanes; ++j) {
+        lanes.push_back( gen );
+        gen.jump();
+    }
+
+    const size_t whole = count - (count % kLanes);
+    size_t i = 0;
+    for ( ; i < whole; i += kLanes)
+        for (int j = 0; j < kLanes; ++j)
+            buffer[i+j] = lanes[j]();
+
+    for ( ; i < count; ++i)
+        buffer[i] = gen();
+}
+
+/******************************************************************************/
+
+// fill() must match the reference sequence, and later calls must continue it
+template<class Gen>
+void verify_fill(const char *label)
+{
+    const size_t count = 1003;     // odd, to exercise the tails
+    std::vector<uint64_t> scalar( count+1 ), bulk( count+1 );
+    Gen a( init_value ), b( init_value );
+    a.set_stream( 3 );
+    b.set_stream( 3 );
+    scalar[0] = a();
+    bulk[0] = b();      // leave counter based generators part way through a block
+    reference_fill( a, &scalar[1], count );
+    b.fill( &bulk[1], count );
+    if (scalar != bulk || a() != b())
+        printf("test %s fill failed\n", label);
+}
+
+/******************************************************************************/
+
+// cheap sanity check on bulk output: mean and the balance of each bit
+template<class Gen>
+void verify_bulk_statistics(const char *label)
+{
+    const size_t count = 1 << 16;
+    std::vector<uint64_t> values( count );
+    Gen g( init_value );
+    g.fill( &values[0], count );
+
+    double mean = 0.0;
+    int bitCounts[64] = { 0 };
+    for (size_t i = 0; i < count; ++i) {
+        mean += values[i] * (1.0 / 18446744073709551616.0);
+        for (int b = 0; b < 64; ++b)
+            bitCounts[b] += int((values[i] >> b) & 1);
+    }
+    mean /= count;
+
+    // 6 sigma limits, so this should never fail for a decent generator
+    const double meanLimit = 6.0 * sqrt( 1.0 / (12.0 * count) );
+    const double bitLimit = 6.0 * sqrt( count * 0.25 );
+    bool failed = fabs( mean - 0.5 ) > meanLimit;
+    for (int b = 0; b < 64; ++b)
+        if (fabs( bitCounts[b] - count * 0.5 ) > bitLimit)
+            failed = true;
+    if (failed)
+        printf("test %s statistics failed (mean %f)\n", label, mean);
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+// keep results alive, so the compiler can't remove the loops
+uint64_t gGeneratorSum = 0;
+
+const size_t kBulkSize = 8000;      // 64k bytes, stays in cache
+
+uint64_t gBulkBuffer[ kBulkSize ];
+
+/******************************************************************************/
+
+template<class Gen>
+void test_raw_generator( Gen &g, const char *label )
+{
+    uint64_t sum = 0;
+    start_timer();
+    for (int i = 0; i != iterations; ++i)
+        {
+        sum += g();
+        }
+    gGeneratorSum += sum;
+    record_result( timer(), label );
+}
+
+/******************************************************************************/
+
+// baseline for bulk generation: one call per value
+template<class Gen>
+void test_bulk_calls( Gen &g, const char *label )
+{
+    const int passes = iterations / (int)kBulkSize;
+    start_timer();
+    for (int i = 0; i != passes; ++i)
+        {
+        for (size_t j = 0; j < kBulkSize; ++j)
+            gBulkBuffer[j] = g();
+        gGeneratorSum += gBulkBuffer[ i % kBulkSize ];
+        }
+    record_result( timer(), label );
+}
+
+/******************************************************************************/
+
+template<class Gen>
+void test_bulk_fill( Gen &g, const char *label )
+{
+    const int passes = iterations / (int)kBulkSize;
+    start_timer();
+    for (int i = 0; i != passes; ++i)
+        {
+        g.fill( gBulkBuffer, kBulkSize );
+        gGeneratorSum += gBulkBuffer[ i % kBulkSize ];
+        }
+    record_result( timer(), label );
+}
+
+/******************************************************************************/
+
+// The same total count is split over the threads, each with its own stream and buffer.
+template<class Gen>
+void test_threaded_fill( benchmark::thread_pool &pool, int threads, const char *gen_label, stringPool &stringStorage )
+{
+    const int passes = iterations / (int)kBulkSize;
+    std::vector<uint64_t> sums( threads * 8, 0 );     // spaced out to avoid false sharing
+
+    start_wall_timer();
+    pool.run( threads, [&]( int index ) {
+        Gen g( init_value );
+        g.set_stream( index );
+        std::vector<uint64_t> buffer( kBulkSize );
+        uint64_t sum = 0;
+        for (int i = index; i < passes; i += threads) {
+            g.fill( &buffer[0], kBulkSize );
+            sum += buffer[ i % kBulkSize ];
+        }
+        sums[ index * 8 ] = sum;
+    } );
+    double elapsed = wall_timer();
+
+    for (int i = 0; i < threads; ++i)
+        gGeneratorSum += sums[ i * 8 ];
+
+    stringStorage.push_back( string(gen_label) + " fill " + std::to_string(threads) + " threads" );
+    record_result( elapsed, stringStorage.back().c_str() );
+}
+
+/******************************************************************************/
+
+template<class Gen>
+void test_threaded_generator( benchmark::thread_pool &pool, const char *gen_label, stringPool &stringStorage )
+{
+    for (int threads = 1; threads < pool.size(); threads *= 2)
+        test_threaded_fill<Gen>( pool, threads, gen_label, stringStorage );
+    test_threaded_fill<Gen>( pool, pool.size(), gen_label, stringStorage );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+// Fast distribution sampling
+// Most code pays for the distribution more than for the engine, so these replace
+//    uniform_int_distribution, uniform_real_distribution, normal_distribution and
+//    exponential_distribution with cheaper methods that work from raw bits.
+
+constexpr int floor_log2(uint64_t x) {
+    return (x <= 1) ? 0 : 1 + floor_log2(x >> 1);
+}
+
+// number of uniformly random bits we can take from each call to the engine
+template<class Gen>
+struct engine_bits {
+    static constexpr uint64_t range = uint64_t(Gen::max() - Gen::min());
+    static constexpr int bits = (range == UINT64_MAX) ? 64 : floor_log2(range + 1);
+    static constexpr uint64_t mask = (bits >= 64) ? UINT64_MAX : ((1ULL << (bits & 63)) - 1);
+};
+
+// Engines with ranges that are not a power of 2 (minstd_rand, knuth_b) have a tiny bias here,
+//    which we accept for benchmarking.
+template<class Gen>
+inline uint64_t random_bits64(Gen &g) {
+    const int bits = engine_bits<Gen>::bits;
+    if (bits >= 64)
+        return uint64_t(g() - Gen::min());
+    uint64_t result = 0;
+    for (int have = 0; have < 64; have += bits)
+        result = (result << (bits & 63)) ^ (uint64_t(g() - Gen::min()) & engine_bits<Gen>::mask);
+    return result;
+}
+
+template<class Gen>
+inline uint32_t random_bits32(Gen &g) {
+    const int bits = engine_bits<Gen>::bits;
+    if (bits >= 32)
+        return uint32_t(g() - Gen::min());
+    uint32_t result = 0;
+    for (int have = 0; have < 32; have += bits)
+        result = (result << (bits & 31)) ^ uint32_t(uint64_t(g() - Gen::min()) & engine_bits<Gen>::mask);
+    return result;
+}
+
+/******************************************************************************/
+
+// Lemire's nearly divisionless method, result in [0, range)
+// The modulo only happens when the low word lands in the small rejection zone.
+template<class Gen>
+inline uint32_t bounded_lemire(Gen &g, uint32_t range) {
+    uint64_t product = uint64_t( random_bits32(g) ) * range;
+    uint32_t low = uint32_t(product);
+    if (low < range) {
+        const uint32_t threshold = uint32_t(-range) % range;
+        while (low < threshold) {
+            product = uint64_t( random_bits32(g) ) * range;
+            low = uint32_t(product);
+        }
+    }
+    return uint32_t(product >> 32);
+}
+
+/******************************************************************************/
+
+// [0,1) with 52 bits: put random bits in the mantissa of a double in [1,2), then subtract 1
+static inline double bits_to_double(uint64_t bits) {
+    const uint64_t pattern = 0x3FF0000000000000ULL | (bits >> 12);
+    double result;
+    memcpy( &result, &pattern, sizeof(result) );
+    return result - 1.0;
+}
+
+// [0,1) with 53 bits
+static inline double bits_to_double53(uint64_t bits) {
+    return double(bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/******************************************************************************/
+
+// Ziggurat method for the standard normal distribution, Marsaglia and Tsang (2000),
+//    with 53 bit uniforms and the rectangle test rewritten as a ratio, like Doornik's ZIGNOR.
+// About 99% of samples take one random word, one table lookup, a compare and a multiply.
+class ziggurat_normal {
+public:
+    static const int kLayers = 128;
+
+    ziggurat_normal() {
+        const double R = 3.442619855899;
+        const double V = 9.91256303526217e-3;
+        const double fR = exp( -0.5 * R * R );
+        edge[0] = V / fR;
+        edge[1] = R;
+        for (int i = 1; i < kLayers-1; ++i)
+            edge[i+1] = sqrt( -2.0 * log( V / edge[i] + exp( -0.5 * edge[i] * edge[i] ) ) );
+        edge[kLayers] = 0.0;
+        for (int i = 0; i < kLayers; ++i)
+            ratio[i] = edge[i+1] / edge[i];
+        tail = R;
+    }
+
+    template<class Gen>
+    double operator()(Gen &g) const {
+        for (;;) {
+            const uint64_t bits = random_bits64(g);
+            const int i = int(bits & (kLayers-1));
+            const double u = double( int64_t(bits) >> 11 ) * (1.0 / 4503599627370496.0);  // [-1,1)
+            if (fabs(u) < ratio[i])
+                return u * edge[i];     // inside the rectangle, the common case
+            double result;
+            if (slow_path( g, i, u, result ))
+                return result;
+        }
+    }
+
+    // the edge and the tail of each layer, rarely used
+    template<class Gen>
+    bool slow_path(Gen &g, int i, double u, double &result) const {
+        if (i == 0) {
+            double x, y;
+            do {
+                x = -log( 1.0 - bits_to_double53( random_bits64(g) ) ) / tail;
+                y = -log( 1.0 - bits_to_double53( random_bits64(g) ) );
+            } while (2.0 * y < x * x);
+            result = (u < 0.0) ? -(tail + x) : (tail + x);
+            return true;
+        }
+        const double x = u * edge[i];
+        const double f0 = exp( -0.5 * (edge[i] * edge[i] - x * x) );
+        const double f1 = exp( -0.5 * (edge[i+1] * edge[i+1] - x * x) );
+        if (f1 + bits_to_double53( random_bits64(g) ) * (f0 - f1) < 1.0) {
+            result = x;
+            return true;
+        }
+        return false;
+    }
+
+    double edge[kLayers+1];
+    double ratio[kLayers];
+    double tail;
+};
+
+/******************************************************************************/
+
+// Ziggurat method for the standard exponential distribution, Marsaglia and Tsang (2000)
+class ziggurat_exponential {
+public:
+    static const int kLayers = 256;
+
+    ziggurat_exponential() {
+        const double R = 7.69711747013104972;
+        const double V = 3.949659822581572e-3;
+        edge[0] = V / exp( -R );
+        edge[1] = R;
+        for (int i = 1; i < kLayers-1; ++i)
+            edge[i+1] = -log( V / edge[i] + exp( -edge[i] ) );
+        edge[kLayers] = 0.0;
+        for (int i = 0; i < kLayers; ++i)
+            ratio[i] = edge[i+1] / edge[i];
+        tail = R;
+    }
+
+    template<class Gen>
+    double operator()(Gen &g) const {
+        for (;;) {
+            const uint64_t bits = random_bits64(g);
+            const int i = int(bits & (kLayers-1));
+            const double u = bits_to_double53( bits );
+            if (u < ratio[i])
+                return u * edge[i];     // inside the rectangle, the common case
+            double result;
+            if (slow_path( g, i, u, result ))
+                return result;
+        }
+    }
+
+    template<class Gen>
+    bool slow_path(Gen &g, int i, double u, double &result) const {
+        if (i == 0) {
+            result = tail - log( 1.0 - bits_to_double53( random_bits64(g) ) );
+            return true;
+        }
+        const double x = u * edge[i];
+        const double f0 = exp( -(edge[i] - x) );
+        const double f1 = exp( -(edge[i+1] - x) );
+        if (f1 + bits_to_double53( random_bits64(g) ) * (f0 - f1) < 1.0) {
+            result = x;
+            return true;
+        }
+        return false;
+    }
+
+    double edge[kLayers+1];
+    double ratio[kLayers];
+    double tail;
+};
+
+const ziggurat_normal gZigguratNormal;
+const ziggurat_exponential gZigguratExponential;
+
+/******************************************************************************/
+
+// Bulk versions, for generators with fill(): make a block of raw bits, then transform it.
+// The transforms are simple enough for the compiler to vectorize the common case.
+
+double gDoubleBuffer[ kBulkSize ];
+uint32_t gIntBuffer[ kBulkSize ];
+
+template<class Gen>
+void fill_uniform_double(Gen &g, double *out, size_t count) {
+    for (size_t start = 0; start < count; start += kBulkSize) {
+        const size_t n = std::min( kBulkSize, count - start );
+        g.fill( gBulkBuffer, n );
+        for (size_t j = 0; j < n; ++j)
+            out[start+j] = bits_to_double( gBulkBuffer[j] );
+    }
+}
+
+template<class Gen>
+void fill_bounded(Gen &g, uint32_t *out, size_t count, uint32_t range) {
+    const uint32_t threshold = uint32_t(-range) % range;
+    for (size_t start = 0; start < count; start += kBulkSize) {
+        const size_t n = std::min( kBulkSize, count - start );
+        g.fill( gBulkBuffer, n );
+        for (size_t j = 0; j < n; ++j) {
+            uint64_t product = uint64_t( uint32_t(gBulkBuffer[j]) ) * range;
+            if (uint32_t(product) < threshold)      // rare, resample like the scalar version
+                product = uint64_t( bounded_lemire( g, range ) ) << 32;
+            out[start+j] = uint32_t(product >> 32);
+        }
+    }
+}
+
+template<class Gen>
+void fill_normal(Gen &g, double *out, size_t count) {
+    const ziggurat_normal &zig = gZigguratNormal;
+    for (size_t start = 0; start < count; start += kBulkSize) {
+        const size_t n = std::min( kBulkSize, count - start );
+        g.fill( gBulkBuffer, n );
+        for (size_t j = 0; j < n; ++j) {
+            const uint64_t bits = gBulkBuffer[j];
+            const int i = int(bits & (ziggurat_normal::kLayers-1));
+            const double u = double( int64_t(bits) >> 11 ) * (1.0 / 4503599627370496.0);
+            double result = u * zig.edge[i];
+            if (!(fabs(u) < zig.ratio[i])) {
+                if (!zig.slow_path( g, i, u, result ))
+                    result = zig( g );
+            }
+            out[start+j] = result;
+        }
+    }
+}
+
+template<class Gen>
+void fill_exponential(Gen &g, double *out, size_t count) {
+    const ziggurat_exponential &zig = gZigguratExponential;
+    for (size_t start = 0; start < count; start += kBulkSize) {
+        const size_t n = std::min( kBulkSize, count - start );
+        g.fill( gBulkBuffer, n );
+        for (size_t j = 0; j < n; ++j) {
+            const uint64_t bits = gBulkBuffer[j];
+            const int i = int(bits & (ziggurat_exponential::kLayers-1));
+            const double u = bits_to_double53( bits );
+            double result = u * zig.edge[i];
+            if (!(u < zig.ratio[i])) {
+                if (!zig.slow_path( g, i, u, result ))
+                    result = zig( g );
+            }
+            out[start+j] = result;
+        }
+    }
+}
+
+/******************************************************************************/
+
+// Statistical checks, with limits around 6 sigma so they should never fail by chance.
+
+static bool check_limit(double value, double expected, double sigma) {
+    return fabs( value - expected ) <= 6.0 * sigma;
+}
+
+static bool check_moments(const std::vector<double> &values, double mean, double variance, double fourthMoment) {
+    const double n = double(values.size());
+    double sum = 0.0, sum2 = 0.0;
+    for (double v : values)
+        sum += v;
+    const double sampleMean = sum / n;
+    for (double v : values)
+        sum2 += (v - sampleMean) * (v - sampleMean);
+    const double sampleVariance = sum2 / (n - 1.0);
+    return check_limit( sampleMean, mean, sqrt( variance / n ) )
+        && check_limit( sampleVariance, variance, sqrt( (fourthMoment - variance*variance) / n ) );
+}
+
+static bool check_fraction(const std::vector<double> &values, double limit, bool absolute, double expected) {
+    size_t count = 0;
+    for (double v : values)
+        if ((absolute ? fabs(v) : v) < limit)
+            count++;
+    const double n = double(values.size());
+    return check_limit( count / n, expected, sqrt( expected * (1.0 - expected) / n ) );
+}
+
+// chi-square against equally likely buckets, limit is well past the 0.0001 critical value
+static bool check_buckets(const std::vector<uint32_t> &counts, size_t total) {
+    const double expected = double(total) / counts.size();
+    double chi = 0.0;
+    for (uint32_t c : counts)
+        chi += (c - expected) * (c - expected) / expected;
+    const double dof = double(counts.size() - 1);
+    return chi < dof + 8.0 * sqrt( 2.0 * dof );
+}
+
+template<class Gen>
+void verify_distributions( Gen &g, const char *gen_label )
+{
+    const size_t count = 1 << 18;
+    std::vector<double> values( count );
+
+    std::vector<uint32_t> buckets( 10, 0 );
+    bool inRange = true;
+    for (size_t i = 0; i < count; ++i) {
+        buckets[ bounded_lemire( g, 10 ) ]++;
+        inRange = inRange && (bounded_lemire( g, 19999 ) < 19999);
+    }
+    if (!inRange || !check_buckets( buckets, count ))
+        printf("test bounded_lemire %s failed\n", gen_label);
+
+    std::vector<uint32_t> buckets16( 16, 0 );
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = bits_to_double( random_bits64(g) );
+        inRange = inRange && (values[i] >= 0.0 && values[i] < 1.0);
+        buckets16[ int(values[i] * 16.0) & 15 ]++;
+    }
+    if (!inRange || !check_buckets( buckets16, count ) || !check_moments( values, 0.5, 1.0/12.0, 1.0/80.0 ))
+        printf("test bits_to_double %s failed\n", gen_label);
+
+    for (size_t i = 0; i < count; ++i)
+        values[i] = gZigguratNormal( g );
+    if (!check_moments( values, 0.0, 1.0, 3.0 )
+        || !check_fraction( values, 1.0, true, erf( 1.0 / sqrt(2.0) ) )
+        || !check_fraction( values, 2.0, true, erf( 2.0 / sqrt(2.0) ) )
+        || !check_fraction( values, 3.0, true, erf( 3.0 / sqrt(2.0) ) )
+        || !check_fraction( values, 0.0, false, 0.5 ))
+        printf("test ziggurat normal %s failed\n", gen_label);
+
+    bool positive = true;
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = gZigguratExponential( g );
+        positive = positive && (values[i] >= 0.0);
+    }
+    if (!positive || !check_moments( values, 1.0, 1.0, 9.0 )
+        || !check_fraction( values, 1.0, false, 1.0 - exp( -1.0 ) )
+        || !check_fraction( values, 3.0, false, 1.0 - exp( -3.0 ) ))
+        printf("test ziggurat exponential %s failed\n", gen_label);
+}
+
+/******************************************************************************/
+
+template<class Gen>
+void verify_bulk_distributions( Gen &g, const char *gen_label )
+{
+    const size_t count = 1 << 18;
+    std::vector<double> values( count );
+    std::vector<uint32_t> ints( count );
+
+    fill_bounded( g, &ints[0], count, 10 );
+    std::vector<uint32_t> buckets( 10, 0 );
+    bool inRange = true;
+    for (size_t i = 0; i < count; ++i) {
+        inRange = inRange && (ints[i] < 10);
+        buckets[ ints[i] % 10 ]++;
+    }
+    if (!inRange || !check_buckets( buckets, count ))
+        printf("test bounded bulk %s failed\n", gen_label);
+
+    fill_uniform_double( g, &values[0], count );
+    if (!check_moments( values, 0.5, 1.0/12.0, 1.0/80.0 ))
+        printf("test uniform double bulk %s failed\n", gen_label);
+
+    fill_normal( g, &values[0], count );
+    if (!check_moments( values, 0.0, 1.0, 3.0 ) || !check_fraction( values, 2.0, true, erf( 2.0 / sqrt(2.0) ) ))
+        printf("test normal bulk %s failed\n", gen_label);
+
+    fill_exponential( g, &values[0], count );
+    if (!check_moments( values, 1.0, 1.0, 9.0 ) || !check_fraction( values, 3.0, false, 1.0 - exp( -3.0 ) ))
+        printf("test exponential bulk %s failed\n", gen_label);
+}
+
+/******************************************************************************/
+
+// distribution tests take a lot longer per value, so use fewer values
+int distribution_iterations() { return std::max( 1, iterations / 10 ); }
+
+// record one timed loop with a label built from the distribution and engine
+static void record_distribution( double time, const char *what, const char *gen_label, stringPool &stringStorage ) {
+    stringStorage.push_back( string(what) + " " + gen_label );
+    record_result( time, stringStorage.back().c_str() );
+}
+
+/******************************************************************************/
+
+template<class Gen>
+void test_fast_distributions( Gen &g, const char *gen_label, stringPool &stringStorage )
+{
+    const int count = distribution_iterations();
+    int64_t sum = 0;
+    double sumDouble = 0.0;
+    int i;
+
+    verify_distributions( g, gen_label );
+
+    uniform_int_distribution<int32_t> uniformInts( -9999, 9999 );
+    uniform_real_distribution<double> uniformDoubles( 0.0, 1.0 );
+    normal_distribution<double> normalDoubles( 0.0, 1.0 );
+    exponential_distribution<double> exponentialDoubles( 1.0 );
+
+    start_timer();
+    for (i = 0; i != count; ++i)
+        sum += uniformInts(g);
+    record_distribution( timer(), "uniform_int_distribution", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != count; ++i)
+        sum += int32_t( bounded_lemire( g, 19999 ) ) - 9999;
+    record_distribution( timer(), "bounded_lemire", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != count; ++i)
+        sumDouble += uniformDoubles(g);
+    record_distribution( timer(), "uniform_real_distribution<double>", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != count; ++i)
+        sumDouble += bits_to_double( random_bits64(g) );
+    record_distribution( timer(), "bits_to_double", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != count; ++i)
+        sumDouble += normalDoubles(g);
+    record_distribution( timer(), "normal_distribution<double>", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != count; ++i)
+        sumDouble += gZigguratNormal(g);
+    record_distribution( timer(), "ziggurat normal", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != count; ++i)
+        sumDouble += exponentialDoubles(g);
+    record_distribution( timer(), "exponential_distribution<double>", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != count; ++i)
+        sumDouble += gZigguratExponential(g);
+    record_distribution( timer(), "ziggurat exponential", gen_label, stringStorage );
+
+    gGeneratorSum += uint64_t(sum) + uint64_t(sumDouble);
+}
+
+/******************************************************************************/
+
+template<class Gen>
+void test_bulk_distributions( Gen &g, const char *gen_label, stringPool &stringStorage )
+{
+    const int passes = std::max( 1, distribution_iterations() / (int)kBulkSize );
+    double sumDouble = 0.0;
+    int i;
+
+    verify_bulk_distributions( g, gen_label );
+
+    start_timer();
+    for (i = 0; i != passes; ++i) {
+        fill_bounded( g, gIntBuffer, kBulkSize, 19999 );
+        sumDouble += gIntBuffer[ i % kBulkSize ];
+    }
+    record_distribution( timer(), "bounded bulk", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != passes; ++i) {
+        fill_uniform_double( g, gDoubleBuffer, kBulkSize );
+        sumDouble += gDoubleBuffer[ i % kBulkSize ];
+    }
+    record_distribution( timer(), "uniform double bulk", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != passes; ++i) {
+        fill_normal( g, gDoubleBuffer, kBulkSize );
+        sumDouble += gDoubleBuffer[ i % kBulkSize ];
+    }
+    record_distribution( timer(), "normal bulk", gen_label, stringStorage );
+
+    start_timer();
+    for (i = 0; i != passes; ++i) {
+        fill_exponential( g, gDoubleBuffer, kBulkSize );
+        sumDouble += gDoubleBuffer[ i % kBulkSize ];
+    }
+    record_distribution( timer(), "exponential bulk", gen_label, stringStorage );
+
+    gGeneratorSum += uint64_t(sumDouble);
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 
 template<class _URNG>
 void test_one_generator( _URNG &g, const char *gen_label, int32_t &sum, double &sumDouble, stringPool &stringStorage )
@@ -404,6 +1597,102 @@ int main (int argc, char *argv[])
     summarize("std random templates", 1, iterations, kDontShowGMeans, kDontShowPenalty );
 
 
+
+// modern generators
+    verify_generators();
+    verify_fill<xoshiro256ss>( "xoshiro256**" );
+    verify_fill<pcg64>( "pcg64" );
+    verify_fill<wyrand>( "wyrand" );
+    verify_fill<philox4x32>( "philox4x32-10" );
+    verify_fill<threefry2x64>( "threefry2x64-20" );
+    verify_bulk_statistics<xoshiro256ss>( "xoshiro256**" );
+    verify_bulk_statistics<pcg64>( "pcg64" );
+    verify_bulk_statistics<wyrand>( "wyrand" );
+    verify_bulk_statistics<philox4x32>( "philox4x32-10" );
+    verify_bulk_statistics<threefry2x64>( "threefry2x64-20" );
+
+    xoshiro256ss xoshiro_gen(init_value+42);
+    pcg64 pcg64_gen(init_value+42);
+    wyrand wyrand_gen(init_value+42);
+    philox4x32 philox_gen(init_value+42);
+    threefry2x64 threefry_gen(init_value+42);
+
+    test_raw_generator( minstd_lc_gen, "minstd_rand" );
+    test_raw_generator( twister32_gen, "mt19937" );
+    test_raw_generator( twister64_gen, "mt19937_64" );
+    test_raw_generator( xoshiro_gen, "xoshiro256**" );
+    test_raw_generator( pcg64_gen, "pcg64" );
+    test_raw_generator( wyrand_gen, "wyrand" );
+    test_raw_generator( philox_gen, "philox4x32-10" );
+    test_raw_generator( threefry_gen, "threefry2x64-20" );
+
+    summarize("raw generator output", 1, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
+    const int bulkPasses = iterations / (int)kBulkSize;
+
+    test_bulk_calls( twister64_gen, "mt19937_64 calls" );
+    test_bulk_calls( xoshiro_gen, "xoshiro256** calls" );
+    test_bulk_fill( xoshiro_gen, "xoshiro256** fill" );
+    test_bulk_calls( pcg64_gen, "pcg64 calls" );
+    test_bulk_fill( pcg64_gen, "pcg64 fill" );
+    test_bulk_calls( wyrand_gen, "wyrand calls" );
+    test_bulk_fill( wyrand_gen, "wyrand fill" );
+    test_bulk_calls( philox_gen, "philox4x32-10 calls" );
+    test_bulk_fill( philox_gen, "philox4x32-10 fill" );
+    test_bulk_calls( threefry_gen, "threefry2x64-20 calls" );
+    test_bulk_fill( threefry_gen, "threefry2x64-20 fill" );
+
+    summarize("bulk generator output", (int)kBulkSize, bulkPasses, kDontShowGMeans, kDontShowPenalty );
+
+
+    benchmark::thread_pool pool;
+    
+    test_threaded_generator<xoshiro256ss>( pool, "xoshiro256**", stringStorage );
+    test_threaded_generator<pcg64>( pool, "pcg64", stringStorage );
+    test_threaded_generator<wyrand>( pool, "wyrand", stringStorage );
+    test_threaded_generator<philox4x32>( pool, "philox4x32-10", stringStorage );
+    test_threaded_generator<threefry2x64>( pool, "threefry2x64-20", stringStorage );
+
+    summarize("threaded generator output", (int)kBulkSize, bulkPasses, kDontShowGMeans, kDontShowPenalty );
+
+
+// distributions, std versus fast, one summary per engine
+    const int distributionCount = distribution_iterations();
+
+    test_fast_distributions( minstd_lc_gen, "minstd_rand", stringStorage );
+    summarize("distributions minstd_rand", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+    test_fast_distributions( knuth_shuffle_gen, "knuth_b", stringStorage );
+    summarize("distributions knuth_b", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+    test_fast_distributions( ranlux24_gen, "ranlux24", stringStorage );
+    summarize("distributions ranlux24", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+    test_fast_distributions( ranlux48_gen, "ranlux48", stringStorage );
+    summarize("distributions ranlux48", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+    test_fast_distributions( twister32_gen, "mt19937", stringStorage );
+    summarize("distributions mt19937", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+    test_fast_distributions( twister64_gen, "mt19937_64", stringStorage );
+    summarize("distributions mt19937_64", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+
+    test_fast_distributions( xoshiro_gen, "xoshiro256**", stringStorage );
+    test_bulk_distributions( xoshiro_gen, "xoshiro256**", stringStorage );
+    summarize("distributions xoshiro256**", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+    test_fast_distributions( pcg64_gen, "pcg64", stringStorage );
+    test_bulk_distributions( pcg64_gen, "pcg64", stringStorage );
+    summarize("distributions pcg64", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+    test_fast_distributions( wyrand_gen, "wyrand", stringStorage );
+    test_bulk_distributions( wyrand_gen, "wyrand", stringStorage );
+    summarize("distributions wyrand", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+    test_fast_distributions( philox_gen, "philox4x32-10", stringStorage );
+    test_bulk_distributions( philox_gen, "philox4x32-10", stringStorage );
+    summarize("distributions philox4x32-10", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+    test_fast_distributions( threefry_gen, "threefry2x64-20", stringStorage );
+    test_bulk_distributions( threefry_gen, "threefry2x64-20", stringStorage );
+    summarize("distributions threefry2x64-20", 1, distributionCount, kDontShowGMeans, kDontShowPenalty );
+
+    if (gGeneratorSum == 42)    // unlikely, but the compiler can't know that
+        printf("\n");
+
+
     return 0;
 }
 
@@ -13,6 +13,8 @@ Assumptions:
         BidirectionalIterator
         RandomAccessIterator
 
+    2) std::list::reverse and std::forward_list::reverse should relink the nodes instead of swapping values.
+
 
 NOTE - reverse_n and reverse_copy_n templates would be useful for bidirectional and radom access iterators.
         So we have a counted loop that can be unrolled/vectorized as needed.
@@ -21,12 +23,12 @@ NOTE - reverse_n and reverse_copy_n templates would be useful for bidirectional
 
 
 
-TODO - reverse linked lists
+NOTE - Linked lists can be reversed by relinking the nodes, which needs to know details of the list implementation.
     http://stepanovpapers.com/notes.pdf
             lecture 22
-    WARNING - needs to know details of list implementation!
-    forward iter ( std::forward_list::reverse )
-    bidirectional iter (std::list::reverse)
+    Our own lists have a reverse() member for this, like std::list::reverse and std::forward_list::reverse.
+    The container tests compare that with swapping values, on vector, deque, and linked lists.
+    Portable code cannot see the blocks inside a std::deque, so deques are only reversed through their iterators.
 
 */
 
@@ -41,11 +43,16 @@ TODO - reverse linked lists
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 #include <deque>
+#include <list>
+#include <forward_list>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_algorithms.h"
 #include "benchmark_typenames.h"
+#include "benchmark_containers.h"
 
 /******************************************************************************/
 /******************************************************************************/
@@ -884,6 +891,76 @@ void fast_reverse_copy4(RandomAccessIterator begin,
 /******************************************************************************/
 /******************************************************************************/
 
+// swap values from both ends of a list that has reverse iterators, with a counted loop
+// so we don't have to compare the two iterators every time
+template <class ForwardIterator, class ReverseIterator>
+void reverse_values_n(ForwardIterator begin,
+                        ReverseIterator rbegin,
+                        size_t count) {
+    for ( size_t j = 0; j < count; ++j, ++begin, ++rbegin ) {
+        std::swap(*begin,*rbegin);
+    }
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+// reverse a whole container, so we can use the same test for every idiom
+template <class Container>
+void container_std_reverse(Container &data) {
+    std::reverse( data.begin(), data.end() );
+}
+
+/******************************************************************************/
+
+template <class Container>
+void container_simple_reverse(Container &data) {
+    my_simple_reverse( data.begin(), data.end() );
+}
+
+/******************************************************************************/
+
+template <class Container>
+void container_fast_reverse(Container &data) {
+    my_fast_reverse( data.begin(), data.end() );
+}
+
+/******************************************************************************/
+
+// the pointer versions, on the data inside a vector
+template <class Container>
+void container_fast_reverse2(Container &data) {
+    fast_reverse2( data.data(), data.data() + data.size() );
+}
+
+template <class Container>
+void container_fast_reverse3(Container &data) {
+    fast_reverse3( data.data(), data.data() + data.size() );
+}
+
+template <class Container>
+void container_fast_reverse4(Container &data) {
+    fast_reverse4( data.data(), data.data() + data.size() );
+}
+
+/******************************************************************************/
+
+template <class Container>
+void container_reverse_values_n(Container &data) {
+    reverse_values_n( data.begin(), data.rbegin(), data.size() / 2 );
+}
+
+/******************************************************************************/
+
+// relink the nodes
+template <class Container>
+void container_member_reverse(Container &data) {
+    data.reverse();
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 static std::deque<std::string> gLabels;
 
 // test with a simple template
@@ -925,6 +1002,27 @@ void test_reverse_copy(Iterator begin, Iterator end, Iterator result, Iterator r
 /******************************************************************************/
 /******************************************************************************/
 
+// test with a whole container
+template <class Container, typename RR>
+void test_reverse_container(Container &data, RR func, const std::string label) {
+
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        func( data );
+    }
+    
+    gLabels.push_back( label );
+    record_result( timer(), gLabels.back().c_str() );
+    
+    // an even number of reversals leaves the data in the original order
+    if (!std::is_sorted( data.begin(), data.end() ))
+        printf("test %s failed\n", label.c_str());
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 #define OUTPUT_CSV  0
 
 // test rotate functions on different sized arrays
@@ -1176,6 +1274,68 @@ void TestOneType()
 /******************************************************************************/
 /******************************************************************************/
 
+// compare value swapping and relinking reversals over each standard sequence container and our own linked lists, pooled and not
+template <typename T>
+void TestContainers()
+{
+    auto base_iterations = iterations;
+    
+    std::string myTypeName( getTypeName<T>() );
+    
+    gLabels.clear();
+    
+    T data[SIZE];
+    
+    fill_descending( data, data+SIZE, SIZE+init_value );
+    // sort, to account for aliasing of values in some types
+    std::sort( data, data+SIZE );
+    
+    sequence_containers<T> containers( data, data+SIZE );
+    
+    typedef std::vector<T> VT;
+    typedef std::deque<T> DT;
+    typedef std::list<T> LT;
+
+    test_reverse_container( containers.dataVector, container_std_reverse<VT>, myTypeName + " vector std::reverse");
+    test_reverse_container( containers.dataVector, container_simple_reverse<VT>, myTypeName + " vector simple_reverse");
+    test_reverse_container( containers.dataVector, container_fast_reverse<VT>, myTypeName + " vector fast_reverse");
+    test_reverse_container( containers.dataVector, container_fast_reverse2<VT>, myTypeName + " vector fast_reverse2 data");
+    test_reverse_container( containers.dataVector, container_fast_reverse3<VT>, myTypeName + " vector fast_reverse3 data");
+    test_reverse_container( containers.dataVector, container_fast_reverse4<VT>, myTypeName + " vector fast_reverse4 data");
+
+    test_reverse_container( containers.dataDeque, container_std_reverse<DT>, myTypeName + " deque std::reverse");
+    test_reverse_container( containers.dataDeque, container_simple_reverse<DT>, myTypeName + " deque simple_reverse");
+    test_reverse_container( containers.dataDeque, container_fast_reverse<DT>, myTypeName + " deque fast_reverse");
+    
+    std::string temp1( myTypeName + " reverse random access containers");
+    summarize(temp1.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+
+
+    // pointer chasing is much slower, keep the count even
+    iterations = ((base_iterations / 8) + 1) & ~1;
+
+    test_reverse_container( containers.dataList, container_std_reverse<LT>, myTypeName + " list std::reverse");
+    test_reverse_container( containers.dataList, container_simple_reverse<LT>, myTypeName + " list simple_reverse");
+    test_reverse_container( containers.dataList, container_fast_reverse<LT>, myTypeName + " list fast_reverse");
+    test_reverse_container( containers.dataList, container_reverse_values_n<LT>, myTypeName + " list reverse_values_n");
+    test_reverse_container( containers.dataList, container_member_reverse<LT>, myTypeName + " list list::reverse");
+    test_reverse_container( containers.dataForwardList, container_member_reverse< std::forward_list<T> >, myTypeName + " forward_list forward_list::reverse");
+    test_reverse_container( containers.dataSingleList, container_member_reverse< SingleLinkList<T> >, myTypeName + " SingleLinkList reverse");
+    test_reverse_container( containers.dataPooledSingleList, container_member_reverse< PooledSingleLinkList<T> >, myTypeName + " PooledSingleLinkList reverse");
+    test_reverse_container( containers.dataDoubleList, container_reverse_values_n< DoubleLinkList<T> >, myTypeName + " DoubleLinkList reverse_values_n");
+    test_reverse_container( containers.dataDoubleList, container_member_reverse< DoubleLinkList<T> >, myTypeName + " DoubleLinkList reverse");
+    test_reverse_container( containers.dataPooledDoubleList, container_reverse_values_n< PooledDoubleLinkList<T> >, myTypeName + " PooledDoubleLinkList reverse_values_n");
+    test_reverse_container( containers.dataPooledDoubleList, container_member_reverse< PooledDoubleLinkList<T> >, myTypeName + " PooledDoubleLinkList reverse");
+    
+    std::string temp2( myTypeName + " reverse linked lists");
+    summarize(temp2.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 int main(int argc, char** argv) {
 
     // output command for documentation:
@@ -1204,6 +1364,11 @@ int main(int argc, char** argv) {
     TestOneType<uint64_t>();
     
     TestOneType<double>();
+    
+    
+    TestContainers<int32_t>();
+    
+    TestContainers<double>();
 
 
 #if THESE_WORK_BUT_TAKE_A_WHILE_TO_RUN
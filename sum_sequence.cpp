@@ -15,6 +15,10 @@ Assumptions:
     
     3) The compiler may recognize ineffecient summation idioms and substitute efficient methods.
 
+    4) Accurate summation (compensated, pairwise) will cost a little time, but not as much as summing in a larger type.
+
+    5) Summing a deque or list should cost little more than the pointer chasing needed to reach the data.
+
 
 
 NOTE - MSVC generates dozens of bogus precision loss error messages about std::accumulate.
@@ -29,13 +33,13 @@ NOTE - gcc can generate bogus warnings about high iteration numbers in loops
 
 
 
-TODO - test other containers
-    vector
-    deque
-    list
-    forward_list
+NOTE - The container tests run the same accumulators over vector, deque, list, forward_list and our own linked lists.
+        Linked lists go through a forward_indexer, which walks the list as the indices increase.
+        Pooled lists can also be summed in pool order, one block of nodes at a time, with plain pointers.
+        Portable code cannot see the blocks inside a std::deque, so deques only use their iterators.
 
-TODO - create forward iterator friendly versions of each accumulator
+NOTE - compensated sums (Kahan, Neumaier) need IEEE rounding, and are broken by fast math options.
+        The accuracy tests report the relative error against a double-double reference.
 
 NOTE - Simple cache hinting did not help on Intel i7
         The built-in linear predictor is good enough.
@@ -53,13 +57,17 @@ NOTE - std::reduce not available until C++17 (which is not yet stable on all ava
 #include <cmath>
 #include <cstdlib>
 #include <numeric>
+#include <vector>
 #include <deque>
+#include <list>
+#include <forward_list>
 #include <string>
 #include <iostream>
 #include "benchmark_results.h"
 #include "benchmark_timer.h"
 #include "benchmark_algorithms.h"
 #include "benchmark_typenames.h"
+#include "benchmark_containers.h"
 
 /******************************************************************************/
 /******************************************************************************/
@@ -700,10 +708,246 @@ struct accumulate16 {
 /******************************************************************************/
 /******************************************************************************/
 
+/*
+    Accurate summation
+    The simple sums above can lose all significant bits when values vary in magnitude or cancel,
+        and the result changes with the order of the additions (unrolling, vectorization, threading).
+    These trade some speed for accuracy, see TestAccuracy below for the errors.
+    Compensated sums depend on IEEE rounding, and will be "optimized" away by fast math options.
+*/
+
+// Kahan: carry the rounding error of each addition into the next value
+template <typename Iter, typename T>
+struct accumulate_kahan {
+    T operator()( Iter first, const size_t count )
+    {
+        T sum(0);
+        T compensation(0);
+        for (size_t j = 0; j < count; ++j) {
+            T y = T(first[j]) - compensation;
+            T t = sum + y;
+            compensation = (t - sum) - y;
+            sum = t;
+        }
+        return sum;
+    }
+};
+
+/******************************************************************************/
+
+// Neumaier: Kahan-Babuska, also correct when the new value is larger than the running sum
+template <typename Iter, typename T>
+struct accumulate_neumaier {
+    T operator()( Iter first, const size_t count )
+    {
+        T sum(0);
+        T compensation(0);
+        for (size_t j = 0; j < count; ++j) {
+            T value = T(first[j]);
+            T t = sum + value;
+            if (std::abs(sum) >= std::abs(value))
+                compensation += (sum - t) + value;
+            else
+                compensation += (value - t) + sum;
+            sum = t;
+        }
+        return sum + compensation;
+    }
+};
+
+/******************************************************************************/
+
+// small blocks summed directly, with 4 accumulators so they still vectorize
+template <typename Iter, typename T>
+inline T block_sum( Iter first, const size_t count )
+{
+    T sum[4] = { 0,0,0,0 };
+    size_t j;
+    
+    for ( j = 0; j < (count & ~size_t(3)); j += 4) {
+        sum[0] += first[j+0];
+        sum[1] += first[j+1];
+        sum[2] += first[j+2];
+        sum[3] += first[j+3];
+    }
+
+    for (; j < count; ++j) {
+        sum[0] += first[j];
+    }
+    
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+/******************************************************************************/
+
+// pairwise: split in half recursively, error grows with log(N) instead of N
+template <typename Iter, typename T>
+struct accumulate_pairwise {
+    T operator()( Iter first, const size_t count )
+    {
+        const size_t block = 64;
+        if (count <= block)
+            return block_sum<Iter,T>( first, count );
+        
+        size_t half = (count / 2 + block - 1) & ~(block - 1);     // keep the blocks aligned
+        return (*this)( first, half ) + (*this)( first + half, count - half );
+    }
+};
+
+/******************************************************************************/
+
+// cascade: pairwise without recursion, partial sums of 2^N blocks are kept like a binary counter
+template <typename Iter, typename T>
+struct accumulate_cascade {
+    T operator()( Iter first, const size_t count )
+    {
+        const size_t block = 64;
+        T partial[ 64 ];
+        size_t blocks = 0;
+        size_t j;
+        
+        for (j = 0; (j + block) <= count; j += block) {
+            T sum = block_sum<Iter,T>( first + j, block );
+            size_t n = ++blocks;
+            int level = 0;
+            while ((n & 1) == 0) {      // merge equal sized partial sums
+                sum = partial[level] + sum;
+                n >>= 1;
+                ++level;
+            }
+            partial[level] = sum;
+        }
+        
+        T result = block_sum<Iter,T>( first + j, count - j );
+        for (int level = 0; (blocks >> level) != 0; ++level)
+            if ((blocks >> level) & 1)
+                result = partial[level] + result;
+        
+        return result;
+    }
+};
+
+/******************************************************************************/
+
+// Kahan with 8 independent lanes made to look like vectors, so the compiler can vectorize it
+// lanes are combined with Neumaier's method at the end
+template <typename Iter, typename T>
+struct accumulate_kahan_blocked {
+    T operator()( Iter first, const size_t count )
+    {
+        T sum[8] = { 0,0,0,0, 0,0,0,0 };
+        T compensation[8] = { 0,0,0,0, 0,0,0,0 };
+        size_t j, k;
+        
+        for ( j = 0; j < (count & ~size_t(7)); j += 8) {
+            for (k = 0; k < 8; ++k) {
+                T y = T(first[j+k]) - compensation[k];
+                T t = sum[k] + y;
+                compensation[k] = (t - sum[k]) - y;
+                sum[k] = t;
+            }
+        }
+        
+        for (k = 0; j < count; ++j, ++k) {
+            T y = T(first[j]) - compensation[k];
+            T t = sum[k] + y;
+            compensation[k] = (t - sum[k]) - y;
+            sum[k] = t;
+        }
+        
+        T result(0);
+        T error(0);
+        for (k = 0; k < 8; ++k) {
+            T s, e;
+            two_sum( result, sum[k], s, e );
+            result = s;
+            error += e - compensation[k];
+        }
+        
+        return result + error;
+    }
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
+/*
+    Container friendly summation
+    The indexed accumulators above work on any random access iterator, and on linked lists through a forward_indexer.
+    These are written for the containers themselves.
+*/
+
+// forward iterators only need increment and dereference
+template <typename Iter, typename T>
+struct accumulate_forward {
+    T operator()( Iter first, const size_t count )
+    {
+        T sum(0);
+        for (size_t j = 0; j < count; ++j) {
+            sum += *first++;
+        }
+        return sum;
+    }
+};
+
+/******************************************************************************/
+
+// forward iterator, with multiple accumulation variables
+// the next item still can't be found until the previous node is loaded
+template <typename Iter, typename T>
+struct accumulate_forward4 {
+    T operator()( Iter first, const size_t count )
+    {
+        T sum(0);
+        T sum1(0);
+        T sum2(0);
+        T sum3(0);
+        size_t j;
+        
+        for (j = 0; (j + 3) < count; j += 4) {
+            sum  += *first++;
+            sum1 += *first++;
+            sum2 += *first++;
+            sum3 += *first++;
+        }
+
+        for (; j < count; ++j) {
+            sum += *first++;
+        }
+
+        sum += sum1 + sum2 + sum3;
+        
+        return sum;
+    }
+};
+
+/******************************************************************************/
+
+// unordered: sum the node pool of a pooled list, one block of nodes at a time
+// unused nodes add zero instead of branching
+template <typename PooledList, typename T>
+struct accumulate_pool_blocks {
+    T operator()( const PooledList *list, const size_t )
+    {
+        T sum(0);
+        list->for_each_block( [&sum]( const auto *node, const auto *node_end ) {
+            T sum1(0);
+            for ( ; node != node_end; ++node)
+                sum1 += node->in_use() ? T(node->value) : T(0);
+            sum += sum1;
+        } );
+        return sum;
+    }
+};
+
+/******************************************************************************/
+/******************************************************************************/
+
 std::deque<std::string> gLabels;
 
-template <typename T, typename Summer>
-void test_accumulate(const T* first, const size_t count, Summer func, const std::string label) {
+// the sum is checked as the value type, like the array tests always have
+template <typename Iter, typename Summer, typename T = typename std::iterator_traits<Iter>::value_type>
+void test_accumulate(Iter first, const size_t count, Summer func, const std::string label) {
 
     start_timer();
 
@@ -848,6 +1092,11 @@ void TestOneTypeFloat()
     TestOneFuncFloat< const T*, T, accumulate14 >( data, SIZE, myTypeName + " accumulate14" );
     TestOneFuncFloat< const T*, T, accumulate15 >( data, SIZE, myTypeName + " accumulate15" );
     TestOneFuncFloat< const T*, T, accumulate16 >( data, SIZE, myTypeName + " accumulate16" );
+    TestOneFuncFloat< const T*, T, accumulate_kahan >( data, SIZE, myTypeName + " accumulate_kahan" );
+    TestOneFuncFloat< const T*, T, accumulate_neumaier >( data, SIZE, myTypeName + " accumulate_neumaier" );
+    TestOneFuncFloat< const T*, T, accumulate_pairwise >( data, SIZE, myTypeName + " accumulate_pairwise" );
+    TestOneFuncFloat< const T*, T, accumulate_cascade >( data, SIZE, myTypeName + " accumulate_cascade" );
+    TestOneFuncFloat< const T*, T, accumulate_kahan_blocked >( data, SIZE, myTypeName + " accumulate_kahan_blocked" );
     
     
     std::string temp1( myTypeName + " sum_sequence" );
@@ -857,6 +1106,238 @@ void TestOneTypeFloat()
 /******************************************************************************/
 /******************************************************************************/
 
+// every indexed accumulator, summing to the value type of the container
+template<typename T, typename Iter>
+void TestContainerFuncs( Iter first, const std::string label )
+{
+    test_accumulate( first, SIZE, accumulate_std<Iter, T>(), label + " std::accumulate" );
+    test_accumulate( first, SIZE, accumulate1<Iter, T>(), label + " accumulate1" );
+    test_accumulate( first, SIZE, accumulate2<Iter, T>(), label + " accumulate2" );
+    test_accumulate( first, SIZE, accumulate3<Iter, T>(), label + " accumulate3" );
+    test_accumulate( first, SIZE, accumulate4<Iter, T>(), label + " accumulate4" );
+    test_accumulate( first, SIZE, accumulate5<Iter, T>(), label + " accumulate5" );
+    test_accumulate( first, SIZE, accumulate6<Iter, T>(), label + " accumulate6" );
+    test_accumulate( first, SIZE, accumulate7<Iter, T>(), label + " accumulate7" );
+    test_accumulate( first, SIZE, accumulate8<Iter, T>(), label + " accumulate8" );
+    test_accumulate( first, SIZE, accumulate9<Iter, T>(), label + " accumulate9" );
+    test_accumulate( first, SIZE, accumulate10<Iter, T>(), label + " accumulate10" );
+    test_accumulate( first, SIZE, accumulate11<Iter, T>(), label + " accumulate11" );
+    test_accumulate( first, SIZE, accumulate12<Iter, T>(), label + " accumulate12" );
+    test_accumulate( first, SIZE, accumulate13<Iter, T>(), label + " accumulate13" );
+    test_accumulate( first, SIZE, accumulate14<Iter, T>(), label + " accumulate14" );
+    test_accumulate( first, SIZE, accumulate15<Iter, T>(), label + " accumulate15" );
+    test_accumulate( first, SIZE, accumulate16<Iter, T>(), label + " accumulate16" );
+}
+
+/******************************************************************************/
+
+template<typename T, typename Iter>
+void TestContainerFuncsFloat( Iter first, const std::string label )
+{
+    TestContainerFuncs<T>( first, label );
+    test_accumulate( first, SIZE, accumulate_kahan<Iter, T>(), label + " accumulate_kahan" );
+    test_accumulate( first, SIZE, accumulate_neumaier<Iter, T>(), label + " accumulate_neumaier" );
+    test_accumulate( first, SIZE, accumulate_pairwise<Iter, T>(), label + " accumulate_pairwise" );
+    test_accumulate( first, SIZE, accumulate_cascade<Iter, T>(), label + " accumulate_cascade" );
+    test_accumulate( first, SIZE, accumulate_kahan_blocked<Iter, T>(), label + " accumulate_kahan_blocked" );
+}
+
+/******************************************************************************/
+
+// random access containers use the accumulators directly
+template<typename T, typename Iter>
+void TestRandomAccessContainer( Iter first, const std::string label, bool isFloat )
+{
+    if (isFloat)
+        TestContainerFuncsFloat<T>( first, label );
+    else
+        TestContainerFuncs<T>( first, label );
+}
+
+/******************************************************************************/
+
+// linked lists use the accumulators through a forward_indexer, and the forward versions directly
+template<typename T, typename Iter>
+void TestForwardContainer( Iter first, const std::string label, bool isFloat )
+{
+    forward_cursor<Iter> cursor( first );
+    forward_indexer<Iter> indexer( cursor );
+    
+    if (isFloat)
+        TestContainerFuncsFloat<T>( indexer, label );
+    else
+        TestContainerFuncs<T>( indexer, label );
+    
+    test_accumulate( first, SIZE, accumulate_forward<Iter, T>(), label + " accumulate_forward" );
+    test_accumulate( first, SIZE, accumulate_forward4<Iter, T>(), label + " accumulate_forward4" );
+}
+
+/******************************************************************************/
+
+// summing a pooled list in pool order is faster, when the order does not matter
+template<typename T, typename PooledList>
+void TestPooledList( PooledList &list, const std::string label )
+{
+    typedef accumulate_pool_blocks<PooledList, T> Summer;
+    test_accumulate<const PooledList *, Summer, T>( &list, SIZE, Summer(), label + " accumulate_pool_blocks" );
+}
+
+/******************************************************************************/
+
+// run the sum idioms over each standard sequence container and our own linked lists, pooled and not
+// float and integer types can share this, because we only sum to the value type
+template<typename T>
+void TestContainers()
+{
+    const bool isFloat = (T(2.9) > T(2.0));
+    std::string myTypeName( getTypeName<T>() );
+    const int base_iterations = iterations;
+    
+    T data[SIZE];
+    fill(data, data+SIZE, T(init_value));
+    
+    sequence_containers<T> containers( data, data+SIZE );
+    
+    
+    gLabels.clear();
+    TestRandomAccessContainer<T>( containers.dataVector.cbegin(), myTypeName + " vector", isFloat );
+    std::string temp1( myTypeName + " vector sum_sequence" );
+    summarize(temp1.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    // deque iterators check for the end of each block
+    iterations = base_iterations / 4;
+    
+    gLabels.clear();
+    TestRandomAccessContainer<T>( containers.dataDeque.cbegin(), myTypeName + " deque", isFloat );
+    std::string temp2( myTypeName + " deque sum_sequence" );
+    summarize(temp2.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    
+    // pointer chasing is much slower
+    iterations = base_iterations / 32;
+    
+    gLabels.clear();
+    TestForwardContainer<T>( containers.dataList.cbegin(), myTypeName + " list", isFloat );
+    std::string temp3( myTypeName + " list sum_sequence" );
+    summarize(temp3.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    gLabels.clear();
+    TestForwardContainer<T>( containers.dataForwardList.cbegin(), myTypeName + " forward_list", isFloat );
+    std::string temp4( myTypeName + " forward_list sum_sequence" );
+    summarize(temp4.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    gLabels.clear();
+    TestForwardContainer<T>( containers.dataSingleList.cbegin(), myTypeName + " SingleLinkList", isFloat );
+    std::string temp5( myTypeName + " SingleLinkList sum_sequence" );
+    summarize(temp5.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    gLabels.clear();
+    TestForwardContainer<T>( containers.dataPooledSingleList.cbegin(), myTypeName + " PooledSingleLinkList", isFloat );
+    TestPooledList<T>( containers.dataPooledSingleList, myTypeName + " PooledSingleLinkList" );
+    std::string temp6( myTypeName + " PooledSingleLinkList sum_sequence" );
+    summarize(temp6.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    gLabels.clear();
+    TestForwardContainer<T>( containers.dataDoubleList.cbegin(), myTypeName + " DoubleLinkList", isFloat );
+    std::string temp7( myTypeName + " DoubleLinkList sum_sequence" );
+    summarize(temp7.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    gLabels.clear();
+    TestForwardContainer<T>( containers.dataPooledDoubleList.cbegin(), myTypeName + " PooledDoubleLinkList", isFloat );
+    TestPooledList<T>( containers.dataPooledDoubleList, myTypeName + " PooledDoubleLinkList" );
+    std::string temp8( myTypeName + " PooledDoubleLinkList sum_sequence" );
+    summarize(temp8.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+    
+    iterations = base_iterations;
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
+// time a sum on real data, with the relative error against an exact reference in the label
+// every call must give the same answer, or totals won't be reproducible
+template <typename T, typename Summer>
+void test_accuracy(const T* first, const size_t count, Summer func, const std::string label, const double_double &reference) {
+    const auto expected = func( first, count );
+    char buffer[ 100 ];
+    snprintf( buffer, sizeof(buffer), ", relative error %.1e", reference.relative_error( expected ) );
+
+    // the data doesn't change, so keep the compiler from moving the sum out of the loop
+    const T * volatile source = first;
+
+    start_timer();
+
+    for(int i = 0; i < iterations; ++i) {
+        auto sum = func( source, count );
+        if (sum != expected)
+            printf("test %s failed, result not reproducible\n", label.c_str() );
+    }
+    
+    // need the labels to remain valid until we print the summary
+    gLabels.push_back( label + buffer );
+    record_result( timer(), gLabels.back().c_str() );
+}
+
+/******************************************************************************/
+
+// mixed magnitudes, interleaved with large values that cancel at the end of the sequence
+template <typename T>
+void fill_cancelling( T *first, const size_t count ) {
+    fill_mixed_magnitudes( first, count );
+    const size_t pairs = count / 4;
+    for (size_t j = 0; j < pairs; ++j) {
+        T large = T( double( uint64_t(crand64()) & 0xFFFFF ) * 100.0 );
+        first[ 2*j + 1 ] = large;
+        first[ count - 1 - 2*j ] = -large;
+    }
+}
+
+/******************************************************************************/
+
+template<typename T>
+void TestOneAccuracy( const T *data, const size_t count, const std::string &name )
+{
+    std::string myTypeName( getTypeName<T>() );
+    
+    gLabels.clear();
+    
+    double_double reference;
+    for (size_t j = 0; j < count; ++j)
+        reference.add( double(data[j]) );
+
+    test_accuracy( data, count, accumulate_std<const T*, T>(), myTypeName + " std::accumulate", reference );
+    test_accuracy( data, count, accumulate1<const T*, T>(), myTypeName + " accumulate1", reference );
+    test_accuracy( data, count, accumulate16<const T*, T>(), myTypeName + " accumulate16", reference );
+    test_accuracy( data, count, accumulate_kahan<const T*, T>(), myTypeName + " accumulate_kahan", reference );
+    test_accuracy( data, count, accumulate_neumaier<const T*, T>(), myTypeName + " accumulate_neumaier", reference );
+    test_accuracy( data, count, accumulate_pairwise<const T*, T>(), myTypeName + " accumulate_pairwise", reference );
+    test_accuracy( data, count, accumulate_cascade<const T*, T>(), myTypeName + " accumulate_cascade", reference );
+    test_accuracy( data, count, accumulate_kahan_blocked<const T*, T>(), myTypeName + " accumulate_kahan_blocked", reference );
+    if (sizeof(T) < sizeof(double))
+        test_accuracy( data, count, accumulate16<const T*, double>(), myTypeName + " accumulate16 to double", reference );
+    
+    std::string temp1( myTypeName + " sum_sequence accuracy " + name );
+    summarize(temp1.c_str(), SIZE, iterations, kDontShowGMeans, kDontShowPenalty );
+}
+
+/******************************************************************************/
+
+template<typename T>
+void TestAccuracy()
+{
+    T data[SIZE];
+    
+    scrand( 4242 );
+    fill_mixed_magnitudes( data, SIZE );
+    TestOneAccuracy( data, SIZE, "mixed magnitudes" );
+    
+    fill_cancelling( data, SIZE );
+    TestOneAccuracy( data, SIZE, "cancelling" );
+}
+
+/******************************************************************************/
+/******************************************************************************/
+
 int main(int argc, char** argv) {
 
     // output command for documentation:
@@ -881,6 +1362,12 @@ int main(int argc, char** argv) {
     TestOneType<uint64_t>();
     TestOneTypeFloat<float>();
     TestOneTypeFloat<double>();
+    
+    TestAccuracy<float>();
+    TestAccuracy<double>();
+    
+    TestContainers<int32_t>();
+    TestContainers<double>();
 //    TestOneType<long double>();   // nobody appears to be generating good code for long double
 
 